@@ -0,0 +1,86 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/artifact_writer.h"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "src/base.h"
+#include "src/frame.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Lossless WebP effort of the animations. See WriteStillImageOrAnimation().
+constexpr int kFastWebpEffort = 0;
+constexpr int kDefaultWebpEffort = 9;
+
+}  // namespace
+
+ArtifactWriter::ArtifactWriter(size_t num_threads,
+                               size_t max_num_queued_images, bool fast,
+                               bool quiet)
+    : fast_(fast),
+      quiet_(quiet),
+      artifacts_(max_num_queued_images == 0 ? 1 : max_num_queued_images) {
+  for (size_t i = 0; i < (num_threads == 0 ? 1 : num_threads); ++i) {
+    threads_.emplace_back([this]() { Run(); });
+  }
+}
+
+ArtifactWriter::~ArtifactWriter() { (void)Close(); }
+
+void ArtifactWriter::Write(Image image, std::string file_path) {
+  artifacts_.Push({std::move(image), std::move(file_path)});
+}
+
+Status ArtifactWriter::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_closed_) {
+      is_closed_ = true;
+      artifacts_.Close();
+    }
+  }
+  for (std::thread& thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+void ArtifactWriter::Run() {
+  Artifact artifact;
+  while (artifacts_.Pop(artifact)) {
+#if defined(HAS_WEBP2)
+    const Status status = WriteStillImageOrAnimation(
+        artifact.image, artifact.file_path.c_str(), quiet_,
+        fast_ ? kFastWebpEffort : kDefaultWebpEffort);
+#else
+    const Status status = Status::kUnknownError;
+#endif
+    artifact = Artifact();  // Free the pixels before waiting for the next.
+    if (status != Status::kOk) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (status_ == Status::kOk) status_ = status;
+    }
+  }
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,67 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_ARTIFACT_WRITER_H_
+#define SRC_ARTIFACT_WRITER_H_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/base.h"
+#include "src/frame.h"
+#include "src/worker.h"
+
+namespace codec_compare_gen {
+
+// Writes images to disk in separate threads, so that the tasks producing them
+// do not wait for their PNG or WebP compression. Thread-safe.
+class ArtifactWriter {
+ public:
+  // At most max_num_queued_images wait to be written at any time. If fast,
+  // the animations are compressed at the lowest lossless WebP effort.
+  ArtifactWriter(size_t num_threads, size_t max_num_queued_images, bool fast,
+                 bool quiet);
+  ArtifactWriter(const ArtifactWriter&) = delete;
+  ArtifactWriter& operator=(const ArtifactWriter&) = delete;
+  ~ArtifactWriter();  // Same as Close() without the returned status.
+
+  // Same as WriteStillImageOrAnimation(image, file_path) but asynchronous.
+  // Blocks while the queue is full.
+  void Write(Image image, std::string file_path);
+  // Waits for all queued images to be written. Returns the first error.
+  Status Close();
+
+ private:
+  struct Artifact {
+    Image image;
+    std::string file_path;
+  };
+
+  void Run();
+
+  const bool fast_;
+  const bool quiet_;
+  BoundedQueue<Artifact> artifacts_;
+  std::mutex mutex_;  // Guards the fields below.
+  Status status_ = Status::kOk;  // kOk or first encountered error.
+  bool is_closed_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_ARTIFACT_WRITER_H_
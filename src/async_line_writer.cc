@@ -0,0 +1,140 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/async_line_writer.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+AsyncLineWriter::AsyncLineWriter(size_t max_num_buffered_bytes,
+                                 double max_delay_seconds)
+    : max_num_buffered_bytes_(max_num_buffered_bytes),
+      max_delay_(max_delay_seconds) {}
+
+AsyncLineWriter::~AsyncLineWriter() { (void)Close(); }
+
+Status AsyncLineWriter::Open(const std::string& file_path, bool quiet) {
+  CHECK_OR_RETURN(file_ == nullptr, quiet);
+  file_ = std::fopen(file_path.c_str(), "ab");
+  CHECK_OR_RETURN(file_ != nullptr, quiet)
+      << "Could not open " << file_path << " for writing";
+  file_path_ = file_path;
+  quiet_ = quiet;
+  stop_ = false;
+  status_ = Status::kOk;
+  thread_ = std::thread(&AsyncLineWriter::Run, this);
+  return Status::kOk;
+}
+
+void AsyncLineWriter::Append(const std::string& line) {
+  Append(line, /*line_break=*/true);
+}
+
+void AsyncLineWriter::AppendBytes(std::string_view bytes) {
+  Append(bytes, /*line_break=*/false);
+}
+
+void AsyncLineWriter::Append(std::string_view bytes, bool line_break) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_written_.wait(lock, [this] {
+    return buffer_.size() < max_num_buffered_bytes_ || stop_;
+  });
+  buffer_ += bytes;
+  if (line_break) buffer_ += '\n';
+  ++num_appended_lines_;
+  if (buffer_.size() >= max_num_buffered_bytes_) wake_writer_.notify_one();
+}
+
+Status AsyncLineWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!thread_.joinable()) return status_;
+  const uint64_t num_lines = num_appended_lines_;
+  flush_requested_ = true;
+  wake_writer_.notify_one();
+  batch_written_.wait(
+      lock, [this, num_lines] { return num_written_lines_ >= num_lines; });
+  return status_;
+}
+
+Status AsyncLineWriter::Close() {
+  if (!thread_.joinable()) return Status::kOk;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    wake_writer_.notify_one();
+  }
+  thread_.join();
+  const bool is_closed = std::fclose(file_) == 0;
+  file_ = nullptr;
+  OK_OR_RETURN(status_);
+  CHECK_OR_RETURN(is_closed, quiet_) << "Could not close " << file_path_;
+  return Status::kOk;
+}
+
+void AsyncLineWriter::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    // Wakes up at least every max_delay_ to write what was appended meanwhile.
+    wake_writer_.wait_for(lock, max_delay_, [this] {
+      return stop_ || flush_requested_ ||
+             buffer_.size() >= max_num_buffered_bytes_;
+    });
+    flush_requested_ = false;
+    if (buffer_.empty()) {
+      batch_written_.notify_all();
+      if (stop_) break;
+      continue;
+    }
+    std::string batch;
+    batch.swap(buffer_);
+    const uint64_t num_lines = num_appended_lines_;
+    batch_written_.notify_all();  // The buffer has room again.
+
+    lock.unlock();
+    const Status status = Write(batch);
+    lock.lock();
+    if (status_ == Status::kOk) status_ = status;
+    num_written_lines_ = num_lines;
+    batch_written_.notify_all();
+  }
+}
+
+Status AsyncLineWriter::Write(const std::string& batch) {
+  CHECK_OR_RETURN(
+      std::fwrite(batch.data(), 1, batch.size(), file_) == batch.size(),
+      quiet_)
+      << "Could not write to " << file_path_;
+  CHECK_OR_RETURN(std::fflush(file_) == 0, quiet_)
+      << "Could not flush " << file_path_;
+#ifdef HAVE_UNISTD_H
+  CHECK_OR_RETURN(fsync(fileno(file_)) == 0, quiet_)
+      << "Could not sync " << file_path_;
+#endif
+  return Status::kOk;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,81 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_ASYNC_LINE_WRITER_H_
+#define SRC_ASYNC_LINE_WRITER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Appends lines to a file from a dedicated thread, so that the callers do not
+// wait for the disk. The lines are buffered and written in batches, once
+// max_num_buffered_bytes are waiting or at most max_delay_seconds after being
+// appended. Each batch is synced to the disk, so that at most the last
+// max_delay_seconds of lines are lost if the process is killed.
+class AsyncLineWriter {
+ public:
+  AsyncLineWriter(size_t max_num_buffered_bytes, double max_delay_seconds);
+  AsyncLineWriter(const AsyncLineWriter&) = delete;
+  ~AsyncLineWriter();  // Calls Close().
+
+  // Opens file_path in append mode and starts the writing thread.
+  Status Open(const std::string& file_path, bool quiet);
+  // Thread-safe. Appends the line followed by a line break. Blocks while
+  // max_num_buffered_bytes are already waiting to be written.
+  void Append(const std::string& line);
+  // Same as Append() without line break, for binary contents.
+  void AppendBytes(std::string_view bytes);
+  // Thread-safe. Returns once all lines appended so far are written and synced.
+  Status Flush();
+  // Writes the remaining lines and closes the file. Returns the first error
+  // encountered since Open().
+  Status Close();
+
+ private:
+  void Append(std::string_view bytes, bool line_break);
+  void Run();
+  Status Write(const std::string& batch);
+
+  const size_t max_num_buffered_bytes_;
+  const std::chrono::duration<double> max_delay_;
+  std::string file_path_;
+  std::FILE* file_ = nullptr;  // Only accessed by thread_ once started.
+  bool quiet_ = true;
+  std::thread thread_;
+
+  std::mutex mutex_;  // Guards the fields below.
+  std::condition_variable wake_writer_;
+  std::condition_variable batch_written_;
+  std::string buffer_;
+  uint64_t num_appended_lines_ = 0;
+  uint64_t num_written_lines_ = 0;
+  bool flush_requested_ = false;
+  bool stop_ = false;
+  Status status_ = Status::kOk;  // First encountered error.
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_ASYNC_LINE_WRITER_H_
@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstddef>
 #include <iostream>
+#include <limits>
 #include <utility>
 
 namespace codec_compare_gen {
@@ -63,17 +64,30 @@ enum class DistortionMetric {
   kLibjxlButteraugli,
   kLibjxlSsimulacra,
   kLibjxlSsimulacra2,
-  kLibjxlP3norm
+  kLibjxlP3norm,
+  // PSNR over all samples of all channels at once, without alpha blending.
+  // Unlike kLibwebp2Psnr, it can be computed on rows as they are decoded.
+  kSamplePsnr
 };
 static constexpr size_t kNumDistortionMetrics =
-    static_cast<size_t>(DistortionMetric::kLibjxlP3norm) + 1;
+    static_cast<size_t>(DistortionMetric::kSamplePsnr) + 1;
 static constexpr const char* kDistortionMetricToStr[] = {
-    "PSNR",       "SSIM",        "DSSIM", "Butteraugli",
-    "SSimulacra", "SSimulacra2", "P3norm"};
+    "PSNR",       "SSIM",        "DSSIM",  "Butteraugli",
+    "SSimulacra", "SSimulacra2", "P3norm", "SamplePSNR"};
 static_assert(sizeof(kDistortionMetricToStr) /
                   sizeof(kDistortionMetricToStr[0]) ==
               kNumDistortionMetrics);
+// Returns true if the metric is computed when no metric is selected.
+inline bool IsComputedByDefault(DistortionMetric metric) {
+  return metric != DistortionMetric::kSamplePsnr;
+}
+// How the durations of the repetitions of a task are aggregated.
+enum class TimingStatistic { kMean, kMedian, kMin };
+
 static constexpr float kNoDistortion = 99.f;  // Measured dB (for PSNR).
+// Value of the metrics that were not selected for computation.
+static constexpr float kDistortionNotComputed =
+    std::numeric_limits<float>::quiet_NaN();
 
 //------------------------------------------------------------------------------
 // Status management
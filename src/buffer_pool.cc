@@ -0,0 +1,150 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/buffer_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace codec_compare_gen {
+
+namespace {
+
+constexpr size_t kMinNumPooledBytes = size_t{64} << 10;
+constexpr size_t kMaxNumBlocksPerSizeClass = 2;
+
+// Over the pools of all threads.
+std::atomic<size_t> max_num_pooled_bytes{kDefaultMaxNumPooledBytes};
+std::atomic<size_t> total_num_pooled_bytes{0};
+
+// Rounds num_bytes up to the next quarter of a power of two.
+size_t GetSizeClass(size_t num_bytes) {
+  if (num_bytes < kMinNumPooledBytes) return num_bytes;
+  size_t power_of_two = 1;
+  while (power_of_two <= num_bytes / 2) power_of_two *= 2;
+  const size_t step = power_of_two / 4;
+  return (num_bytes + step - 1) / step * step;
+}
+
+class Pool {
+ public:
+  ~Pool() {
+    is_alive_ = false;
+    total_num_pooled_bytes -= num_bytes_;
+  }
+
+  // Returns null if the pool of the calling thread was destroyed.
+  static Pool* Get() {
+    thread_local Pool pool;
+    return is_alive_ ? &pool : nullptr;
+  }
+
+  std::unique_ptr<uint8_t[]> Take(size_t capacity) {
+    is_used_ = true;
+    const auto it = free_blocks_.find(capacity);
+    if (it == free_blocks_.end() || it->second.empty()) return nullptr;
+    std::unique_ptr<uint8_t[]> bytes = std::move(it->second.back());
+    it->second.pop_back();
+    num_bytes_ -= capacity;
+    total_num_pooled_bytes -= capacity;
+    return bytes;
+  }
+
+  void Give(std::unique_ptr<uint8_t[]> bytes, size_t capacity) {
+    // The threads that only destroy buffers, such as the ArtifactWriter ones,
+    // would never reuse them.
+    if (!is_used_ || capacity < kMinNumPooledBytes) return;  // Freed.
+    std::vector<std::unique_ptr<uint8_t[]>>& blocks = free_blocks_[capacity];
+    if (blocks.size() >= kMaxNumBlocksPerSizeClass) return;
+    // Reserved first so that concurrent threads cannot exceed the maximum.
+    if (total_num_pooled_bytes.fetch_add(capacity) + capacity >
+        max_num_pooled_bytes) {
+      total_num_pooled_bytes -= capacity;
+      return;
+    }
+    blocks.push_back(std::move(bytes));
+    num_bytes_ += capacity;
+  }
+
+  size_t num_bytes() const { return num_bytes_; }
+
+ private:
+  // Trivially destructible so that it can be read during the thread exit.
+  static thread_local bool is_alive_;
+
+  // By capacity.
+  std::unordered_map<size_t, std::vector<std::unique_ptr<uint8_t[]>>>
+      free_blocks_;
+  size_t num_bytes_ = 0;
+  bool is_used_ = false;  // True once Take() was called by this thread.
+};
+
+thread_local bool Pool::is_alive_ = true;
+
+}  // namespace
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : bytes_(std::move(other.bytes_)), capacity_(other.capacity_) {
+  other.capacity_ = 0;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+  if (this != &other) {
+    Release();
+    bytes_ = std::move(other.bytes_);
+    capacity_ = other.capacity_;
+    other.capacity_ = 0;
+  }
+  return *this;
+}
+
+PooledBuffer::~PooledBuffer() { Release(); }
+
+void PooledBuffer::Release() {
+  if (bytes_ == nullptr) return;
+  Pool* pool = Pool::Get();
+  if (pool != nullptr) pool->Give(std::move(bytes_), capacity_);
+  bytes_.reset();
+  capacity_ = 0;
+}
+
+PooledBuffer GetPooledBuffer(size_t num_bytes) {
+  PooledBuffer buffer;
+  buffer.capacity_ = GetSizeClass(num_bytes);
+  Pool* pool = Pool::Get();
+  if (pool != nullptr) buffer.bytes_ = pool->Take(buffer.capacity_);
+  // Not value-initialized, to skip writing the pages before they are needed.
+  if (buffer.bytes_ == nullptr) {
+    buffer.bytes_.reset(new uint8_t[buffer.capacity_]);
+  }
+  return buffer;
+}
+
+size_t GetNumPooledBytes() {
+  const Pool* pool = Pool::Get();
+  return pool != nullptr ? pool->num_bytes() : 0;
+}
+
+void SetMaxNumPooledBytes(size_t max_num_bytes) {
+  max_num_pooled_bytes = max_num_bytes;
+}
+
+size_t GetTotalNumPooledBytes() { return total_num_pooled_bytes; }
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,66 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_BUFFER_POOL_H_
+#define SRC_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace codec_compare_gen {
+
+// Uninitialized memory block. Given back at destruction to the pool of the
+// destroying thread, which keeps a few blocks of each size class for the next
+// GetPooledBuffer() calls of that thread, if it made any. This avoids mapping,
+// faulting and unmapping the pages of large images again for each task. The
+// pools of all threads together keep at most SetMaxNumPooledBytes().
+class PooledBuffer {
+ public:
+  PooledBuffer() = default;
+  PooledBuffer(PooledBuffer&& other) noexcept;
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+  ~PooledBuffer();
+
+  uint8_t* data() const { return bytes_.get(); }
+  size_t capacity() const { return capacity_; }
+
+ private:
+  friend PooledBuffer GetPooledBuffer(size_t num_bytes);
+  void Release();
+
+  std::unique_ptr<uint8_t[]> bytes_;
+  size_t capacity_ = 0;
+};
+
+// Returns a block of at least num_bytes, reused from the pool of the calling
+// thread if possible. The capacity is rounded up to a size class at most 25%
+// larger. Small blocks are not pooled because malloc() is fast enough.
+PooledBuffer GetPooledBuffer(size_t num_bytes);
+
+// Number of bytes kept in the pool of the calling thread and not in use.
+size_t GetNumPooledBytes();
+
+// Limits the number of bytes kept by the pools of all threads and not in use.
+// The blocks given back above that are freed instead. 0 disables pooling. Does
+// not free the blocks already kept.
+inline constexpr size_t kDefaultMaxNumPooledBytes = size_t{1} << 30;
+void SetMaxNumPooledBytes(size_t max_num_bytes);
+
+// Number of bytes kept by the pools of all threads and not in use.
+size_t GetTotalNumPooledBytes();
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_BUFFER_POOL_H_
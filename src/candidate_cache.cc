@@ -0,0 +1,79 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/candidate_cache.h"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// TaskInput::Serialize() ignores the number of codec threads and the encoded
+// path is irrelevant.
+std::string GetKey(const TaskInput& input) {
+  return TaskInput{input.codec_settings, input.image_path}.Serialize() + ", t" +
+         std::to_string(input.codec_settings.num_threads);
+}
+
+}  // namespace
+
+void CandidateCache::Expect(const TaskInput& candidate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++entries_[GetKey(candidate)].num_expected;
+}
+
+void CandidateCache::Insert(const TaskInput& input,
+                            std::string_view encoded_image,
+                            double encoding_duration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(GetKey(input));
+  if (it == entries_.end() || it->second.is_inserted) return;
+  it->second.is_inserted = true;
+  it->second.encoded_image = encoded_image;
+  it->second.encoding_duration = encoding_duration;
+}
+
+bool CandidateCache::Take(const TaskInput& candidate,
+                          std::string& encoded_image,
+                          double& encoding_duration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(GetKey(candidate));
+  if (it == entries_.end()) return false;
+  Entry& entry = it->second;
+  const bool is_inserted = entry.is_inserted;
+  if (is_inserted) {
+    encoded_image = entry.encoded_image;
+    encoding_duration = entry.encoding_duration;
+    ++num_hits_;
+  }
+  if (entry.num_expected <= 1) {
+    entries_.erase(it);
+  } else {
+    --entry.num_expected;
+  }
+  return is_inserted;
+}
+
+size_t CandidateCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,63 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_CANDIDATE_CACHE_H_
+#define SRC_CANDIDATE_CACHE_H_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Thread-safe encoded images of the tasks of a run that are also candidates of
+// its codec combination tasks, so that these do not encode the same bitstreams
+// again. An encoded image is only kept if it is expected, until it is taken.
+class CandidateCache {
+ public:
+  // Registers one future Take() of candidate.
+  void Expect(const TaskInput& candidate);
+  // Keeps a copy of the encoded_image of input if it is expected and not kept
+  // yet.
+  void Insert(const TaskInput& input, std::string_view encoded_image,
+              double encoding_duration);
+  // Copies the encoded image of candidate and its encoding duration. Returns
+  // false if it was not inserted yet. Either way, one expected Take() of
+  // candidate is consumed and the encoded image is released after the last.
+  bool Take(const TaskInput& candidate, std::string& encoded_image,
+            double& encoding_duration);
+
+  size_t num_hits() const;
+
+ private:
+  struct Entry {
+    size_t num_expected = 0;  // Remaining Take() calls.
+    bool is_inserted = false;
+    std::string encoded_image;
+    double encoding_duration = 0;
+  };
+
+  mutable std::mutex mutex_;  // Guards the fields below.
+  // By TaskInput::Serialize() and number of codec threads.
+  std::unordered_map<std::string, Entry> entries_;
+  size_t num_hits_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_CANDIDATE_CACHE_H_
@@ -16,12 +16,17 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -42,8 +47,14 @@
 #include "src/distortion.h"
 #include "src/frame.h"
 #include "src/framework.h"
+#include "src/image_cache.h"
+#include "src/image_header.h"
+#include "src/mapped_file.h"
+#include "src/resource_usage.h"
 #include "src/task.h"
+#include "src/temp_file_cache.h"
 #include "src/timer.h"
+#include "src/trace.h"
 
 #if defined(HAS_WEBP2)
 #include "third_party/libwebp2/src/wp2/base.h"
@@ -323,10 +334,6 @@ bool CodecIsSupportedByBrowsers(Codec codec) {
   return false;
 }
 
-#if defined(HAS_WEBP2)
-
-namespace {
-
 bool CodecSupportsBitDepth(Codec codec, uint32_t d) {
   switch (codec) {
     case Codec::kWebp:
@@ -362,6 +369,14 @@ bool CodecSupportsBitDepth(Codec codec, uint32_t d) {
   return false;
 }
 
+bool CodecSupportsRowDecoding(Codec codec) {
+  return codec == Codec::kJpegXl || codec == Codec::kJpegmoz;
+}
+
+#if defined(HAS_WEBP2)
+
+namespace {
+
 // Returns the 8-bit format layout required by the API of the given codec.
 WP2SampleFormat CodecToNeededFormat(Codec codec, bool has_transparency) {
   switch (codec) {
@@ -415,7 +430,7 @@ StatusOr<WP2::Data> EncodeAvifIq(const TaskInput& input,
                     /*ycgco_re=*/false, /*tune=*/"iq", /*avm=*/false, quiet);
 }
 StatusOr<std::pair<Image, double>> DecodeAvifRegularOrExp(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   return DecodeAvif(input, encoded_image, /*avm=*/false, quiet);
 }
 StatusOr<WP2::Data> EncodeAvifExp(const TaskInput& input,
@@ -429,174 +444,585 @@ StatusOr<WP2::Data> EncodeAvifAvm(const TaskInput& input,
                     /*ycgco_re=*/true, /*tune=*/nullptr, /*avm=*/true, quiet);
 }
 StatusOr<std::pair<Image, double>> DecodeAvifAvm(const TaskInput& input,
-                                                 const WP2::Data& encoded_image,
+                                                 WP2::DataView encoded_image,
                                                  bool quiet) {
   return DecodeAvif(input, encoded_image, /*avm=*/true, quiet);
 }
 
-}  // namespace
+using EncodeFunc = StatusOr<WP2::Data> (*)(const TaskInput& input,
+                                           const Image& original_image,
+                                           bool quiet);
 
-StatusOr<TaskOutput> EncodeDecode(const TaskInput& input,
-                                  const std::string& metric_binary_folder_path,
-                                  size_t thread_id, EncodeMode encode_mode,
-                                  bool quiet) {
-  TaskOutput task;
-  task.task_input = input;
+// Returns the encoding function of the codec, or nullptr.
+EncodeFunc GetEncodeFunc(Codec codec) {
+  return codec == Codec::kWebp          ? &EncodeWebp
+         : codec == Codec::kWebp2       ? &EncodeWebp2
+         : codec == Codec::kJpegXl      ? &EncodeJxl
+         : codec == Codec::kAvif        ? &EncodeAvifRegular
+         : codec == Codec::kAvifSsim    ? &EncodeAvifSsim
+         : codec == Codec::kAvifIq      ? &EncodeAvifIq
+         : codec == Codec::kAvifExp     ? &EncodeAvifExp
+         : codec == Codec::kAvifAvm     ? &EncodeAvifAvm
+         : codec == Codec::kAvifLibheif ? &EncodeAvifLibheif
+         : codec == Codec::kCombination ? &EncodeCodecCombination
+         : codec == Codec::kJpegturbo   ? &EncodeJpegturbo
+         : codec == Codec::kJpegli      ? &EncodeJpegli
+         : codec == Codec::kJpegsimple  ? &EncodeJpegsimple
+         : codec == Codec::kJpegmoz     ? &EncodeJpegmoz
+         : codec == Codec::kJp2         ? &EncodeOpenjpeg
+         : codec == Codec::kFfv1        ? &EncodeFfv1
+         : codec == Codec::kBasis       ? &EncodeBasis
+                                        : nullptr;
+}
 
-  const WP2SampleFormat initial_format = CodecToNeededFormat(
-      input.codec_settings.codec, /*has_transparency=*/true);
-  ASSIGN_OR_RETURN(Image original_image,
-                   ReadStillImageOrAnimation(input.image_path.c_str(),
-                                             initial_format, quiet));
+using DecodeFunc = StatusOr<std::pair<Image, double>> (*)(
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet);
+
+// Returns the decoding function of the codec, or nullptr.
+DecodeFunc GetDecodeFunc(Codec codec) {
+  return codec == Codec::kWebp          ? &DecodeWebp
+         : codec == Codec::kWebp2       ? &DecodeWebp2
+         : codec == Codec::kJpegXl      ? &DecodeJxl
+         : codec == Codec::kAvif        ? &DecodeAvifRegularOrExp
+         : codec == Codec::kAvifSsim    ? &DecodeAvifRegularOrExp
+         : codec == Codec::kAvifIq      ? &DecodeAvifRegularOrExp
+         : codec == Codec::kAvifExp     ? &DecodeAvifRegularOrExp
+         : codec == Codec::kAvifAvm     ? &DecodeAvifAvm
+         : codec == Codec::kAvifLibheif ? &DecodeAvifLibheif
+         : codec == Codec::kCombination ? &DecodeCodecCombination
+         : codec == Codec::kJpegturbo   ? &DecodeJpegturbo
+         : codec == Codec::kJpegli      ? &DecodeJpegli
+         : codec == Codec::kJpegsimple  ? &DecodeJpegsimple
+         : codec == Codec::kJpegmoz     ? &DecodeJpegmoz
+         : codec == Codec::kJp2         ? &DecodeOpenjpeg
+         : codec == Codec::kFfv1        ? &DecodeFfv1
+         : codec == Codec::kBasis       ? &DecodeBasis
+                                        : nullptr;
+}
+
+using DecodeRowsFunc = Status (*)(const TaskInput& input,
+                                  WP2::DataView encoded_image,
+                                  WP2SampleFormat format,
+                                  const RowCallback& on_row, bool quiet);
+
+// Returns the row decoding function of the codec, or nullptr.
+// Matches CodecSupportsRowDecoding().
+DecodeRowsFunc GetDecodeRowsFunc(Codec codec) {
+  return codec == Codec::kJpegXl    ? &DecodeJxlRows
+         : codec == Codec::kJpegmoz ? &DecodeJpegmozRows
+                                    : nullptr;
+}
+
+// Returns ReadStillImageOrAnimation(image_path, format), owned by the caller,
+// who can convert it in place.
+StatusOr<Image> ReadOriginalImage(const std::string& image_path,
+                                  WP2SampleFormat format, bool quiet) {
+  TraceScope trace("read image");
+  return ReadStillImageOrAnimation(image_path.c_str(), format, quiet);
+}
 
+// Returns the sample format needed by the codec of input for the original
+// image read in format, dropping alpha if the image is opaque.
+StatusOr<WP2SampleFormat> GetFormatForCodec(const TaskInput& input,
+                                            const Image& original,
+                                            WP2SampleFormat format,
+                                            bool is_known_opaque, bool quiet) {
   bool has_transparency = false;
-  for (const Frame& frame : original_image) {
-    has_transparency |= frame.pixels.HasTransparency();
+  if (!is_known_opaque) {
+    for (const Frame& frame : original) {
+      has_transparency |= frame.pixels.HasTransparency();
+    }
   }
-  WP2SampleFormat needed_format =
+  const WP2SampleFormat needed_format =
       CodecToNeededFormat(input.codec_settings.codec, has_transparency);
-  if (initial_format != needed_format) {
-    needed_format = WP2FormatAtbpc(
-        needed_format, WP2Formatbpc(original_image.front().pixels.format()));
-    CHECK_OR_RETURN(needed_format != WP2_FORMAT_NUM, quiet);
-    // Ditch alpha if the image is opaque.
-    ASSIGN_OR_RETURN(original_image,
-                     CloneAs(original_image, needed_format, quiet));
+  if (needed_format == format) return format;
+  WP2SampleFormat format_at_bit_depth = WP2FormatAtbpc(
+      needed_format, WP2Formatbpc(original.front().pixels.format()));
+  CHECK_OR_RETURN(format_at_bit_depth != WP2_FORMAT_NUM, quiet);
+  return format_at_bit_depth;
+}
+
+// Returns true if the codec of input does not support the 16-bit original
+// image, whose frames must then be considered 8-bit and twice as large. The
+// compression rate is likely terrible.
+bool NeedsSpreadTo8bit(const TaskInput& input, uint32_t bit_depth) {
+  return bit_depth == 16 &&
+         !CodecSupportsBitDepth(input.codec_settings.codec, 16) &&
+         input.codec_settings.quality == kQualityLossless;
+}
+
+// Same as ReadImageForCodec() through the cache, where each step is a
+// distinct entry shared by all tasks needing it.
+StatusOr<std::shared_ptr<const Image>> ReadCachedImageForCodec(
+    const TaskInput& input, WP2SampleFormat initial_format,
+    bool is_known_opaque, ImageCache& cache, bool quiet) {
+  TraceScope trace("read image");
+  if (input.image_header.IsKnown() &&
+      NeedsSpreadTo8bit(input, input.image_header.bit_depth) &&
+      CodecToNeededFormat(input.codec_settings.codec,
+                          /*has_transparency=*/false) == initial_format) {
+    // The format does not depend on the pixels. Only cache the spread image
+    // rather than the unspread one too.
+    return cache.Get(input.image_path, initial_format, initial_format, quiet,
+                     /*spread_to_8bit=*/true);
   }
-  if (WP2Formatbpc(original_image.front().pixels.format()) == 16 &&
-      !CodecSupportsBitDepth(input.codec_settings.codec, 16) &&
-      input.codec_settings.quality == kQualityLossless) {
-    // The codec does not support 16-bit images. Consider the frames to be 8-bit
-    // and twice as large. The compression rate is likely terrible.
-    ASSIGN_OR_RETURN(original_image, SpreadTo8bit(original_image, quiet));
+  ASSIGN_OR_RETURN(
+      std::shared_ptr<const Image> original,
+      cache.Get(input.image_path, initial_format, initial_format, quiet));
+  ASSIGN_OR_RETURN(const WP2SampleFormat format,
+                   GetFormatForCodec(input, *original, initial_format,
+                                     is_known_opaque, quiet));
+  if (format != initial_format) {
+    ASSIGN_OR_RETURN(original, cache.Get(input.image_path, initial_format,
+                                         format, quiet));
+  }
+  if (NeedsSpreadTo8bit(input,
+                        WP2Formatbpc(original->front().pixels.format()))) {
+    ASSIGN_OR_RETURN(original,
+                     cache.Get(input.image_path, initial_format, format, quiet,
+                               /*spread_to_8bit=*/true));
+  }
+  return original;
+}
+
+// Returns the half-width of the 95% confidence interval of the mean of the
+// durations, relative to that mean. Infinite if there are fewer than 2.
+double RelativeConfidenceInterval(const std::vector<double>& durations) {
+  if (durations.size() < 2) return std::numeric_limits<double>::infinity();
+  double mean = 0;
+  for (double duration : durations) mean += duration;
+  mean /= durations.size();
+  if (mean <= 0) return 0;
+  // Two-sided Student's t-distribution quantiles for 1 to 10 degrees of
+  // freedom, approximated above.
+  static constexpr double kTQuantiles[] = {12.71, 4.30, 3.18, 2.78, 2.57,
+                                           2.45,  2.36, 2.31, 2.26, 2.23};
+  const size_t degrees_of_freedom = durations.size() - 1;
+  const double t = degrees_of_freedom <= 10
+                       ? kTQuantiles[degrees_of_freedom - 1]
+                       : 1.96 + 2.4 / degrees_of_freedom;
+  return t * StandardDeviation(durations) / std::sqrt(durations.size()) /
+         mean;
+}
+
+}  // namespace
+
+StatusOr<std::shared_ptr<const Image>> ReadImageForCodec(
+    const TaskInput& input, ImageCache* original_image_cache, bool quiet) {
+  // Read opaque files straight into the opaque format rather than reading them
+  // with an alpha channel and then converting the whole image to drop it.
+  // The header is probed at planning time, except for tasks received from a
+  // remote server for example.
+  const bool is_known_opaque =
+      input.image_header.IsKnown()
+          ? input.image_header.IsKnownOpaque()
+          : ProbeImageHeader(input.image_path).IsKnownOpaque();
+  const WP2SampleFormat initial_format = CodecToNeededFormat(
+      input.codec_settings.codec, /*has_transparency=*/!is_known_opaque);
+  std::shared_ptr<const Image> original;
+  if (original_image_cache != nullptr) {
+    ASSIGN_OR_RETURN(original,
+                     ReadCachedImageForCodec(input, initial_format,
+                                             is_known_opaque,
+                                             *original_image_cache, quiet));
+  } else {
+    // Read for this task only, so it is converted in place.
+    ASSIGN_OR_RETURN(Image image, ReadOriginalImage(input.image_path,
+                                                    initial_format, quiet));
+    ASSIGN_OR_RETURN(const WP2SampleFormat format,
+                     GetFormatForCodec(input, image, initial_format,
+                                       is_known_opaque, quiet));
+    if (format != initial_format) {
+      TraceScope trace("convert image");
+      ASSIGN_OR_RETURN(image, CloneAs(image, format, quiet));
+    }
+    if (NeedsSpreadTo8bit(input,
+                          WP2Formatbpc(image.front().pixels.format()))) {
+      // Reinterpret its memory instead of holding a spread copy next to it.
+      TraceScope trace("convert image");
+      ASSIGN_OR_RETURN(image, SpreadTo8bit(std::move(image), quiet));
+    }
+    original = std::make_shared<const Image>(std::move(image));
   }
   CHECK_OR_RETURN(CodecSupportsBitDepth(
                       input.codec_settings.codec,
-                      WP2Formatbpc(original_image.front().pixels.format())),
+                      WP2Formatbpc(original->front().pixels.format())),
                   quiet);
+  return original;
+}
+
+StatusOr<WP2::Data> EncodeWithCodec(const TaskInput& input,
+                                    const Image& original_image, bool quiet) {
+  const EncodeFunc encode_func = GetEncodeFunc(input.codec_settings.codec);
+  CHECK_OR_RETURN(encode_func != nullptr, quiet);
+  return encode_func(input, original_image, quiet);
+}
 
-  auto encode_func =
-      input.codec_settings.codec == Codec::kWebp          ? &EncodeWebp
-      : input.codec_settings.codec == Codec::kWebp2       ? &EncodeWebp2
-      : input.codec_settings.codec == Codec::kJpegXl      ? &EncodeJxl
-      : input.codec_settings.codec == Codec::kAvif        ? &EncodeAvifRegular
-      : input.codec_settings.codec == Codec::kAvifSsim    ? &EncodeAvifSsim
-      : input.codec_settings.codec == Codec::kAvifIq      ? &EncodeAvifIq
-      : input.codec_settings.codec == Codec::kAvifExp     ? &EncodeAvifExp
-      : input.codec_settings.codec == Codec::kAvifAvm     ? &EncodeAvifAvm
-      : input.codec_settings.codec == Codec::kAvifLibheif ? &EncodeAvifLibheif
-      : input.codec_settings.codec == Codec::kCombination
-          ? &EncodeCodecCombination
-      : input.codec_settings.codec == Codec::kJpegturbo  ? &EncodeJpegturbo
-      : input.codec_settings.codec == Codec::kJpegli     ? &EncodeJpegli
-      : input.codec_settings.codec == Codec::kJpegsimple ? &EncodeJpegsimple
-      : input.codec_settings.codec == Codec::kJpegmoz    ? &EncodeJpegmoz
-      : input.codec_settings.codec == Codec::kJp2        ? &EncodeOpenjpeg
-      : input.codec_settings.codec == Codec::kFfv1       ? &EncodeFfv1
-      : input.codec_settings.codec == Codec::kBasis      ? &EncodeBasis
-                                                         : nullptr;
-  auto decode_func =
-      input.codec_settings.codec == Codec::kWebp       ? &DecodeWebp
-      : input.codec_settings.codec == Codec::kWebp2    ? &DecodeWebp2
-      : input.codec_settings.codec == Codec::kJpegXl   ? &DecodeJxl
-      : input.codec_settings.codec == Codec::kAvif     ? &DecodeAvifRegularOrExp
-      : input.codec_settings.codec == Codec::kAvifSsim ? &DecodeAvifRegularOrExp
-      : input.codec_settings.codec == Codec::kAvifIq   ? &DecodeAvifRegularOrExp
-      : input.codec_settings.codec == Codec::kAvifExp  ? &DecodeAvifRegularOrExp
-      : input.codec_settings.codec == Codec::kAvifAvm  ? &DecodeAvifAvm
-      : input.codec_settings.codec == Codec::kAvifLibheif ? &DecodeAvifLibheif
-      : input.codec_settings.codec == Codec::kCombination
-          ? &DecodeCodecCombination
-      : input.codec_settings.codec == Codec::kJpegturbo  ? &DecodeJpegturbo
-      : input.codec_settings.codec == Codec::kJpegli     ? &DecodeJpegli
-      : input.codec_settings.codec == Codec::kJpegsimple ? &DecodeJpegsimple
-      : input.codec_settings.codec == Codec::kJpegmoz    ? &DecodeJpegmoz
-      : input.codec_settings.codec == Codec::kJp2        ? &DecodeOpenjpeg
-      : input.codec_settings.codec == Codec::kFfv1       ? &DecodeFfv1
-      : input.codec_settings.codec == Codec::kBasis      ? &DecodeBasis
-                                                         : nullptr;
+StatusOr<std::pair<Image, double>> DecodeWithCodec(const TaskInput& input,
+                                                   WP2::DataView encoded_image,
+                                                   bool quiet) {
+  const DecodeFunc decode_func = GetDecodeFunc(input.codec_settings.codec);
+  CHECK_OR_RETURN(decode_func != nullptr, quiet);
+  return decode_func(input, encoded_image, quiet);
+}
+
+StatusOr<DecodedTask> EncodeAndDecode(
+    const TaskInput& input, EncodeMode encode_mode,
+    const TimingSettings& timing, const ResourceUsageSettings& resource_usage,
+    ImageCache* original_image_cache, ArtifactWriter* artifact_writer,
+    CandidateCache* candidate_cache, uint64_t stream_rows_min_num_pixels,
+    bool quiet) {
+  DecodedTask decoded_task;
+  TaskOutput& task = decoded_task.task;
+  task.task_input = input;
+
+  ASSIGN_OR_RETURN(const std::shared_ptr<const Image> original,
+                   ReadImageForCodec(input, original_image_cache, quiet));
+  const Image& original_image = *original;
+
+  const EncodeFunc encode_func = GetEncodeFunc(input.codec_settings.codec);
+  const DecodeFunc decode_func = GetDecodeFunc(input.codec_settings.codec);
+  // The decoded PNG needs the whole decoded image.
+  const WP2::ArgbBuffer& original_pixels = original_image.front().pixels;
+  const DecodeRowsFunc decode_rows_func =
+      stream_rows_min_num_pixels > 0 && original_image.size() == 1 &&
+              uint64_t{original_pixels.width()} * original_pixels.height() >=
+                  stream_rows_min_num_pixels &&
+              (encode_mode != EncodeMode::kEncodeAndSaveToDisk ||
+               CodecIsSupportedByBrowsers(input.codec_settings.codec))
+          ? GetDecodeRowsFunc(input.codec_settings.codec)
+          : nullptr;
+  // Returns the decoded image and the color conversion duration, or an empty
+  // image if the rows are streamed to on_row instead.
+  const auto decode = [&](WP2::DataView encoded_view,
+                          const RowCallback& on_row)
+      -> StatusOr<std::pair<Image, double>> {
+    if (decode_rows_func == nullptr) {
+      return decode_func(input, encoded_view, quiet);
+    }
+    OK_OR_RETURN(decode_rows_func(input, encoded_view,
+                                  original_pixels.format(), on_row, quiet));
+    return std::pair<Image, double>(Image(), 0);
+  };
+  const RowCallback discard_rows = [](uint32_t, uint32_t, uint32_t,
+                                      const void*) {};
+
+  // Warm up the caches, the allocator and the codec library before timing.
+  if (encode_mode != EncodeMode::kLoadFromDisk) {
+    CHECK_OR_RETURN(encode_func != nullptr, quiet);
+    for (uint32_t i = 0; i < timing.num_warmups; ++i) {
+      TraceScope trace("encode warmup");
+      ASSIGN_OR_RETURN(const WP2::Data warmup_encoded_image,
+                       encode_func(input, original_image, quiet));
+    }
+  }
 
+  // Opened before the codec threads are created so that they are counted.
+  ResourceUsageMeter meter(resource_usage);
+  meter.Start();
+  std::optional<TraceScope> encoding_trace(std::in_place, "encode");
   const Timer encoding_duration;
+  double reused_encoding_duration = 0;  // See CandidateCache.
   WP2::Data encoded_image;
+  MappedFile encoded_file;  // Decoded in place without any copy.
+  WP2::DataView encoded_view;
   if (encode_mode == EncodeMode::kLoadFromDisk) {
     CHECK_OR_RETURN(!task.task_input.encoded_path.empty(), quiet);
-    std::ifstream file{task.task_input.encoded_path, std::ios::binary};
-    CHECK_OR_RETURN(file.good(), quiet);
-    auto length{std::filesystem::file_size(task.task_input.encoded_path)};
-    CHECK_OR_RETURN(encoded_image.Resize(length, false) == WP2_STATUS_OK,
-                    quiet);
-    file.read(reinterpret_cast<char*>(encoded_image.bytes),
-              static_cast<long>(length));
+    OK_OR_RETURN(encoded_file.Open(task.task_input.encoded_path, quiet));
+    const std::string_view contents = encoded_file.contents();
+    CHECK_OR_RETURN(!contents.empty(), quiet)
+        << "Empty encoded file " << task.task_input.encoded_path;
+    encoded_view = {reinterpret_cast<const uint8_t*>(contents.data()),
+                    contents.size()};
+  } else if (input.codec_settings.codec == Codec::kCombination &&
+             candidate_cache != nullptr) {
+    ASSIGN_OR_RETURN(encoded_image, EncodeCodecCombinationWithCandidates(
+                                        input, original_image, candidate_cache,
+                                        reused_encoding_duration, quiet));
+    encoded_view = {encoded_image.bytes, encoded_image.size};
   } else {
     CHECK_OR_RETURN(encode_func != nullptr, quiet);
     ASSIGN_OR_RETURN(encoded_image, encode_func(input, original_image, quiet));
+    encoded_view = {encoded_image.bytes, encoded_image.size};
   }
-  task.encoding_duration = encoding_duration.seconds();
+  // As if the reused candidates were encoded one after the other.
+  task.encoding_duration =
+      encoding_duration.seconds() + reused_encoding_duration;
+  task.encoding_usage = meter.Stop();
+  encoding_trace.reset();
   task.image_width = original_image.front().pixels.width();
   task.image_height = original_image.front().pixels.height();
   task.bit_depth = WP2Formatbpc(original_image.front().pixels.format());
   task.num_frames = static_cast<uint32_t>(original_image.size());
-  task.encoded_size = encoded_image.size;
+  task.encoded_size = encoded_view.size;
+  decoded_task.encoded_digest = std::hash<std::string_view>()(std::string_view(
+      reinterpret_cast<const char*>(encoded_view.bytes), encoded_view.size));
 
+  CHECK_OR_RETURN(decode_func != nullptr, quiet);
+  for (uint32_t i = 0; i < timing.num_warmups; ++i) {
+    TraceScope trace("decode warmup");
+    ASSIGN_OR_RETURN(const auto warmup_decoded_image,
+                     decode(encoded_view, discard_rows));
+  }
+
+  meter.Start();
   const Timer decoding_duration;
   Image decoded_image;
-  CHECK_OR_RETURN(decode_func != nullptr, quiet);
   {
+    TraceScope trace("decode");
     ASSIGN_OR_RETURN(auto image_and_color_conversion_duration,
-                     decode_func(input, encoded_image, quiet));
+                     decode(encoded_view, discard_rows));
     decoded_image = std::move(image_and_color_conversion_duration.first);
     task.decoding_color_conversion_duration =
         image_and_color_conversion_duration.second;
   }
   task.decoding_duration = decoding_duration.seconds();
+  task.decoding_usage = meter.Stop();
+
+  if (timing.max_relative_error > 0) {
+    // Only time the repetitions. Their output is the same as above.
+    std::vector<double> encoding_durations = {task.encoding_duration};
+    std::vector<double> decoding_durations = {task.decoding_duration};
+    std::vector<double> color_conversion_durations = {
+        task.decoding_color_conversion_duration};
+    // Reading the encoded file from disk is not worth timing. A first encoding
+    // reusing candidates is not timed like a full encode_func() call, so both
+    // kinds of durations are not mixed.
+    const bool repeat_encoding = encode_mode != EncodeMode::kLoadFromDisk &&
+                                 reused_encoding_duration == 0;
+    const Timer repetitions_duration;
+    while (repetitions_duration.seconds() < timing.max_seconds) {
+      const bool time_encoding =
+          repeat_encoding && RelativeConfidenceInterval(encoding_durations) >
+                                 timing.max_relative_error;
+      const bool time_decoding =
+          RelativeConfidenceInterval(decoding_durations) >
+          timing.max_relative_error;
+      if (!time_encoding && !time_decoding) break;
+      if (time_encoding) {
+        TraceScope trace("encode repetition");
+        const Timer repetition_duration;
+        ASSIGN_OR_RETURN(const WP2::Data repeated_encoded_image,
+                         encode_func(input, original_image, quiet));
+        encoding_durations.push_back(repetition_duration.seconds());
+      }
+      if (time_decoding) {
+        TraceScope trace("decode repetition");
+        const Timer repetition_duration;
+        ASSIGN_OR_RETURN(const auto repeated_decoded_image,
+                         decode(encoded_view, discard_rows));
+        decoding_durations.push_back(repetition_duration.seconds());
+        color_conversion_durations.push_back(repeated_decoded_image.second);
+      }
+    }
+    task.encoding_duration =
+        AggregateDurations(encoding_durations, timing.statistic);
+    task.decoding_duration =
+        AggregateDurations(decoding_durations, timing.statistic);
+    task.decoding_color_conversion_duration =
+        AggregateDurations(color_conversion_durations, timing.statistic);
+  }
+  if (candidate_cache != nullptr && encode_mode != EncodeMode::kLoadFromDisk) {
+    candidate_cache->Insert(
+        input,
+        std::string_view(reinterpret_cast<const char*>(encoded_image.bytes),
+                         encoded_image.size),
+        task.encoding_duration);
+  }
 
   std::string decoded_path;
   if (encode_mode == EncodeMode::kEncodeAndSaveToDisk) {
     CHECK_OR_RETURN(!input.encoded_path.empty(), quiet);
-    std::ofstream(input.encoded_path, std::ios::binary)
-        .write(reinterpret_cast<char*>(encoded_image.bytes),
-               encoded_image.size);
+    {
+      TraceScope trace("write encoded file");
+      std::ofstream(input.encoded_path, std::ios::binary)
+          .write(reinterpret_cast<char*>(encoded_image.bytes),
+                 encoded_image.size);
+    }
 
     // Some image formats are not supported by all major browsers.
     if (!CodecIsSupportedByBrowsers(input.codec_settings.codec)) {
       // Also write a PNG or WebP of the decoded image to disk for convenience.
       // Keep the PNG extension for the simplicity of the whole pipeline.
-      decoded_path = input.encoded_path + ".png";
-      OK_OR_RETURN(WriteStillImageOrAnimation(decoded_image,
-                                              decoded_path.c_str(), quiet));
+      if (artifact_writer != nullptr) {
+        // The copy is much faster than the compression.
+        TraceScope trace("copy artifact");
+        ASSIGN_OR_RETURN(Image copy,
+                         CloneAs(decoded_image,
+                                 decoded_image.front().pixels.format(), quiet));
+        artifact_writer->Write(std::move(copy), input.encoded_path + ".png");
+      } else {
+        decoded_path = input.encoded_path + ".png";
+        TraceScope trace("write artifact");
+        OK_OR_RETURN(WriteStillImageOrAnimation(decoded_image,
+                                                decoded_path.c_str(), quiet));
+      }
     }
   }
 
-  ASSIGN_OR_RETURN(const bool pixel_equality,
-                   PixelEquality(original_image, decoded_image, quiet));
+  std::optional<TraceScope> pixel_equality_trace(std::in_place,
+                                                 "pixel equality");
+  bool pixel_equality;
+  if (decode_rows_func != nullptr) {
+    // Decode once more, untimed, comparing the rows on the fly.
+    RowDistortion row_distortion(original_pixels);
+    ASSIGN_OR_RETURN(const auto compared_decoded_image,
+                     decode(encoded_view, [&](uint32_t x, uint32_t y,
+                                              uint32_t num_pixels,
+                                              const void* pixels) {
+                       row_distortion.AddRow(x, y, num_pixels, pixels);
+                     }));
+    ASSIGN_OR_RETURN(pixel_equality, row_distortion.PixelEquality(quiet));
+    ASSIGN_OR_RETURN(decoded_task.streamed_psnr, row_distortion.Psnr(quiet));
+  } else {
+    ASSIGN_OR_RETURN(pixel_equality,
+                     PixelEquality(original_image, decoded_image, quiet));
+  }
+  pixel_equality_trace.reset();
   if (task.task_input.codec_settings.quality == kQualityLossless &&
-      !pixel_equality) {
+      !pixel_equality && decoded_task.streamed_psnr.has_value()) {
+    CHECK_OR_RETURN(false, quiet)
+        << input.image_path << " encoded with "
+        << CodecName(task.task_input.codec_settings.codec)
+        << " was not decoded losslessly (PSNR " << *decoded_task.streamed_psnr
+        << "dB)";
+  } else if (task.task_input.codec_settings.quality == kQualityLossless &&
+             !pixel_equality) {
+    // PSNR is computed in-process and does not need any metric binary.
     ASSIGN_OR_RETURN(const float psnr,
                      GetAverageDistortion(
                          input.image_path, original_image, decoded_path,
-                         decoded_image, input, metric_binary_folder_path,
-                         DistortionMetric::kLibwebp2Psnr, thread_id, quiet));
+                         decoded_image, input,
+                         /*metric_binary_folder_path=*/"",
+                         DistortionMetric::kLibwebp2Psnr, /*thread_id=*/0,
+                         quiet));
     CHECK_OR_RETURN(false, quiet)
         << input.image_path << " encoded with "
         << CodecName(task.task_input.codec_settings.codec)
         << " was not decoded losslessly (PSNR " << psnr << "dB)";
   }
 
-  if (pixel_equality) {
+  decoded_task.original = std::move(original);
+  decoded_task.decoded = std::move(decoded_image);
+  decoded_task.decoded_path = std::move(decoded_path);
+  decoded_task.pixel_equality = pixel_equality;
+  return decoded_task;
+}
+
+StatusOr<TaskOutput> ComputeDistortions(
+    const DecodedTask& decoded_task,
+    const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& distortion_metrics, size_t thread_id,
+    uint32_t num_frame_threads, TempFileCache* reference_file_cache,
+    bool quiet) {
+  TraceScope trace("distortions");
+  TaskOutput task = decoded_task.task;
+  const TaskInput& input = task.task_input;
+  if (decoded_task.pixel_equality) {
     std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
               kNoDistortion);
+  } else if (decoded_task.streamed_psnr.has_value()) {
+    CHECK_OR_RETURN(distortion_metrics.size() == 1 &&
+                        distortion_metrics.front() ==
+                            DistortionMetric::kSamplePsnr,
+                    quiet)
+        << "Only SamplePSNR is computed on streamed rows";
+    std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+              kDistortionNotComputed);
+    task.distortions[static_cast<size_t>(DistortionMetric::kSamplePsnr)] =
+        *decoded_task.streamed_psnr;
   } else {
-    for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
-      ASSIGN_OR_RETURN(task.distortions[m],
-                       GetAverageDistortion(
-                           input.image_path, original_image, decoded_path,
-                           decoded_image, input, metric_binary_folder_path,
-                           static_cast<DistortionMetric>(m), thread_id, quiet));
+    std::vector<DistortionMetric> metrics = distortion_metrics;
+    if (metrics.empty()) {
+      for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+        const DistortionMetric metric = static_cast<DistortionMetric>(m);
+        if (IsComputedByDefault(metric)) metrics.push_back(metric);
+      }
+    }
+    ASSIGN_OR_RETURN(
+        const std::vector<float> distortions,
+        GetAverageDistortions(input.image_path, *decoded_task.original,
+                              decoded_task.decoded_path, decoded_task.decoded,
+                              input, metric_binary_folder_path, metrics,
+                              thread_id, num_frame_threads,
+                              reference_file_cache, quiet));
+    std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+              kDistortionNotComputed);
+    for (size_t i = 0; i < metrics.size(); ++i) {
+      task.distortions[static_cast<size_t>(metrics[i])] = distortions[i];
     }
   }
   return task;
 }
 
+StatusOr<TaskOutput> EncodeDecode(
+    const TaskInput& input, const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& distortion_metrics, size_t thread_id,
+    EncodeMode encode_mode, const TimingSettings& timing,
+    const ResourceUsageSettings& resource_usage,
+    ImageCache* original_image_cache, TempFileCache* reference_file_cache,
+    bool quiet) {
+  ASSIGN_OR_RETURN(const DecodedTask decoded_task,
+                   EncodeAndDecode(input, encode_mode, timing,
+                                   resource_usage, original_image_cache,
+                                   /*artifact_writer=*/nullptr,
+                                   /*candidate_cache=*/nullptr,
+                                   /*stream_rows_min_num_pixels=*/0, quiet));
+  return ComputeDistortions(decoded_task, metric_binary_folder_path,
+                            distortion_metrics, thread_id,
+                            /*num_frame_threads=*/1, reference_file_cache,
+                            quiet);
+}
+
+StatusOr<DecodingBenchmark> BenchmarkDecoding(const TaskInput& input,
+                                              uint32_t num_decodings,
+                                              uint32_t num_warmups,
+                                              bool quiet) {
+  CHECK_OR_RETURN(num_decodings > 0, quiet);
+  const DecodeFunc decode_func = GetDecodeFunc(input.codec_settings.codec);
+  CHECK_OR_RETURN(decode_func != nullptr, quiet);
+  CHECK_OR_RETURN(!input.encoded_path.empty(), quiet);
+  MappedFile encoded_file;
+  OK_OR_RETURN(encoded_file.Open(input.encoded_path, quiet));
+  const std::string_view contents = encoded_file.contents();
+  CHECK_OR_RETURN(!contents.empty(), quiet)
+      << "Empty encoded file " << input.encoded_path;
+  const WP2::DataView encoded_view = {
+      reinterpret_cast<const uint8_t*>(contents.data()), contents.size()};
+
+  DecodingBenchmark benchmark;
+  TaskOutput& task = benchmark.task;
+  task.task_input = input;
+  task.encoded_size = encoded_view.size;
+  task.encoding_duration = 0;
+  task.decoding_duration = 0;
+  task.decoding_color_conversion_duration = 0;
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+            kDistortionNotComputed);
+  for (uint32_t i = 0; i < std::max(num_warmups, 1u); ++i) {
+    // Also brings the pages of the mapped file into memory.
+    ASSIGN_OR_RETURN(const auto warmup_decoded_image,
+                     decode_func(input, encoded_view, quiet));
+    const Image& image = warmup_decoded_image.first;
+    CHECK_OR_RETURN(!image.empty(), quiet);
+    task.image_width = image.front().pixels.width();
+    task.image_height = image.front().pixels.height();
+    task.bit_depth = WP2Formatbpc(image.front().pixels.format());
+    task.num_frames = static_cast<uint32_t>(image.size());
+  }
+
+  benchmark.decoding_durations.reserve(num_decodings);
+  for (uint32_t i = 0; i < num_decodings; ++i) {
+    const Timer decoding_duration;
+    ASSIGN_OR_RETURN(const auto decoded_image,
+                     decode_func(input, encoded_view, quiet));
+    benchmark.decoding_durations.push_back(decoding_duration.seconds());
+  }
+  std::sort(benchmark.decoding_durations.begin(),
+            benchmark.decoding_durations.end());
+  return benchmark;
+}
+
 #else
 
 StatusOr<TaskOutput> EncodeDecode(const TaskInput&, bool quiet) {
@@ -16,11 +16,21 @@
 #define SRC_CODEC_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "src/artifact_writer.h"
 #include "src/base.h"
+#include "src/candidate_cache.h"
+#include "src/frame.h"
+#include "src/image_cache.h"
+#include "src/resource_usage.h"
 #include "src/task.h"
+#include "src/temp_file_cache.h"
 
 namespace codec_compare_gen {
 
@@ -32,13 +42,91 @@ StatusOr<Codec> CodecFromName(const std::string& name, bool quiet);
 std::vector<int> CodecLossyQualities(Codec codec);
 std::string CodecExtension(Codec codec);
 bool CodecIsSupportedByBrowsers(Codec codec);
+// Returns true if the codec encodes the samples of the given depth as is.
+bool CodecSupportsBitDepth(Codec codec, uint32_t bit_depth);
+// Returns true if the still images of the codec can be decoded row by row
+// without holding the whole decoded image. See RowCallback.
+bool CodecSupportsRowDecoding(Codec codec);
 
 enum class EncodeMode { kEncode, kEncodeAndSaveToDisk, kLoadFromDisk };
 
-StatusOr<TaskOutput> EncodeDecode(const TaskInput& input,
-                                  const std::string& metric_binary_folder_path,
-                                  size_t thread_id, EncodeMode encode_mode,
-                                  bool quiet);
+// Encoded and decoded task, before its distortions are computed.
+struct DecodedTask {
+  TaskOutput task;  // All fields are set but the distortions.
+  std::shared_ptr<const Image> original;
+  Image decoded;
+  std::string decoded_path;  // PNG file of decoded. Can be empty.
+  bool pixel_equality = false;
+  // Set instead of decoded if the rows were compared to the original as they
+  // were decoded. Only kSamplePsnr is available then.
+  std::optional<float> streamed_psnr;
+  size_t encoded_digest = 0;  // Hash of the encoded bytes. See RepetitionCache.
+};
+
+// Reads the original image of input through original_image_cache if not null,
+// in the sample format and bit depth expected by its codec, as encoded by
+// EncodeAndDecode().
+StatusOr<std::shared_ptr<const Image>> ReadImageForCodec(
+    const TaskInput& input, ImageCache* original_image_cache, bool quiet);
+
+#if defined(HAS_WEBP2)
+// Calls the encoding or the decoding function of the codec of input once,
+// without any timing. The original_image must come from ReadImageForCodec().
+// Used to profile the codec adapters in isolation, see tools/ccgen_bench.cc.
+StatusOr<WP2::Data> EncodeWithCodec(const TaskInput& input,
+                                    const Image& original_image, bool quiet);
+StatusOr<std::pair<Image, double>> DecodeWithCodec(const TaskInput& input,
+                                                   WP2::DataView encoded_image,
+                                                   bool quiet);
+#endif  // HAS_WEBP2
+
+// First part of EncodeDecode(): everything but the distortion metrics.
+// The encoding and the decoding are repeated as specified by timing, reusing
+// the same original image. The encoded size is the one of the first measured
+// encoding. The resource_usage is measured around the first measured encoding
+// and decoding. If artifact_writer is not null, the decoded PNG (see
+// EncodeDecode()) is written asynchronously and decoded_path is left empty.
+// If stream_rows_min_num_pixels is not 0, the still images of at least that
+// many pixels are decoded row by row if CodecSupportsRowDecoding() and no
+// decoded PNG is needed, and the rows are compared to the original as they
+// are decoded (see DecodedTask::streamed_psnr). The timed decodings discard
+// the rows.
+StatusOr<DecodedTask> EncodeAndDecode(
+    const TaskInput& input, EncodeMode encode_mode,
+    const TimingSettings& timing, const ResourceUsageSettings& resource_usage,
+    ImageCache* original_image_cache, ArtifactWriter* artifact_writer,
+    CandidateCache* candidate_cache, uint64_t stream_rows_min_num_pixels,
+    bool quiet);
+// Second part of EncodeDecode(), which can run in another thread.
+// If decoded_task.streamed_psnr is set, the distortion_metrics must be
+// kSamplePsnr only.
+StatusOr<TaskOutput> ComputeDistortions(
+    const DecodedTask& decoded_task,
+    const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& distortion_metrics, size_t thread_id,
+    uint32_t num_frame_threads, TempFileCache* reference_file_cache,
+    bool quiet);
+
+// Only the distortion_metrics are computed, or all the ones
+// IsComputedByDefault() if empty.
+// The original image is read through original_image_cache if not null.
+// The PNG files of the original frames given to the metric binaries are shared
+// through reference_file_cache if not null.
+StatusOr<TaskOutput> EncodeDecode(
+    const TaskInput& input, const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& distortion_metrics, size_t thread_id,
+    EncodeMode encode_mode, const TimingSettings& timing,
+    const ResourceUsageSettings& resource_usage,
+    ImageCache* original_image_cache, TempFileCache* reference_file_cache,
+    bool quiet);
+
+// Loads input.encoded_path into memory once and decodes it num_decodings times
+// back-to-back, after num_warmups discarded decodings (at least one, so that
+// the timed ones run with warm caches).
+StatusOr<DecodingBenchmark> BenchmarkDecoding(const TaskInput& input,
+                                              uint32_t num_decodings,
+                                              uint32_t num_warmups,
+                                              bool quiet);
 
 }  // namespace codec_compare_gen
 
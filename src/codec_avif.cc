@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "src/base.h"
+#include "src/codec_context.h"
 #include "src/frame.h"
 #include "src/serialization.h"
 #include "src/task.h"
@@ -155,6 +156,19 @@ class RwData : public avifRWData {
   ~RwData() { avifRWDataFree(this); }
 };
 
+// Returns owned_decoder, or a decoder kept by the calling thread if
+// ReuseCodecContexts(). avifDecoderParse() resets it. Can be null.
+// avifEncoder cannot be reused once finished so it is always created.
+avifDecoder* GetDecoder(avif::DecoderPtr& owned_decoder) {
+  if (!ReuseCodecContexts()) {
+    owned_decoder.reset(avifDecoderCreate());
+    return owned_decoder.get();
+  }
+  thread_local avif::DecoderPtr reused_decoder;
+  if (reused_decoder == nullptr) reused_decoder.reset(avifDecoderCreate());
+  return reused_decoder.get();
+}
+
 }  // namespace
 
 StatusOr<WP2::Data> EncodeAvif(const TaskInput& input,
@@ -166,6 +180,7 @@ StatusOr<WP2::Data> EncodeAvif(const TaskInput& input,
   avif::EncoderPtr encoder(avifEncoderCreate());
   CHECK_OR_RETURN(encoder != nullptr, quiet) << "avifEncoderCreate() failed";
   encoder->speed = input.codec_settings.effort;  // Simpler not to reverse.
+  encoder->maxThreads = static_cast<int>(input.codec_settings.num_threads);
   encoder->quality =
       lossless ? AVIF_QUALITY_LOSSLESS : input.codec_settings.quality;
   encoder->qualityAlpha = encoder->quality;
@@ -212,16 +227,18 @@ StatusOr<WP2::Data> EncodeAvif(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeAvif(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool avm, bool quiet) {
-  avif::DecoderPtr decoder(avifDecoderCreate());
+  avif::DecoderPtr owned_decoder;
+  avifDecoder* decoder = GetDecoder(owned_decoder);
   CHECK_OR_RETURN(decoder != nullptr, quiet);
   decoder->codecChoice = avm ? AVIF_CODEC_CHOICE_AVM : AVIF_CODEC_CHOICE_AUTO;
+  decoder->maxThreads = static_cast<int>(input.codec_settings.num_threads);
 
-  CHECK_OR_RETURN(avifDecoderSetIOMemory(decoder.get(), encoded_image.bytes,
+  CHECK_OR_RETURN(avifDecoderSetIOMemory(decoder, encoded_image.bytes,
                                          encoded_image.size) == AVIF_RESULT_OK,
                   quiet);
-  CHECK_OR_RETURN(avifDecoderParse(decoder.get()) == AVIF_RESULT_OK, quiet)
+  CHECK_OR_RETURN(avifDecoderParse(decoder) == AVIF_RESULT_OK, quiet)
       << "avifDecoderParse() failed: " << decoder->diag.error;
   if (decoder->imageCount > 1) {
     CHECK_OR_RETURN(decoder->timescale == 1000, quiet) << decoder->timescale;
@@ -231,7 +248,7 @@ StatusOr<std::pair<Image, double>> DecodeAvif(const TaskInput& input,
   image.reserve(decoder->imageCount);
   avifResult result;
   double color_conversion_duration = 0;
-  while ((result = avifDecoderNextImage(decoder.get())) == AVIF_RESULT_OK) {
+  while ((result = avifDecoderNextImage(decoder)) == AVIF_RESULT_OK) {
     const Timer timer;
     ASSIGN_OR_RETURN(WP2::ArgbBuffer buffer,
                      AvifImageToArgbBuffer(*decoder->image, quiet));
@@ -251,7 +268,7 @@ StatusOr<WP2::Data> EncodeAvif(const TaskInput&, const Image&, bool, bool, bool,
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_AVIF";
 }
 StatusOr<std::pair<Image, double>> DecodeAvif(const TaskInput&,
-                                              const WP2::Data&, bool,
+                                              WP2::DataView, bool,
                                               bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_AVIF";
 }
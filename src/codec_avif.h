@@ -40,7 +40,7 @@ StatusOr<WP2::Data> EncodeAvif(const TaskInput& input,
                                const char* tune, bool avm, bool quiet);
 // Returns the decoded image and the color conversion duration.
 StatusOr<std::pair<Image, double>> DecodeAvif(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool avm, bool quiet);
 #endif  // HAS_WEBP2
 
@@ -172,7 +172,8 @@ StatusOr<WP2::Data> EncodeAvifLibheif(const TaskInput& input,
   CHECK_OR_RETURN(err.code == heif_error_Ok, quiet)
       << "heif_encoder_set_param for speed failed: " << err.message;
 
-  err = heif_encoder_set_parameter_integer(encoder, "threads", 1);
+  err = heif_encoder_set_parameter_integer(
+      encoder, "threads", static_cast<int>(input.codec_settings.num_threads));
   CHECK_OR_RETURN(err.code == heif_error_Ok, quiet)
       << "heif_encoder_set_param for threads failed: " << err.message;
 
@@ -199,12 +200,16 @@ StatusOr<WP2::Data> EncodeAvifLibheif(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeAvifLibheif(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   heif_context* context = heif_context_alloc();
   CHECK_OR_RETURN(context != nullptr, quiet) << "heif_context_alloc failed";
   const HeifContext context_ptr(context, &heif_context_free);
 
-  heif_context_set_max_decoding_threads(context, 0);
+  // 0 decodes the tiles and the alpha plane on the calling thread.
+  heif_context_set_max_decoding_threads(
+      context, input.codec_settings.num_threads > 1
+                   ? static_cast<int>(input.codec_settings.num_threads)
+                   : 0);
 
   heif_error err = heif_context_read_from_memory_without_copy(
       context, encoded_image.bytes, encoded_image.size, nullptr);
@@ -230,7 +235,8 @@ StatusOr<std::pair<Image, double>> DecodeAvifLibheif(
   CHECK_OR_RETURN(options != nullptr, quiet)
       << "heif_decoding_options_alloc failed";
   const HeifDecodingOptions options_ptr(options, &heif_decoding_options_free);
-  options->num_codec_threads = 1;
+  options->num_codec_threads =
+      static_cast<int>(input.codec_settings.num_threads);
   options->ignore_transformations = true;  // There should be no transformation.
 
   heif_image* decoded = nullptr;
@@ -271,7 +277,7 @@ StatusOr<WP2::Data> EncodeAvifLibheif(const TaskInput&, const Image&,
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_HEIF";
 }
 StatusOr<std::pair<Image, double>> DecodeAvifLibheif(const TaskInput&,
-                                                     const WP2::Data&,
+                                                     WP2::DataView,
                                                      bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_HEIF";
 }
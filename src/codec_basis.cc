@@ -15,12 +15,14 @@
 #include "src/codec_basis.h"
 
 #include <cstdint>
+#include <memory>
 #include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "src/base.h"
+#include "src/codec_context.h"
 #include "src/frame.h"
 #include "src/serialization.h"
 #include "src/task.h"
@@ -99,11 +101,26 @@ StatusOr<WP2::Data> EncodeBasis(const TaskInput& input,
                                      pixels.height(), num_channels);
   params.m_quality_level = input.codec_settings.quality;
   params.m_mip_gen = false;
-  params.m_multithreading = false;
-
-  // There must be at least one thread on top of the calling thread apparently.
-  basisu::job_pool job_pool(/*num_threads=*/1);
-  params.m_pJob_pool = &job_pool;
+  params.m_multithreading = input.codec_settings.num_threads > 1;
+
+  // The calling thread counts as one. The transcoder is single-threaded.
+  // Its threads are kept for the next tasks if ReuseCodecContexts().
+  std::unique_ptr<basisu::job_pool> owned_job_pool;
+  std::unique_ptr<basisu::job_pool>* job_pool = &owned_job_pool;
+  if (ReuseCodecContexts()) {
+    thread_local std::unique_ptr<basisu::job_pool> reused_job_pool;
+    if (reused_job_pool != nullptr &&
+        reused_job_pool->get_total_threads() !=
+            input.codec_settings.num_threads) {
+      reused_job_pool.reset();
+    }
+    job_pool = &reused_job_pool;
+  }
+  if (*job_pool == nullptr) {
+    *job_pool =
+        std::make_unique<basisu::job_pool>(input.codec_settings.num_threads);
+  }
+  params.m_pJob_pool = job_pool->get();
 
   // Uncomment for debugging.
   // params.m_debug = true;
@@ -130,7 +147,7 @@ StatusOr<WP2::Data> EncodeBasis(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeBasis(const TaskInput& input,
-                                               const WP2::Data& encoded_image,
+                                               WP2::DataView encoded_image,
                                                bool quiet) {
   CHECK_OR_RETURN(encoded_image.size > 1, quiet);
   const uint8_t pad = encoded_image.bytes[0];
@@ -193,7 +210,7 @@ StatusOr<WP2::Data> EncodeBasis(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_BASIS";
 }
 StatusOr<std::pair<Image, double>> DecodeBasis(const TaskInput&,
-                                               const WP2::Data&, bool quiet) {
+                                               WP2::DataView, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_BASIS";
 }
 #endif  // HAS_BASIS
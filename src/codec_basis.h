@@ -46,7 +46,7 @@ std::vector<int> BasisLossyQualities();
 StatusOr<WP2::Data> EncodeBasis(const TaskInput& input,
                                 const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeBasis(const TaskInput& input,
-                                               const WP2::Data& encoded_image,
+                                               WP2::DataView encoded_image,
                                                bool quiet);
 #endif  // HAS_WEBP2
 
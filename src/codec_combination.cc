@@ -16,12 +16,16 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "src/base.h"
+#include "src/candidate_cache.h"
 #include "src/codec_jpegxl.h"
 #include "src/codec_webp.h"
 #include "src/codec_webp2.h"
@@ -45,6 +49,44 @@ std::vector<int> CodecCombinationLossyQualities() {
   return qualities;  // [5:95] so that every quality works with each codec.
 }
 
+std::vector<TaskInput> CodecCombinationCandidates(const TaskInput& input) {
+  struct CodecEffort {
+    Codec codec;
+    int effort;
+  };
+  constexpr CodecEffort kNone = {Codec::kCombination, -1};
+  constexpr int kMaxNumCodecs = 3;
+  constexpr int kMaxEffort = 9;
+  // Arbitrary mapping from input effort to codec combination.
+  constexpr CodecEffort kCombinations[kMaxEffort + 1][kMaxNumCodecs] = {
+      /*0=*/{{Codec::kJpegXl, /*effort=*/1}, kNone, kNone},
+      /*1=*/{{Codec::kWebp, 1}, kNone, kNone},
+      /*2=*/{{Codec::kWebp, 2}, kNone, kNone},
+      /*3=*/{{Codec::kWebp, 3}, kNone, kNone},
+      /*4=*/{{Codec::kWebp, 4}, kNone, kNone},
+      /*5=*/{{Codec::kWebp, 6}, kNone, kNone},
+      /*6=*/{{Codec::kWebp, 6}, {Codec::kJpegXl, 2}, kNone},
+      /*7=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 3}, {Codec::kJpegXl, 2}},
+      /*8=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 3}, {Codec::kJpegXl, 9}},
+      /*9=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 5}, {Codec::kJpegXl, 9}},
+  };
+  std::vector<TaskInput> candidates;
+  if (input.codec_settings.effort < 0 ||
+      input.codec_settings.effort > kMaxEffort) {
+    return candidates;
+  }
+  for (const CodecEffort& codec_effort :
+       kCombinations[input.codec_settings.effort]) {
+    if (codec_effort.effort == kNone.effort) break;
+    candidates.push_back(
+        {{codec_effort.codec, input.codec_settings.chroma_subsampling,
+          codec_effort.effort, input.codec_settings.quality,
+          input.codec_settings.num_threads},
+         input.image_path});
+  }
+  return candidates;
+}
+
 #if defined(HAS_WEBP2)
 
 namespace {
@@ -56,73 +98,137 @@ bool HasTransparency(const Image& image) {
   return false;
 }
 
-struct CodecEffort {
-  Codec codec;
-  int effort;
-};
+// Returns original_image if it is already in that format, or its copy converted
+// to that format and stored in conversions otherwise, or an existing one.
+StatusOr<const Image*> GetImageAs(
+    const Image& original_image, WP2SampleFormat format,
+    std::vector<std::pair<WP2SampleFormat, Image>>& conversions, bool quiet) {
+  if (std::all_of(original_image.begin(), original_image.end(),
+                  [format](const Frame& frame) {
+                    return frame.pixels.format() == format;
+                  })) {
+    return &original_image;
+  }
+  for (const auto& conversion : conversions) {
+    if (conversion.first == format) return &conversion.second;
+  }
+  ASSIGN_OR_RETURN(Image image, CloneAs(original_image, format, quiet));
+  conversions.emplace_back(format, std::move(image));
+  return &conversions.back().second;
+}
+
+StatusOr<WP2::Data> EncodeCandidate(const TaskInput& input, const Image& image,
+                                    bool quiet) {
+  if (input.codec_settings.codec == Codec::kWebp) {
+    return EncodeWebp(input, image, quiet);
+  }
+  if (input.codec_settings.codec == Codec::kWebp2) {
+    return EncodeWebp2(input, image, quiet);
+  }
+  assert(input.codec_settings.codec == Codec::kJpegXl);
+  return EncodeJxl(input, image, quiet);
+}
 
 }  // namespace
 
 StatusOr<WP2::Data> EncodeCodecCombination(const TaskInput& input,
                                            const Image& original_image,
                                            bool quiet) {
-  constexpr CodecEffort kNone = {Codec::kCombination, -1};
-  constexpr int kMaxNumCodecs = 3;
-  constexpr int kMaxEffort = 9;
-  // Arbitrary mapping from input effort to codec combination.
-  constexpr CodecEffort kCombinations[kMaxEffort + 1][kMaxNumCodecs] = {
-      /*0=*/{{Codec::kJpegXl, /*effort=*/1}, kNone, kNone},
-      /*1=*/{{Codec::kWebp, 1}, kNone, kNone},
-      /*2=*/{{Codec::kWebp, 2}, kNone, kNone},
-      /*3=*/{{Codec::kWebp, 3}, kNone, kNone},
-      /*4=*/{{Codec::kWebp, 4}, kNone, kNone},
-      /*5=*/{{Codec::kWebp, 6}, kNone, kNone},
-      /*6=*/{{Codec::kWebp, 6}, {Codec::kJpegXl, 2}, kNone},
-      /*7=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 3}, {Codec::kJpegXl, 2}},
-      /*8=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 3}, {Codec::kJpegXl, 9}},
-      /*9=*/{{Codec::kWebp, 6}, {Codec::kWebp2, 5}, {Codec::kJpegXl, 9}},
-  };
-  CHECK_OR_RETURN(input.codec_settings.effort >= 0 &&
-                      input.codec_settings.effort <= kMaxEffort,
-                  quiet)
-      << "Invalid effort " << input.codec_settings.effort;
-  const CodecEffort* combination = kCombinations[input.codec_settings.effort];
+  double reused_encoding_duration = 0;
+  return EncodeCodecCombinationWithCandidates(input, original_image,
+                                              /*candidate_cache=*/nullptr,
+                                              reused_encoding_duration, quiet);
+}
 
-  WP2::Data data;
-  for (int i = 0; i < kMaxNumCodecs; ++i) {
-    const TaskInput specialized_input = {
-        {combination[i].codec, input.codec_settings.chroma_subsampling,
-         combination[i].effort, input.codec_settings.quality},
-        input.image_path};
-    if (specialized_input.codec_settings.effort == kNone.effort) break;
+StatusOr<WP2::Data> EncodeCodecCombinationWithCandidates(
+    const TaskInput& input, const Image& original_image,
+    CandidateCache* candidate_cache, double& reused_encoding_duration,
+    bool quiet) {
+  const std::vector<TaskInput> specialized_inputs =
+      CodecCombinationCandidates(input);
+  CHECK_OR_RETURN(!specialized_inputs.empty(), quiet)
+      << "Invalid effort " << input.codec_settings.effort;
+  const size_t num_candidates = specialized_inputs.size();
+  std::vector<WP2::Data> candidates(num_candidates);
 
-    using std::swap;
-    if (specialized_input.codec_settings.codec == Codec::kWebp) {
-      ASSIGN_OR_RETURN(const Image image,
-                       CloneAs(original_image, WebPPictureFormat(), quiet));
-      ASSIGN_OR_RETURN(WP2::Data candidate,
-                       EncodeWebp(specialized_input, image, quiet));
-      if (data.IsEmpty() || candidate.size < data.size) swap(data, candidate);
-    } else if (specialized_input.codec_settings.codec == Codec::kWebp2) {
-      ASSIGN_OR_RETURN(WP2::Data candidate,
-                       EncodeWebp2(specialized_input, original_image, quiet));
-      if (data.IsEmpty() || candidate.size < data.size) swap(data, candidate);
+  // Candidates already encoded by other tasks of the same run.
+  std::vector<size_t> encoded_indices;
+  for (size_t i = 0; i < num_candidates; ++i) {
+    std::string encoded_image;
+    double encoding_duration;
+    if (candidate_cache != nullptr &&
+        candidate_cache->Take(specialized_inputs[i], encoded_image,
+                              encoding_duration)) {
+      CHECK_OR_RETURN(
+          candidates[i].CopyFrom(
+              reinterpret_cast<const uint8_t*>(encoded_image.data()),
+              encoded_image.size()) == WP2_STATUS_OK,
+          quiet);
+      reused_encoding_duration += encoding_duration;
     } else {
-      assert(specialized_input.codec_settings.codec == Codec::kJpegXl);
+      encoded_indices.push_back(i);
+    }
+  }
+
+  // Convert the original image once per required format, before encoding.
+  std::vector<std::pair<WP2SampleFormat, Image>> conversions;
+  conversions.reserve(num_candidates);  // Keeps the pointers below valid.
+  std::vector<const Image*> images(num_candidates, nullptr);
+  for (size_t i : encoded_indices) {
+    const Codec codec = specialized_inputs[i].codec_settings.codec;
+    const Image* image = &original_image;
+    if (codec == Codec::kWebp) {
+      ASSIGN_OR_RETURN(image, GetImageAs(original_image, WebPPictureFormat(),
+                                         conversions, quiet));
+    } else if (codec == Codec::kJpegXl) {
       const WP2SampleFormat jxl_format =
           HasTransparency(original_image) ? WP2_RGBA_32 : WP2_RGB_24;
-      ASSIGN_OR_RETURN(const Image image,
-                       CloneAs(original_image, jxl_format, quiet));
-      ASSIGN_OR_RETURN(WP2::Data candidate,
-                       EncodeJxl(specialized_input, image, quiet));
-      if (data.IsEmpty() || candidate.size < data.size) swap(data, candidate);
+      ASSIGN_OR_RETURN(image, GetImageAs(original_image, jxl_format,
+                                         conversions, quiet));
+    }
+    images[i] = image;
+  }
+
+  // The candidates are independent. Encode them concurrently if the task is
+  // allowed to use several threads.
+  std::vector<Status> statuses(num_candidates, Status::kOk);
+  const auto encode = [&](size_t i) {
+    StatusOr<WP2::Data> candidate =
+        EncodeCandidate(specialized_inputs[i], *images[i], quiet);
+    statuses[i] = candidate.status;
+    if (candidate.status == Status::kOk) {
+      candidates[i] = std::move(candidate.value);
+    }
+  };
+  if (input.codec_settings.num_threads > 1 && encoded_indices.size() > 1) {
+    std::vector<std::thread> threads;
+    threads.reserve(encoded_indices.size() - 1);
+    for (size_t j = 1; j < encoded_indices.size(); ++j) {
+      threads.emplace_back(encode, encoded_indices[j]);
+    }
+    encode(encoded_indices.front());
+    for (std::thread& thread : threads) thread.join();
+  } else {
+    for (size_t i : encoded_indices) {
+      encode(i);
+      OK_OR_RETURN(statuses[i]);
+    }
+  }
+
+  // Same choice as if encoded sequentially: the first smallest one.
+  WP2::Data data;
+  for (size_t i = 0; i < num_candidates; ++i) {
+    OK_OR_RETURN(statuses[i]);
+    using std::swap;
+    if (data.IsEmpty() || candidates[i].size < data.size) {
+      swap(data, candidates[i]);
     }
   }
   return data;
 }
 
 StatusOr<std::pair<Image, double>> DecodeCodecCombination(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   if (encoded_image.size >= 12 &&
       std::equal(encoded_image.bytes, encoded_image.bytes + 4, "RIFF") &&
       std::equal(encoded_image.bytes + 8, encoded_image.bytes + 12, "WEBP")) {
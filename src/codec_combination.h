@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "src/base.h"
+#include "src/candidate_cache.h"
 #include "src/frame.h"
 #include "src/task.h"
 
@@ -33,19 +34,31 @@ std::string CodecCombinationVersion();
 
 std::vector<int> CodecCombinationLossyQualities();
 
+// Returns the tasks encoded by EncodeCodecCombination() for input, or nothing
+// if input.codec_settings.effort is invalid.
+std::vector<TaskInput> CodecCombinationCandidates(const TaskInput& input);
+
 #if defined(HAS_WEBP2)
 
 // Tries encoding the original_image as WebP, WebP2 and/or JpegXL at various
 // efforts depending on input.codec_settings.effort. Returns the smallest
-// encoded payload.
+// encoded payload. The candidates are encoded concurrently if
+// input.codec_settings.num_threads is greater than 1.
 StatusOr<WP2::Data> EncodeCodecCombination(const TaskInput& input,
                                            const Image& original_image,
                                            bool quiet);
+// Same as EncodeCodecCombination() but the candidates found in candidate_cache
+// are not encoded again. Their recorded encoding durations are added to
+// reused_encoding_duration.
+StatusOr<WP2::Data> EncodeCodecCombinationWithCandidates(
+    const TaskInput& input, const Image& original_image,
+    CandidateCache* candidate_cache, double& reused_encoding_duration,
+    bool quiet);
 
 // Returns the encoded_image decoded by the first successful codec among WebP,
 // WebP2 and JpegXL and the color conversion duration.
 StatusOr<std::pair<Image, double>> DecodeCodecCombination(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet);
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet);
 
 #endif  // HAS_WEBP2
 
@@ -0,0 +1,29 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_CODEC_CONTEXT_H_
+#define SRC_CODEC_CONTEXT_H_
+
+namespace codec_compare_gen {
+
+// If true, which is the default, the codec adapters keep their encoder,
+// decoder and thread pool instances in thread-local storage and reset them for
+// the next task run by the same thread, instead of creating new ones for each
+// encoding and decoding. Disabling it measures the cold-start cost.
+void SetReuseCodecContexts(bool reuse);
+bool ReuseCodecContexts();
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_CODEC_CONTEXT_H_
@@ -126,7 +126,8 @@ StatusOr<WP2::Data> EncodeFfv1(const TaskInput& input,
   ffv1.context->height = static_cast<int>(pixels.height());
   ffv1.context->time_base = {1, 25};
   ffv1.context->framerate = {25, 1};
-  ffv1.context->thread_count = 1;
+  ffv1.context->thread_count =
+      static_cast<int>(input.codec_settings.num_threads);
   // TODO(yguyon): Support 16-bit.
   CHECK_OR_RETURN(WP2Formatbpc(pixels.format()) == 8, quiet);
   ffv1.context->pix_fmt =
@@ -185,7 +186,7 @@ StatusOr<WP2::Data> EncodeFfv1(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeFfv1(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool quiet) {
   CHECK_OR_RETURN(sizeof(Ffv1Container) < encoded_image.size, quiet);
   const Ffv1Container header{
@@ -210,7 +211,8 @@ StatusOr<std::pair<Image, double>> DecodeFfv1(const TaskInput& input,
   ffv1.context->pix_fmt = header.format;
   ffv1.context->time_base = {1, 25};
   ffv1.context->framerate = {25, 1};
-  ffv1.context->thread_count = 1;
+  ffv1.context->thread_count =
+      static_cast<int>(input.codec_settings.num_threads);
 
   // From AVCodecContext::extradata documentation:
   //   The allocated memory should be AV_INPUT_BUFFER_PADDING_SIZE bytes larger
@@ -260,7 +262,7 @@ StatusOr<WP2::Data> EncodeFfv1(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_FFV1";
 }
 StatusOr<std::pair<Image, double>> DecodeFfv1(const TaskInput&,
-                                              const WP2::Data&, bool quiet) {
+                                              WP2::DataView, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_FFV1";
 }
 #endif  // HAS_FFV1
@@ -37,7 +37,7 @@ std::string Ffv1Version();
 StatusOr<WP2::Data> EncodeFfv1(const TaskInput& input,
                                const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeFfv1(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool quiet);
 #endif  // HAS_WEBP2
 
@@ -157,7 +157,7 @@ StatusOr<WP2::Data> EncodeJpegli(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeJpegli(const TaskInput& input,
-                                                const WP2::Data& encoded_image,
+                                                WP2::DataView encoded_image,
                                                 bool quiet) {
   return DecodeJpegturbo(input, encoded_image, quiet);
 }
@@ -168,7 +168,7 @@ StatusOr<WP2::Data> EncodeJpegli(const TaskInput&, const Image&, bool quiet) {
       << "Encoding images requires HAS_JPEGXL and HAS_JPEGTURBO";
 }
 StatusOr<std::pair<Image, double>> DecodeJpegli(const TaskInput&,
-                                                const WP2::Data&, bool quiet) {
+                                                WP2::DataView, bool quiet) {
   CHECK_OR_RETURN(false, quiet)
       << "Decoding images requires HAS_JPEGXL and HAS_JPEGTURBO";
 }
@@ -37,7 +37,7 @@ std::vector<int> JpegliLossyQualities();
 StatusOr<WP2::Data> EncodeJpegli(const TaskInput& input,
                                  const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeJpegli(const TaskInput& input,
-                                                const WP2::Data& encoded_image,
+                                                WP2::DataView encoded_image,
                                                 bool quiet);
 #endif  // HAS_WEBP2
 
@@ -160,7 +160,7 @@ StatusOr<WP2::Data> EncodeJpegmoz(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeJpegmoz(const TaskInput& input,
-                                                 const WP2::Data& encoded_image,
+                                                 WP2::DataView encoded_image,
                                                  bool quiet) {
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -204,12 +204,57 @@ StatusOr<std::pair<Image, double>> DecodeJpegmoz(const TaskInput& input,
   return std::pair<Image, double>(std::move(image), 0);
 }
 
+Status DecodeJpegmozRows(const TaskInput& input, WP2::DataView encoded_image,
+                         WP2SampleFormat format, const RowCallback& on_row,
+                         bool quiet) {
+  CHECK_OR_RETURN(format == WP2_RGB_24, quiet);
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, encoded_image.bytes, encoded_image.size);
+  const int result = jpeg_read_header(&cinfo, TRUE);
+  if (result != 1) {
+    jpeg_destroy_decompress(&cinfo);
+    CHECK_OR_RETURN(false, quiet) << "jpeg_read_header() failed: " << result;
+  }
+  (void)jpeg_start_decompress(&cinfo);
+  if (cinfo.output_components != 3) {
+    jpeg_destroy_decompress(&cinfo);
+    CHECK_OR_RETURN(false, quiet)
+        << "output_components: " << cinfo.output_components;
+  }
+
+  // Only one row is held at a time.
+  std::vector<JSAMPLE> row(static_cast<size_t>(cinfo.output_width) *
+                           cinfo.output_components);
+  int num_scanlines = 0;
+  while (cinfo.output_scanline < cinfo.output_height) {
+    const uint32_t y = static_cast<uint32_t>(cinfo.output_scanline);
+    JSAMPROW row_pointer[1] = {row.data()};
+    num_scanlines = jpeg_read_scanlines(&cinfo, row_pointer, 1);
+    if (num_scanlines != 1) break;
+    on_row(/*x=*/0, y, static_cast<uint32_t>(cinfo.output_width), row.data());
+  }
+
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  CHECK_OR_RETURN(num_scanlines == 1, quiet)
+      << "num_scanlines: " << num_scanlines;
+  return Status::kOk;
+}
+
 #else
 StatusOr<WP2::Data> EncodeJpegmoz(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_JPEGMOZ";
 }
 StatusOr<std::pair<Image, double>> DecodeJpegmoz(const TaskInput&,
-                                                 const WP2::Data&, bool quiet) {
+                                                 WP2::DataView, bool quiet) {
+  CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_JPEGMOZ";
+}
+Status DecodeJpegmozRows(const TaskInput&, WP2::DataView, WP2SampleFormat,
+                         const RowCallback&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_JPEGMOZ";
 }
 #endif  // HAS_JPEGMOZ
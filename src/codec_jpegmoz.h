@@ -37,8 +37,13 @@ std::vector<int> JpegmozLossyQualities();
 StatusOr<WP2::Data> EncodeJpegmoz(const TaskInput& input,
                                   const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeJpegmoz(const TaskInput& input,
-                                                 const WP2::Data& encoded_image,
+                                                 WP2::DataView encoded_image,
                                                  bool quiet);
+// Same as DecodeJpegmoz() but hands out the rows to on_row one by one instead
+// of returning the whole image. The format must be WP2_RGB_24.
+Status DecodeJpegmozRows(const TaskInput& input, WP2::DataView encoded_image,
+                         WP2SampleFormat format, const RowCallback& on_row,
+                         bool quiet);
 #endif  // HAS_WEBP2
 
 }  // namespace codec_compare_gen
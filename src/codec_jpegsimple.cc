@@ -96,7 +96,7 @@ StatusOr<WP2::Data> EncodeJpegsimple(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeJpegsimple(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   return DecodeJpegturbo(input, encoded_image, quiet);
 }
 
@@ -107,7 +107,7 @@ StatusOr<WP2::Data> EncodeJpegsimple(const TaskInput&, const Image&,
       << "Encoding images requires HAS_JPEGSIMPLE and HAS_JPEGTURBO";
 }
 StatusOr<std::pair<Image, double>> DecodeJpegsimple(const TaskInput&,
-                                                    const WP2::Data&,
+                                                    WP2::DataView,
                                                     bool quiet) {
   CHECK_OR_RETURN(false, quiet)
       << "Decoding images requires HAS_JPEGSIMPLE and HAS_JPEGTURBO";
@@ -37,7 +37,7 @@ std::vector<int> JpegsimpleLossyQualities();
 StatusOr<WP2::Data> EncodeJpegsimple(const TaskInput& input,
                                      const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeJpegsimple(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet);
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet);
 #endif  // HAS_WEBP2
 
 }  // namespace codec_compare_gen
@@ -95,16 +95,17 @@ StatusOr<WP2::Data> EncodeJpegturbo(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeJpegturbo(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   int jpegSubsamp, width, height;
 
   const tjhandle handle = tjInitDecompress();
   CHECK_OR_RETURN(handle != nullptr, quiet) << "tjInitDecompress() failed";
 
-  int result =
-      tjDecompressHeader2(handle, encoded_image.bytes,
-                          static_cast<unsigned long>(encoded_image.size),
-                          &width, &height, &jpegSubsamp);
+  // The bytes are not modified, despite the signature.
+  int result = tjDecompressHeader2(
+      handle, const_cast<unsigned char*>(encoded_image.bytes),
+      static_cast<unsigned long>(encoded_image.size), &width, &height,
+      &jpegSubsamp);
   CHECK_OR_RETURN(result == 0, quiet)
       << "tjDecompressHeader2() failed with " << result;
 
@@ -135,7 +136,7 @@ StatusOr<WP2::Data> EncodeJpegturbo(const TaskInput&, const Image&,
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_JPEGTURBO";
 }
 StatusOr<std::pair<Image, double>> DecodeJpegturbo(const TaskInput&,
-                                                   const WP2::Data&,
+                                                   WP2::DataView,
                                                    bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_JPEGTURBO";
 }
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "src/base.h"
+#include "src/codec_context.h"
 #include "src/frame.h"
 #include "src/task.h"
 #include "src/timer.h"
@@ -38,6 +39,8 @@
 #include "third_party/libjxl/lib/include/jxl/decode_cxx.h"
 #include "third_party/libjxl/lib/include/jxl/encode.h"
 #include "third_party/libjxl/lib/include/jxl/encode_cxx.h"
+#include "third_party/libjxl/lib/include/jxl/thread_parallel_runner.h"
+#include "third_party/libjxl/lib/include/jxl/thread_parallel_runner_cxx.h"
 #include "third_party/libjxl/lib/include/jxl/types.h"
 #endif
 
@@ -82,6 +85,63 @@ size_t ArgbBufferSize(const WP2::ArgbBuffer& image) {
          static_cast<size_t>(image.width()) * WP2FormatBpp(image.format());
 }
 
+// Returns null if single-threaded, which is the default of libjxl. Otherwise
+// the runner is owned_runner, or kept by the calling thread if
+// ReuseCodecContexts().
+StatusOr<void*> GetRunner(const TaskInput& input,
+                          JxlThreadParallelRunnerPtr& owned_runner,
+                          bool quiet) {
+  const size_t num_threads = input.codec_settings.num_threads;
+  if (num_threads <= 1) return static_cast<void*>(nullptr);
+  JxlThreadParallelRunnerPtr* runner = &owned_runner;
+  if (ReuseCodecContexts()) {
+    thread_local JxlThreadParallelRunnerPtr reused_runner;
+    thread_local size_t reused_runner_num_threads = 0;
+    if (reused_runner_num_threads != num_threads) {
+      reused_runner.reset();
+      reused_runner_num_threads = num_threads;
+    }
+    runner = &reused_runner;
+  }
+  if (*runner == nullptr) {
+    *runner = JxlThreadParallelRunnerMake(nullptr, num_threads);
+    CHECK_OR_RETURN(*runner != nullptr, quiet)
+        << "JxlThreadParallelRunnerMake() failed";
+  }
+  return static_cast<void*>(runner->get());
+}
+
+// Returns owned_encoder, or a reset encoder kept by the calling thread if
+// ReuseCodecContexts(). Can be null.
+JxlEncoder* GetEncoder(JxlEncoderPtr& owned_encoder) {
+  if (!ReuseCodecContexts()) {
+    owned_encoder = JxlEncoderMake(nullptr);
+    return owned_encoder.get();
+  }
+  thread_local JxlEncoderPtr reused_encoder;
+  if (reused_encoder == nullptr) {
+    reused_encoder = JxlEncoderMake(nullptr);
+  } else {
+    JxlEncoderReset(reused_encoder.get());
+  }
+  return reused_encoder.get();
+}
+
+// Same as GetEncoder() for decoding.
+JxlDecoder* GetDecoder(JxlDecoderPtr& owned_decoder) {
+  if (!ReuseCodecContexts()) {
+    owned_decoder = JxlDecoderMake(nullptr);
+    return owned_decoder.get();
+  }
+  thread_local JxlDecoderPtr reused_decoder;
+  if (reused_decoder == nullptr) {
+    reused_decoder = JxlDecoderMake(nullptr);
+  } else {
+    JxlDecoderReset(reused_decoder.get());
+  }
+  return reused_decoder.get();
+}
+
 }  // namespace
 
 StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
@@ -93,9 +153,18 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
       quiet)
       << "libjxl only supports 4:4:4 (no chroma subsampling)";
 
-  const JxlEncoderPtr encoder = JxlEncoderMake(nullptr);
+  JxlEncoderPtr owned_encoder;
+  JxlEncoder* encoder = GetEncoder(owned_encoder);
   CHECK_OR_RETURN(encoder != nullptr, quiet) << "JxlEncoderMake() failed";
-  // Single-threaded by default, no need to call JxlEncoderSetParallelRunner().
+  JxlThreadParallelRunnerPtr owned_runner;
+  ASSIGN_OR_RETURN(void* const runner, GetRunner(input, owned_runner, quiet));
+  if (runner != nullptr) {
+    CHECK_OR_RETURN(
+        JxlEncoderSetParallelRunner(encoder, JxlThreadParallelRunner, runner) ==
+            JXL_ENC_SUCCESS,
+        quiet)
+        << "JxlEncoderSetParallelRunner() failed";
+  }
 
   JxlBasicInfo basic_info;
   JxlEncoderInitBasicInfo(&basic_info);
@@ -119,27 +188,27 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
     basic_info.animation.tps_numerator = 1;
     basic_info.animation.tps_denominator = 1000;
   }
-  JxlEncoderStatus status = JxlEncoderSetBasicInfo(encoder.get(), &basic_info);
+  JxlEncoderStatus status = JxlEncoderSetBasicInfo(encoder, &basic_info);
   CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
       << "JxlEncoderSetBasicInfo() failed with error code "
-      << JxlEncoderGetError(encoder.get()) << " when encoding "
+      << JxlEncoderGetError(encoder) << " when encoding "
       << input.image_path;
 
   JxlColorEncoding color_encoding = {};
   JxlColorEncodingSetToSRGB(&color_encoding, /*is_gray=*/JXL_FALSE);
   // Match cjxl output (according to jxlinfo).
   color_encoding.rendering_intent = JXL_RENDERING_INTENT_PERCEPTUAL;
-  status = JxlEncoderSetColorEncoding(encoder.get(), &color_encoding);
+  status = JxlEncoderSetColorEncoding(encoder, &color_encoding);
   CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
       << "JxlEncoderSetColorEncoding() failed with error code "
-      << JxlEncoderGetError(encoder.get()) << " when encoding "
+      << JxlEncoderGetError(encoder) << " when encoding "
       << input.image_path;
 
   if (input.codec_settings.effort >= 11) {
-    JxlEncoderAllowExpertOptions(encoder.get());
+    JxlEncoderAllowExpertOptions(encoder);
   }
   JxlEncoderFrameSettings* frame_settings =
-      JxlEncoderFrameSettingsCreate(encoder.get(), nullptr);
+      JxlEncoderFrameSettingsCreate(encoder, nullptr);
   CHECK_OR_RETURN(frame_settings != nullptr, quiet)
       << "JxlEncoderFrameSettingsCreate() returned null when encoding "
       << input.image_path;
@@ -148,7 +217,7 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
     status = JxlEncoderSetFrameLossless(frame_settings, JXL_TRUE);
     CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
         << "JxlEncoderSetFrameLossless() failed with error code "
-        << JxlEncoderGetError(encoder.get()) << " when encoding "
+        << JxlEncoderGetError(encoder) << " when encoding "
         << input.image_path;
     // JXL_ENC_FRAME_SETTING_KEEP_INVISIBLE should be ON by default if lossless.
   } else {
@@ -157,7 +226,7 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
     status = JxlEncoderSetFrameDistance(frame_settings, distance);
     CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
         << "JxlEncoderSetFrameDistance() failed with error code "
-        << JxlEncoderGetError(encoder.get()) << " when encoding "
+        << JxlEncoderGetError(encoder) << " when encoding "
         << input.image_path << " with distance " << distance << " (quality "
         << input.codec_settings.quality << ")";
   }
@@ -167,7 +236,7 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
   CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
       << "JxlEncoderFrameSettingsSetOption(/*effort=*/"
       << input.codec_settings.effort << ") failed with error code "
-      << JxlEncoderGetError(encoder.get()) << " when encoding "
+      << JxlEncoderGetError(encoder) << " when encoding "
       << input.image_path;
 
   for (const Frame& frame : original_image) {
@@ -191,10 +260,10 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
                                      ArgbBufferSize(frame.pixels));
     CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
         << "JxlEncoderAddImageFrame() failed with error "
-        << JxlEncoderGetError(encoder.get()) << " when encoding "
+        << JxlEncoderGetError(encoder) << " when encoding "
         << input.image_path;
   }
-  JxlEncoderCloseInput(encoder.get());
+  JxlEncoderCloseInput(encoder);
 
   WP2::Data data;
   CHECK_OR_RETURN(data.Resize(64, /*keep_bytes=*/false) == WP2_STATUS_OK,
@@ -203,7 +272,7 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
   uint8_t* next_out = data.bytes;
   size_t avail_out = data.size - (next_out - data.bytes);
   do {
-    status = JxlEncoderProcessOutput(encoder.get(), &next_out, &avail_out);
+    status = JxlEncoderProcessOutput(encoder, &next_out, &avail_out);
     if (status == JXL_ENC_NEED_MORE_OUTPUT) {
       size_t offset = next_out - data.bytes;
       CHECK_OR_RETURN(
@@ -218,37 +287,47 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
       quiet);
   CHECK_OR_RETURN(status == JXL_ENC_SUCCESS, quiet)
       << "JxlEncoderProcessOutput() failed with error code "
-      << JxlEncoderGetError(encoder.get()) << " when encoding "
+      << JxlEncoderGetError(encoder) << " when encoding "
       << input.image_path;
   return data;
 }
 
 StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput& input,
-                                             const WP2::Data& encoded_image,
+                                             WP2::DataView encoded_image,
                                              bool quiet) {
-  const JxlDecoderPtr decoder = JxlDecoderMake(nullptr);
+  JxlDecoderPtr owned_decoder;
+  JxlDecoder* decoder = GetDecoder(owned_decoder);
   CHECK_OR_RETURN(decoder != nullptr, quiet) << "JxlDecoderMake() failed";
+  JxlThreadParallelRunnerPtr owned_runner;
+  ASSIGN_OR_RETURN(void* const runner, GetRunner(input, owned_runner, quiet));
+  if (runner != nullptr) {
+    CHECK_OR_RETURN(
+        JxlDecoderSetParallelRunner(decoder, JxlThreadParallelRunner, runner) ==
+            JXL_DEC_SUCCESS,
+        quiet)
+        << "JxlDecoderSetParallelRunner() failed";
+  }
 
   JxlDecoderStatus status = JxlDecoderSubscribeEvents(
-      decoder.get(), JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE);
+      decoder, JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE);
   CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
       << "JxlDecoderSubscribeEvents() failed with error code " << status
       << " when decoding " << input.image_path;
 
-  status = JxlDecoderSetInput(decoder.get(), encoded_image.bytes,
-                              encoded_image.size);
+  status =
+      JxlDecoderSetInput(decoder, encoded_image.bytes, encoded_image.size);
   CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
       << "JxlDecoderSetInput() failed with error code " << status
       << " when decoding " << input.image_path;
-  JxlDecoderCloseInput(decoder.get());
+  JxlDecoderCloseInput(decoder);
 
-  status = JxlDecoderProcessInput(decoder.get());
+  status = JxlDecoderProcessInput(decoder);
   CHECK_OR_RETURN(status == JXL_DEC_BASIC_INFO, quiet)
       << "First call to JxlDecoderProcessInput() unexpectedly returned "
       << status << " when decoding " << input.image_path;
 
   JxlBasicInfo info;
-  status = JxlDecoderGetBasicInfo(decoder.get(), &info);
+  status = JxlDecoderGetBasicInfo(decoder, &info);
   CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
       << "JxlDecoderGetBasicInfo() failed with error code " << status
       << " when decoding " << input.image_path;
@@ -263,11 +342,11 @@ StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput& input,
           : (info.alpha_bits > 0 ? WP2_RGBA_64 : WP2_RGB_48);
 
   Image image;
-  while ((status = JxlDecoderProcessInput(decoder.get())) ==
+  while ((status = JxlDecoderProcessInput(decoder)) ==
          JXL_DEC_NEED_IMAGE_OUT_BUFFER) {
     if (info.have_animation) {
       JxlFrameHeader frame_header;
-      status = JxlDecoderGetFrameHeader(decoder.get(), &frame_header);
+      status = JxlDecoderGetFrameHeader(decoder, &frame_header);
       CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
           << "JxlDecoderGetFrameHeader() failed with error code " << status
           << " when decoding " << input.image_path;
@@ -278,17 +357,16 @@ StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput& input,
       image.emplace_back(WP2::ArgbBuffer(format), /*duration_ms=*/0);
     }
 
+    OK_OR_RETURN(AllocatePixels(info.xsize, info.ysize, image.back(), quiet));
     WP2::ArgbBuffer& buffer = image.back().pixels;
-    CHECK_OR_RETURN(buffer.Resize(info.xsize, info.ysize) == WP2_STATUS_OK,
-                    quiet);
     const JxlPixelFormat pixel_format = ArgbBufferToJxlPixelFormat(buffer);
     status = JxlDecoderSetImageOutBuffer(
-        decoder.get(), &pixel_format, buffer.GetRow(0), ArgbBufferSize(buffer));
+        decoder, &pixel_format, buffer.GetRow(0), ArgbBufferSize(buffer));
     CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
         << "JxlDecoderSetImageOutBuffer() failed with error code " << status
         << " when decoding " << input.image_path;
 
-    status = JxlDecoderProcessInput(decoder.get());
+    status = JxlDecoderProcessInput(decoder);
     CHECK_OR_RETURN(status == JXL_DEC_FULL_IMAGE, quiet)
         << "JxlDecoderProcessInput() unexpectedly returned " << status
         << " instead of JXL_DEC_FULL_IMAGE when decoding " << input.image_path;
@@ -300,14 +378,99 @@ StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput& input,
   return std::pair<Image, double>(std::move(image), 0);
 }
 
+Status DecodeJxlRows(const TaskInput& input, WP2::DataView encoded_image,
+                     WP2SampleFormat format, const RowCallback& on_row,
+                     bool quiet) {
+  CHECK_OR_RETURN(format == WP2_RGBA_32 || format == WP2_RGB_24 ||
+                      format == WP2_RGBA_64 || format == WP2_RGB_48,
+                  quiet)
+      << "libjxl requires RGB(A)";
+  JxlDecoderPtr owned_decoder;
+  JxlDecoder* decoder = GetDecoder(owned_decoder);
+  CHECK_OR_RETURN(decoder != nullptr, quiet) << "JxlDecoderMake() failed";
+  JxlThreadParallelRunnerPtr owned_runner;
+  ASSIGN_OR_RETURN(void* const runner, GetRunner(input, owned_runner, quiet));
+  if (runner != nullptr) {
+    CHECK_OR_RETURN(
+        JxlDecoderSetParallelRunner(decoder, JxlThreadParallelRunner, runner) ==
+            JXL_DEC_SUCCESS,
+        quiet)
+        << "JxlDecoderSetParallelRunner() failed";
+  }
+
+  JxlDecoderStatus status = JxlDecoderSubscribeEvents(
+      decoder, JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE);
+  CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
+      << "JxlDecoderSubscribeEvents() failed with error code " << status
+      << " when decoding " << input.image_path;
+
+  status =
+      JxlDecoderSetInput(decoder, encoded_image.bytes, encoded_image.size);
+  CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
+      << "JxlDecoderSetInput() failed with error code " << status
+      << " when decoding " << input.image_path;
+  JxlDecoderCloseInput(decoder);
+
+  status = JxlDecoderProcessInput(decoder);
+  CHECK_OR_RETURN(status == JXL_DEC_BASIC_INFO, quiet)
+      << "First call to JxlDecoderProcessInput() unexpectedly returned "
+      << status << " when decoding " << input.image_path;
+  JxlBasicInfo info;
+  status = JxlDecoderGetBasicInfo(decoder, &info);
+  CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
+      << "JxlDecoderGetBasicInfo() failed with error code " << status
+      << " when decoding " << input.image_path;
+  CHECK_OR_RETURN(!info.have_animation, quiet)
+      << "Rows of animations cannot be streamed";
+
+  status = JxlDecoderProcessInput(decoder);
+  CHECK_OR_RETURN(status == JXL_DEC_NEED_IMAGE_OUT_BUFFER, quiet)
+      << "JxlDecoderProcessInput() unexpectedly returned " << status
+      << " instead of JXL_DEC_NEED_IMAGE_OUT_BUFFER when decoding "
+      << input.image_path;
+  JxlPixelFormat pixel_format;
+  pixel_format.num_channels = WP2FormatHasAlpha(format) ? 4 : 3;
+  pixel_format.data_type =
+      WP2Formatbpc(format) == 8 ? JXL_TYPE_UINT8 : JXL_TYPE_UINT16;
+  pixel_format.endianness = JXL_NATIVE_ENDIAN;
+  pixel_format.align = 0;
+  status = JxlDecoderSetImageOutCallback(
+      decoder, &pixel_format,
+      [](void* opaque, size_t x, size_t y, size_t num_pixels,
+         const void* pixels) {
+        (*static_cast<const RowCallback*>(opaque))(
+            static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+            static_cast<uint32_t>(num_pixels), pixels);
+      },
+      const_cast<RowCallback*>(&on_row));
+  CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
+      << "JxlDecoderSetImageOutCallback() failed with error code " << status
+      << " when decoding " << input.image_path;
+
+  status = JxlDecoderProcessInput(decoder);
+  CHECK_OR_RETURN(status == JXL_DEC_FULL_IMAGE, quiet)
+      << "JxlDecoderProcessInput() unexpectedly returned " << status
+      << " instead of JXL_DEC_FULL_IMAGE when decoding " << input.image_path;
+  status = JxlDecoderProcessInput(decoder);
+  CHECK_OR_RETURN(status == JXL_DEC_SUCCESS, quiet)
+      << "Last call to JxlDecoderProcessInput() unexpectedly returned "
+      << status << " instead of JXL_DEC_SUCCESS when decoding "
+      << input.image_path;
+  return Status::kOk;
+}
+
 #else
 StatusOr<WP2::Data> EncodeJxl(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_JPEGXL";
 }
-StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput&, const WP2::Data&,
+StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput&, WP2::DataView,
                                              bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_JPEGXL";
 }
+Status DecodeJxlRows(const TaskInput&, WP2::DataView, WP2SampleFormat,
+                     const RowCallback&, bool quiet) {
+  CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_JPEGXL";
+}
 #endif  // HAS_JPEGXL
 
 #endif  // HAS_WEBP2
@@ -38,8 +38,14 @@ StatusOr<WP2::Data> EncodeJxl(const TaskInput& input,
                               const Image& original_image, bool quiet);
 // Returns the decoded image and the color conversion duration.
 StatusOr<std::pair<Image, double>> DecodeJxl(const TaskInput& input,
-                                             const WP2::Data& encoded_image,
+                                             WP2::DataView encoded_image,
                                              bool quiet);
+// Same as DecodeJxl() for still images but hands out the decoded rows to
+// on_row, possibly from several threads, instead of returning the whole image.
+// The format must be one of the RGB(A) formats returned by DecodeJxl().
+Status DecodeJxlRows(const TaskInput& input, WP2::DataView encoded_image,
+                     WP2SampleFormat format, const RowCallback& on_row,
+                     bool quiet);
 #endif  // HAS_WEBP2
 
 }  // namespace codec_compare_gen
@@ -171,6 +171,10 @@ StatusOr<WP2::Data> EncodeOpenjpeg(const TaskInput& input,
 
   CHECK_OR_RETURN(opj_setup_encoder(codec.get(), &parameters, opj_image.get()),
                   quiet);
+  CHECK_OR_RETURN(
+      opj_codec_set_threads(
+          codec.get(), static_cast<int>(input.codec_settings.num_threads)),
+      quiet);
 
   struct Stream {
     WP2::Data encoded_image;
@@ -255,9 +259,9 @@ StatusOr<WP2::Data> EncodeOpenjpeg(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeOpenjpeg(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet) {
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet) {
   struct Stream {
-    const WP2::Data& encoded_image;
+    WP2::DataView encoded_image;
     size_t offset;
   } stream_data{encoded_image, 0};
   std::unique_ptr<opj_stream_t, decltype(&opj_stream_destroy)> stream(
@@ -324,6 +328,10 @@ StatusOr<std::pair<Image, double>> DecodeOpenjpeg(
   opj_dparameters parameters;
   opj_set_default_decoder_parameters(&parameters);
   CHECK_OR_RETURN(opj_setup_decoder(codec.get(), &parameters), quiet);
+  CHECK_OR_RETURN(
+      opj_codec_set_threads(
+          codec.get(), static_cast<int>(input.codec_settings.num_threads)),
+      quiet);
 
   opj_image_t* opj_image_ptr;
   CHECK_OR_RETURN(opj_read_header(stream.get(), codec.get(), &opj_image_ptr),
@@ -398,7 +406,7 @@ StatusOr<WP2::Data> EncodeOpenjpeg(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_OPENJPEG";
 }
 StatusOr<std::pair<Image, double>> DecodeOpenjpeg(const TaskInput&,
-                                                  const WP2::Data&,
+                                                  WP2::DataView,
                                                   bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_OPENJPEG";
 }
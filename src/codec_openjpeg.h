@@ -39,7 +39,7 @@ std::vector<int> OpenjpegLossyQualities();
 StatusOr<WP2::Data> EncodeOpenjpeg(const TaskInput& input,
                                    const Image& original_image, bool quiet);
 StatusOr<std::pair<Image, double>> DecodeOpenjpeg(
-    const TaskInput& input, const WP2::Data& encoded_image, bool quiet);
+    const TaskInput& input, WP2::DataView encoded_image, bool quiet);
 #endif  // HAS_WEBP2
 
 }  // namespace codec_compare_gen
@@ -139,7 +139,7 @@ StatusOr<WP2::Data> EncodeWebp(const TaskInput& input,
     config.method = input.codec_settings.effort;
     config.use_sharp_yuv = 1;
   }
-  config.thread_level = 0;
+  config.thread_level = input.codec_settings.num_threads > 1 ? 1 : 0;
 
   const int width = static_cast<int>(original_image.front().pixels.width());
   const int height = static_cast<int>(original_image.front().pixels.height());
@@ -189,12 +189,12 @@ StatusOr<WP2::Data> EncodeWebp(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeWebp(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool quiet) {
   WebPAnimDecoderOptions dec_options;
   CHECK_OR_RETURN(WebPAnimDecoderOptionsInit(&dec_options), quiet);
   dec_options.color_mode = MODE_BGRA;
-  dec_options.use_threads = 0;
+  dec_options.use_threads = input.codec_settings.num_threads > 1 ? 1 : 0;
   const WebPData webp_data = {encoded_image.bytes, encoded_image.size};
   std::unique_ptr<WebPAnimDecoder, decltype(&WebPAnimDecoderDelete)> dec(
       WebPAnimDecoderNew(&webp_data, &dec_options), WebPAnimDecoderDelete);
@@ -231,7 +231,7 @@ StatusOr<WP2::Data> EncodeWebp(const TaskInput&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Encoding images requires HAS_WEBP";
 }
 StatusOr<std::pair<Image, double>> DecodeWebp(const TaskInput&,
-                                              const WP2::Data&, bool quiet) {
+                                              WP2::DataView, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Decoding images requires HAS_WEBP";
 }
 #endif  // HAS_WEBP
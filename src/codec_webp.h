@@ -40,7 +40,7 @@ StatusOr<WP2::Data> EncodeWebp(const TaskInput& input,
                                const Image& original_image, bool quiet);
 // Returns the decoded image and the color conversion duration.
 StatusOr<std::pair<Image, double>> DecodeWebp(const TaskInput& input,
-                                              const WP2::Data& encoded_image,
+                                              WP2::DataView encoded_image,
                                               bool quiet);
 #endif  // HAS_WEBP2
 
@@ -86,7 +86,7 @@ StatusOr<WP2::Data> EncodeWebp2(const TaskInput& input,
     config.uv_mode = WP2::EncoderConfig::UVMode444;
   }
   config.effort = input.codec_settings.effort;
-  config.thread_level = 0;
+  config.thread_level = input.codec_settings.num_threads - 1;
   if (original_image.size() == 1) {
     const WP2Status status =
         WP2::Encode(original_image.front().pixels, &writer, config);
@@ -113,14 +113,14 @@ StatusOr<WP2::Data> EncodeWebp2(const TaskInput& input,
 }
 
 StatusOr<std::pair<Image, double>> DecodeWebp2(const TaskInput& input,
-                                               const WP2::Data& encoded_image,
+                                               WP2::DataView encoded_image,
                                                bool quiet) {
   // TODO: Fix the following error when compiled with gcc --enable-default-pie:
   //         codec_webp2.cc.o:(.data.rel.ro.ArrayDecoderE):
   //         undefined reference to typeinfo for WP2::Decoder
 
   WP2::DecoderConfig config;
-  config.thread_level = 0;
+  config.thread_level = input.codec_settings.num_threads - 1;
   WP2::ArrayDecoder decoder(encoded_image.bytes, encoded_image.size, config);
   Image image;
 
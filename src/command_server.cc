@@ -0,0 +1,224 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_server.h"
+
+#ifdef HAVE_UNISTD_H
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "src/base.h"
+
+#ifdef HAVE_UNISTD_H
+extern char** environ;
+#endif
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Printed by the shell on its own line after each command.
+constexpr const char kMarker[] = "codec_compare_gen_command_done";
+
+std::atomic<bool> use_command_servers{false};
+
+#ifdef HAVE_UNISTD_H
+// Not inherited by the other started processes, which would keep the shell
+// alive.
+bool CreatePipe(int fds[2]) {
+#if defined(__linux__)
+  return pipe2(fds, O_CLOEXEC) == 0;
+#else
+  if (pipe(fds) != 0) return false;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+}
+#endif
+
+}  // namespace
+
+bool CommandServer::IsSupported() {
+#ifdef HAVE_UNISTD_H
+  return true;
+#else
+  return false;
+#endif
+}
+
+CommandServer::~CommandServer() { Stop(); }
+
+StatusOr<std::string> CommandServer::Run(const std::string& command_line,
+                                         bool quiet) {
+  // The marker is printed even if the command failed. The command must not
+  // read the next requests.
+  const std::string request = "{ " + command_line + "\n} < /dev/null\n" +
+                              "printf '\\n%s\\n' " + kMarker + "\n";
+  // Retry once in case the shell was killed.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    if (pid_ < 0) OK_OR_RETURN(Start(quiet));
+    std::string standard_output;
+    if (Write(request) && ReadUntilMarker(standard_output)) {
+      return standard_output;
+    }
+    Stop();
+  }
+  CHECK_OR_RETURN(false, quiet)
+      << "The shell ended while running " << command_line;
+}
+
+Status CommandServer::Start(bool quiet) {
+#ifdef HAVE_UNISTD_H
+  int to_shell[2], from_shell[2];
+  CHECK_OR_RETURN(CreatePipe(to_shell), quiet) << "pipe() failed";
+  if (!CreatePipe(from_shell)) {
+    close(to_shell[0]);
+    close(to_shell[1]);
+    CHECK_OR_RETURN(false, quiet) << "pipe() failed";
+  }
+
+  // posix_spawn() does not copy the memory of this process, unlike fork().
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, to_shell[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, from_shell[1], STDOUT_FILENO);
+  char sh[] = "sh";
+  char* argv[] = {sh, nullptr};
+  pid_t pid;
+  const int error = posix_spawn(&pid, "/bin/sh", &actions,
+                                /*attrp=*/nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(to_shell[0]);
+  close(from_shell[1]);
+  if (error != 0) {
+    close(to_shell[1]);
+    close(from_shell[0]);
+    CHECK_OR_RETURN(false, quiet) << "Could not start /bin/sh";
+  }
+  pid_ = static_cast<int>(pid);
+  to_shell_ = to_shell[1];
+  from_shell_ = from_shell[0];
+  ++num_starts_;
+  return Status::kOk;
+#else
+  CHECK_OR_RETURN(false, quiet)
+      << "Command servers are only supported on POSIX systems";
+#endif
+}
+
+void CommandServer::Stop() {
+#ifdef HAVE_UNISTD_H
+  if (pid_ < 0) return;
+  close(to_shell_);  // The shell exits at the end of its input.
+  close(from_shell_);
+  waitpid(static_cast<pid_t>(pid_), /*wstatus=*/nullptr, /*options=*/0);
+  pid_ = to_shell_ = from_shell_ = -1;
+#endif
+}
+
+bool CommandServer::Write(const std::string& bytes) {
+#ifdef HAVE_UNISTD_H
+  // Writing to a pipe without reader raises SIGPIPE, which would end this
+  // process. Block it for this thread only.
+  sigset_t sigpipe, old_mask;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, &old_mask);
+  bool success = true;
+  for (size_t offset = 0; offset < bytes.size();) {
+    const ssize_t size =
+        write(to_shell_, bytes.data() + offset, bytes.size() - offset);
+    if (size < 0 && errno == EINTR) continue;
+    if (size <= 0) {
+      success = false;
+      break;
+    }
+    offset += static_cast<size_t>(size);
+  }
+  if (!success) {
+    // Discard the SIGPIPE raised above, if any, before unblocking it.
+    sigset_t pending;
+    int signal;
+    if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+      sigwait(&sigpipe, &signal);
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+  return success;
+#else
+  return false;
+#endif
+}
+
+bool CommandServer::ReadUntilMarker(std::string& output) {
+#ifdef HAVE_UNISTD_H
+  const std::string end = std::string("\n") + kMarker + "\n";
+  output.clear();
+  char buffer[4096];
+  while (output.size() < end.size() ||
+         output.compare(output.size() - end.size(), end.size(), end) != 0) {
+    const ssize_t size = read(from_shell_, buffer, sizeof(buffer));
+    if (size < 0 && errno == EINTR) continue;
+    if (size <= 0) return false;
+    output.append(buffer, static_cast<size_t>(size));
+  }
+  output.resize(output.size() - end.size());
+  return true;
+#else
+  return false;
+#endif
+}
+
+StatusOr<std::string> CommandServerPool::Run(const std::string& command_line,
+                                             bool quiet) {
+  std::unique_ptr<CommandServer> server;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_servers_.empty()) {
+      ++num_servers_;
+    } else {
+      server = std::move(idle_servers_.back());
+      idle_servers_.pop_back();
+    }
+  }
+  if (server == nullptr) server = std::make_unique<CommandServer>();
+  StatusOr<std::string> output = server->Run(command_line, quiet);
+  std::lock_guard<std::mutex> lock(mutex_);
+  idle_servers_.push_back(std::move(server));
+  return output;
+}
+
+size_t CommandServerPool::num_servers() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_servers_;
+}
+
+void SetUseCommandServers(bool use) { use_command_servers = use; }
+bool UseCommandServers() { return use_command_servers; }
+
+}  // namespace codec_compare_gen
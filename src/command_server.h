@@ -0,0 +1,84 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_COMMAND_SERVER_H_
+#define SRC_COMMAND_SERVER_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Long-lived shell running the given command lines one after the other, so
+// that this process is not forked for each of them. The shell is started at
+// the first Run() and restarted if it died. Not thread-safe: use one instance
+// per thread. Only supported on POSIX systems.
+class CommandServer {
+ public:
+  static bool IsSupported();
+
+  CommandServer() = default;
+  CommandServer(const CommandServer&) = delete;
+  CommandServer& operator=(const CommandServer&) = delete;
+  ~CommandServer();  // Ends the shell.
+
+  // Same as reading the standard output of popen(command_line). The standard
+  // input of the command is empty. The exit status is ignored, as with popen().
+  StatusOr<std::string> Run(const std::string& command_line, bool quiet);
+
+  int num_starts() const { return num_starts_; }
+
+ private:
+  Status Start(bool quiet);
+  void Stop();
+  // Both return false if the shell ended.
+  bool Write(const std::string& bytes);
+  bool ReadUntilMarker(std::string& output);
+
+  int pid_ = -1;
+  int to_shell_ = -1;    // Standard input of the shell.
+  int from_shell_ = -1;  // Standard output of the shell.
+  int num_starts_ = 0;
+};
+
+// Thread-safe set of CommandServers shared by all threads, so that the shells
+// outlive the short-lived threads running commands, such as the frame threads
+// of each animated task. A server is only used by one thread at a time.
+class CommandServerPool {
+ public:
+  // Runs command_line with an idle server, or with a new one if all are busy.
+  StatusOr<std::string> Run(const std::string& command_line, bool quiet);
+
+  // Number of servers created so far, that is the highest number of commands
+  // run at once.
+  size_t num_servers() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<CommandServer>> idle_servers_;
+  size_t num_servers_ = 0;
+};
+
+// Enables or disables the use of CommandServers. See RunProcess().
+void SetUseCommandServers(bool use);
+bool UseCommandServers();
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_COMMAND_SERVER_H_
@@ -0,0 +1,106 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cpu_affinity.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/base.h"
+#include "src/serialization.h"
+
+namespace codec_compare_gen {
+
+std::vector<int> GetAllowedCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(/*pid=calling thread*/ 0, sizeof(set), &set) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+  }
+#endif
+  return cpus;
+}
+
+Status SetAllowedCpus(const std::vector<int>& cpus, bool quiet) {
+  CHECK_OR_RETURN(!cpus.empty(), quiet) << "No CPU to run on";
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    CHECK_OR_RETURN(cpu >= 0 && cpu < CPU_SETSIZE, quiet)
+        << "Bad CPU index " << cpu;
+    CPU_SET(cpu, &set);
+  }
+  CHECK_OR_RETURN(
+      sched_setaffinity(/*pid=calling thread*/ 0, sizeof(set), &set) == 0,
+      quiet)
+      << "sched_setaffinity() failed";
+  return Status::kOk;
+#else
+  CHECK_OR_RETURN(false, quiet) << "Pinning threads is only supported on Linux";
+#endif
+}
+
+StatusOr<std::vector<int>> ParseCpuList(std::string_view list, bool quiet) {
+  std::vector<int> cpus;
+  std::vector<std::string_view> ranges;
+  SplitViews(list, ',', ranges);
+  for (std::string_view range : ranges) {
+    if (range.empty()) continue;  // Trailing comma or empty list.
+    const size_t dash = range.find('-');
+    const std::string_view first_str = range.substr(0, dash);
+    const std::string_view last_str =
+        dash == std::string_view::npos ? first_str : range.substr(dash + 1);
+    int first, last;
+    const bool is_valid = ParseNumber(Trim(first_str), first) &&
+                          ParseNumber(Trim(last_str), last);
+    CHECK_OR_RETURN(is_valid && first >= 0 && first <= last, quiet)
+        << "Bad CPU range \"" << range << "\" in \"" << list << "\"";
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+StatusOr<std::vector<int>> GetNumaNodeCpus(int numa_node, bool quiet) {
+  CHECK_OR_RETURN(numa_node >= 0, quiet) << "Bad NUMA node " << numa_node;
+  const std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(numa_node) + "/cpulist";
+  std::ifstream file(path);
+  CHECK_OR_RETURN(file.is_open(), quiet)
+      << "Could not read the CPUs of NUMA node " << numa_node << " from "
+      << path;
+  const std::string list((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  ASSIGN_OR_RETURN(std::vector<int> cpus, ParseCpuList(Trim(list), quiet));
+  CHECK_OR_RETURN(!cpus.empty(), quiet)
+      << "NUMA node " << numa_node << " has no CPU";
+  return cpus;
+}
+
+}  // namespace codec_compare_gen
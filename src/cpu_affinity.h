@@ -0,0 +1,41 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_CPU_AFFINITY_H_
+#define SRC_CPU_AFFINITY_H_
+
+#include <string_view>
+#include <vector>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Returns the CPUs the calling thread is allowed to run on, in increasing
+// order, or an empty vector if unavailable on this platform.
+std::vector<int> GetAllowedCpus();
+
+// Restricts the calling thread to the given CPUs. The threads and processes it
+// creates afterwards inherit that restriction. Only supported on Linux.
+Status SetAllowedCpus(const std::vector<int>& cpus, bool quiet);
+
+// Parses a list of CPUs such as "0-3,8,10-11", in increasing order.
+StatusOr<std::vector<int>> ParseCpuList(std::string_view list, bool quiet);
+
+// Returns the CPUs of the given NUMA node, as listed by the Linux kernel.
+StatusOr<std::vector<int>> GetNumaNodeCpus(int numa_node, bool quiet);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_CPU_AFFINITY_H_
@@ -19,22 +19,33 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "src/base.h"
 #include "src/codec.h"
+#include "src/command_server.h"
+#include "src/distortion_libjxl.h"
 #include "src/frame.h"
 #include "src/framework.h"
+#include "src/pixel_kernels.h"
 #include "src/serialization.h"
 #include "src/task.h"
+#include "src/temp_file_cache.h"
+#include "src/trace.h"
 
 #if defined(HAS_WEBP2)
 #include "third_party/libwebp2/imageio/image_enc.h"
@@ -43,21 +54,33 @@
 
 namespace codec_compare_gen {
 
+bool NeedsMetricBinaries(const std::vector<DistortionMetric>& metrics) {
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    const DistortionMetric metric = static_cast<DistortionMetric>(m);
+    if (((metrics.empty() && IsComputedByDefault(metric)) ||
+         std::find(metrics.begin(), metrics.end(), metric) != metrics.end()) &&
+        metric != DistortionMetric::kLibwebp2Psnr &&
+        metric != DistortionMetric::kLibwebp2Ssim &&
+        metric != DistortionMetric::kSamplePsnr &&
+        !IsInProcessDistortion(metric)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 #if defined(HAS_WEBP2)
 
 namespace {
 
-class FileDeleter {
- public:
-  explicit FileDeleter(const std::string& file_path) : file_path_(file_path) {}
-  ~FileDeleter() {
-    if (!file_path_.empty()) std::filesystem::remove(file_path_);
-  }
-  const std::string file_path_;
-};
-
 // Runs the binary in a sub-process and returns its standard output.
 StatusOr<std::string> RunProcess(const char* binary_path_and_args, bool quiet) {
+  TraceScope trace("run metric binary");
+  if (UseCommandServers()) {
+    // Shared by all threads, ended with this process.
+    static CommandServerPool command_servers;
+    return command_servers.Run(binary_path_and_args, quiet);
+  }
   // std::system() is in the standard but pclose() can return stdout without an
   // extra file.
   std::unique_ptr<FILE, decltype(&pclose)> file_descriptor(
@@ -74,69 +97,102 @@ StatusOr<std::string> RunProcess(const char* binary_path_and_args, bool quiet) {
 
 //------------------------------------------------------------------------------
 
-StatusOr<float> GetLibwebp2Distortion(const WP2::ArgbBuffer& reference,
-                                      const WP2::ArgbBuffer& image,
-                                      const TaskInput& task,
-                                      WP2::MetricType metric, bool quiet) {
-  float distortion[5];
-  const WP2Status status =
-      (task.codec_settings.quality == kQualityLossless ||
-       !reference.HasTransparency())
-          ? image.GetDistortion(reference, metric, distortion)
-          : image.GetDistortionBlackOrWhiteBackground(reference, metric,
-                                                      distortion);
-
-  if (status == WP2_STATUS_UNSUPPORTED_FEATURE &&
-      WP2FormatBpp(reference.format()) != 4) {
-    // Some metrics need four channels.
-    WP2::ArgbBuffer reference4(
-        WP2IsPremultiplied(reference.format()) ? WP2_Argb_32 : WP2_ARGB_32);
-    CHECK_OR_RETURN(reference4.ConvertFrom(reference) == WP2_STATUS_OK, quiet);
-    WP2::ArgbBuffer image4(WP2IsPremultiplied(image.format()) ? WP2_Argb_32
-                                                              : WP2_ARGB_32);
-    CHECK_OR_RETURN(image4.ConvertFrom(image) == WP2_STATUS_OK, quiet);
-    return GetLibwebp2Distortion(reference4, image4, task, metric, quiet);
-  }
-
-  CHECK_OR_RETURN(status == WP2_STATUS_OK, quiet)
-      << "GetDistortion(" << metric << ") failed on " << task.image_path
-      << " and " << CodecName(task.codec_settings.codec) << " at effort "
-      << task.codec_settings.effort << ", chroma subsampling "
-      << SubsamplingToString(task.codec_settings.chroma_subsampling)
-      << " and quality " << task.codec_settings.quality << ": "
-      << WP2GetStatusMessage(status);
-  float overall_distortion = distortion[4];
-
-  if (metric == WP2::PSNR &&
-      (task.codec_settings.quality == kQualityLossless
-           ? overall_distortion != kNoDistortion
-           : overall_distortion <
-                 (task.codec_settings.quality > 90 ? 10 : 2))) {
-    if (!quiet) {
-      std::cerr << "Error: " << task.image_path
-                << " was encoded or decoded with loss in "
-                << CodecName(task.codec_settings.codec) << " format at effort "
-                << task.codec_settings.effort << ", chroma subsampling "
-                << SubsamplingToString(task.codec_settings.chroma_subsampling)
-                << " and quality " << task.codec_settings.quality << " (alpha "
-                << distortion[0] << "dB, R " << distortion[1] << "dB, G "
-                << distortion[2] << "dB, B " << distortion[3] << "dB, overall "
-                << overall_distortion << "dB)" << std::endl;
+// Returns the libwebp2 distortions of image compared to reference for each
+// of the given metrics, in the same order. The transparency check and any
+// format conversion are done once for all metrics.
+StatusOr<std::vector<float>> GetLibwebp2Distortions(
+    const WP2::ArgbBuffer& reference, const WP2::ArgbBuffer& image,
+    const TaskInput& task, const std::vector<WP2::MetricType>& metrics,
+    bool quiet) {
+  const bool on_background = task.codec_settings.quality != kQualityLossless &&
+                             reference.HasTransparency();
+  const WP2::ArgbBuffer* final_reference = &reference;
+  const WP2::ArgbBuffer* final_image = &image;
+  std::optional<WP2::ArgbBuffer> reference4, image4;
+
+  std::vector<float> distortions;
+  distortions.reserve(metrics.size());
+  for (WP2::MetricType metric : metrics) {
+    float distortion[5];
+    const auto evaluate = [&]() {
+      return on_background ? final_image->GetDistortionBlackOrWhiteBackground(
+                                 *final_reference, metric, distortion)
+                           : final_image->GetDistortion(*final_reference,
+                                                        metric, distortion);
+    };
+    WP2Status status = evaluate();
+
+    if (status == WP2_STATUS_UNSUPPORTED_FEATURE && !reference4.has_value() &&
+        WP2FormatBpp(reference.format()) != 4) {
+      // Some metrics need four channels. Convert once for the next metrics.
+      reference4.emplace(WP2IsPremultiplied(reference.format()) ? WP2_Argb_32
+                                                                : WP2_ARGB_32);
+      CHECK_OR_RETURN(reference4->ConvertFrom(reference) == WP2_STATUS_OK,
+                      quiet);
+      image4.emplace(WP2IsPremultiplied(image.format()) ? WP2_Argb_32
+                                                        : WP2_ARGB_32);
+      CHECK_OR_RETURN(image4->ConvertFrom(image) == WP2_STATUS_OK, quiet);
+      final_reference = &*reference4;
+      final_image = &*image4;
+      status = evaluate();
     }
-    // Uncomment to dump the problematic image.
+
+    CHECK_OR_RETURN(status == WP2_STATUS_OK, quiet)
+        << "GetDistortion(" << metric << ") failed on " << task.image_path
+        << " and " << CodecName(task.codec_settings.codec) << " at effort "
+        << task.codec_settings.effort << ", chroma subsampling "
+        << SubsamplingToString(task.codec_settings.chroma_subsampling)
+        << " and quality " << task.codec_settings.quality << ": "
+        << WP2GetStatusMessage(status);
+    float overall_distortion = distortion[4];
+
+    if (metric == WP2::PSNR &&
+        (task.codec_settings.quality == kQualityLossless
+             ? overall_distortion != kNoDistortion
+             : overall_distortion <
+                   (task.codec_settings.quality > 90 ? 10 : 2))) {
+      if (!quiet) {
+        std::cerr << "Error: " << task.image_path
+                  << " was encoded or decoded with loss in "
+                  << CodecName(task.codec_settings.codec)
+                  << " format at effort " << task.codec_settings.effort
+                  << ", chroma subsampling "
+                  << SubsamplingToString(task.codec_settings.chroma_subsampling)
+                  << " and quality " << task.codec_settings.quality
+                  << " (alpha " << distortion[0] << "dB, R " << distortion[1]
+                  << "dB, G " << distortion[2] << "dB, B " << distortion[3]
+                  << "dB, overall " << overall_distortion << "dB)"
+                  << std::endl;
+      }
+      // Uncomment to dump the problematic image.
 #if 0
-    (void)WP2::SaveImage(reference, "/tmp/ccgen_original.png");
-    (void)WP2::SaveImage(image, "/tmp/ccgen_decoded.png");
+      (void)WP2::SaveImage(reference, "/tmp/ccgen_original.png");
+      (void)WP2::SaveImage(image, "/tmp/ccgen_decoded.png");
 #endif
-    return Status::kUnknownError;
+      return Status::kUnknownError;
+    }
+    distortions.push_back(overall_distortion);
   }
-  return overall_distortion;
+  return distortions;
+}
+
+StatusOr<float> GetLibwebp2Distortion(const WP2::ArgbBuffer& reference,
+                                      const WP2::ArgbBuffer& image,
+                                      const TaskInput& task,
+                                      WP2::MetricType metric, bool quiet) {
+  ASSIGN_OR_RETURN(
+      const std::vector<float> distortions,
+      GetLibwebp2Distortions(reference, image, task, {metric}, quiet));
+  float distortion = distortions.front();
+  return distortion;
 }
 
 Status SaveImage(const WP2::ArgbBuffer& image, const std::string& file_path,
                  bool quiet) {
+  TraceScope trace("write temporary PNG");
   const WP2Status status =
-      WP2::SaveImage(image, file_path.c_str(), /*overwrite=*/true);
+      WP2::SaveImage(image, file_path.c_str(), /*overwrite=*/true,
+                     WP2::FileFormat::PNG);  // The path may be a MemoryFile.
   if (status == WP2_STATUS_UNSUPPORTED_FEATURE &&
       image.format() != WP2_Argb_32 && image.format() != WP2_ARGB_32) {
     WP2::ArgbBuffer image4(WP2IsPremultiplied(image.format()) ? WP2_Argb_32
@@ -151,20 +207,62 @@ Status SaveImage(const WP2::ArgbBuffer& image, const std::string& file_path,
   return Status::kOk;
 }
 
-StatusOr<std::string> GetBinaryDistortion(const std::string& reference_path,
-                                          const WP2::ArgbBuffer& reference,
-                                          const std::string& image_path,
-                                          const WP2::ArgbBuffer& image,
-                                          const TaskInput& task,
-                                          const std::string& metric_binary_path,
-                                          size_t thread_id, bool quiet) {
+// Returns a file name identifying the pixels so that identical frames share
+// the same PNG file in a TempFileCache.
+std::string GetPngContentKey(const WP2::ArgbBuffer& image) {
+  const size_t row_size = image.width() * WP2FormatBpp(image.format());
+  size_t hash = 0;
+  for (uint32_t y = 0; y < image.height(); ++y) {
+    const std::string_view row(
+        reinterpret_cast<const char*>(image.GetRow(y)), row_size);
+    // Same combination as boost::hash_combine().
+    hash ^= std::hash<std::string_view>()(row) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+  }
+  char hex[2 * sizeof(hash) + 1];
+  std::snprintf(hex, sizeof(hex), "%0*zx", static_cast<int>(2 * sizeof(hash)),
+                hash);
+  return std::to_string(image.width()) + "x" +
+         std::to_string(image.height()) + "_f" +
+         std::to_string(static_cast<int>(image.format())) + "_" + hex + ".png";
+}
+
+// PNG files of a reference frame and of a distorted frame, as read by the
+// metric binaries. The temporary ones are deleted at destruction.
+struct MetricInputFiles {
+  MetricInputFiles() = default;
+  MetricInputFiles(const MetricInputFiles&) = delete;
+  ~MetricInputFiles() {
+    for (const std::string* path : {&temp_reference_path, &temp_image_path}) {
+      if (!path->empty()) std::filesystem::remove(*path);
+    }
+  }
+
+  std::string reference_path;
+  std::string image_path;
+  std::shared_ptr<const TempFile> shared_reference_file;
+  std::string temp_reference_path;
+  std::string temp_image_path;
+  // Instead of the temporary files above if UseMemoryFiles().
+  MemoryFile memory_reference_file;
+  MemoryFile memory_image_file;
+};
+
+// Fills files with the given paths if they are PNG files of the given frames,
+// or with temporary PNG files written from the given frames otherwise.
+Status GetMetricInputFiles(const std::string& reference_path,
+                           const WP2::ArgbBuffer& reference,
+                           const std::string& image_path,
+                           const WP2::ArgbBuffer& image, size_t thread_id,
+                           TempFileCache* reference_file_cache, bool quiet,
+                           MetricInputFiles& files) {
   CHECK_OR_RETURN(!reference_path.empty(), quiet);
-  CHECK_OR_RETURN(!metric_binary_path.empty(), quiet);
   const bool maybeAnimated = !EndsWith(reference_path, ".png");
 
   std::string path_prefix;
   if (image_path.empty() || maybeAnimated) {
-    path_prefix = std::filesystem::temp_directory_path() / "codec_compare_gen";
+    path_prefix =
+        std::filesystem::path(GetFastTempDirectory()) / "codec_compare_gen";
 #ifdef HAVE_UNISTD_H
     // Process-safe file name.
     path_prefix += "_process";
@@ -177,45 +275,68 @@ StatusOr<std::string> GetBinaryDistortion(const std::string& reference_path,
 
   // Create a PNG file containing the original pixels of the current frame if
   // not PNG (could be a GIF with multiple frames for example).
-  std::string temp_reference_path;
-  std::string_view final_reference_path = reference_path;
-  if (maybeAnimated) {
+  files.reference_path = reference_path;
+  if (maybeAnimated && reference_file_cache != nullptr) {
+    // Shared by all metrics and tasks evaluated against the same pixels.
+    ASSIGN_OR_RETURN(files.shared_reference_file,
+                     reference_file_cache->Get(
+                         GetPngContentKey(reference),
+                         [&](const std::string& path) {
+                           return SaveImage(reference, path, quiet);
+                         },
+                         quiet));
+    files.reference_path = files.shared_reference_file->path;
+  } else if (maybeAnimated && UseMemoryFiles()) {
+    OK_OR_RETURN(files.memory_reference_file.Create("reference.png", quiet));
+    files.reference_path = files.memory_reference_file.path();
+    OK_OR_RETURN(SaveImage(reference, files.reference_path, quiet));
+  } else if (maybeAnimated) {
     // Thread-safe file name.
-    temp_reference_path = path_prefix + "_reference.png";
-    OK_OR_RETURN(SaveImage(reference, temp_reference_path, quiet));
-    final_reference_path = temp_reference_path;
+    files.temp_reference_path = path_prefix + "_reference.png";
+    OK_OR_RETURN(SaveImage(reference, files.temp_reference_path, quiet));
+    files.reference_path = files.temp_reference_path;
   }
-  const FileDeleter temp_reference_path_deleter(temp_reference_path);
 
   // Create a PNG file containing the decoded pixels if not done or if animated.
-  std::string temp_image_path;
-  std::string_view final_image_path = image_path;
-  if (image_path.empty() || maybeAnimated) {
-    temp_image_path = path_prefix + "_image.png";
-    OK_OR_RETURN(SaveImage(image, temp_image_path, quiet));
-    final_image_path = temp_image_path;
+  files.image_path = image_path;
+  if ((image_path.empty() || maybeAnimated) && UseMemoryFiles()) {
+    OK_OR_RETURN(files.memory_image_file.Create("image.png", quiet));
+    files.image_path = files.memory_image_file.path();
+    OK_OR_RETURN(SaveImage(image, files.image_path, quiet));
+  } else if (image_path.empty() || maybeAnimated) {
+    files.temp_image_path = path_prefix + "_image.png";
+    OK_OR_RETURN(SaveImage(image, files.temp_image_path, quiet));
+    files.image_path = files.temp_image_path;
   }
-  const FileDeleter temp_image_path_deleter(temp_image_path);
+  return Status::kOk;
+}
 
+// The paths come from GetMetricInputFiles().
+StatusOr<std::string> GetBinaryDistortion(const std::string& reference_path,
+                                          const std::string& image_path,
+                                          const std::string& metric_binary_path,
+                                          bool quiet) {
+  CHECK_OR_RETURN(!reference_path.empty() && !image_path.empty(), quiet);
+  CHECK_OR_RETURN(!metric_binary_path.empty(), quiet);
   const std::string binary_path_and_args = Escape(metric_binary_path) + " " +
-                                           Escape(final_reference_path) + " " +
-                                           Escape(final_image_path);
+                                           Escape(reference_path) + " " +
+                                           Escape(image_path);
   return RunProcess(binary_path_and_args.c_str(), quiet);
 }
 
 StatusOr<float> GetLibjxlDistortion(
     const std::string& reference_path, const WP2::ArgbBuffer& reference,
     const std::string& image_path, const WP2::ArgbBuffer& image,
-    const TaskInput& task, const std::string& metric_binary_folder_path,
-    DistortionMetric metric, size_t thread_id, bool quiet) {
+    const std::string& metric_binary_folder_path, DistortionMetric metric,
+    bool quiet) {
+  if (IsInProcessDistortion(metric)) {
+    return GetInProcessDistortion(reference, image, metric, quiet);
+  }
   // Metric binaries are not available: just return -1 for simplicity.
   if (metric_binary_folder_path.empty()) return -1;
 
   const char* metric_binary_name;
-  if (metric == DistortionMetric::kLibjxlButteraugli ||
-      metric == DistortionMetric::kLibjxlP3norm) {
-    metric_binary_name = "butteraugli_main";
-  } else if (metric == DistortionMetric::kLibjxlSsimulacra) {
+  if (metric == DistortionMetric::kLibjxlSsimulacra) {
     metric_binary_name = "ssimulacra_main";
   } else {
     CHECK_OR_RETURN(metric == DistortionMetric::kLibjxlSsimulacra2, quiet);
@@ -225,32 +346,47 @@ StatusOr<float> GetLibjxlDistortion(
       std::filesystem::path(metric_binary_folder_path) / "libjxl" / "build" /
       "tools" / metric_binary_name;
   ASSIGN_OR_RETURN(
-      std::string standard_output,
-      GetBinaryDistortion(reference_path, reference, image_path, image, task,
-                          metric_binary_path, thread_id, quiet));
-
-  if (metric == DistortionMetric::kLibjxlButteraugli ||
-      metric == DistortionMetric::kLibjxlP3norm) {
-    static constexpr const char* kP3normToken = "3-norm:";
-    const auto p3norm_token_position = standard_output.find(kP3normToken);
-    CHECK_OR_RETURN(p3norm_token_position != std::string::npos, quiet)
-        << "\"3-norm:\" token not found in \"" << standard_output << "\"";
-    standard_output = metric == DistortionMetric::kLibjxlButteraugli
-                          ? standard_output.substr(0, p3norm_token_position)
-                          : standard_output.substr(p3norm_token_position +
-                                                   std::strlen(kP3normToken));
+      const std::string standard_output,
+      GetBinaryDistortion(reference_path, image_path, metric_binary_path,
+                          quiet));
+  return std::stof(Trim(standard_output));
+}
+
+// kLibjxlButteraugli and kLibjxlP3norm come from the same evaluation.
+StatusOr<ButteraugliDistortions> GetButteraugliDistortions(
+    const std::string& reference_path, const WP2::ArgbBuffer& reference,
+    const std::string& image_path, const WP2::ArgbBuffer& image,
+    const std::string& metric_binary_folder_path, bool quiet) {
+  if (IsInProcessDistortion(DistortionMetric::kLibjxlButteraugli)) {
+    return GetInProcessButteraugliDistortions(reference, image, quiet);
   }
+  // Metric binaries are not available: just return -1 for simplicity.
+  if (metric_binary_folder_path.empty()) return ButteraugliDistortions{-1, -1};
 
-  return std::stof(Trim(standard_output));
+  const std::string metric_binary_path =
+      std::filesystem::path(metric_binary_folder_path) / "libjxl" / "build" /
+      "tools" / "butteraugli_main";
+  ASSIGN_OR_RETURN(
+      const std::string standard_output,
+      GetBinaryDistortion(reference_path, image_path, metric_binary_path,
+                          quiet));
+
+  static constexpr const char* kP3normToken = "3-norm:";
+  const auto p3norm_token_position = standard_output.find(kP3normToken);
+  CHECK_OR_RETURN(p3norm_token_position != std::string::npos, quiet)
+      << "\"3-norm:\" token not found in \"" << standard_output << "\"";
+  ButteraugliDistortions distortions;
+  distortions.max_norm =
+      std::stof(Trim(standard_output.substr(0, p3norm_token_position)));
+  distortions.p3norm = std::stof(Trim(standard_output.substr(
+      p3norm_token_position + std::strlen(kP3normToken))));
+  return distortions;
 }
 
 StatusOr<float> GetDssimDistortion(const std::string& reference_path,
-                                   const WP2::ArgbBuffer& reference,
                                    const std::string& image_path,
-                                   const WP2::ArgbBuffer& image,
-                                   const TaskInput& task,
                                    const std::string& metric_binary_folder_path,
-                                   size_t thread_id, bool quiet) {
+                                   bool quiet) {
   // Metric binaries are not available: just return -1 for simplicity.
   if (metric_binary_folder_path.empty()) return -1;
 
@@ -259,18 +395,45 @@ StatusOr<float> GetDssimDistortion(const std::string& reference_path,
       "release" / "dssim";
   ASSIGN_OR_RETURN(
       const std::string standard_output,
-      GetBinaryDistortion(reference_path, reference, image_path, image, task,
-                          metric_binary_path, thread_id, quiet));
+      GetBinaryDistortion(reference_path, image_path, metric_binary_path,
+                          quiet));
   return std::stof(Trim(Split(standard_output, '\t').front()));
 }
 
+// Returns the kSamplePsnr of image compared to reference, as if its rows were
+// given to a RowDistortion.
+StatusOr<float> GetSamplePsnr(const WP2::ArgbBuffer& reference,
+                              const WP2::ArgbBuffer& image, bool quiet) {
+  CHECK_OR_RETURN(image.width() == reference.width() &&
+                      image.height() == reference.height(),
+                  quiet)
+      << "Cannot compare a " << image.width() << "x" << image.height()
+      << " image to a " << reference.width() << "x" << reference.height()
+      << " one";
+  const WP2::ArgbBuffer* final_image = &image;
+  WP2::ArgbBuffer converted(reference.format());
+  if (image.format() != reference.format()) {
+    // The samples are compared in the format of the reference.
+    CHECK_OR_RETURN(converted.ConvertFrom(image) == WP2_STATUS_OK, quiet)
+        << "Cannot convert the decoded pixels to the format of the original";
+    final_image = &converted;
+  }
+  RowDistortion row_distortion(reference);
+  for (uint32_t y = 0; y < reference.height(); ++y) {
+    row_distortion.AddRow(/*x=*/0, y, reference.width(),
+                          final_image->GetRow(y));
+  }
+  return row_distortion.Psnr(quiet);
+}
+
 StatusOr<float> GetDistortion(
     const std::string& reference_path, const WP2::ArgbBuffer& reference,
     const std::string& image_path, const WP2::ArgbBuffer& image,
     const TaskInput& task, const std::string& metric_binary_folder_path,
-    DistortionMetric metric, size_t thread_id, bool quiet) {
+    DistortionMetric metric, bool quiet) {
   if (metric_binary_folder_path == "no_metric_binary_for_testing" &&
-      metric != DistortionMetric::kLibwebp2Psnr) {
+      metric != DistortionMetric::kLibwebp2Psnr &&
+      metric != DistortionMetric::kSamplePsnr) {
     // Return a placeholder value which does not need actual distortion binaries
     // for testing.
     return GetLibwebp2Distortion(reference, image, task, WP2::PSNR, quiet);
@@ -282,53 +445,166 @@ StatusOr<float> GetDistortion(
     case DistortionMetric::kLibwebp2Ssim:
       return GetLibwebp2Distortion(reference, image, task, WP2::SSIM, quiet);
     case DistortionMetric::kLibjxlButteraugli:
+    case DistortionMetric::kLibjxlP3norm: {
+      ASSIGN_OR_RETURN(const ButteraugliDistortions distortions,
+                       GetButteraugliDistortions(reference_path, reference,
+                                                 image_path, image,
+                                                 metric_binary_folder_path,
+                                                 quiet));
+      float distortion = metric == DistortionMetric::kLibjxlButteraugli
+                             ? distortions.max_norm
+                             : distortions.p3norm;
+      return distortion;
+    }
     case DistortionMetric::kLibjxlSsimulacra:
     case DistortionMetric::kLibjxlSsimulacra2:
-    case DistortionMetric::kLibjxlP3norm:
       return GetLibjxlDistortion(reference_path, reference, image_path, image,
-                                 task, metric_binary_folder_path, metric,
-                                 thread_id, quiet);
+                                 metric_binary_folder_path, metric, quiet);
     case DistortionMetric::kDssim:
-      return GetDssimDistortion(reference_path, reference, image_path, image,
-                                task, metric_binary_folder_path, thread_id,
-                                quiet);
+      return GetDssimDistortion(reference_path, image_path,
+                                metric_binary_folder_path, quiet);
+    case DistortionMetric::kSamplePsnr:
+      return GetSamplePsnr(reference, image, quiet);
   }
   return Status::kUnknownError;
 }
 
+// Same as GetDistortion() for each of the given metrics, but the evaluations
+// shared by several metrics are only done once.
+StatusOr<std::vector<float>> GetDistortions(
+    const std::string& reference_path, const WP2::ArgbBuffer& reference,
+    const std::string& image_path, const WP2::ArgbBuffer& image,
+    const TaskInput& task, const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& metrics, size_t thread_id,
+    TempFileCache* reference_file_cache, bool quiet) {
+  // Write the PNG files read by the metric binaries once for all metrics.
+  MetricInputFiles files;
+  if (metric_binary_folder_path != "no_metric_binary_for_testing" &&
+      !metric_binary_folder_path.empty() && NeedsMetricBinaries(metrics)) {
+    OK_OR_RETURN(GetMetricInputFiles(reference_path, reference, image_path,
+                                     image, thread_id, reference_file_cache,
+                                     quiet, files));
+  } else {
+    files.reference_path = reference_path;
+    files.image_path = image_path;
+  }
+  const std::string& reference_file_path = files.reference_path;
+  const std::string& image_file_path = files.image_path;
+
+  std::vector<float> distortions(metrics.size());
+  std::optional<ButteraugliDistortions> butteraugli;
+  // PSNR first and SSIM last, or only one of them.
+  std::optional<std::vector<float>> libwebp2;
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const DistortionMetric metric = metrics[i];
+    // The evaluations shared by several metrics are traced as the first one.
+    TraceScope trace(kDistortionMetricToStr[static_cast<size_t>(metric)]);
+    if (metric_binary_folder_path != "no_metric_binary_for_testing" &&
+        (metric == DistortionMetric::kLibwebp2Psnr ||
+         metric == DistortionMetric::kLibwebp2Ssim)) {
+      if (!libwebp2.has_value()) {
+        std::vector<WP2::MetricType> libwebp2_metrics;
+        for (DistortionMetric other : metrics) {
+          if (other == DistortionMetric::kLibwebp2Psnr) {
+            libwebp2_metrics.insert(libwebp2_metrics.begin(), WP2::PSNR);
+          } else if (other == DistortionMetric::kLibwebp2Ssim) {
+            libwebp2_metrics.push_back(WP2::SSIM);
+          }
+        }
+        ASSIGN_OR_RETURN(libwebp2,
+                         GetLibwebp2Distortions(reference, image, task,
+                                                libwebp2_metrics, quiet));
+      }
+      distortions[i] = metric == DistortionMetric::kLibwebp2Psnr
+                           ? libwebp2->front()
+                           : libwebp2->back();
+    } else if (metric_binary_folder_path != "no_metric_binary_for_testing" &&
+               (metric == DistortionMetric::kLibjxlButteraugli ||
+                metric == DistortionMetric::kLibjxlP3norm)) {
+      if (!butteraugli.has_value()) {
+        ASSIGN_OR_RETURN(butteraugli,
+                         GetButteraugliDistortions(
+                             reference_file_path, reference, image_file_path,
+                             image, metric_binary_folder_path, quiet));
+      }
+      distortions[i] = metric == DistortionMetric::kLibjxlButteraugli
+                           ? butteraugli->max_norm
+                           : butteraugli->p3norm;
+    } else {
+      ASSIGN_OR_RETURN(distortions[i],
+                       GetDistortion(reference_file_path, reference,
+                                     image_file_path, image, task,
+                                     metric_binary_folder_path, metric,
+                                     quiet));
+    }
+  }
+  return distortions;
+}
+
+// Frames a[a_index] and b[b_index] displayed together for duration_ms.
+struct FramePair {
+  size_t a_index;
+  size_t b_index;
+  uint32_t duration_ms;
+};
+
+// Returns true if the frames at indices i and j of image have the same pixels.
+StatusOr<bool> SameFrames(const Image& image, size_t i, size_t j, bool quiet) {
+  if (i == j) return true;
+  const WP2::ArgbBuffer& a = image[i].pixels;
+  const WP2::ArgbBuffer& b = image[j].pixels;
+  if (a.format() != b.format() || a.width() != b.width() ||
+      a.height() != b.height()) {
+    return false;
+  }
+  return PixelEquality(a, b, quiet);
+}
+
 }  // namespace
 
-StatusOr<float> GetAverageDistortion(
+StatusOr<std::vector<float>> GetAverageDistortions(
     const std::string& a_path, const Image& a, const std::string& b_path,
     const Image& b, const TaskInput& task,
-    const std::string& metric_binary_folder_path, DistortionMetric metric,
-    size_t thread_id, bool quiet) {
+    const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& metrics, size_t thread_id,
+    uint32_t num_frame_threads, TempFileCache* reference_file_cache,
+    bool quiet) {
   CHECK_OR_RETURN(!a.empty() && !b.empty(), quiet);
+  CHECK_OR_RETURN(num_frame_threads > 0, quiet);
   if (a.size() == 1 && b.size() == 1) {
-    return GetDistortion(a_path, a.front().pixels, b_path, b.front().pixels,
-                         task, metric_binary_folder_path, metric, thread_id,
-                         quiet);
+    return GetDistortions(a_path, a.front().pixels, b_path, b.front().pixels,
+                          task, metric_binary_folder_path, metrics, thread_id,
+                          reference_file_cache, quiet);
   }
 
   const uint32_t a_duration_ms = GetDurationMs(a);
   CHECK_OR_RETURN(a_duration_ms > 0, quiet);
   CHECK_OR_RETURN(a_duration_ms == GetDurationMs(b), quiet);
 
-  float distortion_sum = 0;
+  // List the pairs of frames displayed at the same time, merging the
+  // consecutive pairs showing the same pixels so that static segments are only
+  // evaluated once.
+  std::vector<FramePair> pairs;
   size_t a_index = 0, b_index = 0;
   uint32_t previous_time = 0, a_time = 0, b_time = 0;  // milliseconds
   do {
-    ASSIGN_OR_RETURN(
-        const float distortion,
-        GetDistortion(a_path, a[a_index].pixels, b_path, b[b_index].pixels,
-                      task, metric_binary_folder_path, metric, thread_id,
-                      quiet));
-
     const uint32_t next_a_time = a_time + a[a_index].duration_ms;
     const uint32_t next_b_time = b_time + b[b_index].duration_ms;
     const uint32_t current_time = std::min(next_a_time, next_b_time);
-    // Weigh the distortion by frame duration.
-    distortion_sum += distortion * (current_time - previous_time);
+    bool is_same_pair = false;
+    if (!pairs.empty()) {
+      ASSIGN_OR_RETURN(const bool is_same_a,
+                       SameFrames(a, pairs.back().a_index, a_index, quiet));
+      if (is_same_a) {
+        ASSIGN_OR_RETURN(is_same_pair,
+                         SameFrames(b, pairs.back().b_index, b_index, quiet));
+      }
+    }
+    if (is_same_pair) {
+      pairs.back().duration_ms += current_time - previous_time;
+    } else {
+      pairs.push_back({a_index, b_index, current_time - previous_time});
+    }
 
     if (current_time >= next_a_time) {
       ++a_index;
@@ -342,16 +618,74 @@ StatusOr<float> GetAverageDistortion(
   } while (a_index < a.size() && b_index < b.size());
   CHECK_OR_RETURN(a_index == a.size() && b_index == b.size(), quiet);
   CHECK_OR_RETURN(a_time == b_time && a_time == a_duration_ms, quiet);
-  return distortion_sum / a_duration_ms;
+
+  // Evaluate the pairs in parallel. Each thread has its own temporary files.
+  std::vector<std::vector<float>> pair_distortions(pairs.size());
+  std::vector<Status> pair_statuses(pairs.size(), Status::kOk);
+  std::atomic<size_t> next_pair_index{0};
+  const auto evaluate_pairs = [&](size_t slot) {
+    for (size_t i = next_pair_index++; i < pairs.size();
+         i = next_pair_index++) {
+      StatusOr<std::vector<float>> distortions = GetDistortions(
+          a_path, a[pairs[i].a_index].pixels, b_path,
+          b[pairs[i].b_index].pixels, task, metric_binary_folder_path, metrics,
+          thread_id * num_frame_threads + slot, reference_file_cache, quiet);
+      pair_statuses[i] = distortions.status;
+      pair_distortions[i] = std::move(distortions.value);
+    }
+  };
+  const size_t num_threads = std::min<size_t>(num_frame_threads, pairs.size());
+  std::vector<std::thread> threads;
+  for (size_t slot = 1; slot < num_threads; ++slot) {
+    threads.emplace_back(evaluate_pairs, slot);
+  }
+  evaluate_pairs(/*slot=*/0);
+  for (std::thread& thread : threads) thread.join();
+
+  // Weigh the distortions by frame duration, in timeline order.
+  std::vector<float> distortion_sums(metrics.size(), 0);
+  for (size_t p = 0; p < pairs.size(); ++p) {
+    OK_OR_RETURN(pair_statuses[p]);
+    for (size_t i = 0; i < metrics.size(); ++i) {
+      distortion_sums[i] += pair_distortions[p][i] * pairs[p].duration_ms;
+    }
+  }
+  for (float& distortion_sum : distortion_sums) {
+    distortion_sum /= a_duration_ms;
+  }
+  return distortion_sums;
+}
+
+StatusOr<float> GetAverageDistortion(
+    const std::string& a_path, const Image& a, const std::string& b_path,
+    const Image& b, const TaskInput& task,
+    const std::string& metric_binary_folder_path, DistortionMetric metric,
+    size_t thread_id, bool quiet) {
+  ASSIGN_OR_RETURN(const std::vector<float> distortions,
+                   GetAverageDistortions(a_path, a, b_path, b, task,
+                                         metric_binary_folder_path, {metric},
+                                         thread_id, /*num_frame_threads=*/1,
+                                         /*reference_file_cache=*/nullptr,
+                                         quiet));
+  float distortion = distortions.front();
+  return distortion;
 }
 
 StatusOr<bool> PixelEquality(const WP2::ArgbBuffer& a, const WP2::ArgbBuffer& b,
                              bool quiet) {
   CHECK_OR_RETURN(a.format() == b.format(), quiet);
   CHECK_OR_RETURN(a.width() == b.width() && a.height() == b.height(), quiet);
+  if (a.height() == 0) return true;
+  const size_t row_size = size_t{a.width()} * WP2FormatBpp(a.format());
+  if (a.stride() == row_size && b.stride() == row_size) {
+    // Unpadded buffers are compared in one go.
+    return BytesEqual(static_cast<const uint8_t*>(a.GetRow(0)),
+                      static_cast<const uint8_t*>(b.GetRow(0)),
+                      row_size * a.height());
+  }
   for (uint32_t y = 0; y < a.height(); ++y) {
-    if (std::memcmp(a.GetRow(y), b.GetRow(y),
-                    a.width() * WP2FormatBpp(a.format())) != 0) {
+    if (!BytesEqual(static_cast<const uint8_t*>(a.GetRow(y)),
+                    static_cast<const uint8_t*>(b.GetRow(y)), row_size)) {
       return false;
     }
   }
@@ -393,6 +727,55 @@ StatusOr<bool> PixelEquality(const Image& a, const Image& b, bool quiet) {
   return true;
 }
 
+void RowDistortion::AddRow(uint32_t x, uint32_t y, uint32_t num_pixels,
+                           const void* pixels) {
+  if (y >= reference_.height() || x > reference_.width() ||
+      num_pixels > reference_.width() - x) {
+    out_of_bounds_ = true;
+    return;
+  }
+  const uint32_t num_channels_and_bytes = WP2FormatBpp(reference_.format());
+  const size_t offset = size_t{x} * num_channels_and_bytes;
+  const size_t num_bytes = size_t{num_pixels} * num_channels_and_bytes;
+  const uint8_t* reference_row =
+      static_cast<const uint8_t*>(reference_.GetRow(y)) + offset;
+  uint64_t sum;
+  if (WP2Formatbpc(reference_.format()) == 8) {
+    sum = SumOfSquaredDifferences(reference_row,
+                                  static_cast<const uint8_t*>(pixels),
+                                  num_bytes);
+  } else {
+    sum = SumOfSquaredDifferences(
+        reinterpret_cast<const uint16_t*>(reference_row),
+        static_cast<const uint16_t*>(pixels), num_bytes / sizeof(uint16_t));
+  }
+  sum_of_squared_differences_ += sum;
+  num_received_pixels_ += num_pixels;
+}
+
+StatusOr<bool> RowDistortion::PixelEquality(bool quiet) const {
+  CHECK_OR_RETURN(!out_of_bounds_, quiet) << "Decoded row out of bounds";
+  CHECK_OR_RETURN(num_received_pixels_ ==
+                      uint64_t{reference_.width()} * reference_.height(),
+                  quiet)
+      << "Decoded " << num_received_pixels_.load() << " pixels instead of "
+      << reference_.width() << "x" << reference_.height();
+  return sum_of_squared_differences_ == 0;
+}
+
+StatusOr<float> RowDistortion::Psnr(bool quiet) const {
+  ASSIGN_OR_RETURN(const bool pixel_equality, PixelEquality(quiet));
+  if (pixel_equality) return kNoDistortion;
+  const uint32_t bpc = WP2Formatbpc(reference_.format());
+  const double max_sample = static_cast<double>((1u << bpc) - 1);
+  const double num_samples =
+      static_cast<double>(num_received_pixels_) *
+      (WP2FormatBpp(reference_.format()) / ((bpc + 7) / 8));
+  const double mse = sum_of_squared_differences_ / num_samples;
+  const double psnr = 10 * std::log10(max_sample * max_sample / mse);
+  return static_cast<float>(std::min(psnr, double{kNoDistortion}));
+}
+
 #else
 StatusOr<float> GetAverageDistortion(const std::string&, const Image&,
                                      const std::string&, const Image&,
@@ -400,6 +783,12 @@ StatusOr<float> GetAverageDistortion(const std::string&, const Image&,
                                      DistortionMetric, size_t, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Computing distortions requires HAS_WEBP2";
 }
+StatusOr<std::vector<float>> GetAverageDistortions(
+    const std::string&, const Image&, const std::string&, const Image&,
+    const TaskInput&, const std::string&, const std::vector<DistortionMetric>&,
+    size_t, uint32_t, TempFileCache*, bool quiet) {
+  CHECK_OR_RETURN(false, quiet) << "Computing distortions requires HAS_WEBP2";
+}
 StatusOr<bool> PixelEquality(const Image&, const Image&, bool quiet) {
   CHECK_OR_RETURN(false, quiet) << "Equality check requires HAS_WEBP2";
 }
@@ -15,12 +15,16 @@
 #ifndef SRC_DISTORTION_H_
 #define SRC_DISTORTION_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "src/base.h"
 #include "src/frame.h"
 #include "src/task.h"
+#include "src/temp_file_cache.h"
 
 #if defined(HAS_WEBP2)
 #include "third_party/libwebp2/src/wp2/base.h"
@@ -28,6 +32,11 @@
 
 namespace codec_compare_gen {
 
+// Returns true if any of the given metrics (all the IsComputedByDefault() ones
+// if empty) is computed by a binary found in metric_binary_folder_path rather
+// than in this process.
+bool NeedsMetricBinaries(const std::vector<DistortionMetric>& metrics);
+
 // Computes the average distortion between the given frame sequences.
 // They must have the same total duration.
 StatusOr<float> GetAverageDistortion(
@@ -36,6 +45,22 @@ StatusOr<float> GetAverageDistortion(
     const std::string& metric_binary_folder_path, DistortionMetric metric,
     size_t thread_id, bool quiet);
 
+// Same as GetAverageDistortion() for each of the given metrics, in the same
+// order. Metrics computed by the same evaluation (such as kLibjxlButteraugli
+// and kLibjxlP3norm) share it for each pair of frames.
+// The PNG files written for the metric binaries from the frames of a are
+// reused through reference_file_cache. Can be null.
+// The pairs of animation frames are evaluated by up to num_frame_threads
+// threads, and consecutive pairs showing the same pixels only once. Callers
+// must give the same num_frame_threads for their temporary files not to clash.
+StatusOr<std::vector<float>> GetAverageDistortions(
+    const std::string& a_path, const Image& a, const std::string& b_path,
+    const Image& b, const TaskInput& task,
+    const std::string& metric_binary_folder_path,
+    const std::vector<DistortionMetric>& metrics, size_t thread_id,
+    uint32_t num_frame_threads, TempFileCache* reference_file_cache,
+    bool quiet);
+
 // Returns true if all pixels match between the two given frame sequences.
 // They must have the same total duration.
 StatusOr<bool> PixelEquality(const Image& a, const Image& b, bool quiet);
@@ -43,6 +68,31 @@ StatusOr<bool> PixelEquality(const Image& a, const Image& b, bool quiet);
 #if defined(HAS_WEBP2)
 StatusOr<bool> PixelEquality(const WP2::ArgbBuffer& a, const WP2::ArgbBuffer& b,
                              bool quiet);
+
+// Compares the rows of a decoded image to a reference as they are decoded, so
+// that the whole decoded image is never held in memory. See RowCallback.
+class RowDistortion {
+ public:
+  // The reference must outlive this instance. The decoded rows must be in its
+  // sample format.
+  explicit RowDistortion(const WP2::ArgbBuffer& reference)
+      : reference_(reference) {}
+
+  // Thread-safe.
+  void AddRow(uint32_t x, uint32_t y, uint32_t num_pixels, const void* pixels);
+
+  // Returns true if all pixels of the reference were received and match.
+  StatusOr<bool> PixelEquality(bool quiet) const;
+  // Returns the kSamplePsnr over all samples of all channels, or kNoDistortion
+  // if they all match.
+  StatusOr<float> Psnr(bool quiet) const;
+
+ private:
+  const WP2::ArgbBuffer& reference_;
+  std::atomic<uint64_t> num_received_pixels_{0};
+  std::atomic<uint64_t> sum_of_squared_differences_{0};
+  std::atomic<bool> out_of_bounds_{false};
+};
 #endif
 
 }  // namespace codec_compare_gen
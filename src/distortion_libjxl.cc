@@ -0,0 +1,167 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/distortion_libjxl.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "src/base.h"
+
+#if defined(HAS_WEBP2)
+#include "third_party/libwebp2/src/wp2/base.h"
+#endif
+
+#if defined(HAS_LIBJXL_METRICS)
+// Internal libjxl headers, matching the version pinned in deps.sh.
+#include "jxl/cms.h"
+#include "jxl/types.h"
+#include "lib/jxl/base/span.h"
+#include "lib/jxl/butteraugli/butteraugli.h"
+#include "lib/jxl/codec_in_out.h"
+#include "lib/jxl/color_encoding_internal.h"
+#include "lib/jxl/enc_butteraugli_comparator.h"
+#include "lib/jxl/enc_external_image.h"
+#include "lib/jxl/image.h"
+#include "tools/no_memory_manager.h"
+#include "tools/ssimulacra2.h"
+#endif  // HAS_LIBJXL_METRICS
+
+namespace codec_compare_gen {
+
+#if defined(HAS_WEBP2) && defined(HAS_LIBJXL_METRICS)
+
+namespace {
+
+// Returns the pixels as an sRGB bundle, with the same channels and bit depth
+// as the PNG file that SaveImage() would have written for the metric binaries.
+StatusOr<std::unique_ptr<jxl::CodecInOut>> ToCodecInOut(
+    const WP2::ArgbBuffer& buffer, bool quiet) {
+  const bool has_alpha = WP2FormatHasAlpha(buffer.format());
+  const uint32_t bit_depth = WP2Formatbpc(buffer.format()) > 8 ? 16 : 8;
+  const WP2SampleFormat format =
+      bit_depth == 16 ? (has_alpha ? WP2_RGBA_64 : WP2_RGB_48)
+                      : (has_alpha ? WP2_RGBA_32 : WP2_RGB_24);
+  WP2::ArgbBuffer converted(format);
+  const WP2::ArgbBuffer* pixels = &buffer;
+  if (buffer.format() != format) {
+    CHECK_OR_RETURN(converted.ConvertFrom(buffer) == WP2_STATUS_OK, quiet);
+    pixels = &converted;
+  }
+
+  const size_t row_size = pixels->width() * WP2FormatBpp(format);
+  std::vector<uint8_t> bytes(row_size * pixels->height());
+  for (uint32_t y = 0; y < pixels->height(); ++y) {
+    std::memcpy(bytes.data() + y * row_size, pixels->GetRow(y), row_size);
+  }
+  const JxlPixelFormat pixel_format = {
+      has_alpha ? 4u : 3u, bit_depth == 16 ? JXL_TYPE_UINT16 : JXL_TYPE_UINT8,
+      JXL_NATIVE_ENDIAN, /*align=*/0};
+
+  auto io =
+      std::make_unique<jxl::CodecInOut>(jpegxl::tools::NoMemoryManager());
+  io->metadata.m.SetUintSamples(bit_depth);
+  io->metadata.m.color_encoding = jxl::ColorEncoding::SRGB(/*is_gray=*/false);
+  if (has_alpha) io->metadata.m.SetAlphaBits(bit_depth);
+  CHECK_OR_RETURN(io->SetSize(pixels->width(), pixels->height()), quiet);
+  CHECK_OR_RETURN(jxl::ConvertFromExternal(
+                      jxl::Bytes(bytes.data(), bytes.size()), pixels->width(),
+                      pixels->height(), io->metadata.m.color_encoding,
+                      bit_depth, pixel_format, /*pool=*/nullptr, &io->Main()),
+                  quiet)
+      << "ConvertFromExternal() failed";
+  return io;
+}
+
+}  // namespace
+
+bool IsInProcessDistortion(DistortionMetric metric) {
+  // SSIMULACRA (version 1) and DSSIM are only available as binaries.
+  return metric == DistortionMetric::kLibjxlButteraugli ||
+         metric == DistortionMetric::kLibjxlP3norm ||
+         metric == DistortionMetric::kLibjxlSsimulacra2;
+}
+
+StatusOr<float> GetInProcessDistortion(const WP2::ArgbBuffer& reference,
+                                       const WP2::ArgbBuffer& image,
+                                       DistortionMetric metric, bool quiet) {
+  CHECK_OR_RETURN(IsInProcessDistortion(metric), quiet);
+  if (metric != DistortionMetric::kLibjxlSsimulacra2) {
+    ASSIGN_OR_RETURN(const ButteraugliDistortions distortions,
+                     GetInProcessButteraugliDistortions(reference, image,
+                                                        quiet));
+    float distortion = metric == DistortionMetric::kLibjxlButteraugli
+                           ? distortions.max_norm
+                           : distortions.p3norm;
+    return distortion;
+  }
+
+  ASSIGN_OR_RETURN(const std::unique_ptr<jxl::CodecInOut> reference_io,
+                   ToCodecInOut(reference, quiet));
+  ASSIGN_OR_RETURN(const std::unique_ptr<jxl::CodecInOut> image_io,
+                   ToCodecInOut(image, quiet));
+  const jxl::StatusOr<Msssim> msssim =
+      ComputeSSIMULACRA2(reference_io->Main(), image_io->Main());
+  CHECK_OR_RETURN(msssim.ok(), quiet) << "ComputeSSIMULACRA2() failed";
+  return static_cast<float>(msssim.value_().Score());
+}
+
+StatusOr<ButteraugliDistortions> GetInProcessButteraugliDistortions(
+    const WP2::ArgbBuffer& reference, const WP2::ArgbBuffer& image,
+    bool quiet) {
+  ASSIGN_OR_RETURN(const std::unique_ptr<jxl::CodecInOut> reference_io,
+                   ToCodecInOut(reference, quiet));
+  ASSIGN_OR_RETURN(const std::unique_ptr<jxl::CodecInOut> image_io,
+                   ToCodecInOut(image, quiet));
+
+  // Same default parameters as butteraugli_main.
+  const jxl::ButteraugliParams params;
+  jxl::ImageF distmap;
+  const jxl::StatusOr<float> distance = jxl::ButteraugliDistance(
+      reference_io->Main(), image_io->Main(), params, *JxlGetDefaultCms(),
+      &distmap, /*pool=*/nullptr);
+  CHECK_OR_RETURN(distance.ok(), quiet) << "ButteraugliDistance() failed";
+  ButteraugliDistortions distortions;
+  distortions.max_norm = distance.value_();
+  distortions.p3norm =
+      static_cast<float>(jxl::ComputeDistanceP(distmap, params, /*p=*/3));
+  return distortions;
+}
+
+#else
+
+bool IsInProcessDistortion(DistortionMetric) { return false; }
+
+#if defined(HAS_WEBP2)
+StatusOr<float> GetInProcessDistortion(const WP2::ArgbBuffer&,
+                                       const WP2::ArgbBuffer&, DistortionMetric,
+                                       bool quiet) {
+  CHECK_OR_RETURN(false, quiet)
+      << "In-process metrics require CCGEN_IN_PROCESS_METRICS";
+  return Status::kUnknownError;
+}
+StatusOr<ButteraugliDistortions> GetInProcessButteraugliDistortions(
+    const WP2::ArgbBuffer&, const WP2::ArgbBuffer&, bool quiet) {
+  CHECK_OR_RETURN(false, quiet)
+      << "In-process metrics require CCGEN_IN_PROCESS_METRICS";
+  return Status::kUnknownError;
+}
+#endif  // HAS_WEBP2
+
+#endif  // HAS_WEBP2 && HAS_LIBJXL_METRICS
+
+}  // namespace codec_compare_gen
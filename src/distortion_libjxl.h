@@ -0,0 +1,49 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_DISTORTION_LIBJXL_H_
+#define SRC_DISTORTION_LIBJXL_H_
+
+#include "src/base.h"
+
+#if defined(HAS_WEBP2)
+#include "third_party/libwebp2/src/wp2/base.h"
+#endif
+
+namespace codec_compare_gen {
+
+// kLibjxlButteraugli and kLibjxlP3norm, computed from the same distance map.
+struct ButteraugliDistortions {
+  float max_norm;
+  float p3norm;
+};
+
+// Returns true if the metric can be computed by GetInProcessDistortion(),
+// meaning the binary was built with CCGEN_IN_PROCESS_METRICS.
+bool IsInProcessDistortion(DistortionMetric metric);
+
+#if defined(HAS_WEBP2)
+// Computes the metric by calling libjxl directly on the pixels, instead of
+// writing PNG files and running the metric binary built by deps.sh.
+StatusOr<float> GetInProcessDistortion(const WP2::ArgbBuffer& reference,
+                                       const WP2::ArgbBuffer& image,
+                                       DistortionMetric metric, bool quiet);
+StatusOr<ButteraugliDistortions> GetInProcessButteraugliDistortions(
+    const WP2::ArgbBuffer& reference, const WP2::ArgbBuffer& image,
+    bool quiet);
+#endif
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_DISTORTION_LIBJXL_H_
@@ -0,0 +1,200 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/encode_cache.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/mapped_file.h"
+#include "src/serialization.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+std::vector<std::unordered_set<int>> GetLossyQualities() {
+  std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<int>(Codec::kNumCodecs));
+  for (size_t i = 0; i < qualities_per_codec.size(); ++i) {
+    const std::vector<int> q = CodecLossyQualities(static_cast<Codec>(i));
+    qualities_per_codec[i] = std::unordered_set<int>(q.begin(), q.end());
+  }
+  return qualities_per_codec;
+}
+
+bool HasDistortions(const TaskOutput& output,
+                    const std::vector<DistortionMetric>& distortion_metrics) {
+  if (output.task_input.codec_settings.quality == kQualityLossless) {
+    return true;
+  }
+  if (distortion_metrics.empty()) {
+    for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+      if (IsComputedByDefault(static_cast<DistortionMetric>(m)) &&
+          std::isnan(output.distortions[m])) {
+        return false;
+      }
+    }
+  }
+  for (DistortionMetric metric : distortion_metrics) {
+    if (std::isnan(output.distortions[static_cast<size_t>(metric)])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+EncodeCache::EncodeCache(std::string folder_path, std::string measurement_key)
+    : folder_path_(std::move(folder_path)),
+      measurement_key_(std::move(measurement_key)),
+      qualities_per_codec_(GetLossyQualities()) {}
+
+bool EncodeCache::GetKey(const TaskInput& input, Key& key) {
+  bool is_hashed = false;
+  uint64_t image_hash = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = image_hashes_.find(input.image_path);
+    if (it != image_hashes_.end()) {
+      is_hashed = true;
+      image_hash = it->second;
+    }
+  }
+  if (!is_hashed) {
+    // Outside of the critical section because it reads the whole file.
+    MappedFile image;
+    if (image.Open(input.image_path, /*quiet=*/true) != Status::kOk) {
+      return false;
+    }
+    image_hash = StableHash(image.contents());
+    std::lock_guard<std::mutex> lock(mutex_);
+    image_hashes_[input.image_path] = image_hash;
+  }
+
+  const CodecSettings& codec_settings = input.codec_settings;
+  std::stringstream description;
+  description << CodecName(codec_settings.codec) << " "
+              << CodecVersion(codec_settings.codec) << ", "
+              << SubsamplingToString(codec_settings.chroma_subsampling)
+              << ", e" << codec_settings.effort << ", q"
+              << codec_settings.quality << ", t" << codec_settings.num_threads
+              << ", " << std::hex << std::setfill('0') << std::setw(16)
+              << image_hash << ", " << measurement_key_;
+  key.description = description.str();
+  std::stringstream file_stem;
+  file_stem << std::hex << std::setfill('0') << std::setw(16)
+            << StableHash(key.description);
+  key.file_stem = file_stem.str();
+  return true;
+}
+
+EncodeCache::Entry& EncodeCache::GetEntry(const Key& key) {
+  const auto [it, was_inserted] = entries_.try_emplace(key.file_stem);
+  Entry& entry = it->second;
+  if (!was_inserted) return entry;
+  std::ifstream file(std::filesystem::path(folder_path_) /
+                     (key.file_stem + ".csv"));
+  std::string line;
+  // A different description means a hash collision.
+  if (!std::getline(file, line) || line != key.description) return entry;
+  while (std::getline(file, line)) {
+    StatusOr<TaskOutput> output = TaskOutput::Unserialize(
+        line, qualities_per_codec_, /*quiet=*/true);
+    // Skips the truncated lines of interrupted runs.
+    if (output.status == Status::kOk) {
+      entry.outputs.push_back(std::move(output.value));
+    }
+  }
+  return entry;
+}
+
+bool EncodeCache::Reuse(const TaskInput& input, bool save_encoded,
+                        const std::vector<DistortionMetric>& distortion_metrics,
+                        TaskOutput& output) {
+  Key key;
+  if (!GetKey(input, key)) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry = GetEntry(key);
+  if (entry.num_reused >= entry.outputs.size()) return false;
+  const TaskOutput& recorded_output = entry.outputs[entry.num_reused];
+  if (!HasDistortions(recorded_output, distortion_metrics)) return false;
+  if (save_encoded) {
+    if (input.encoded_path.empty()) return false;
+    std::error_code error_code;
+    std::filesystem::copy_file(
+        std::filesystem::path(folder_path_) /
+            (key.file_stem + "." + CodecExtension(input.codec_settings.codec)),
+        input.encoded_path, std::filesystem::copy_options::overwrite_existing,
+        error_code);
+    if (error_code) return false;
+  }
+  output = recorded_output;
+  output.task_input = input;
+  ++entry.num_reused;
+  ++num_hits_;
+  return true;
+}
+
+void EncodeCache::Insert(const TaskOutput& output) {
+  if (output.is_extrapolated) return;  // Not measured.
+  Key key;
+  if (!GetKey(output.task_input, key)) return;
+  const std::filesystem::path entry_path =
+      std::filesystem::path(folder_path_) / (key.file_stem + ".csv");
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::error_code error_code;
+  const bool is_new = !std::filesystem::exists(entry_path, error_code);
+  std::ofstream file(entry_path, std::ios::app);
+  if (!file.is_open()) return;
+  if (is_new) file << key.description << std::endl;
+  file << output.Serialize() << std::endl;
+}
+
+void EncodeCache::InsertEncodedFile(const TaskInput& input) {
+  if (input.encoded_path.empty()) return;
+  Key key;
+  if (!GetKey(input, key)) return;
+  const std::filesystem::path cached_encoded_path =
+      std::filesystem::path(folder_path_) /
+      (key.file_stem + "." + CodecExtension(input.codec_settings.codec));
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::error_code error_code;
+  if (!std::filesystem::exists(cached_encoded_path, error_code)) {
+    std::filesystem::copy_file(input.encoded_path, cached_encoded_path,
+                               error_code);
+  }
+}
+
+size_t EncodeCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+}  // namespace codec_compare_gen
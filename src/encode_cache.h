@@ -0,0 +1,87 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_ENCODE_CACHE_H_
+#define SRC_ENCODE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Thread-safe outputs of the tasks run by previous comparisons, persisted in a
+// folder shared by any number of runs, with possibly different images, codecs
+// or results folders. An entry is keyed by the contents of the original image,
+// the codec version and settings, and how the tasks are measured, so an output
+// is only reused where the task would run the same way. Each entry keeps all
+// the outputs recorded for its key, so that the repetitions of a run reuse
+// distinct measurements.
+class EncodeCache {
+ public:
+  // Entries with another measurement_key are not shared, for example if the
+  // timings are aggregated differently.
+  EncodeCache(std::string folder_path, std::string measurement_key);
+
+  // Copies into output an output of input recorded by a previous run and not
+  // reused yet, with the paths of input, if it has all the distortion_metrics
+  // (the IsComputedByDefault() ones if empty). If save_encoded, the recorded
+  // encoded file is also copied to input.encoded_path, and nothing is reused
+  // without one. Returns false otherwise, in which case Insert() is expected
+  // after running the task.
+  bool Reuse(const TaskInput& input, bool save_encoded,
+             const std::vector<DistortionMetric>& distortion_metrics,
+             TaskOutput& output);
+  // Appends output to its entry for the next runs. Best effort.
+  void Insert(const TaskOutput& output);
+  // Records the file just encoded to input.encoded_path, unless one already
+  // was. Best effort.
+  void InsertEncodedFile(const TaskInput& input);
+
+  size_t num_hits() const;
+
+ private:
+  struct Key {
+    std::string description;  // Human-readable, first line of the entry file.
+    std::string file_stem;    // Hash of the description.
+  };
+  struct Entry {
+    std::vector<TaskOutput> outputs;  // Recorded by previous runs.
+    size_t num_reused = 0;
+  };
+
+  // Returns false if the original image cannot be read.
+  bool GetKey(const TaskInput& input, Key& key);
+  // Loads the outputs recorded for key once.
+  Entry& GetEntry(const Key& key);
+
+  const std::string folder_path_;
+  const std::string measurement_key_;
+  const std::vector<std::unordered_set<int>> qualities_per_codec_;
+  mutable std::mutex mutex_;  // Guards all fields below and the files.
+  std::unordered_map<std::string, uint64_t> image_hashes_;  // By image path.
+  std::unordered_map<std::string, Entry> entries_;  // By Key::file_stem.
+  size_t num_hits_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_ENCODE_CACHE_H_
@@ -14,14 +14,17 @@
 
 #include "src/frame.h"
 
+#include <cstddef>
 #include <cstdint>
 
 #if defined(HAS_WEBP2)
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "src/base.h"
+#include "src/buffer_pool.h"
 #include "src/codec_webp.h"
 #include "src/distortion.h"
 #include "src/task.h"
@@ -42,11 +45,26 @@ uint32_t GetDurationMs(const Image& image) {
 
 #if defined(HAS_WEBP2)
 
+Status AllocatePixels(uint32_t width, uint32_t height, Frame& frame,
+                      bool quiet) {
+  CHECK_OR_RETURN(width > 0 && height > 0, quiet)
+      << "Bad dimensions " << width << "x" << height;
+  const uint32_t stride = width * WP2FormatBpp(frame.pixels.format());
+  PooledBuffer storage = GetPooledBuffer(size_t{stride} * height);
+  CHECK_OR_RETURN(frame.pixels.SetExternal(width, height, storage.data(),
+                                           stride) == WP2_STATUS_OK,
+                  quiet);
+  frame.pixel_storage = std::move(storage);
+  return Status::kOk;
+}
+
 StatusOr<Image> CloneAs(const Image& from, WP2SampleFormat format, bool quiet) {
   Image to;
   to.reserve(from.size());
   for (const Frame& frame : from) {
     to.emplace_back(WP2::ArgbBuffer(format), frame.duration_ms);
+    OK_OR_RETURN(AllocatePixels(frame.pixels.width(), frame.pixels.height(),
+                                to.back(), quiet));
     CHECK_OR_RETURN(to.back().pixels.ConvertFrom(frame.pixels) == WP2_STATUS_OK,
                     quiet);
     // Check that there was no bit depth loss.
@@ -64,12 +82,10 @@ StatusOr<Image> SpreadTo8bit(const Image& from, bool quiet) {
     const WP2SampleFormat format = WP2FormatAtbpc(frame.pixels.format(), 8);
     CHECK_OR_RETURN(format != WP2_FORMAT_NUM, quiet);
     to.emplace_back(WP2::ArgbBuffer(format), frame.duration_ms);
-    CHECK_OR_RETURN(to.back().pixels.Resize(
-                        frame.pixels.width() *
-                            (WP2FormatBpp(frame.pixels.format()) /
-                             WP2FormatNumChannels(frame.pixels.format())),
-                        frame.pixels.height()) == WP2_STATUS_OK,
-                    quiet);
+    OK_OR_RETURN(AllocatePixels(
+        frame.pixels.width() * (WP2FormatBpp(frame.pixels.format()) /
+                                WP2FormatNumChannels(frame.pixels.format())),
+        frame.pixels.height(), to.back(), quiet));
     const uint32_t num_samples_per_row =
         WP2FormatNumChannels(frame.pixels.format()) * frame.pixels.width();
     for (uint32_t y = 0; y < frame.pixels.height(); ++y) {
@@ -89,6 +105,42 @@ StatusOr<Image> SpreadTo8bit(const Image& from, bool quiet) {
   return to;
 }
 
+StatusOr<Image> SpreadTo8bit(Image&& from, bool quiet) {
+  Image to;
+  to.reserve(from.size());
+  std::vector<uint16_t> row;
+  for (Frame& frame : from) {
+    const WP2SampleFormat format = WP2FormatAtbpc(frame.pixels.format(), 8);
+    CHECK_OR_RETURN(format != WP2_FORMAT_NUM, quiet);
+    CHECK_OR_RETURN(WP2Formatbpc(frame.pixels.format()) == 16, quiet);
+    const uint32_t num_samples_per_row =
+        WP2FormatNumChannels(frame.pixels.format()) * frame.pixels.width();
+    row.resize(num_samples_per_row);
+    // Same layout as the deep copy but within the memory of each 16-bit row,
+    // which has exactly as many bytes.
+    for (uint32_t y = 0; y < frame.pixels.height(); ++y) {
+      uint8_t* dst = reinterpret_cast<uint8_t*>(frame.pixels.GetRow(y));
+      std::memcpy(row.data(), dst, num_samples_per_row * sizeof(uint16_t));
+      for (uint32_t i = 0; i < num_samples_per_row; ++i) {
+        dst[i] = row[i] >> 8;
+        dst[i + num_samples_per_row] = row[i] & 0xFF;
+      }
+    }
+
+    to.emplace_back(WP2::ArgbBuffer(format), frame.duration_ms);
+    CHECK_OR_RETURN(
+        to.back().pixels.SetExternal(
+            frame.pixels.width() * 2, frame.pixels.height(),
+            reinterpret_cast<uint8_t*>(frame.pixels.GetRow(0)),
+            frame.pixels.stride()) == WP2_STATUS_OK,
+        quiet);
+    to.back().pixel_storage = std::move(frame.pixel_storage);
+    to.back().viewed_pixels =
+        std::make_unique<WP2::ArgbBuffer>(std::move(frame.pixels));
+  }
+  return to;
+}
+
 StatusOr<Image> MakeView(const Image& from, bool quiet) {
   Image to;
   to.reserve(from.size());
@@ -123,12 +175,21 @@ StatusOr<Image> ReadStillImageOrAnimation(const char* file_path,
           << image.size() << " of " << file_path;
 
       if (duration_ms == 0 && !is_last) {
-        std::cout << "Warning: 0-second frame " << image.size() << " of "
-                  << file_path << " was ignored" << std::endl;
+        // Not on stdout, which some tools reserve for their results.
+        if (!quiet) {
+          std::cerr << "Warning: 0-second frame " << image.size() << " of "
+                    << file_path << " was ignored" << std::endl;
+        }
         continue;
       }
       format = WP2FormatAtbpc(format, WP2Formatbpc(buffer.format()));
       CHECK_OR_RETURN(format != WP2_FORMAT_NUM, quiet);
+      if (image.empty() && is_last && buffer.format() == format) {
+        // Still image decoded in the right format. Take it without any copy.
+        buffer.metadata_.Clear();
+        image.emplace_back(std::move(buffer), duration_ms);
+        break;
+      }
       WP2::ArgbBuffer pixels(format);
       // All metadata is discarded during the conversion.
       CHECK_OR_RETURN(pixels.ConvertFrom(buffer) == WP2_STATUS_OK, quiet);
@@ -152,7 +213,7 @@ StatusOr<Image> ReadStillImageOrAnimation(const char* file_path,
 }
 
 Status WriteStillImageOrAnimation(const Image& image, const char* file_path,
-                                  bool quiet) {
+                                  bool quiet, int webp_effort) {
   if (image.size() == 1) {
     const WP2Status status =
         WP2::SaveImage(image.front().pixels, file_path, /*overwrite=*/true);
@@ -164,7 +225,7 @@ Status WriteStillImageOrAnimation(const Image& image, const char* file_path,
     // Keep whatever extension (.png) for the simplicity of the whole pipeline.
     const char* encoded_path = file_path;
     const TaskInput input = {
-        {Codec::kWebp, Subsampling::k444, /*effort=*/9, kQualityLossless},
+        {Codec::kWebp, Subsampling::k444, webp_effort, kQualityLossless},
         /*image_path=*/file_path,  // For better logs.
         encoded_path};
     CHECK_OR_RETURN(WP2Formatbpc(image.front().pixels.format()) == 8, quiet);
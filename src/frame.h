@@ -16,10 +16,13 @@
 #define SRC_FRAME_H_
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "src/base.h"
+#include "src/buffer_pool.h"
 
 #if defined(HAS_WEBP2)
 #include "third_party/libwebp2/src/wp2/base.h"
@@ -35,6 +38,11 @@ struct Frame {
       : pixels(std::move(pixels)), duration_ms(duration_ms) {};
 
   WP2::ArgbBuffer pixels;
+  // Memory of pixels if allocated by AllocatePixels(). Empty otherwise.
+  PooledBuffer pixel_storage;
+  // Buffer owning the memory of pixels if pixels reinterprets it in another
+  // sample format. Null otherwise. See SpreadTo8bit().
+  std::unique_ptr<WP2::ArgbBuffer> viewed_pixels;
 #endif
   uint32_t duration_ms;  // 0 for still images.
 };
@@ -42,16 +50,34 @@ struct Frame {
 // Still or animated image.
 using Image = std::vector<Frame>;
 
+// Receives num_pixels decoded pixels of row y starting at column x, in the
+// sample format requested from the decoder. Can be called by several threads
+// at once and in any order.
+using RowCallback = std::function<void(uint32_t x, uint32_t y,
+                                       uint32_t num_pixels, const void* pixels)>;
+
 uint32_t GetDurationMs(const Image& image);
 
 #if defined(HAS_WEBP2)
 
 inline constexpr WP2SampleFormat kARGB32 = WP2_ARGB_32;
 
+// Allocates width x height pixels in the format of frame.pixels from the buffer
+// pool of the calling thread, instead of a fresh allocation. See PooledBuffer.
+Status AllocatePixels(uint32_t width, uint32_t height, Frame& frame,
+                      bool quiet);
+
 // Makes a deep copy of the given frame sequence and converts the pixels to the
 // given format.
 StatusOr<Image> CloneAs(const Image& from, WP2SampleFormat format, bool quiet);
+
+// Considers the given 16-bit frame sequence as 8-bit and twice as wide: the
+// first half of each row contains the most significant bytes of the samples
+// and the second half the least significant ones.
+// The first overload makes a deep copy. The second one shuffles the bytes of
+// each row in place and returns views reinterpreting the memory of from.
 StatusOr<Image> SpreadTo8bit(const Image& from, bool quiet);
+StatusOr<Image> SpreadTo8bit(Image&& from, bool quiet);
 
 // Makes a shallow copy of the given frame sequence.
 StatusOr<Image> MakeView(const Image& from, bool quiet);
@@ -61,9 +87,9 @@ StatusOr<Image> ReadStillImageOrAnimation(const char* file_path,
                                           WP2SampleFormat format, bool quiet);
 
 // Writes a frame sequence to a file (PNG for still images, WebP for
-// animations).
+// animations, losslessly compressed at webp_effort in [0:9]).
 Status WriteStillImageOrAnimation(const Image& image, const char* file_path,
-                                  bool quiet);
+                                  bool quiet, int webp_effort = 9);
 
 #endif
 
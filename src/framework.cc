@@ -15,31 +15,70 @@
 #include "src/framework.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <set>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "src/artifact_writer.h"
+#include "src/async_line_writer.h"
 #include "src/base.h"
+#include "src/buffer_pool.h"
+#include "src/candidate_cache.h"
 #include "src/codec.h"
 #include "src/codec_basis.h"
+#include "src/codec_combination.h"
+#include "src/codec_context.h"
+#include "src/command_server.h"
+#include "src/cpu_affinity.h"
+#include "src/encode_cache.h"
+#include "src/framework_steps.h"
+#include "src/image_cache.h"
+#include "src/image_dedup.h"
+#include "src/image_header.h"
+#include "src/image_prefetcher.h"
+#include "src/mapped_file.h"
+#include "src/memory_governor.h"
+#include "src/memory_usage.h"
+#include "src/progress_tracker.h"
+#include "src/quality_search.h"
+#include "src/remote_tasks.h"
+#include "src/repetition_cache.h"
 #include "src/result_json.h"
 #include "src/serialization.h"
+#include "src/shard.h"
+#include "src/stop_signal.h"
 #include "src/task.h"
+#include "src/task_binary.h"
+#include "src/task_cost.h"
+#include "src/temp_file_cache.h"
 #include "src/timer.h"
+#include "src/trace.h"
 #include "src/worker.h"
 
 using seconds = std::chrono::duration<double>;
@@ -48,161 +87,962 @@ using chrono = std::chrono::high_resolution_clock;
 namespace codec_compare_gen {
 namespace {
 
-// Shared among all TaskWorkers. Guarded by a mutex in WorkerPool.
+// Original frames written as PNG files for the metric binaries are kept in a
+// fast temporary directory and shared across tasks, up to this size.
+constexpr size_t kReferenceFileCacheMaxNumBytes = size_t{256} << 20;
+
+// Completed tasks are appended to the progress file in batches, at least that
+// often.
+constexpr size_t kCompletedTasksMaxNumBufferedBytes = size_t{1} << 20;
+constexpr double kCompletedTasksMaxDelaySeconds = 1;
+
+// The status file is rewritten that often while the tasks run.
+constexpr double kStatusFileUpdatePeriodSeconds = 10;
+
+// Tasks sharing these settings are aggregated into the same JSON file.
+struct BatchKey {
+  Codec codec;
+  Subsampling chroma_subsampling;
+  int effort;
+  uint32_t num_threads;  // Timings with different thread counts are not mixed.
+
+  bool operator<(const BatchKey& other) const {
+    return std::tie(codec, chroma_subsampling, effort, num_threads) <
+           std::tie(other.codec, other.chroma_subsampling, other.effort,
+                    other.num_threads);
+  }
+};
+
+BatchKey GetBatchKey(const TaskInput& input) {
+  return {input.codec_settings.codec, input.codec_settings.chroma_subsampling,
+          input.codec_settings.effort, input.codec_settings.num_threads};
+}
+
+std::string GetBatchFileName(const BatchKey& batch) {
+  // Add a heading 0 when effort goes to 10 for better JSON file sorting.
+  const std::string effort_str =
+      ((batch.codec == Codec::kJpegXl && batch.effort < 10) ? "0" : "") +
+      std::to_string(batch.effort);
+  return CodecName(batch.codec) + "_" +
+         SubsamplingToString(batch.chroma_subsampling) + "_" + effort_str +
+         (batch.num_threads != 1 ? "_t" + std::to_string(batch.num_threads)
+                                 : "");
+}
+
+std::string GetBatchPrettyName(const CodecSettings& codec_settings) {
+  std::string batch_pretty_name = CodecPrettyName(
+      codec_settings.codec, codec_settings.quality == kQualityLossless,
+      codec_settings.chroma_subsampling, codec_settings.effort);
+  if (codec_settings.num_threads != 1) {
+    batch_pretty_name +=
+        " " + std::to_string(codec_settings.num_threads) + " threads";
+  }
+  return batch_pretty_name;
+}
+
+// Returns settings.stream_rows_min_num_pixels if the rows can be compared as
+// they are decoded, that is if SamplePSNR is the only requested metric.
+uint64_t StreamRowsMinNumPixels(const ComparisonSettings& settings) {
+  return settings.distortion_metrics.size() == 1 &&
+                 settings.distortion_metrics.front() ==
+                     DistortionMetric::kSamplePsnr
+             ? settings.stream_rows_min_num_pixels
+             : 0;
+}
+
+struct QueuedTask {
+  TaskInput input;
+  EncodeMode encode_mode = EncodeMode::kEncode;
+};
+
+// Task queued for its distortions, holding its memory admission until its
+// images are released by the DistortionWorker.
+struct AdmittedTask {
+  DecodedTask decoded;
+  MemoryAdmission admission;
+};
+
+// Shared among all TaskWorkers and DistortionWorkers. These are thread-safe so
+// that they do not contend on a single lock for each task.
 struct WorkerContext {
-  Status status = Status::kOk;  // kOk or first encountered error.
-  std::vector<TaskOutput> completed_tasks;
-  std::vector<TaskInput> remaining_tasks;
+  // Constant while the workers run.
   bool load_encoded_from_disk = false;
-  std::unordered_set<std::string> written_files;
-  std::string completed_tasks_file_path;
-  std::ofstream completed_tasks_file;
   std::string metric_binary_folder_path;
-  size_t num_tasks = 0;
-  size_t num_failures = 0;
-
+  std::vector<DistortionMetric> distortion_metrics;
+  uint32_t num_frame_threads = 1;
+  uint64_t stream_rows_min_num_pixels = 0;  // See EncodeAndDecode().
+  TimingSettings timing;
+  ResultsFormat results_format;
+  ResourceUsageSettings resource_usage;
+  ImageCache* original_image_cache = nullptr;      // Thread-safe. Can be null.
+  // Thread-safe. Can be null. Reads the images of the next queued tasks of
+  // each TaskWorker, up to prefetch_num_images distinct ones.
+  ImagePrefetcher* image_prefetcher = nullptr;
+  size_t prefetch_num_images = 0;
+  // Thread-safe. Can be null. Writes the decoded PNG files.
+  ArtifactWriter* artifact_writer = nullptr;
+  TempFileCache* reference_file_cache = nullptr;  // Thread-safe. Can be null.
+  // Thread-safe. Null if there is no repetition.
+  RepetitionCache* repetition_cache = nullptr;
+  EncodeCache* encode_cache = nullptr;  // Thread-safe. Can be null.
+  // Thread-safe. Can be null. Encoded candidates of the combination tasks.
+  CandidateCache* candidate_cache = nullptr;
+  // Thread-safe. Both null if the memory of the running tasks is not limited.
+  MemoryGovernor* memory_governor = nullptr;
+  TaskMemoryModel* memory_model = nullptr;
+  // Thread-safe. Tasks copied instead of run. Null if there is none.
+  DuplicateTasks* duplicate_tasks = nullptr;
   size_t max_num_failures = 0;
+  // No task is started once deadline is passed or once a stop signal is caught
+  // if stop_on_signal, nor any task that cost_model (if not null) predicts to
+  // end after deadline. See IsStopping().
+  chrono::time_point deadline = chrono::time_point::max();
+  bool stop_on_signal = false;
+  const TaskCostModel* cost_model = nullptr;
+  std::atomic<bool> is_stopping{false};  // Thread-safe. Set by IsStopping().
+  // CPUs each TaskWorker is restricted to. Empty if not pinned.
+  std::vector<std::vector<int>> task_worker_cpus;
   bool quiet = true;
-  size_t num_completed_tasks_since_start = 0;
   chrono::time_point start_time = chrono::now();
+
+  // Moved to queued_tasks while the workers run.
+  std::vector<TaskInput> remaining_tasks;
+  WorkStealingQueue<QueuedTask>* queued_tasks = nullptr;  // Thread-safe.
+  // Set if the qualities are bisected instead of all run. Thread-safe.
+  QualitySearches* quality_searches = nullptr;
+  // Set if the distortions are computed by DistortionWorkers.
+  BoundedQueue<AdmittedTask>* decoded_tasks = nullptr;  // Thread-safe.
+  size_t first_distortion_thread_id = 0;
+  // Set if remote workers take tasks from queued_tasks too. Their tasks are
+  // held, because they come back if the connection is lost.
+  bool has_remote_workers = false;
+  // Set if the tasks come from a coordinator instead. One connection per
+  // TaskWorker.
+  std::vector<std::unique_ptr<LineConnection>>* coordinator_connections =
+      nullptr;
+
+  std::mutex mutex;  // Guards the fields below while the workers run.
+  Status status = Status::kOk;  // kOk or first encountered error.
+  std::vector<TaskOutput> completed_tasks;
+  std::set<BatchKey> outdated_batches;  // JSON files to write.
+  size_t num_tasks = 0;
+  size_t num_failures = 0;
+  size_t num_completed_tasks_since_start = 0;
+  size_t num_abandoned_tasks = 0;  // Predicted to end after the deadline.
+  // Null to estimate the time left from task counts only.
+  ProgressTracker* progress_tracker = nullptr;
   chrono::time_point last_progress_display_time = chrono::now();
+
+  // Thread-safe. Null if there is no completed tasks file.
+  AsyncLineWriter* completed_tasks_writer = nullptr;
+  // Null unless the completed tasks file uses the binary format. Guarded by
+  // binary_task_encoder_mutex, which also keeps the strings appended before
+  // the records referring to them.
+  BinaryTaskEncoder* binary_task_encoder = nullptr;
+  std::mutex binary_task_encoder_mutex;
 };
 
+// Gives a copied task the encoded file of the task it was copied from.
+void CopyEncodedFile(const std::string& from_path, const std::string& to_path,
+                     bool quiet) {
+  std::error_code error;
+  if (from_path.empty() || to_path.empty() || from_path == to_path ||
+      !std::filesystem::exists(from_path, error)) {
+    return;
+  }
+  std::filesystem::remove(to_path, error);
+  std::filesystem::create_hard_link(from_path, to_path, error);
+  if (error) {
+    error.clear();  // For example across file systems.
+    std::filesystem::copy_file(from_path, to_path, error);
+  }
+  if (error && !quiet) {
+    std::cerr << "Warning: Could not copy " << from_path << " to " << to_path
+              << ": " << error.message() << std::endl;
+  }
+}
+
+// Records the outcome of a task and displays the progress from time to time.
+// Also records the copies of the task for the duplicate images, unless
+// is_copy. Thread-safe.
+void EndTaskOutput(WorkerContext& context, const TaskInput& task_input,
+                   const StatusOr<TaskOutput>& task_output,
+                   const std::string& serialized_task_output,
+                   bool is_copy = false) {
+  const std::vector<TaskInput> copies =
+      context.duplicate_tasks == nullptr || is_copy
+          ? std::vector<TaskInput>()
+          : context.duplicate_tasks->Take(task_input);
+  if (task_output.status == Status::kOk) {
+    for (const TaskInput& copy_input : copies) {
+      CopyEncodedFile(task_output.value.task_input.encoded_path,
+                      copy_input.encoded_path, context.quiet);
+      TaskOutput copy = task_output.value;
+      copy.task_input = copy_input;
+      const std::string serialized_copy = copy.Serialize();
+      EndTaskOutput(context, copy_input, std::move(copy), serialized_copy,
+                    /*is_copy=*/true);
+    }
+  }
+
+  if (task_output.status == Status::kOk &&
+      context.completed_tasks_writer != nullptr) {
+    if (context.binary_task_encoder != nullptr) {
+      std::lock_guard<std::mutex> lock(context.binary_task_encoder_mutex);
+      context.completed_tasks_writer->AppendBytes(
+          context.binary_task_encoder->Encode(task_output.value));
+    } else {
+      context.completed_tasks_writer->Append(serialized_task_output);
+    }
+  }
+
+  bool drain = false;
+  std::string progress;  // Displayed outside of the critical section.
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    if (task_output.status == Status::kOk) {
+      context.completed_tasks.push_back(task_output.value);
+      context.outdated_batches.insert(GetBatchKey(task_input));
+      ++context.num_completed_tasks_since_start;
+      // A copy took no time.
+      if (context.progress_tracker != nullptr && !is_copy) {
+        context.progress_tracker->OnCompleted(task_output.value);
+      }
+    } else {
+      if (context.status == Status::kOk) {
+        context.status = task_output.status;
+      }
+      context.num_tasks -= 1 + copies.size();
+      ++context.num_failures;
+      if (context.progress_tracker != nullptr) {
+        context.progress_tracker->OnFailed(task_input);
+      }
+      drain = context.num_failures > context.max_num_failures;
+    }
+
+    const double duration_since_last_progress_display =
+        seconds(chrono::now() - context.last_progress_display_time).count();
+    if (!context.quiet && duration_since_last_progress_display > 30) {
+      context.last_progress_display_time = chrono::now();
+      const double duration_since_start =
+          seconds(chrono::now() - context.start_time).count();
+      const size_t num_remaining_tasks =
+          (context.queued_tasks != nullptr ? context.queued_tasks->size()
+                                           : 0) +
+          (context.duplicate_tasks != nullptr ? context.duplicate_tasks->size()
+                                              : 0);
+      const size_t num_tasks_left =
+          context.num_tasks - context.completed_tasks.size();
+      const size_t num_tasks_in_fly = num_tasks_left - num_remaining_tasks;
+      double estimated_seconds_left =
+          context.num_completed_tasks_since_start == 0
+              ? -1
+              : duration_since_start /
+                    context.num_completed_tasks_since_start * num_tasks_left;
+      if (context.progress_tracker != nullptr) {
+        // Tasks of different codecs, efforts and image sizes are far from
+        // taking the same time.
+        estimated_seconds_left = context.progress_tracker->EstimateSecondsLeft(
+            duration_since_start, num_tasks_left);
+      }
+      std::ostringstream stream;
+      stream << context.completed_tasks.size() << "/" << context.num_tasks
+             << " (" << num_tasks_in_fly << " running, "
+             << duration_since_start << "s elapsed, ";
+      if (estimated_seconds_left < 0) {
+        stream << "unknown time left)";
+      } else {
+        stream << "~" << Timer::SecondsToString(estimated_seconds_left)
+               << " left)";
+      }
+      if (context.progress_tracker != nullptr) {
+        const std::string throughput =
+            context.progress_tracker->ThroughputToString(duration_since_start);
+        if (!throughput.empty()) stream << " (" << throughput << ")";
+      }
+      if (context.original_image_cache != nullptr) {
+        stream << " (image cache: " << context.original_image_cache->num_hits()
+               << " hits, " << context.original_image_cache->num_misses()
+               << " misses)";
+      }
+      if (context.image_prefetcher != nullptr) {
+        stream << " (prefetch: " << context.image_prefetcher->num_hits()
+               << " hits, " << context.image_prefetcher->num_misses()
+               << " misses, " << context.image_prefetcher->stall_seconds()
+               << "s stalled)";
+      }
+      if (context.repetition_cache != nullptr) {
+        stream << " (" << context.repetition_cache->num_hits()
+               << " repetitions reused their distortions)";
+      }
+      progress = stream.str();
+    }
+  }
+
+  if (drain && context.queued_tasks != nullptr) {
+    // Drain remaining tasks to exit quickly.
+    context.queued_tasks->Clear();
+  } else if (task_output.status != Status::kOk) {
+    std::cerr << "Failure: " << task_input.Serialize() << std::endl;
+  }
+  if (!progress.empty()) std::cout << progress << std::endl;
+}
+
+// Returns true if no task should be started anymore, because the deadline is
+// passed or a stop signal was caught. The queued tasks are then dropped and
+// left to a later run, and the running ones are let to end. Thread-safe.
+bool IsStopping(WorkerContext& context) {
+  if (context.is_stopping) return true;
+  const bool is_signaled =
+      context.stop_on_signal && StopSignalCatcher::IsStopRequested();
+  if (!is_signaled && chrono::now() < context.deadline) return false;
+  if (!context.is_stopping.exchange(true)) {
+    if (context.queued_tasks != nullptr) context.queued_tasks->Clear();
+    if (!context.quiet) {
+      std::cout << (is_signaled ? "Stop signal received" : "Time budget spent")
+                << ", waiting for the running tasks to end (send the signal "
+                   "again to abort them)"
+                << std::endl;
+    }
+  }
+  return true;
+}
+
+// Returns true if the task is predicted to end after the deadline.
+bool WouldOverrun(const WorkerContext& context, const TaskInput& task) {
+  if (context.cost_model == nullptr ||
+      context.deadline == chrono::time_point::max()) {
+    return false;
+  }
+  return chrono::now() + std::chrono::duration_cast<chrono::duration>(seconds(
+                             context.cost_model->Estimate(task))) >
+         context.deadline;
+}
+
+// Writes the progress of the run as JSON to status_file_path. The file is
+// replaced atomically so that it can be polled while being updated.
+Status WriteStatusFile(WorkerContext& context,
+                       const std::string& status_file_path, bool is_done,
+                       bool quiet) {
+  std::string json;
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    const double duration_since_start =
+        seconds(chrono::now() - context.start_time).count();
+    const size_t num_tasks_left =
+        is_done ? 0 : context.num_tasks - context.completed_tasks.size();
+    json = context.progress_tracker->ToJson(
+        duration_since_start, context.num_tasks, context.completed_tasks.size(),
+        context.num_failures, num_tasks_left, is_done);
+  }
+  const std::string temp_file_path = status_file_path + ".tmp";
+  {
+    std::ofstream file(temp_file_path, std::ios::trunc);
+    CHECK_OR_RETURN(file.is_open(), quiet)
+        << "Could not open " << temp_file_path << " for writing";
+    file << json;
+    CHECK_OR_RETURN(file.good(), quiet)
+        << "Could not write " << temp_file_path;
+  }
+  std::error_code error;
+  std::filesystem::rename(temp_file_path, status_file_path, error);
+  CHECK_OR_RETURN(!error, quiet) << "Could not rename " << temp_file_path
+                                 << " to " << status_file_path << ": "
+                                 << error.message();
+  return Status::kOk;
+}
+
+// Calls a function every period in a separate thread, until destruction.
+class PeriodicCaller {
+ public:
+  PeriodicCaller(double period_seconds, std::function<void()> function)
+      : thread_([this, period_seconds, function]() {
+          std::unique_lock<std::mutex> lock(mutex_);
+          while (!wake_.wait_for(lock,
+                                 std::chrono::duration<double>(period_seconds),
+                                 [this] { return stop_; })) {
+            lock.unlock();
+            function();
+            lock.lock();
+          }
+        }) {}
+  PeriodicCaller(const PeriodicCaller&) = delete;
+  PeriodicCaller& operator=(const PeriodicCaller&) = delete;
+  ~PeriodicCaller() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+ private:
+  std::mutex mutex_;  // Guards stop_.
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread thread_;  // Last so that the fields above exist when it starts.
+};
+
+// Ends the hold of a task returned by WorkStealingQueue::PopAndHold(). In a
+// quality search, queues the next tasks that depend on its output.
+void ReleaseHeldTask(WorkerContext& context, size_t shard_index,
+                     const StatusOr<TaskOutput>& task_output) {
+  QualitySearches* quality_searches = context.quality_searches;
+  if (quality_searches == nullptr) {
+    context.queued_tasks->Release(shard_index, {});
+    return;
+  }
+  std::vector<QueuedTask> next_tasks;
+  std::vector<TaskOutput> extrapolated_tasks;
+  if (task_output.status == Status::kOk) {
+    // Repetitions of the same quality share the same encoded path. Only save
+    // to disk the first occurrence of each, as in RunTasks(). The next curve
+    // samples can span several qualities.
+    std::unordered_set<std::string> written_files;
+    for (TaskInput& input :
+         quality_searches->OnTaskCompleted(task_output.value,
+                                           extrapolated_tasks)) {
+      QueuedTask task;
+      if (!input.encoded_path.empty() &&
+          written_files.insert(input.encoded_path).second) {
+        task.encode_mode = EncodeMode::kEncodeAndSaveToDisk;
+      }
+      task.input = std::move(input);
+      next_tasks.push_back(std::move(task));
+    }
+  }
+  for (TaskOutput& task : extrapolated_tasks) {
+    const std::string serialized_task = task.Serialize();
+    const TaskInput task_input = task.task_input;
+    EndTaskOutput(context, task_input, std::move(task), serialized_task);
+  }
+  // Run right after by this worker to keep the original image cached.
+  context.queued_tasks->Release(shard_index, std::move(next_tasks));
+  std::lock_guard<std::mutex> lock(context.mutex);
+  context.num_tasks = context.completed_tasks.size() +
+                      quality_searches->MaxNumRemainingTasks();
+}
+
+// Asks the coordinator for the next task. Returns false if there is none left
+// or if the connection is lost.
+bool RequestRemoteTask(LineConnection& coordinator, QueuedTask& task,
+                       bool quiet) {
+  std::string line;
+  if (!coordinator.WriteLine("get") || !coordinator.ReadLine(line)) {
+    return false;
+  }
+  if (line == "done") return false;
+  constexpr std::string_view kPrefix = "task ";
+  return line.compare(0, kPrefix.size(), kPrefix) == 0 &&
+         UnserializeRemoteTask(std::string_view(line).substr(kPrefix.size()),
+                               task.input, task.encode_mode,
+                               quiet) == Status::kOk;
+}
+
 class TaskWorker : public Worker<WorkerContext, TaskWorker> {
  public:
   using Worker<WorkerContext, TaskWorker>::Worker;
+  static constexpr bool kIsThreadSafe = true;
 
  private:
   bool AssignTask(WorkerContext& context) override {
-    if (context.remaining_tasks.empty()) return false;
-    current_task_input_ = context.remaining_tasks.back();
+    QueuedTask queued_task;
+    coordinator_ = context.coordinator_connections == nullptr
+                       ? nullptr
+                       : (*context.coordinator_connections)[worker_id_].get();
+    // The next tasks of a search are only known once its current ones end.
+    is_held_ =
+        context.quality_searches != nullptr || context.has_remote_workers;
+    while (true) {
+      if (IsStopping(context)) return false;
+      if (coordinator_ != nullptr) {
+        if (!RequestRemoteTask(*coordinator_, queued_task, context.quiet)) {
+          return false;
+        }
+      } else if (is_held_) {
+        if (!context.queued_tasks->PopAndHold(worker_id_, queued_task)) {
+          return false;
+        }
+      } else if (!context.queued_tasks->Pop(worker_id_, queued_task)) {
+        return false;
+      }
+      // A task of the coordinator is run anyway, it would not come back.
+      if (coordinator_ != nullptr ||
+          !WouldOverrun(context, queued_task.input)) {
+        break;
+      }
+      // Left to a later run, but a shorter task may still fit.
+      if (is_held_) context.queued_tasks->Release(worker_id_, {});
+      std::lock_guard<std::mutex> lock(context.mutex);
+      ++context.num_abandoned_tasks;
+    }
+    if (context.image_prefetcher != nullptr && coordinator_ == nullptr) {
+      PrefetchNextImages(context, queued_task.input.image_path);
+    }
+    current_task_input_ = std::move(queued_task.input);
+    encode_mode_ = queued_task.encode_mode;
+    timing_ = context.timing;
+    resource_usage_ = context.resource_usage;
     metric_binary_folder_path_ = context.metric_binary_folder_path;
-    if (context.load_encoded_from_disk) {
-      encode_mode_ = EncodeMode::kLoadFromDisk;
-    } else {
-      // Only save to disk the first occurrence of the same file to avoid any
-      // disk access concurrency issue.
-      encode_mode_ =
-          !current_task_input_.encoded_path.empty() &&
-                  context.written_files.insert(current_task_input_.encoded_path)
-                      .second
-              ? EncodeMode::kEncodeAndSaveToDisk
-              : EncodeMode::kEncode;
-    }
-    context.remaining_tasks.pop_back();
-    max_num_failures_ = context.max_num_failures;
+    distortion_metrics_ = context.distortion_metrics;
+    num_frame_threads_ = context.num_frame_threads;
+    stream_rows_min_num_pixels_ = context.stream_rows_min_num_pixels;
+    original_image_cache_ = context.original_image_cache;
+    image_prefetcher_ = context.image_prefetcher;
+    artifact_writer_ = context.artifact_writer;
+    reference_file_cache_ = context.reference_file_cache;
+    repetition_cache_ = context.repetition_cache;
+    encode_cache_ = context.encode_cache;
+    candidate_cache_ = context.candidate_cache;
+    memory_governor_ = context.memory_governor;
+    memory_model_ = context.memory_model;
+    decoded_tasks_ = context.decoded_tasks;
     quiet_ = context.quiet;
     return true;
   }
 
   void DoTask() override {
-    current_task_output_ =
-        EncodeDecode(current_task_input_, metric_binary_folder_path_,
-                     worker_id_, encode_mode_, quiet_);
-    if (current_task_output_.status != Status::kOk) return;
+    is_current_task_queued_ = false;
+    TaskOutput cached_task_output;
+    if (encode_cache_ != nullptr && encode_mode_ != EncodeMode::kLoadFromDisk &&
+        encode_cache_->Reuse(
+            current_task_input_,
+            /*save_encoded=*/encode_mode_ == EncodeMode::kEncodeAndSaveToDisk,
+            distortion_metrics_, cached_task_output)) {
+      // Measured by a previous run.
+      current_task_output_ = std::move(cached_task_output);
+      serialized_current_task_output_ = current_task_output_.value.Serialize();
+      return;
+    }
+    if (image_prefetcher_ != nullptr &&
+        (original_image_cache_ == nullptr ||
+         !original_image_cache_->Contains(current_task_input_.image_path))) {
+      image_prefetcher_->Wait(current_task_input_.image_path);
+    }
+    // Held until the distortions are computed, by this worker or by a
+    // DistortionWorker.
+    MemoryAdmission admission(
+        memory_governor_, memory_governor_ == nullptr
+                              ? 0
+                              : memory_model_->Estimate(current_task_input_));
+    StatusOr<DecodedTask> decoded_task =
+        EncodeAndDecode(current_task_input_, encode_mode_, timing_,
+                        resource_usage_, original_image_cache_,
+                        artifact_writer_, candidate_cache_,
+                        stream_rows_min_num_pixels_, quiet_);
+    current_task_output_.status = decoded_task.status;
+    if (decoded_task.status != Status::kOk) return;
+    if (memory_model_ != nullptr) memory_model_->Learn(decoded_task.value.task);
+    if (encode_cache_ != nullptr &&
+        encode_mode_ == EncodeMode::kEncodeAndSaveToDisk) {
+      encode_cache_->InsertEncodedFile(current_task_input_);
+    }
+    if (repetition_cache_ != nullptr &&
+        repetition_cache_->Reuse(decoded_task.value.encoded_digest,
+                                 decoded_task.value.task)) {
+      // Only the encoding and the decoding of this repetition were timed.
+      current_task_output_ = std::move(decoded_task.value.task);
+    } else if (decoded_tasks_ != nullptr) {
+      // The distortions are computed by a DistortionWorker.
+      decoded_tasks_->Push(
+          AdmittedTask{std::move(decoded_task.value), std::move(admission)});
+      is_current_task_queued_ = true;
+      return;
+    } else {
+      current_task_output_ = ComputeDistortions(
+          decoded_task.value, metric_binary_folder_path_, distortion_metrics_,
+          worker_id_, num_frame_threads_, reference_file_cache_, quiet_);
+      if (current_task_output_.status != Status::kOk) return;
+      if (repetition_cache_ != nullptr) {
+        repetition_cache_->Insert(current_task_output_.value,
+                                  decoded_task.value.encoded_digest);
+      }
+    }
+    if (encode_cache_ != nullptr) {
+      encode_cache_->Insert(current_task_output_.value);
+    }
     serialized_current_task_output_ = current_task_output_.value.Serialize();
   }
 
   void EndTask(WorkerContext& context) override {
-    if (current_task_output_.status == Status::kOk) {
-      if (!context.completed_tasks_file_path.empty()) {
-        context.completed_tasks_file << serialized_current_task_output_
-                                     << std::endl;
-      }
-      context.completed_tasks.push_back(current_task_output_.value);
-      ++context.num_completed_tasks_since_start;
-    } else {
-      if (context.status == Status::kOk) {
-        context.status = current_task_output_.status;
-      }
-      --context.num_tasks;
-      ++context.num_failures;
-      if (context.num_failures > max_num_failures_) {
-        // Drain remaining tasks to exit quickly.
-        context.remaining_tasks.clear();
+    if (coordinator_ != nullptr) {
+      // The coordinator records it. A lost connection fails the next request.
+      const bool is_ok = current_task_output_.status == Status::kOk;
+      (void)coordinator_->WriteLine(
+          is_ok ? "result " + serialized_current_task_output_ : "failed");
+      serialized_current_task_output_.clear();
+      std::lock_guard<std::mutex> lock(context.mutex);
+      if (is_ok) {
+        ++context.num_completed_tasks_since_start;
       } else {
-        std::cerr << "Failure: " << current_task_input_.Serialize()
-                  << std::endl;
+        ++context.num_failures;
       }
+      return;
+    }
+    if (!is_current_task_queued_) {
+      EndTaskOutput(context, current_task_input_, current_task_output_,
+                    serialized_current_task_output_);
     }
     serialized_current_task_output_.clear();
+    if (is_held_) ReleaseHeldTask(context, worker_id_, current_task_output_);
+  }
 
-    if (!quiet_) {
-      const double duration_since_last_progress_display =
-          seconds(chrono::now() - context.last_progress_display_time).count();
-      if (duration_since_last_progress_display > 30) {
-        context.last_progress_display_time = chrono::now();
-        const double duration_since_start =
-            seconds(chrono::now() - context.start_time).count();
-        const size_t num_tasks_in_fly = context.num_tasks -
-                                        context.completed_tasks.size() -
-                                        context.remaining_tasks.size();
-        // Assume tasks of other workers are halfly done in average.
-        const double estimated_hours_left =
-            duration_since_start / 3600 /
-            (context.num_completed_tasks_since_start + num_tasks_in_fly * 0.5) *
-            (context.remaining_tasks.size() + num_tasks_in_fly * 0.5);
-        std::cout << (context.completed_tasks.size() + num_tasks_in_fly / 2)
-                  << "/" << context.num_tasks << " (" << duration_since_start
-                  << "s elapsed, ~" << estimated_hours_left << " hours left)"
-                  << std::endl;
+  // Prefetches the images of the tasks this worker should run after the
+  // current one, unless stolen by another worker.
+  void PrefetchNextImages(WorkerContext& context,
+                          const std::string& current_image_path) {
+    // Bounds the time spent holding the lock of the queue.
+    constexpr size_t kMaxNumVisitedTasksPerImage = 64;
+    const size_t max_num_visited_tasks =
+        context.prefetch_num_images * kMaxNumVisitedTasksPerImage;
+    std::vector<std::string> next_image_paths;
+    size_t num_visited_tasks = 0;
+    context.queued_tasks->ForEachNext(worker_id_, [&](const QueuedTask& task) {
+      const std::string& image_path = task.input.image_path;
+      if (image_path != current_image_path &&
+          std::find(next_image_paths.begin(), next_image_paths.end(),
+                    image_path) == next_image_paths.end()) {
+        next_image_paths.push_back(image_path);
       }
+      return next_image_paths.size() < context.prefetch_num_images &&
+             ++num_visited_tasks < max_num_visited_tasks;
+    });
+    if (context.original_image_cache != nullptr) {
+      next_image_paths.erase(
+          std::remove_if(next_image_paths.begin(), next_image_paths.end(),
+                         [&](const std::string& image_path) {
+                           return context.original_image_cache->Contains(
+                               image_path);
+                         }),
+          next_image_paths.end());
     }
+    context.image_prefetcher->Prefetch(next_image_paths);
   }
 
   TaskInput current_task_input_;
   std::string metric_binary_folder_path_;
+  std::vector<DistortionMetric> distortion_metrics_;
+  uint32_t num_frame_threads_ = 1;
+  uint64_t stream_rows_min_num_pixels_ = 0;
+  ImageCache* original_image_cache_ = nullptr;
+  ImagePrefetcher* image_prefetcher_ = nullptr;
+  ArtifactWriter* artifact_writer_ = nullptr;
+  CandidateCache* candidate_cache_ = nullptr;
+  MemoryGovernor* memory_governor_ = nullptr;
+  TaskMemoryModel* memory_model_ = nullptr;
+  TempFileCache* reference_file_cache_ = nullptr;
+  RepetitionCache* repetition_cache_ = nullptr;
+  EncodeCache* encode_cache_ = nullptr;
+  BoundedQueue<AdmittedTask>* decoded_tasks_ = nullptr;
+  LineConnection* coordinator_ = nullptr;
+  bool is_held_ = false;
   EncodeMode encode_mode_ = EncodeMode::kEncode;
+  TimingSettings timing_;
+  ResourceUsageSettings resource_usage_;
   StatusOr<TaskOutput> current_task_output_ = Status::kUnknownError;
+  bool is_current_task_queued_ = false;
   std::string serialized_current_task_output_;
-  size_t max_num_failures_;
   bool quiet_;
 };
 
+// Computes the distortions of the tasks encoded and decoded by TaskWorkers.
+class DistortionWorker : public Worker<WorkerContext, DistortionWorker> {
+ public:
+  using Worker<WorkerContext, DistortionWorker>::Worker;
+  static constexpr bool kIsThreadSafe = true;
+
+ private:
+  bool AssignTask(WorkerContext& context) override {
+    if (context.decoded_tasks->IsClosedAndEmpty()) return false;
+    decoded_tasks_ = context.decoded_tasks;
+    metric_binary_folder_path_ = context.metric_binary_folder_path;
+    distortion_metrics_ = context.distortion_metrics;
+    num_frame_threads_ = context.num_frame_threads;
+    reference_file_cache_ = context.reference_file_cache;
+    repetition_cache_ = context.repetition_cache;
+    encode_cache_ = context.encode_cache;
+    // Distinct from the ids of the TaskWorkers for thread-safe file names.
+    thread_id_ = context.first_distortion_thread_id + worker_id_;
+    quiet_ = context.quiet;
+    return true;
+  }
+
+  void DoTask() override {
+    // Another DistortionWorker may have taken the last task in the meantime.
+    has_current_task_ = decoded_tasks_->Pop(current_task_);
+    if (!has_current_task_) return;
+    current_task_output_ = ComputeDistortions(
+        current_task_.decoded, metric_binary_folder_path_, distortion_metrics_,
+        thread_id_, num_frame_threads_, reference_file_cache_, quiet_);
+    if (current_task_output_.status != Status::kOk) return;
+    if (repetition_cache_ != nullptr) {
+      repetition_cache_->Insert(current_task_output_.value,
+                                current_task_.decoded.encoded_digest);
+    }
+    if (encode_cache_ != nullptr) {
+      encode_cache_->Insert(current_task_output_.value);
+    }
+    serialized_current_task_output_ = current_task_output_.value.Serialize();
+  }
+
+  void EndTask(WorkerContext& context) override {
+    if (has_current_task_) {
+      EndTaskOutput(context, current_task_.decoded.task.task_input,
+                    current_task_output_, serialized_current_task_output_);
+    }
+    // Release the images early, then their admitted memory.
+    current_task_.decoded = DecodedTask();
+    current_task_.admission.Reset();
+    serialized_current_task_output_.clear();
+  }
+
+  BoundedQueue<AdmittedTask>* decoded_tasks_ = nullptr;
+  std::string metric_binary_folder_path_;
+  std::vector<DistortionMetric> distortion_metrics_;
+  uint32_t num_frame_threads_ = 1;
+  TempFileCache* reference_file_cache_ = nullptr;
+  RepetitionCache* repetition_cache_ = nullptr;
+  EncodeCache* encode_cache_ = nullptr;
+  size_t thread_id_ = 0;
+  AdmittedTask current_task_;
+  bool has_current_task_ = false;
+  StatusOr<TaskOutput> current_task_output_ = Status::kUnknownError;
+  std::string serialized_current_task_output_;
+  bool quiet_;
+};
+
+// Returns the valid lossy qualities of each codec, for unserialization.
+std::vector<std::unordered_set<int>> GetQualitiesPerCodec() {
+  std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<int>(Codec::kNumCodecs));
+  for (size_t i = 0; i < qualities_per_codec.size(); ++i) {
+    const std::vector<int> q = CodecLossyQualities(static_cast<Codec>(i));
+    qualities_per_codec[i] = std::unordered_set<int>(q.begin(), q.end());
+  }
+  return qualities_per_codec;
+}
+
+// Hands out the tasks of context.queued_tasks to a remote worker, one at a
+// time, until there is none left or the connection is lost.
+void ServeRemoteWorker(WorkerContext& context, LineConnection& connection,
+                       size_t shard_index, double timeout) {
+  connection.SetReadTimeout(timeout);
+  std::string line;
+  if (!connection.ReadLine(line) || line != kRemoteTasksHello) {
+    if (!context.quiet) {
+      std::cerr << "Warning: ignoring a connection that is not a ccgen worker"
+                << std::endl;
+    }
+    return;
+  }
+  const std::vector<std::unordered_set<int>> qualities_per_codec =
+      GetQualitiesPerCodec();
+  constexpr std::string_view kResultPrefix = "result ";
+  while (connection.ReadLine(line) && line == "get") {
+    QueuedTask task;
+    if (IsStopping(context) ||
+        !context.queued_tasks->PopAndHold(shard_index, task)) {
+      (void)connection.WriteLine("done");
+      return;
+    }
+    if (!connection.WriteLine(
+            "task " + SerializeRemoteTask(task.input, task.encode_mode)) ||
+        !connection.ReadLine(line)) {
+      // Given to another worker instead. A worker that timed out may still be
+      // running it, so make its next read or write fail.
+      connection.Shutdown();
+      if (!context.quiet) {
+        std::cerr << "Warning: lost a remote worker, handing "
+                  << task.input.Serialize() << " out again" << std::endl;
+      }
+      std::vector<QueuedTask> lost_tasks;
+      lost_tasks.push_back(std::move(task));
+      context.queued_tasks->Release(shard_index, std::move(lost_tasks));
+      return;
+    }
+    std::string serialized_task_output;
+    StatusOr<TaskOutput> task_output = Status::kUnknownError;
+    if (line.compare(0, kResultPrefix.size(), kResultPrefix) == 0) {
+      serialized_task_output = line.substr(kResultPrefix.size());
+      task_output = TaskOutput::Unserialize(serialized_task_output,
+                                            qualities_per_codec, context.quiet);
+      if (task_output.status == Status::kOk &&
+          !(task_output.value.task_input == task.input)) {
+        if (!context.quiet) {
+          std::cerr << "Error: a remote worker returned "
+                    << task_output.value.task_input.Serialize() << " for "
+                    << task.input.Serialize() << std::endl;
+        }
+        task_output = Status::kUnknownError;
+      }
+    }
+    EndTaskOutput(context, task.input, task_output, serialized_task_output);
+    ReleaseHeldTask(context, shard_index, task_output);
+  }
+}
+
+// Runs all context.remaining_tasks. If settings.num_metric_threads is not zero,
+// the distortions are computed by that many DistortionWorkers so that the
+// encoding threads and the metric binaries do not wait for each other. The
+// distortions are computed by the TaskWorkers in a quality search because they
+// decide which task comes next. If serve_tasks_port is not 0, remote workers
+// can also connect to it and take tasks until all are done.
+Status RunTasks(const ComparisonSettings& settings, uint16_t serve_tasks_port,
+                WorkerContext& context) {
+  const size_t num_workers = 1 + settings.num_extra_threads;
+  std::vector<QueuedTask> tasks;
+  tasks.reserve(context.remaining_tasks.size());
+  {
+    // Only save to disk the first occurrence of the same file to avoid any
+    // disk access concurrency issue.
+    std::unordered_set<std::string> written_files;
+    for (TaskInput& input : context.remaining_tasks) {
+      QueuedTask task;
+      if (context.load_encoded_from_disk) {
+        task.encode_mode = EncodeMode::kLoadFromDisk;
+      } else if (!input.encoded_path.empty() &&
+                 written_files.insert(input.encoded_path).second) {
+        task.encode_mode = EncodeMode::kEncodeAndSaveToDisk;
+      }
+      task.input = std::move(input);
+      tasks.push_back(std::move(task));
+    }
+    context.remaining_tasks.clear();
+  }
+  // Interleaved so that each worker starts with its share of the longest tasks.
+  WorkStealingQueue<QueuedTask> queued_tasks(std::move(tasks), num_workers,
+                                             settings.longest_first);
+  context.queued_tasks = &queued_tasks;
+
+  TaskServer task_server;
+  std::atomic<size_t> num_remote_workers(0);
+  if (serve_tasks_port != 0) {
+    context.has_remote_workers = true;
+    OK_OR_RETURN(task_server.Start(
+        settings.serve_tasks_address, serve_tasks_port,
+        [&context, &num_remote_workers, num_workers,
+         timeout = settings.remote_worker_timeout](LineConnection& connection) {
+          // The tasks of a lost connection go back to the shard of a local
+          // worker.
+          ServeRemoteWorker(context, connection,
+                            num_remote_workers++ % num_workers, timeout);
+        },
+        settings.quiet));
+    if (!settings.quiet) {
+      std::cout << "Serving tasks to remote workers on port "
+                << task_server.port() << std::endl;
+    }
+  }
+
+  WorkerPool<WorkerContext, TaskWorker> pool(num_workers);
+  pool.SetCpusPerWorker(context.task_worker_cpus);
+  if (settings.num_metric_threads == 0 || context.quality_searches != nullptr) {
+    pool.Run(context);
+    // The local workers waited for the tasks held by the remote ones.
+    task_server.Stop();
+  } else {
+    // Bounded to limit the number of decoded images held in memory.
+    BoundedQueue<AdmittedTask> decoded_tasks(2 * settings.num_metric_threads);
+    context.decoded_tasks = &decoded_tasks;
+    context.first_distortion_thread_id = num_workers;
+    WorkerPool<WorkerContext, DistortionWorker> distortion_pool(
+        settings.num_metric_threads);
+    std::thread distortion_thread(
+        [&distortion_pool, &context]() { distortion_pool.Run(context); });
+    pool.Run(context);
+    task_server.Stop();
+    decoded_tasks.Close();
+    distortion_thread.join();
+    context.decoded_tasks = nullptr;
+  }
+  context.queued_tasks = nullptr;
+  context.has_remote_workers = false;
+  return Status::kOk;
+}
+
+}  // namespace
+
 StatusOr<std::vector<TaskOutput>> LoadTasks(
     const ComparisonSettings& settings,
     const std::string& completed_tasks_file_path) {
   std::vector<TaskOutput> completed_tasks;
   if (std::filesystem::exists(completed_tasks_file_path)) {
-    std::ifstream previous_completed_tasks_file(completed_tasks_file_path);
-    if (!previous_completed_tasks_file.is_open()) {
-      std::cerr << "Error: Could not open " << completed_tasks_file_path
-                << " for reading" << std::endl;
-      return Status::kUnknownError;
-    }
+    const Timer timer;
+    MappedFile previous_completed_tasks_file;
+    OK_OR_RETURN(previous_completed_tasks_file.Open(completed_tasks_file_path,
+                                                    settings.quiet));
 
-    std::vector<std::unordered_set<int>> qualities_per_codec(
-        static_cast<int>(Codec::kNumCodecs));
-    for (size_t i = 0; i < qualities_per_codec.size(); ++i) {
-      const std::vector<int> q = CodecLossyQualities(static_cast<Codec>(i));
-      qualities_per_codec[i] = std::unordered_set<int>(q.begin(), q.end());
-    }
-
-    std::string line;
-    while (std::getline(previous_completed_tasks_file, line)) {
-      ASSIGN_OR_RETURN(const TaskOutput task_output,
-                       settings.discard_distortion_values
-                           ? TaskOutput::UnserializeNoDistortion(
-                                 line, qualities_per_codec, settings.quiet)
-                           : TaskOutput::Unserialize(line, qualities_per_codec,
-                                                     settings.quiet));
-      completed_tasks.push_back(task_output);
+    const std::vector<std::unordered_set<int>> qualities_per_codec =
+        GetQualitiesPerCodec();
+    const std::string_view contents = previous_completed_tasks_file.contents();
+    if (IsBinaryTasksFilePath(completed_tasks_file_path)) {
+      if (!contents.empty()) {
+        ASSIGN_OR_RETURN(
+            completed_tasks,
+            UnserializeBinaryTaskOutputs(
+                contents, qualities_per_codec,
+                /*with_distortions=*/!settings.discard_distortion_values,
+                settings.quiet));
+      }
+    } else {
+      ASSIGN_OR_RETURN(
+          completed_tasks,
+          UnserializeTaskOutputs(
+              contents, qualities_per_codec,
+              /*with_distortions=*/!settings.discard_distortion_values,
+              /*num_threads=*/1 + settings.num_extra_threads, settings.quiet));
     }
-    previous_completed_tasks_file.close();
 
     if (!settings.quiet) {
+      const double seconds = timer.seconds();
       std::cout << "Loaded " << completed_tasks.size() << " tasks from "
-                << completed_tasks_file_path << std::endl;
+                << completed_tasks_file_path << " in "
+                << Timer::SecondsToString(seconds);
+      if (seconds > 0) {
+        std::cout << " (" << (contents.size() / seconds / (1 << 20))
+                  << " MB/s)";
+      }
+      std::cout << std::endl;
     }
   }
   return completed_tasks;
 }
 
+namespace {
+
+// Returns true if the task is lossy and lacks any of the selected metrics that
+// can be computed from the saved encoded image.
+bool IsMissingDistortions(const ComparisonSettings& settings,
+                          const TaskOutput& task) {
+  if (task.task_input.codec_settings.quality == kQualityLossless) return false;
+  if (task.task_input.encoded_path.empty()) return false;
+  if (task.is_extrapolated) return false;  // There is no encoded file.
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    if (std::isnan(task.distortions[m]) &&
+        ((settings.distortion_metrics.empty() &&
+          IsComputedByDefault(static_cast<DistortionMetric>(m))) ||
+         std::find(settings.distortion_metrics.begin(),
+                   settings.distortion_metrics.end(),
+                   static_cast<DistortionMetric>(m)) !=
+             settings.distortion_metrics.end())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Recomputes all distortion values if settings.discard_distortion_values, or
+// only the ones that are missing otherwise.
 Status ComputeDistortionInCompletedTasks(
-    const ComparisonSettings& settings,
+    const ComparisonSettings& settings, ImageCache* original_image_cache,
+    TempFileCache* reference_file_cache,
     std::vector<TaskOutput>& completed_tasks) {
+  const bool discard = settings.discard_distortion_values;
   if (!settings.quiet) {
-    std::cout << "Discarding read distortion values and recomputing them"
+    std::cout << (discard
+                      ? "Discarding read distortion values and recomputing them"
+                      : "Computing missing distortion values")
               << std::endl;
   }
 
@@ -213,6 +1053,8 @@ Status ComputeDistortionInCompletedTasks(
     // Only recompute distortion values once for each unique encoded path.
     std::unordered_set<std::string_view> encoded_paths;
     for (const TaskOutput& completed_task : completed_tasks) {
+      if (!discard && !IsMissingDistortions(settings, completed_task)) continue;
+      if (completed_task.is_extrapolated) continue;  // Not encoded.
       CHECK_OR_RETURN(!completed_task.task_input.encoded_path.empty(),
                       settings.quiet);
       if (encoded_paths.insert(completed_task.task_input.encoded_path).second) {
@@ -223,11 +1065,15 @@ Status ComputeDistortionInCompletedTasks(
   context.quiet = settings.quiet;
   context.num_tasks = context.remaining_tasks.size();
   context.metric_binary_folder_path = settings.metric_binary_folder_path;
+  context.distortion_metrics = settings.distortion_metrics;
+  context.num_frame_threads = settings.num_frame_threads;
+  context.stream_rows_min_num_pixels = StreamRowsMinNumPixels(settings);
+  context.original_image_cache = original_image_cache;
+  context.reference_file_cache = reference_file_cache;
   context.max_num_failures = static_cast<size_t>(
       std::lround(context.num_tasks * settings.abort_above_fail_ratio));
 
-  WorkerPool<WorkerContext, TaskWorker> pool(1 + settings.num_extra_threads);
-  pool.Run(context);
+  OK_OR_RETURN(RunTasks(settings, /*serve_tasks_port=*/0, context));
   CHECK_OR_RETURN(context.completed_tasks.size() == context.num_tasks,
                   settings.quiet);
 
@@ -242,11 +1088,21 @@ Status ComputeDistortionInCompletedTasks(
     // Copy the new distortions to the old completed_tasks. Keep the other old
     // metrics as is (encode timing etc.).
     for (TaskOutput& completed_task : completed_tasks) {
+      // Keep the copied distortions of the extrapolated tasks.
+      if (completed_task.is_extrapolated) continue;
       const auto it = results.find(completed_task.task_input.encoded_path);
-      CHECK_OR_RETURN(it != results.end(), settings.quiet);
-      std::copy(it->second->distortions,
-                it->second->distortions + kNumDistortionMetrics,
-                completed_task.distortions);
+      if (discard) {
+        CHECK_OR_RETURN(it != results.end(), settings.quiet);
+        std::copy(it->second->distortions,
+                  it->second->distortions + kNumDistortionMetrics,
+                  completed_task.distortions);
+      } else if (it != results.end()) {
+        for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+          if (!std::isnan(it->second->distortions[m])) {
+            completed_task.distortions[m] = it->second->distortions[m];
+          }
+        }
+      }
     }
   }
 
@@ -256,6 +1112,39 @@ Status ComputeDistortionInCompletedTasks(
   return Status::kOk;
 }
 
+// Identifies planned tasks regardless of their image path length.
+struct TaskKey {
+  CodecSettings codec_settings;
+  size_t image_id;  // Interned image path.
+
+  bool operator==(const TaskKey& other) const {
+    return codec_settings.codec == other.codec_settings.codec &&
+           codec_settings.chroma_subsampling ==
+               other.codec_settings.chroma_subsampling &&
+           codec_settings.effort == other.codec_settings.effort &&
+           codec_settings.quality == other.codec_settings.quality &&
+           codec_settings.num_threads == other.codec_settings.num_threads &&
+           image_id == other.image_id;
+  }
+};
+
+struct TaskKeyHash {
+  size_t operator()(const TaskKey& key) const {
+    size_t hash = key.image_id;
+    for (const size_t value :
+         {static_cast<size_t>(key.codec_settings.codec),
+          static_cast<size_t>(key.codec_settings.chroma_subsampling),
+          static_cast<size_t>(key.codec_settings.effort),
+          static_cast<size_t>(key.codec_settings.quality),
+          static_cast<size_t>(key.codec_settings.num_threads)}) {
+      hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+  }
+};
+
+}  // namespace
+
 Status RemoveCompletedTasksFromRemainingTasks(
     const ComparisonSettings& settings,
     const std::string& completed_tasks_file_path,
@@ -267,51 +1156,50 @@ Status RemoveCompletedTasksFromRemainingTasks(
       << completed_tasks_file_path << " but only " << remaining_tasks.size()
       << " were planned according to input flags";
 
-  struct TaskInputComp {
-    bool operator()(const TaskInput& a, const TaskInput& b) const {
-      if (a.codec_settings.codec < b.codec_settings.codec) return true;
-      if (a.codec_settings.codec > b.codec_settings.codec) return false;
-      if (a.codec_settings.chroma_subsampling <
-          b.codec_settings.chroma_subsampling) {
-        return true;
-      }
-      if (a.codec_settings.chroma_subsampling >
-          b.codec_settings.chroma_subsampling) {
-        return false;
-      }
-      if (a.codec_settings.effort < b.codec_settings.effort) return true;
-      if (a.codec_settings.effort > b.codec_settings.effort) return false;
-      if (a.codec_settings.quality < b.codec_settings.quality) return true;
-      if (a.codec_settings.quality > b.codec_settings.quality) return false;
-      return a.image_path < b.image_path;
-      // Ignore encoded_path which should depend on other fields.
-    }
-    bool operator()(const TaskOutput& a, const TaskOutput& b) const {
-      return operator()(a.task_input, b.task_input);
-    }
-  } comp;
+  // Matching ignores encoded_path in the key because it depends on the other
+  // fields. Image paths are interned to avoid hashing long strings repeatedly.
+  std::unordered_map<std::string_view, size_t> image_ids;
+  image_ids.reserve(completed_tasks.size());
+  std::unordered_map<TaskKey, std::vector<size_t>, TaskKeyHash>
+      key_to_completed_indices;
+  key_to_completed_indices.reserve(completed_tasks.size());
+  for (size_t i = 0; i < completed_tasks.size(); ++i) {
+    const TaskInput& input = completed_tasks[i].task_input;
+    const size_t image_id =
+        image_ids.insert({input.image_path, image_ids.size()}).first->second;
+    key_to_completed_indices[TaskKey{input.codec_settings, image_id}]
+        .push_back(i);
+  }
 
-  // Using sorted tasks speeds lookups up.
-  // An unordered map may be faster but hash function and map manipulation are
-  // not as convenient and it is fast enough as is for now.
-  std::sort(completed_tasks.begin(), completed_tasks.end(), comp);
-  std::sort(remaining_tasks.begin(), remaining_tasks.end(), comp);
+  // Walk the planned tasks in order so that it is preserved.
+  std::vector<bool> is_matched(completed_tasks.size(), false);
   std::vector<TaskInput> kept_remaining_tasks;
   kept_remaining_tasks.reserve(remaining_tasks.size() - completed_tasks.size());
-
-  std::vector<TaskInput>::iterator it_remaining_task = remaining_tasks.begin();
-  for (const TaskOutput& completed : completed_tasks) {
-    while (it_remaining_task != remaining_tasks.end() &&
-           !(*it_remaining_task == completed.task_input)) {
-      kept_remaining_tasks.push_back(*it_remaining_task++);
+  for (TaskInput& remaining : remaining_tasks) {
+    const auto image_id = image_ids.find(remaining.image_path);
+    if (image_id != image_ids.end()) {
+      const auto completed_indices = key_to_completed_indices.find(
+          TaskKey{remaining.codec_settings, image_id->second});
+      if (completed_indices != key_to_completed_indices.end()) {
+        std::vector<size_t>& indices = completed_indices->second;
+        const auto index = std::find_if(
+            indices.begin(), indices.end(), [&](size_t i) {
+              return completed_tasks[i].task_input == remaining;
+            });
+        if (index != indices.end()) {
+          is_matched[*index] = true;
+          indices.erase(index);
+          continue;
+        }
+      }
     }
-    CHECK_OR_RETURN(it_remaining_task != remaining_tasks.end(), settings.quiet)
+    kept_remaining_tasks.push_back(std::move(remaining));
+  }
+  for (size_t i = 0; i < completed_tasks.size(); ++i) {
+    CHECK_OR_RETURN(is_matched[i], settings.quiet)
         << "The following from " << completed_tasks_file_path
-        << " does not match the input flags:" << completed.Serialize();
-    ++it_remaining_task;
+        << " does not match the input flags:" << completed_tasks[i].Serialize();
   }
-  kept_remaining_tasks.insert(kept_remaining_tasks.end(), it_remaining_task,
-                              remaining_tasks.end());
 
   assert(kept_remaining_tasks.size() ==
          remaining_tasks.size() - completed_tasks.size());
@@ -319,17 +1207,29 @@ Status RemoveCompletedTasksFromRemainingTasks(
   return Status::kOk;
 }
 
+namespace {
+
 Status ShuffleRemainingTasks(const ComparisonSettings& settings,
+                             const TaskCostModel& cost_model,
                              std::vector<TaskInput>& remaining_tasks) {
-  if (settings.random_order) {
+  // The tasks are executed in the order of the vector, which is the one given
+  // in args if there is no shuffling.
+  if (settings.longest_first && !cost_model.IsEmpty()) {
+    std::random_device rd;
+    std::mt19937 rng(rd());
+    SortByDecreasingCost(cost_model, settings.random_order ? &rng : nullptr,
+                         remaining_tasks);
+  } else if (settings.group_by_image) {
+    // Keep the decoded original image hot in memory while all its tasks run,
+    // but still shuffle within and across images for fair timings.
+    std::random_device rd;
+    std::mt19937 rng(rd());
+    GroupTasksByImage(settings.random_order ? &rng : nullptr, remaining_tasks);
+  } else if (settings.random_order) {
     // Uniform distribution of tasks to get as fair timings as possible.
     std::random_device rd;
     std::shuffle(remaining_tasks.begin(), remaining_tasks.end(),
                  std::mt19937(rd()));
-  } else {
-    // The tasks will be assigned starting at the back of the vector.
-    // Reverse the order to execute in the same order as given in args.
-    std::reverse(remaining_tasks.begin(), remaining_tasks.end());
   }
   return Status::kOk;
 }
@@ -341,40 +1241,667 @@ bool UsesBasis(const ComparisonSettings& settings) {
   return false;
 }
 
-}  // namespace
+// Written next to the JSON files once they are all up to date. Contains the
+// output of GetResultsSettings().
+constexpr char kResultsSettingsFileName[] = "results_settings.txt";
 
-Status Compare(const std::vector<std::string>& image_paths,
-               const ComparisonSettings& settings,
-               const std::string& completed_tasks_file_path,
-               const std::string& results_folder_path) {
+// Returns what the JSON files depend on besides the completed tasks.
+std::string GetResultsSettings(const ComparisonSettings& settings) {
+  std::stringstream results_settings;
+  results_settings << "timing_statistic "
+                   << TimingStatisticToString(settings.timing.statistic)
+                   << "\ngzip " << settings.results_format.gzip
+                   << "\nchunk_num_rows "
+                   << settings.results_format.chunk_num_rows
+                   << "\ndistortion_metrics";
+  for (DistortionMetric metric : settings.distortion_metrics) {
+    results_settings << " "
+                     << kDistortionMetricToStr[static_cast<size_t>(metric)];
+  }
+  results_settings << "\n";
+  return results_settings.str();
+}
+
+// To be called once all the JSON files are written.
+Status WriteResultsSettings(const ComparisonSettings& settings,
+                            const std::string& results_folder_path) {
+  const std::string results_settings_path =
+      (std::filesystem::path(results_folder_path) / kResultsSettingsFileName)
+          .string();
+  std::ofstream results_settings_file(results_settings_path, std::ios::trunc);
+  results_settings_file << GetResultsSettings(settings);
+  CHECK_OR_RETURN(results_settings_file.good(), settings.quiet)
+      << "Could not write " << results_settings_path;
+  return Status::kOk;
+}
+
+// Inserts the batches of completed_tasks whose JSON file is missing or older
+// than the completed tasks file, meaning that a previous run was interrupted
+// before writing it. Inserts all batches if the JSON files were written with
+// other results_settings, in which case the file recording these is removed
+// until they are all written again.
+void InsertOutdatedBatches(const std::vector<TaskOutput>& completed_tasks,
+                           const std::string& completed_tasks_file_path,
+                           const std::string& results_folder_path,
+                           const ResultsFormat& results_format,
+                           const std::string& results_settings,
+                           std::set<BatchKey>& outdated_batches) {
+  std::set<BatchKey> batches;
+  for (const TaskOutput& task : completed_tasks) {
+    batches.insert(GetBatchKey(task.task_input));
+  }
+  const std::filesystem::path results_settings_path =
+      std::filesystem::path(results_folder_path) / kResultsSettingsFileName;
+  std::ifstream results_settings_file(results_settings_path);
+  const std::string previous_results_settings(
+      (std::istreambuf_iterator<char>(results_settings_file)),
+      std::istreambuf_iterator<char>());
+  results_settings_file.close();
+  std::error_code error_code;
+  bool all = previous_results_settings != results_settings;
+  if (all) std::filesystem::remove(results_settings_path, error_code);
+  const std::filesystem::file_time_type completed_tasks_time =
+      std::filesystem::last_write_time(completed_tasks_file_path, error_code);
+  all |= static_cast<bool>(error_code);
+  for (const BatchKey& batch : batches) {
+    const std::filesystem::file_time_type results_time =
+        std::filesystem::last_write_time(
+            std::filesystem::path(results_folder_path) /
+                (GetBatchFileName(batch) +
+                 ResultsFileExtension(results_format)),
+            error_code);
+    if (all || error_code || results_time < completed_tasks_time) {
+      outdated_batches.insert(batch);
+    }
+  }
+}
+
+// Aggregates the completed tasks of the outdated batches and writes their JSON
+// files, one batch at a time to bound the memory usage. The tasks are copied
+// only if workers_are_running, because context.completed_tasks may grow
+// meanwhile. Thread-safe.
+Status WriteOutdatedResults(WorkerContext& context,
+                            const std::string& results_folder_path,
+                            bool workers_are_running, bool quiet) {
+  const Timer timer;
+  std::set<BatchKey> batches;
+  std::vector<TaskOutput> copied_tasks;
+  std::vector<const TaskOutput*> tasks;
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    batches.swap(context.outdated_batches);
+    if (batches.empty()) return Status::kOk;
+    for (const TaskOutput& task : context.completed_tasks) {
+      if (batches.count(GetBatchKey(task.task_input)) != 0) {
+        if (workers_are_running) {
+          copied_tasks.push_back(task);
+        } else {
+          tasks.push_back(&task);
+        }
+      }
+    }
+  }
+  if (workers_are_running) {
+    tasks.reserve(copied_tasks.size());
+    for (const TaskOutput& task : copied_tasks) tasks.push_back(&task);
+  }
+
+  size_t num_written_files = 0;
+  const Status status = ForEachCodecSettingsAggregatedByImageAndQuality(
+      tasks, context.timing.statistic, quiet,
+      [&](const std::vector<TaskOutput>& batch_tasks) {
+        const CodecSettings& codec_settings =
+            batch_tasks.front().task_input.codec_settings;
+        OK_OR_RETURN(TasksToJson(
+            GetBatchPrettyName(codec_settings), codec_settings,
+            context.timing.statistic, batch_tasks, context.results_format,
+            quiet,
+            std::filesystem::path(results_folder_path) /
+                (GetBatchFileName(GetBatchKey(batch_tasks.front().task_input)) +
+                 ResultsFileExtension(context.results_format))));
+        ++num_written_files;
+        return Status::kOk;
+      });
+  if (status != Status::kOk) {
+    // Try again next time.
+    std::lock_guard<std::mutex> lock(context.mutex);
+    context.outdated_batches.insert(batches.begin(), batches.end());
+    return status;
+  }
+  if (!quiet) {
+    std::cout << "Wrote " << num_written_files << " JSON files in "
+              << Timer::SecondsToString(timer.seconds()) << " (peak RSS "
+              << (GetPeakResidentSetSize() >> 20) << " MB)" << std::endl;
+  }
+  return Status::kOk;
+}
+
+// CPUs reserved for the timed encoding and decoding, and for the rest.
+struct CpuPlan {
+  std::vector<std::vector<int>> task_worker_cpus;  // Empty if not pinned.
+  std::vector<int> other_cpus;  // Empty if not restricted.
+};
+
+StatusOr<CpuPlan> PlanCpus(const ComparisonSettings& settings) {
+  CpuPlan plan;
+  if (!settings.pin_threads && settings.numa_node == -1) return plan;
+  std::vector<int> cpus = GetAllowedCpus();
+  CHECK_OR_RETURN(!cpus.empty(), settings.quiet)
+      << "Restricting threads to CPUs is not supported on this platform";
+  if (settings.numa_node != -1) {
+    ASSIGN_OR_RETURN(const std::vector<int> numa_node_cpus,
+                     GetNumaNodeCpus(settings.numa_node, settings.quiet));
+    std::vector<int> allowed_numa_node_cpus;
+    std::set_intersection(cpus.begin(), cpus.end(), numa_node_cpus.begin(),
+                          numa_node_cpus.end(),
+                          std::back_inserter(allowed_numa_node_cpus));
+    cpus = std::move(allowed_numa_node_cpus);
+    CHECK_OR_RETURN(!cpus.empty(), settings.quiet)
+        << "No CPU of NUMA node " << settings.numa_node << " is allowed";
+  }
+  if (!settings.pin_threads) {
+    plan.other_cpus = std::move(cpus);
+    return plan;
+  }
+
+  const size_t num_workers = 1 + settings.num_extra_threads;
+  const size_t num_timing_cpus = num_workers * settings.num_codec_threads;
+  CHECK_OR_RETURN(num_timing_cpus <= cpus.size(), settings.quiet)
+      << "Pinning " << num_workers << " threads using "
+      << settings.num_codec_threads << " codec threads each requires "
+      << num_timing_cpus << " CPUs but only " << cpus.size()
+      << " are available";
+  for (size_t i = 0; i < num_workers; ++i) {
+    plan.task_worker_cpus.emplace_back(
+        cpus.begin() + i * settings.num_codec_threads,
+        cpus.begin() + (i + 1) * settings.num_codec_threads);
+  }
+  if (num_timing_cpus < cpus.size()) {
+    plan.other_cpus.assign(cpus.begin() + num_timing_cpus, cpus.end());
+  } else {
+    // Nothing left. The other threads compete with the timed ones.
+    plan.other_cpus = std::move(cpus);
+    if (!settings.quiet && settings.num_metric_threads > 0) {
+      std::cout << "Warning: No CPU left for the metric threads" << std::endl;
+    }
+  }
+  return plan;
+}
+
+// Restricts the calling thread and the threads it creates to the given CPUs
+// until destroyed.
+class ScopedAllowedCpus {
+ public:
+  ScopedAllowedCpus() = default;
+  ScopedAllowedCpus(const ScopedAllowedCpus&) = delete;
+  ~ScopedAllowedCpus() {
+    if (!previous_cpus_.empty()) {
+      (void)SetAllowedCpus(previous_cpus_, /*quiet=*/true);
+    }
+  }
+
+  Status Set(const std::vector<int>& cpus, bool quiet) {
+    std::vector<int> previous_cpus = GetAllowedCpus();
+    OK_OR_RETURN(SetAllowedCpus(cpus, quiet));
+    if (previous_cpus_.empty()) previous_cpus_ = std::move(previous_cpus);
+    return Status::kOk;
+  }
+
+ private:
+  std::vector<int> previous_cpus_;
+};
+
+// Returns true if all tasks are repetitions of the same encoding.
+bool IsSingleResult(const std::vector<TaskOutput>& tasks) {
+  if (tasks.empty()) return false;
+  const TaskInput& first = tasks.front().task_input;
+  return std::all_of(tasks.begin(), tasks.end(), [&](const TaskOutput& task) {
+    return task.task_input.codec_settings.codec == first.codec_settings.codec &&
+           task.task_input.codec_settings.chroma_subsampling ==
+               first.codec_settings.chroma_subsampling &&
+           task.task_input.codec_settings.effort ==
+               first.codec_settings.effort &&
+           task.task_input.codec_settings.quality ==
+               first.codec_settings.quality &&
+           task.task_input.codec_settings.num_threads ==
+               first.codec_settings.num_threads &&
+           task.task_input.image_path == first.image_path;
+  });
+}
+
+// Concatenates the completed tasks files of all shards into
+// completed_tasks_file_path and writes all the JSON files from them.
+Status MergeShards(const ComparisonSettings& settings,
+                   const std::string& completed_tasks_file_path,
+                   const std::string& results_folder_path) {
+  CHECK_OR_RETURN(settings.num_shards > 1, settings.quiet)
+      << "--merge_shards requires --num_shards above 1";
+  CHECK_OR_RETURN(!completed_tasks_file_path.empty(), settings.quiet)
+      << "--merge_shards requires --progress_file";
+  WorkerContext context;
+  context.timing = settings.timing;
+  context.results_format = settings.results_format;
+  for (uint32_t shard_index = 0; shard_index < settings.num_shards;
+       ++shard_index) {
+    const std::string shard_file_path = GetShardFilePath(
+        completed_tasks_file_path, shard_index, settings.num_shards);
+    CHECK_OR_RETURN(std::filesystem::exists(shard_file_path), settings.quiet)
+        << "Missing " << shard_file_path << " of shard " << shard_index;
+    ASSIGN_OR_RETURN(std::vector<TaskOutput> shard_tasks,
+                     LoadTasks(settings, shard_file_path));
+    for (TaskOutput& task : shard_tasks) {
+      // Also guarantees that no task is in two shards.
+      CHECK_OR_RETURN(GetShardIndex(task.task_input, settings.num_shards) ==
+                          shard_index,
+                      settings.quiet)
+          << task.task_input.Serialize() << " in " << shard_file_path
+          << " does not belong to shard " << shard_index << " of "
+          << settings.num_shards;
+      context.outdated_batches.insert(GetBatchKey(task.task_input));
+      context.completed_tasks.push_back(std::move(task));
+    }
+  }
+  CHECK_OR_RETURN(!context.completed_tasks.empty(), settings.quiet)
+      << "No completed task in any shard";
+
+  if (std::filesystem::exists(completed_tasks_file_path)) {
+    // Backup the old file.
+    std::filesystem::rename(completed_tasks_file_path,
+                            completed_tasks_file_path + ".bck");
+  }
+  std::ofstream completed_tasks_file(completed_tasks_file_path,
+                                     std::ios::trunc | std::ios::binary);
+  CHECK_OR_RETURN(completed_tasks_file.is_open(), settings.quiet)
+      << "Could not open " << completed_tasks_file_path << " for writing";
+  if (IsBinaryTasksFilePath(completed_tasks_file_path)) {
+    BinaryTaskEncoder binary_task_encoder;
+    completed_tasks_file << BinaryTaskEncoder::Header();
+    for (const TaskOutput& completed_task : context.completed_tasks) {
+      completed_tasks_file << binary_task_encoder.Encode(completed_task);
+    }
+  } else {
+    for (const TaskOutput& completed_task : context.completed_tasks) {
+      completed_tasks_file << completed_task.Serialize() << std::endl;
+    }
+  }
+  completed_tasks_file.close();
+  CHECK_OR_RETURN(!completed_tasks_file.fail(), settings.quiet)
+      << "Could not write " << completed_tasks_file_path;
+  if (!settings.quiet) {
+    std::cout << "Merged " << context.completed_tasks.size() << " tasks from "
+              << settings.num_shards << " shards into "
+              << completed_tasks_file_path << std::endl;
+  }
+
+  // The aggregation checks that the repetitions match whatever the shards.
+  if (!results_folder_path.empty()) {
+    OK_OR_RETURN(WriteOutdatedResults(context, results_folder_path,
+                                      /*workers_are_running=*/false,
+                                      settings.quiet));
+    return WriteResultsSettings(settings, results_folder_path);
+  }
+  return SplitByCodecSettingsAndAggregateByImageAndQuality(
+             context.completed_tasks, settings.timing.statistic,
+             settings.quiet)
+      .status;
+}
+
+// Returns null if settings.encode_cache_folder_path is empty.
+StatusOr<std::unique_ptr<EncodeCache>> CreateEncodeCache(
+    const ComparisonSettings& settings) {
+  const std::string& folder_path = settings.encode_cache_folder_path;
+  if (folder_path.empty()) return std::unique_ptr<EncodeCache>();
+  std::error_code error_code;
+  std::filesystem::create_directories(folder_path, error_code);
+  CHECK_OR_RETURN(!error_code, settings.quiet)
+      << "Could not create " << folder_path;
+  // The recorded outputs depend on how the tasks are timed and measured.
+  const TimingSettings& timing = settings.timing;
+  const ResourceUsageSettings& usage = settings.resource_usage;
+  std::stringstream measurement_key;
+  measurement_key << "w" << timing.num_warmups << " err"
+                  << timing.max_relative_error << " max" << timing.max_seconds
+                  << " " << TimingStatisticToString(timing.statistic)
+                  << " usage" << usage.cpu_time << usage.hardware_counters
+                  << usage.peak_memory
+                  << (settings.pin_threads ? " pinned" : "");
+  return std::make_unique<EncodeCache>(folder_path, measurement_key.str());
+}
+
+// Runs the tasks handed out by the coordinator at settings.coordinator_address
+// and sends their outputs back, until there is none left.
+Status RunRemoteTasks(const ComparisonSettings& settings) {
+  CHECK_OR_RETURN(settings.num_metric_threads == 0, settings.quiet)
+      << "--metric_threads is not supported with --coordinator";
+  BasisContext basis_context(/*enabled=*/UsesBasis(settings));
+  std::unique_ptr<ImageCache> original_image_cache;
+  if (settings.image_cache_max_num_bytes > 0) {
+    original_image_cache =
+        std::make_unique<ImageCache>(settings.image_cache_max_num_bytes);
+  }
+  TempFileCache reference_file_cache(kReferenceFileCacheMaxNumBytes);
+  std::unique_ptr<RepetitionCache> repetition_cache;
+  if (settings.num_repetitions > 0) {
+    repetition_cache =
+        std::make_unique<RepetitionCache>(settings.num_repetitions);
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<EncodeCache> encode_cache,
+                   CreateEncodeCache(settings));
+
+  WorkerContext context;
+  ASSIGN_OR_RETURN(CpuPlan cpu_plan, PlanCpus(settings));
+  ScopedAllowedCpus allowed_cpus;
+  if (!cpu_plan.other_cpus.empty()) {
+    OK_OR_RETURN(allowed_cpus.Set(cpu_plan.other_cpus, settings.quiet));
+  }
+  context.task_worker_cpus = std::move(cpu_plan.task_worker_cpus);
+  context.metric_binary_folder_path = settings.metric_binary_folder_path;
+  context.distortion_metrics = settings.distortion_metrics;
+  context.num_frame_threads = settings.num_frame_threads;
+  context.stream_rows_min_num_pixels = StreamRowsMinNumPixels(settings);
+  context.timing = settings.timing;
+  context.results_format = settings.results_format;
+  context.resource_usage = settings.resource_usage;
+  context.original_image_cache = original_image_cache.get();
+  context.reference_file_cache = &reference_file_cache;
+  context.repetition_cache = repetition_cache.get();
+  context.encode_cache = encode_cache.get();
+  context.quiet = settings.quiet;
+  if (settings.time_budget > 0) {
+    context.deadline = context.start_time +
+                       std::chrono::duration_cast<chrono::duration>(
+                           seconds(settings.time_budget));
+  }
+  context.stop_on_signal = true;
+
+  const size_t num_workers = 1 + settings.num_extra_threads;
+  std::vector<std::unique_ptr<LineConnection>> connections;
+  for (size_t i = 0; i < num_workers; ++i) {
+    connections.push_back(std::make_unique<LineConnection>());
+    OK_OR_RETURN(connections.back()->Connect(settings.coordinator_address,
+                                             settings.quiet));
+    CHECK_OR_RETURN(connections.back()->WriteLine(kRemoteTasksHello),
+                    settings.quiet)
+        << "Lost the connection to " << settings.coordinator_address;
+  }
+  context.coordinator_connections = &connections;
+  if (!settings.quiet) {
+    std::cout << "Running the tasks of " << settings.coordinator_address
+              << " with " << num_workers << " threads" << std::endl;
+  }
+
+  const Timer timer;
+  const StopSignalCatcher stop_signal_catcher;
+  WorkerPool<WorkerContext, TaskWorker> pool(num_workers);
+  pool.SetCpusPerWorker(context.task_worker_cpus);
+  pool.Run(context);
+  if (!settings.quiet) {
+    std::cout << "Ran " << context.num_completed_tasks_since_start
+              << " tasks (" << context.num_failures << " failures) in "
+              << Timer::SecondsToString(timer.seconds()) << std::endl;
+  }
+  return Status::kOk;
+}
+
+// Runs the tasks of settings.shard_index only.
+Status CompareTasks(const std::vector<std::string>& image_paths,
+                    const ComparisonSettings& settings,
+                    const std::string& completed_tasks_file_path,
+                    const std::string& results_folder_path) {
   BasisContext basis_context(/*enabled=*/UsesBasis(settings));
+  std::unique_ptr<ImageCache> original_image_cache;
+  if (settings.image_cache_max_num_bytes > 0) {
+    original_image_cache =
+        std::make_unique<ImageCache>(settings.image_cache_max_num_bytes);
+  }
+  // Deletes the shared temporary reference files when Compare() returns.
+  TempFileCache reference_file_cache(kReferenceFileCacheMaxNumBytes);
+  CHECK_OR_RETURN(settings.num_frame_threads > 0, settings.quiet)
+      << "--frame_threads must be at least 1";
+  CHECK_OR_RETURN(!settings.longest_first || !settings.group_by_image,
+                  settings.quiet)
+      << "--longest_first is incompatible with --group_by_image";
+  // Only the CPU time of the calling thread is measured, not of the threads it
+  // gives to the codecs.
+  CHECK_OR_RETURN(
+      !settings.resource_usage.cpu_time || settings.num_codec_threads <= 1,
+      settings.quiet)
+      << "The CPU time can only be measured with --codec_threads 1";
+  // The peak memory is measured for the whole process, so no other thread may
+  // allocate while a task runs.
+  CHECK_OR_RETURN(!settings.resource_usage.peak_memory ||
+                      (settings.num_extra_threads == 0 &&
+                       settings.num_metric_threads == 0),
+                  settings.quiet)
+      << "The peak memory can only be measured with --threads 0 and "
+         "--metric_threads 0";
+  CHECK_OR_RETURN(!settings.resource_usage.peak_memory ||
+                      settings.results_update_period == 0,
+                  settings.quiet)
+      << "--peak_memory is incompatible with --results_update_period";
+  CHECK_OR_RETURN(
+      !settings.resource_usage.peak_memory || settings.status_file_path.empty(),
+      settings.quiet)
+      << "--peak_memory is incompatible with --status_file";
+  CHECK_OR_RETURN(
+      !settings.resource_usage.peak_memory || settings.serve_tasks_port == 0,
+      settings.quiet)
+      << "--peak_memory is incompatible with --serve_tasks";
+  CHECK_OR_RETURN(
+      !settings.resource_usage.peak_memory || settings.prefetch_num_images == 0,
+      settings.quiet)
+      << "--peak_memory is incompatible with --prefetch";
+  CHECK_OR_RETURN(!settings.resource_usage.peak_memory ||
+                      settings.num_artifact_threads == 0,
+                  settings.quiet)
+      << "--peak_memory is incompatible with --artifact_threads";
+  // Blocks kept for the next tasks would count towards their peak memory.
+  // With --max_memory, they take at most an eighth of the budget.
+  size_t max_num_pooled_bytes = kDefaultMaxNumPooledBytes;
+  if (settings.resource_usage.peak_memory) {
+    max_num_pooled_bytes = 0;
+  } else if (settings.max_memory_num_bytes > 0) {
+    max_num_pooled_bytes = static_cast<size_t>(std::min<uint64_t>(
+        max_num_pooled_bytes, settings.max_memory_num_bytes / 8));
+  }
+  SetMaxNumPooledBytes(max_num_pooled_bytes);
+  const QualitySearchSettings& quality_search = settings.quality_search;
+  CHECK_OR_RETURN(
+      (quality_search.target != QualitySearchTarget::kDistortion &&
+       quality_search.target != QualitySearchTarget::kRateDistortionCurve) ||
+          (settings.distortion_metrics.empty() &&
+           IsComputedByDefault(quality_search.metric)) ||
+          std::find(settings.distortion_metrics.begin(),
+                    settings.distortion_metrics.end(),
+                    quality_search.metric) != settings.distortion_metrics.end(),
+      settings.quiet)
+      << "The distortion metric "
+      << kDistortionMetricToStr[static_cast<size_t>(quality_search.metric)]
+      << " is not computed";
+  CHECK_OR_RETURN(!quality_search.prune_saturated ||
+                      quality_search.target == QualitySearchTarget::kNone,
+                  settings.quiet)
+      << "Pruning saturated qualities is incompatible with quality searches";
   WorkerContext context;
   ASSIGN_OR_RETURN(context.remaining_tasks, PlanTasks(image_paths, settings));
+  KeepShardTasks(settings.shard_index, settings.num_shards,
+                 context.remaining_tasks);
+
+  // Set before starting any thread so that they all inherit it.
+  ASSIGN_OR_RETURN(CpuPlan cpu_plan, PlanCpus(settings));
+  ScopedAllowedCpus allowed_cpus;
+  if (!cpu_plan.other_cpus.empty()) {
+    OK_OR_RETURN(allowed_cpus.Set(cpu_plan.other_cpus, settings.quiet));
+  }
+  context.task_worker_cpus = std::move(cpu_plan.task_worker_cpus);
   ASSIGN_OR_RETURN(context.completed_tasks,
                    LoadTasks(settings, completed_tasks_file_path));
-  if (settings.discard_distortion_values &&
+  const bool has_missing_distortions = std::any_of(
+      context.completed_tasks.begin(), context.completed_tasks.end(),
+      [&settings](const TaskOutput& task) {
+        return IsMissingDistortions(settings, task);
+      });
+  if (!results_folder_path.empty()) {
+    // Only the JSON files whose tasks changed are written.
+    if (settings.skip_all_remaining) {
+      for (const TaskOutput& task : context.completed_tasks) {
+        context.outdated_batches.insert(GetBatchKey(task.task_input));
+      }
+    } else {
+      InsertOutdatedBatches(context.completed_tasks, completed_tasks_file_path,
+                            results_folder_path, settings.results_format,
+                            GetResultsSettings(settings),
+                            context.outdated_batches);
+    }
+  }
+  const bool is_binary_tasks_file =
+      IsBinaryTasksFilePath(completed_tasks_file_path);
+  // Knows the strings already stored in the binary completed tasks file.
+  BinaryTaskEncoder binary_task_encoder;
+  bool is_binary_header_written = false;
+  if ((settings.discard_distortion_values || has_missing_distortions) &&
       std::filesystem::exists(completed_tasks_file_path)) {
-    // Backup the old CSV file.
+    // Backup the old file.
     std::filesystem::rename(completed_tasks_file_path,
                             completed_tasks_file_path + ".bck");
+    for (const TaskOutput& task : context.completed_tasks) {
+      if (settings.discard_distortion_values ||
+          IsMissingDistortions(settings, task)) {
+        context.outdated_batches.insert(GetBatchKey(task.task_input));
+      }
+    }
     OK_OR_RETURN(
-        ComputeDistortionInCompletedTasks(settings, context.completed_tasks));
+        ComputeDistortionInCompletedTasks(settings, original_image_cache.get(),
+                                          &reference_file_cache,
+                                          context.completed_tasks));
     // Dump the updated entries.
     std::ofstream completed_tasks_file(completed_tasks_file_path,
-                                       std::ios::trunc);
+                                       std::ios::trunc | std::ios::binary);
     CHECK_OR_RETURN(completed_tasks_file.is_open(), settings.quiet)
         << "Could not open " << completed_tasks_file_path << " for writing";
-    for (const TaskOutput& completed_task : context.completed_tasks) {
-      completed_tasks_file << completed_task.Serialize() << std::endl;
+    if (is_binary_tasks_file) {
+      completed_tasks_file << BinaryTaskEncoder::Header();
+      for (const TaskOutput& completed_task : context.completed_tasks) {
+        completed_tasks_file << binary_task_encoder.Encode(completed_task);
+      }
+      is_binary_header_written = true;
+    } else {
+      for (const TaskOutput& completed_task : context.completed_tasks) {
+        completed_tasks_file << completed_task.Serialize() << std::endl;
+      }
     }
   }
   OK_OR_RETURN(RemoveCompletedTasksFromRemainingTasks(
       settings, completed_tasks_file_path, context.completed_tasks,
       context.remaining_tasks));
-  OK_OR_RETURN(ShuffleRemainingTasks(settings, context.remaining_tasks));
+  // Known before any decoding to sort the tasks, estimate their memory and
+  // skip the ones that would fail anyway.
+  AnnotateImageHeaders(settings.num_extra_threads + 1, settings.image_headers,
+                       context.remaining_tasks);
+  const auto unsupported_tasks =
+      std::remove_if(context.remaining_tasks.begin(),
+                     context.remaining_tasks.end(), IsKnownUnsupported);
+  if (unsupported_tasks != context.remaining_tasks.end() && !settings.quiet) {
+    std::cout << "Warning: skipping "
+              << (context.remaining_tasks.end() - unsupported_tasks)
+              << " lossy tasks of images whose bit depth is not supported by "
+                 "their codec"
+              << std::endl;
+  }
+  context.remaining_tasks.erase(unsupported_tasks,
+                                context.remaining_tasks.end());
+  std::unique_ptr<DuplicateTasks> duplicate_tasks;
+  if (settings.dedup_images) {
+    ASSIGN_OR_RETURN(const auto originals,
+                     FindDuplicateImages(image_paths, settings.quiet));
+    duplicate_tasks =
+        std::make_unique<DuplicateTasks>(originals, context.remaining_tasks);
+    context.duplicate_tasks = duplicate_tasks.get();
+    if (!settings.quiet) {
+      std::cout << duplicate_tasks->size() << " tasks of " << originals.size()
+                << " duplicate images will be copied instead of run"
+                << std::endl;
+    }
+  }
+  // Based on the durations of the tasks completed by previous runs.
+  const TaskCostModel cost_model(context.completed_tasks);
+  if (settings.longest_first && cost_model.IsEmpty() && !settings.quiet) {
+    std::cout << "No timed completed task to sort by duration, the longest "
+                 "tasks may not run first"
+              << std::endl;
+  }
+  OK_OR_RETURN(
+      ShuffleRemainingTasks(settings, cost_model, context.remaining_tasks));
+  std::unique_ptr<CandidateCache> candidate_cache;
+  if (settings.reuse_candidates) {
+    CHECK_OR_RETURN(
+        settings.quality_search.target == QualitySearchTarget::kNone &&
+            !settings.quality_search.prune_saturated,
+        settings.quiet)
+        << "--reuse_candidates is incompatible with the quality searches";
+    // Run the combinations last, once their candidates are likely encoded.
+    std::stable_partition(context.remaining_tasks.begin(),
+                          context.remaining_tasks.end(),
+                          [](const TaskInput& task) {
+                            return task.codec_settings.codec !=
+                                   Codec::kCombination;
+                          });
+    candidate_cache = std::make_unique<CandidateCache>();
+    for (const TaskInput& task : context.remaining_tasks) {
+      if (task.codec_settings.codec != Codec::kCombination) continue;
+      for (const TaskInput& candidate : CodecCombinationCandidates(task)) {
+        candidate_cache->Expect(candidate);
+      }
+    }
+    context.candidate_cache = candidate_cache.get();
+  }
+  std::unique_ptr<TaskMemoryModel> memory_model;
+  std::unique_ptr<MemoryGovernor> memory_governor;
+  if (settings.max_memory_num_bytes > 0) {
+    // The images kept by the image cache and the blocks pooled between tasks
+    // belong to no running task, so their maximum is charged upfront.
+    const uint64_t num_reserved_bytes =
+        uint64_t{settings.image_cache_max_num_bytes} + max_num_pooled_bytes;
+    CHECK_OR_RETURN(num_reserved_bytes < settings.max_memory_num_bytes,
+                    settings.quiet)
+        << "--max_memory must exceed --image_cache plus the pooled memory ("
+        << (num_reserved_bytes >> 20) << " MB)";
+    memory_model = std::make_unique<TaskMemoryModel>(context.completed_tasks);
+    memory_governor = std::make_unique<MemoryGovernor>(
+        settings.max_memory_num_bytes - num_reserved_bytes);
+    context.memory_model = memory_model.get();
+    context.memory_governor = memory_governor.get();
+  }
   context.quiet = settings.quiet;
-  context.num_tasks =
-      context.completed_tasks.size() + context.remaining_tasks.size();
+  if (settings.time_budget > 0) {
+    context.deadline = context.start_time +
+                       std::chrono::duration_cast<chrono::duration>(
+                           seconds(settings.time_budget));
+    context.cost_model = &cost_model;
+  }
+  context.stop_on_signal = true;
+  std::unique_ptr<QualitySearches> quality_searches;
+  // Recorded once the completed tasks file is open.
+  std::vector<TaskOutput> extrapolated_tasks;
+  if (settings.quality_search.target != QualitySearchTarget::kNone ||
+      settings.quality_search.prune_saturated) {
+    quality_searches = std::make_unique<QualitySearches>(
+        settings.quality_search, context.remaining_tasks,
+        context.completed_tasks);
+    context.remaining_tasks =
+        quality_searches->TakeFirstTasks(extrapolated_tasks);
+    context.quality_searches = quality_searches.get();
+    // Upper bound. Decreases as the searches converge.
+    context.num_tasks = context.completed_tasks.size() +
+                        extrapolated_tasks.size() +
+                        quality_searches->MaxNumRemainingTasks();
+  } else {
+    context.num_tasks = context.completed_tasks.size() +
+                        context.remaining_tasks.size() +
+                        (duplicate_tasks ? duplicate_tasks->size() : 0);
+  }
+  ProgressTracker progress_tracker(context.remaining_tasks, &cost_model);
+  context.progress_tracker = &progress_tracker;
   context.max_num_failures = static_cast<size_t>(
       std::lround(context.num_tasks * settings.abort_above_fail_ratio));
 
@@ -384,17 +1911,84 @@ Status Compare(const std::vector<std::string>& image_paths,
                 << std::endl;
     }
     context.remaining_tasks.clear();
+    extrapolated_tasks.clear();
+    context.duplicate_tasks = nullptr;
     CHECK_OR_RETURN(!context.completed_tasks.empty(), settings.quiet)
         << "No task loaded, remove --skip_all_remaining";
   }
 
-  context.completed_tasks_file_path = completed_tasks_file_path;
+  // Synced regularly to resume from there if interrupted.
+  AsyncLineWriter completed_tasks_writer(kCompletedTasksMaxNumBufferedBytes,
+                                         kCompletedTasksMaxDelaySeconds);
   if (!completed_tasks_file_path.empty()) {
-    context.completed_tasks_file.open(completed_tasks_file_path, std::ios::app);
-    CHECK_OR_RETURN(context.completed_tasks_file.is_open(), settings.quiet)
-        << "Could not open " << completed_tasks_file_path << " for writing";
+    if (is_binary_tasks_file && !is_binary_header_written &&
+        std::filesystem::exists(completed_tasks_file_path) &&
+        std::filesystem::file_size(completed_tasks_file_path) > 0) {
+      size_t complete_size;
+      {
+        MappedFile previous_completed_tasks_file;
+        OK_OR_RETURN(previous_completed_tasks_file.Open(
+            completed_tasks_file_path, settings.quiet));
+        ASSIGN_OR_RETURN(complete_size,
+                         binary_task_encoder.Resume(
+                             previous_completed_tasks_file.contents(),
+                             settings.quiet));
+      }
+      // Drop the record left incomplete by an interrupted run, if any, instead
+      // of appending after it.
+      if (complete_size <
+          std::filesystem::file_size(completed_tasks_file_path)) {
+        std::filesystem::resize_file(completed_tasks_file_path, complete_size);
+      }
+      is_binary_header_written = true;
+    }
+    OK_OR_RETURN(
+        completed_tasks_writer.Open(completed_tasks_file_path, settings.quiet));
+    context.completed_tasks_writer = &completed_tasks_writer;
+    if (is_binary_tasks_file) {
+      if (!is_binary_header_written) {
+        completed_tasks_writer.AppendBytes(BinaryTaskEncoder::Header());
+      }
+      context.binary_task_encoder = &binary_task_encoder;
+    }
   }
   context.metric_binary_folder_path = settings.metric_binary_folder_path;
+  context.distortion_metrics = settings.distortion_metrics;
+  context.num_frame_threads = settings.num_frame_threads;
+  context.stream_rows_min_num_pixels = StreamRowsMinNumPixels(settings);
+  context.timing = settings.timing;
+  context.results_format = settings.results_format;
+  context.resource_usage = settings.resource_usage;
+  context.original_image_cache = original_image_cache.get();
+  context.reference_file_cache = &reference_file_cache;
+  std::unique_ptr<RepetitionCache> repetition_cache;
+  if (settings.num_repetitions > 0) {
+    repetition_cache =
+        std::make_unique<RepetitionCache>(settings.num_repetitions);
+    context.repetition_cache = repetition_cache.get();
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<EncodeCache> encode_cache,
+                   CreateEncodeCache(settings));
+  context.encode_cache = encode_cache.get();
+  std::unique_ptr<ImagePrefetcher> image_prefetcher;
+  if (settings.prefetch_num_images > 0) {
+    image_prefetcher = std::make_unique<ImagePrefetcher>();
+    context.image_prefetcher = image_prefetcher.get();
+    context.prefetch_num_images = settings.prefetch_num_images;
+  }
+  std::unique_ptr<ArtifactWriter> artifact_writer;
+  if (settings.num_artifact_threads > 0) {
+    artifact_writer = std::make_unique<ArtifactWriter>(
+        settings.num_artifact_threads,
+        /*max_num_queued_images=*/2 * settings.num_artifact_threads,
+        settings.fast_artifacts, settings.quiet);
+    context.artifact_writer = artifact_writer.get();
+  }
+  for (TaskOutput& task : extrapolated_tasks) {
+    const std::string serialized_task = task.Serialize();
+    const TaskInput task_input = task.task_input;
+    EndTaskOutput(context, task_input, std::move(task), serialized_task);
+  }
 
   if (!settings.quiet && !settings.skip_all_remaining) {
     std::cout << "Starting " << context.remaining_tasks.size() << " tasks"
@@ -403,57 +1997,114 @@ Status Compare(const std::vector<std::string>& image_paths,
 
   const Timer timer;
 
-  WorkerPool<WorkerContext, TaskWorker> pool(1 + settings.num_extra_threads);
-  pool.Run(context);
+  // Writes the JSON files from time to time while the tasks run.
+  std::unique_ptr<PeriodicCaller> results_updater;
+  if (!results_folder_path.empty() && settings.results_update_period > 0) {
+    results_updater = std::make_unique<PeriodicCaller>(
+        settings.results_update_period, [&]() {
+          (void)WriteOutdatedResults(context, results_folder_path,
+                                     /*workers_are_running=*/true,
+                                     settings.quiet);  // Retried at the end.
+        });
+  }
+  std::unique_ptr<PeriodicCaller> status_updater;
+  if (!settings.status_file_path.empty()) {
+    OK_OR_RETURN(WriteStatusFile(context, settings.status_file_path,
+                                 /*is_done=*/false, settings.quiet));
+    status_updater = std::make_unique<PeriodicCaller>(
+        kStatusFileUpdatePeriodSeconds, [&]() {
+          (void)WriteStatusFile(context, settings.status_file_path,
+                                /*is_done=*/false, settings.quiet);
+        });
+  }
+
+  // Kept until the end so that the completed tasks are recorded and the JSON
+  // files written even if the run is stopped by a signal.
+  const StopSignalCatcher stop_signal_catcher;
+  OK_OR_RETURN(RunTasks(settings, settings.serve_tasks_port, context));
+  if (artifact_writer != nullptr) OK_OR_RETURN(artifact_writer->Close());
+  results_updater.reset();
+  status_updater.reset();
+  if (!settings.status_file_path.empty()) {
+    OK_OR_RETURN(WriteStatusFile(context, settings.status_file_path,
+                                 /*is_done=*/true, settings.quiet));
+  }
   if (!completed_tasks_file_path.empty()) {
-    context.completed_tasks_file.close();
+    OK_OR_RETURN(completed_tasks_writer.Close());
   }
   if (context.num_failures > context.max_num_failures ||
       context.num_completed_tasks_since_start == 0) {
     OK_OR_RETURN(context.status);
   }
 
-  std::vector<std::vector<TaskOutput>> results;
-  ASSIGN_OR_RETURN(results, SplitByCodecSettingsAndAggregateByImageAndQuality(
-                                context.completed_tasks, settings.quiet));
-  const bool single_result = results.size() == 1 && results.front().size() == 1;
-
+  const bool single_result = IsSingleResult(context.completed_tasks);
   if (!results_folder_path.empty()) {
-    for (const std::vector<TaskOutput>& tasks : results) {
-      const CodecSettings& codec_settings =
-          tasks.front().task_input.codec_settings;
-      // Add a heading 0 when effort goes to 10 for better JSON file sorting.
-      const std::string effort_str = ((codec_settings.codec == Codec::kJpegXl &&
-                                       codec_settings.effort < 10)
-                                          ? "0"
-                                          : "") +
-                                     std::to_string(codec_settings.effort);
-      const std::string batch_file_name =
-          CodecName(codec_settings.codec) + "_" +
-          SubsamplingToString(codec_settings.chroma_subsampling) + "_" +
-          effort_str;
-      const std::string batch_pretty_name = CodecPrettyName(
-          codec_settings.codec, codec_settings.quality == kQualityLossless,
-          codec_settings.chroma_subsampling, codec_settings.effort);
-      OK_OR_RETURN(TasksToJson(batch_pretty_name, codec_settings, tasks,
-                               settings.quiet,
-                               std::filesystem::path(results_folder_path) /
-                                   (batch_file_name + ".json")));
-    }
+    OK_OR_RETURN(
+        WriteOutdatedResults(context, results_folder_path,
+                             /*workers_are_running=*/false, settings.quiet));
+    OK_OR_RETURN(WriteResultsSettings(settings, results_folder_path));
   } else if (!single_result) {
-    std::cout << "Warning: no JSON results folder path specified" << std::endl;
+    // The aggregation checks that the repetitions match even if not written.
+    OK_OR_RETURN(SplitByCodecSettingsAndAggregateByImageAndQuality(
+                     context.completed_tasks, settings.timing.statistic,
+                     settings.quiet)
+                     .status);
+    if (settings.num_shards == 1) {
+      std::cout << "Warning: no JSON results folder path specified"
+                << std::endl;
+    }
   }
 
   if (!settings.quiet) {
     std::cout << "Took " << Timer::SecondsToString(timer.seconds())
               << std::endl;
+    if (repetition_cache != nullptr) {
+      std::cout << repetition_cache->num_hits()
+                << " repetitions reused the distortions of the first one"
+                << std::endl;
+    }
+    if (encode_cache != nullptr) {
+      std::cout << encode_cache->num_hits()
+                << " tasks were reused from the encode cache" << std::endl;
+    }
+    if (candidate_cache != nullptr) {
+      std::cout << candidate_cache->num_hits()
+                << " combination candidates were reused from other tasks"
+                << std::endl;
+    }
+    if (memory_governor != nullptr) {
+      std::cout << memory_governor->num_waits()
+                << " tasks waited for enough memory to start" << std::endl;
+    }
+    if (image_prefetcher != nullptr) {
+      std::cout << image_prefetcher->num_hits() << " images were prefetched in "
+                << "time, " << image_prefetcher->num_misses()
+                << " were not and stalled the tasks for "
+                << Timer::SecondsToString(image_prefetcher->stall_seconds())
+                << std::endl;
+    }
     if (context.num_failures > 0) {
       std::cout << " /!\\ Warning: " << context.num_failures << " failures"
                 << std::endl;
     }
+    if (context.num_abandoned_tasks > 0) {
+      std::cout << context.num_abandoned_tasks
+                << " tasks were not started because they were predicted to "
+                   "end after the time budget"
+                << std::endl;
+    }
+    if (context.is_stopping) {
+      std::cout << "Stopped early. Run the same command again to resume."
+                << std::endl;
+    }
   }
 
   if (single_result) {
+    std::vector<std::vector<TaskOutput>> results;
+    ASSIGN_OR_RETURN(results,
+                     SplitByCodecSettingsAndAggregateByImageAndQuality(
+                         context.completed_tasks, settings.timing.statistic,
+                         settings.quiet));
     const TaskOutput& task = results.front().front();
     const TaskInput& input = task.task_input;
     const CodecSettings& codec_settings = input.codec_settings;
@@ -480,12 +2131,22 @@ Status Compare(const std::vector<std::string>& image_paths,
               << "  Color conversion duration (if available): "
               << Timer::SecondsToString(task.decoding_color_conversion_duration)
               << std::endl;
+    if (task.encoding_duration_stddev >= 0) {
+      std::cout << "  Durations are the "
+                << TimingStatisticToString(settings.timing.statistic)
+                << " of the repetitions (standard deviation "
+                << Timer::SecondsToString(task.encoding_duration_stddev)
+                << " to encode, "
+                << Timer::SecondsToString(task.decoding_duration_stddev)
+                << " to decode)" << std::endl;
+    }
     const size_t longest_metric_name = std::strlen(*std::max_element(
         kDistortionMetricToStr, kDistortionMetricToStr + kNumDistortionMetrics,
         [](const char* a, const char* b) {
           return std::strlen(a) < std::strlen(b);
         }));
     for (uint32_t i = 0; i < kNumDistortionMetrics; ++i) {
+      if (std::isnan(task.distortions[i])) continue;  // Not computed.
       std::cout << "  Distortion ("
                 << std::setw(static_cast<int>(longest_metric_name)) << std::left
                 << kDistortionMetricToStr[i] << "): " << task.distortions[i]
@@ -495,4 +2156,148 @@ Status Compare(const std::vector<std::string>& image_paths,
   return Status::kOk;
 }
 
+}  // namespace
+
+Status Compare(const std::vector<std::string>& image_paths,
+               const ComparisonSettings& settings,
+               const std::string& completed_tasks_file_path,
+               const std::string& results_folder_path) {
+  CHECK_OR_RETURN(
+      settings.num_shards > 0 && settings.shard_index < settings.num_shards,
+      settings.quiet)
+      << "--shard_index must be lower than --num_shards";
+  if (!settings.temp_folder_path.empty()) {
+    std::error_code error;
+    CHECK_OR_RETURN(
+        std::filesystem::is_directory(settings.temp_folder_path, error),
+        settings.quiet)
+        << "--temp_folder " << settings.temp_folder_path << " is not a folder";
+  }
+  CHECK_OR_RETURN(!settings.memory_files || MemoryFile::IsSupported(),
+                  settings.quiet)
+      << "--memory_files is only supported on Linux";
+  SetFastTempDirectory(settings.temp_folder_path);
+  SetUseMemoryFiles(settings.memory_files);
+  CHECK_OR_RETURN(!settings.metric_servers || CommandServer::IsSupported(),
+                  settings.quiet)
+      << "--metric_servers is only supported on POSIX systems";
+  SetUseCommandServers(settings.metric_servers);
+  SetReuseCodecContexts(settings.reuse_codec_contexts);
+  TraceRecorder trace_recorder;  // Writes the file when Compare() returns.
+  if (!settings.trace_file_path.empty()) {
+    OK_OR_RETURN(
+        trace_recorder.Start(settings.trace_file_path, settings.quiet));
+  }
+  if (!settings.coordinator_address.empty()) {
+    CHECK_OR_RETURN(settings.num_shards == 1 && settings.serve_tasks_port == 0,
+                    settings.quiet)
+        << "--coordinator is incompatible with --num_shards and --serve_tasks";
+    return RunRemoteTasks(settings);
+  }
+  if (settings.merge_shards) {
+    return MergeShards(settings, completed_tasks_file_path,
+                       results_folder_path);
+  }
+  if (settings.num_shards == 1) {
+    return CompareTasks(image_paths, settings, completed_tasks_file_path,
+                        results_folder_path);
+  }
+  CHECK_OR_RETURN(!completed_tasks_file_path.empty(), settings.quiet)
+      << "--num_shards requires --progress_file";
+  if (!settings.quiet && !results_folder_path.empty()) {
+    std::cout << "The JSON files are only written by --merge_shards"
+              << std::endl;
+  }
+  return CompareTasks(image_paths, settings,
+                      GetShardFilePath(completed_tasks_file_path,
+                                       settings.shard_index,
+                                       settings.num_shards),
+                      /*results_folder_path=*/"");
+}
+
+Status BenchmarkDecoders(const std::vector<std::string>& image_paths,
+                         const ComparisonSettings& settings,
+                         uint32_t num_decodings,
+                         const std::string& results_folder_path) {
+  CHECK_OR_RETURN(!settings.encoded_folder_path.empty(), settings.quiet)
+      << "Benchmarking decoders requires the folder of the encoded images";
+  CHECK_OR_RETURN(num_decodings > 0, settings.quiet);
+  BasisContext basis_context(/*enabled=*/UsesBasis(settings));
+  ASSIGN_OR_RETURN(std::vector<TaskInput> tasks,
+                   PlanTasks(image_paths, settings));
+  // The repetitions share the same encoded file.
+  std::unordered_set<std::string> encoded_paths;
+  tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                             [&encoded_paths](const TaskInput& task) {
+                               return !encoded_paths.insert(task.encoded_path)
+                                           .second;
+                             }),
+              tasks.end());
+
+  // The decodings run one at a time so that they do not compete for the
+  // caches and the memory bandwidth. Pinned like the first TaskWorker.
+  ASSIGN_OR_RETURN(const CpuPlan cpu_plan, PlanCpus(settings));
+  ScopedAllowedCpus allowed_cpus;
+  if (!cpu_plan.task_worker_cpus.empty()) {
+    OK_OR_RETURN(allowed_cpus.Set(cpu_plan.task_worker_cpus.front(),
+                                  settings.quiet));
+  } else if (!cpu_plan.other_cpus.empty()) {
+    OK_OR_RETURN(allowed_cpus.Set(cpu_plan.other_cpus, settings.quiet));
+  }
+
+  const Timer timer;
+  std::map<BatchKey, std::vector<DecodingBenchmark>> batches;
+  size_t num_missing = 0, num_failures = 0;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    const TaskInput& task = tasks[i];
+    std::error_code error_code;
+    if (!std::filesystem::exists(task.encoded_path, error_code)) {
+      ++num_missing;  // Not encoded by a previous run.
+      continue;
+    }
+    StatusOr<DecodingBenchmark> benchmark =
+        BenchmarkDecoding(task, num_decodings, settings.timing.num_warmups,
+                          settings.quiet);
+    if (benchmark.status != Status::kOk) {
+      ++num_failures;
+      continue;
+    }
+    batches[GetBatchKey(task)].push_back(std::move(benchmark.value));
+    if (!settings.quiet) {
+      std::cout << "[" << (i + 1) << "/" << tasks.size() << "] Decoded "
+                << task.encoded_path << " " << num_decodings << " times"
+                << std::endl;
+    }
+  }
+  if (!settings.quiet) {
+    std::cout << "Benchmarked " << (tasks.size() - num_missing - num_failures)
+              << " encoded images in "
+              << Timer::SecondsToString(timer.seconds()) << " ("
+              << num_missing << " missing, " << num_failures << " failed)"
+              << std::endl;
+  }
+
+  if (results_folder_path.empty()) return Status::kOk;
+  for (auto& [batch, benchmarks] : batches) {
+    // Deterministic order regardless of settings.random_order.
+    std::sort(benchmarks.begin(), benchmarks.end(),
+              [](const DecodingBenchmark& a, const DecodingBenchmark& b) {
+                const TaskInput& a_input = a.task.task_input;
+                const TaskInput& b_input = b.task.task_input;
+                return std::tie(a_input.image_path,
+                                a_input.codec_settings.quality) <
+                       std::tie(b_input.image_path,
+                                b_input.codec_settings.quality);
+              });
+    const CodecSettings& codec_settings =
+        benchmarks.front().task.task_input.codec_settings;
+    OK_OR_RETURN(DecodingBenchmarksToJson(
+        GetBatchPrettyName(codec_settings), codec_settings,
+        settings.timing.num_warmups, benchmarks, settings.quiet,
+        std::filesystem::path(results_folder_path) /
+            (GetBatchFileName(batch) + "_decode.json")));
+  }
+  return Status::kOk;
+}
+
 }  // namespace codec_compare_gen
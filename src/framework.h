@@ -15,11 +15,15 @@
 #ifndef SRC_FRAMEWORK_H_
 #define SRC_FRAMEWORK_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "src/base.h"
+#include "src/image_header.h"
+#include "src/resource_usage.h"
 
 namespace codec_compare_gen {
 
@@ -28,20 +32,182 @@ struct CodecSettings {
   Subsampling chroma_subsampling;
   int effort;
   int quality;  // kQualityLossless or in [0:100] (exact range depends on codec)
+  uint32_t num_threads = 1;  // Threads used by the codec library itself.
+};
+
+// How the encoding and the decoding of each task are timed.
+struct TimingSettings {
+  uint32_t num_warmups = 0;  // Discarded encodings and decodings run before
+                             // the measured ones, reusing the same original.
+  // If not 0, the measured encoding and decoding are repeated in-process until
+  // the 95% confidence interval of their durations is within that ratio of
+  // their mean, or until max_seconds are spent on the repetitions.
+  double max_relative_error = 0;
+  double max_seconds = 10;
+  // Aggregates the in-process repetitions above and the repeated tasks.
+  TimingStatistic statistic = TimingStatistic::kMean;
+};
+
+// What each codec settings and image pair searches for, if not kNone.
+enum class QualitySearchTarget {
+  kNone,
+  kDistortion,
+  kBitsPerPixel,
+  kRateDistortionCurve
+};
+
+// Instead of running all planned qualities, bisects them to find the lowest
+// quality reaching a distortion or the highest quality within a size budget,
+// or only samples them where the rate-distortion curve bends.
+struct QualitySearchSettings {
+  QualitySearchTarget target = QualitySearchTarget::kNone;
+  DistortionMetric metric = DistortionMetric::kLibjxlSsimulacra2;
+  // Distortion of metric, bits per pixel, or maximum error of metric when
+  // linearly interpolating the curve between two sampled qualities.
+  double value = 0;
+  // Evenly spread qualities first sampled for kRateDistortionCurve.
+  size_t num_initial_curve_qualities = 5;
+  // Only with kNone. If true, the qualities of each codec settings and image
+  // pair are run in increasing order until the curve saturates, that is once
+  // an encoding is lossless (pixel equality) or its size is unchanged over the
+  // last qualities. The tasks of the higher qualities are then not run but
+  // recorded as extrapolated copies of the saturated one.
+  bool prune_saturated = false;
+};
+
+// How the JSON files of the results are written. See TasksToJson().
+struct ResultsFormat {
+  // If true, the files are compressed with gzip while being written, and
+  // ".gz" is appended to their names.
+  bool gzip = false;
+  // If not 0, the rows of each JSON file are written to separate chunk files
+  // of at most that many rows, listed by the JSON file so that they can be
+  // fetched lazily. The constants are still only in the JSON file.
+  size_t chunk_num_rows = 0;
 };
 
 struct ComparisonSettings {
   std::vector<CodecSettings> codec_settings;
   std::string metric_binary_folder_path;
+  // Where the temporary files are written. See GetFastTempDirectory().
+  std::string temp_folder_path;
+  // If true, the temporary files read by the metric binaries are MemoryFiles.
+  bool memory_files = false;
+  // If true, the metric binaries are started by long-lived shells shared by
+  // all threads instead of forking this process for each measurement. See
+  // CommandServerPool.
+  bool metric_servers = false;
+  // If false, the codec states are created for each encoding and decoding
+  // instead of being reused by each thread. See ReuseCodecContexts().
+  bool reuse_codec_contexts = true;
+  // Computed for lossy tasks. Empty means all. The other metrics are set to
+  // kDistortionNotComputed.
+  std::vector<DistortionMetric> distortion_metrics;
   std::string encoded_folder_path;
   uint32_t num_repetitions = 0;  // 0 means encode/decode each image once,
                                  // 1 means encode/decode each image twice etc.
+  TimingSettings timing;
+  QualitySearchSettings quality_search;
   uint32_t num_extra_threads = 0;  // 0 means single-threaded,
                                    // 1 and above means multi-threaded.
+  uint32_t num_codec_threads = 1;  // Threads given to each encoder and
+                                   // decoder. Recorded in the results because
+                                   // it changes the timings.
+  uint32_t num_metric_threads = 0;  // 0 means distortions are computed by the
+                                    // threads above, otherwise by a separate
+                                    // pool of that many threads.
+  uint32_t num_frame_threads = 1;  // Threads evaluating the frames of each
+                                   // animation in parallel, on top of the
+                                   // threads above.
+  bool pin_threads = false;  // If true, each encoding/decoding thread runs
+                             // alone on num_codec_threads dedicated CPUs
+                             // (Linux only) for more reproducible timings.
+                             // Other threads use the remaining CPUs.
+  int numa_node = -1;  // If not -1, all threads run on the CPUs of that node.
+  // Measured around each encoding and decoding, and recorded in the results.
+  ResourceUsageSettings resource_usage;
+  // If not empty, the durations of the phases of each task and the lock waits
+  // of each thread are written to that Chrome trace JSON file. See TraceScope.
+  std::string trace_file_path;
+  // Headers of the input images already probed, for example by
+  // FindImageFiles(). The other images are probed at planning time.
+  std::unordered_map<std::string, ImageHeader> image_headers;
   bool random_order = false;  // If true, input paths are randomly permuted.
+  bool group_by_image = false;  // If true, tasks sharing the same input path
+                                // are run one after the other.
+  bool longest_first = false;  // If true, the tasks expected to take the
+                               // longest according to the completed tasks
+                               // are run first. Incompatible with
+                               // group_by_image.
   bool discard_distortion_values = false;  // If true, recompute distortions.
+  // If not empty, the outputs and the encoded files of the tasks are recorded
+  // in that folder, and reused by any later run instead of running the same
+  // task again. See EncodeCache.
+  std::string encode_cache_folder_path;
+  // If true, the input images with identical file contents are only encoded
+  // once, and the outputs of their tasks are copied to the duplicates.
+  bool dedup_images = false;
+  // If true, the codec combination tasks reuse the images encoded by the other
+  // tasks with the same settings as their candidates. See CandidateCache.
+  bool reuse_candidates = false;
+  size_t image_cache_max_num_bytes = 0;  // Decoded original images kept in
+                                        // memory across tasks. 0 disables it.
+  // Sum of the estimated peak memory of the tasks running at once. The
+  // workers wait for enough memory before starting a large task. 0 disables
+  // it. See MemoryGovernor.
+  uint64_t max_memory_num_bytes = 0;
+  // If not 0 and distortion_metrics is kSamplePsnr only, the decoded still
+  // images of at least that many pixels are compared to the original row by
+  // row instead of being held whole, for the codecs supporting it. See
+  // CodecSupportsRowDecoding().
+  uint64_t stream_rows_min_num_pixels = 0;
+  // Number of distinct original images read ahead of the next tasks of each
+  // worker, in a separate thread. 0 disables it.
+  size_t prefetch_num_images = 0;
+  // Threads writing the PNG files of the images decoded by the codecs that
+  // browsers do not support, so that the tasks do not wait for them. 0 writes
+  // them synchronously. If fast_artifacts, the animations are compressed
+  // faster by these threads, at the expense of file size.
+  uint32_t num_artifact_threads = 0;
+  bool fast_artifacts = false;
   double abort_above_fail_ratio = 0.1;  // Stop all once that % of tasks failed.
   bool skip_all_remaining = false;  // Just generate already computed results.
+  // If not 0, no task is started once that many seconds have elapsed since
+  // the comparison started, nor any task predicted to end after that by the
+  // durations of the completed tasks. The running tasks are let to end, then
+  // the progress file and the JSON files are written as after a full run.
+  // SIGINT and SIGTERM stop the run the same way.
+  double time_budget = 0;
+  double results_update_period = 0;  // In seconds. If not 0, the outdated JSON
+                                     // files are also written while the tasks
+                                     // run, not only at the end.
+  ResultsFormat results_format;
+  // The tasks can be split into num_shards independent runs, for example on
+  // as many hosts. Each run only performs the tasks of shard_index (see
+  // GetShardIndex()) and appends them to its own completed tasks file instead.
+  uint32_t shard_index = 0;
+  uint32_t num_shards = 1;
+  // If true, no task is run. Instead the completed tasks files of all
+  // num_shards are merged and the JSON files are written from them.
+  bool merge_shards = false;
+  // If not 0, remote workers can connect to that TCP port and run tasks too.
+  // The coordinator still runs them with its own threads, and records all
+  // outputs. Only the initial comparison is served, not the recomputation of
+  // the distortions of completed tasks.
+  uint16_t serve_tasks_port = 0;
+  // Address to listen on for serve_tasks_port. Empty means all interfaces.
+  // There is no authentication, so only expose it to trusted networks.
+  std::string serve_tasks_address;
+  // In seconds. The task of a remote worker that sends nothing for that long is
+  // handed out again, as if its connection was lost. 0 waits forever.
+  double remote_worker_timeout = 3600;
+  // If not empty, "host:port" of a coordinator to run the tasks of (see
+  // serve_tasks_port), instead of planning any. The images and the encoded
+  // folder must be reachable at the same paths as on the coordinator.
+  std::string coordinator_address;
+  // If not empty, the progress of the run is written as JSON to that file
+  // every few seconds, for external monitoring.
+  std::string status_file_path;
   bool quiet = true;  // If true, avoids logging to stdout and stderr.
 };
 
@@ -50,6 +216,15 @@ Status Compare(const std::vector<std::string>& image_paths,
                const std::string& completed_tasks_file_path,
                const std::string& results_folder_path);
 
+// Instead of the whole comparison, only decodes the images previously encoded
+// into settings.encoded_folder_path by Compare(), num_decodings times each. The
+// missing encoded images are skipped. See BenchmarkDecoding(). Writes one JSON
+// file per codec settings in results_folder_path if not empty.
+Status BenchmarkDecoders(const std::vector<std::string>& image_paths,
+                         const ComparisonSettings& settings,
+                         uint32_t num_decodings,
+                         const std::string& results_folder_path);
+
 }  // namespace codec_compare_gen
 
 #endif  // SRC_FRAMEWORK_H_
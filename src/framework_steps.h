@@ -0,0 +1,48 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_FRAMEWORK_STEPS_H_
+#define SRC_FRAMEWORK_STEPS_H_
+
+#include <string>
+#include <vector>
+
+#include "src/base.h"
+#include "src/framework.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Steps of Compare() whose durations scale with the number of tasks rather
+// than with the number of pixels. Exposed to be benchmarked, see
+// tools/framework_bench.cc.
+
+// Returns the tasks stored in the CSV or binary completed_tasks_file_path, or
+// none if the file does not exist.
+StatusOr<std::vector<TaskOutput>> LoadTasks(
+    const ComparisonSettings& settings,
+    const std::string& completed_tasks_file_path);
+
+// Removes from remaining_tasks one planned task per completed task with the
+// same TaskInput, keeping the order. Fails if a completed task was not
+// planned.
+Status RemoveCompletedTasksFromRemainingTasks(
+    const ComparisonSettings& settings,
+    const std::string& completed_tasks_file_path,
+    std::vector<TaskOutput>& completed_tasks,
+    std::vector<TaskInput>& remaining_tasks);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_FRAMEWORK_STEPS_H_
@@ -0,0 +1,138 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "src/base.h"
+#include "src/frame.h"
+
+#if defined(HAS_WEBP2)
+#include "third_party/libwebp2/src/wp2/base.h"
+#endif
+
+namespace codec_compare_gen {
+
+#if defined(HAS_WEBP2)
+
+namespace {
+
+size_t GetNumBytes(const Image& image) {
+  size_t num_bytes = 0;
+  for (const Frame& frame : image) {
+    num_bytes += static_cast<size_t>(frame.pixels.stride()) *
+                 frame.pixels.height();
+  }
+  return num_bytes;
+}
+
+}  // namespace
+
+StatusOr<std::shared_ptr<const Image>> ImageCache::Get(
+    const std::string& image_path, WP2SampleFormat read_format,
+    WP2SampleFormat format, bool quiet, bool spread_to_8bit) {
+  Key key(image_path, read_format, format, spread_to_8bit);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_keys_.splice(lru_keys_.begin(), lru_keys_, it->second.lru_position);
+      ++num_hits_;
+      return std::shared_ptr<const Image>(it->second.image);
+    }
+    ++num_misses_;
+  }
+
+  // Do not hold the lock while decoding so that different images can be read
+  // concurrently. The same image may be read twice by two threads at worst.
+  Image image;
+  std::shared_ptr<const Image> unspread_image;
+  if (spread_to_8bit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it =
+        entries_.find(Key(image_path, read_format, format, /*spread=*/false));
+    if (it != entries_.end()) unspread_image = it->second.image;
+  }
+  if (unspread_image != nullptr) {
+    ASSIGN_OR_RETURN(image, SpreadTo8bit(*unspread_image, quiet));
+  } else {
+    if (format == read_format) {
+      ASSIGN_OR_RETURN(image, ReadStillImageOrAnimation(image_path.c_str(),
+                                                        read_format, quiet));
+    } else {
+      ASSIGN_OR_RETURN(const std::shared_ptr<const Image> read_image,
+                       Get(image_path, read_format, read_format, quiet));
+      ASSIGN_OR_RETURN(image, CloneAs(*read_image, format, quiet));
+    }
+    if (spread_to_8bit) {
+      // Nobody else sees this image so reinterpret its memory instead of
+      // holding a spread copy next to it.
+      ASSIGN_OR_RETURN(image, SpreadTo8bit(std::move(image), quiet));
+    }
+  }
+  const size_t num_bytes = GetNumBytes(image);
+  std::shared_ptr<const Image> shared_image =
+      std::make_shared<const Image>(std::move(image));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto [it, was_inserted] =
+      entries_.emplace(key, Entry{shared_image, num_bytes, {}});
+  if (!was_inserted) {
+    // Another thread inserted the same image in the meantime.
+    return std::shared_ptr<const Image>(it->second.image);
+  }
+  lru_keys_.push_front(std::move(key));
+  it->second.lru_position = lru_keys_.begin();
+  num_bytes_ += num_bytes;
+  // Always keep the most recent entry even if it is bigger than the budget.
+  while (num_bytes_ > max_num_bytes_ && lru_keys_.size() > 1) {
+    const auto evicted = entries_.find(lru_keys_.back());
+    num_bytes_ -= evicted->second.num_bytes;
+    entries_.erase(evicted);
+    lru_keys_.pop_back();
+  }
+  return shared_image;
+}
+
+#endif  // HAS_WEBP2
+
+bool ImageCache::Contains(const std::string& image_path) const {
+#if defined(HAS_WEBP2)
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The keys are sorted by path first.
+  const auto it = entries_.lower_bound(Key(image_path, {}, {}, false));
+  return it != entries_.end() && std::get<0>(it->first) == image_path;
+#else
+  (void)image_path;
+  return false;
+#endif
+}
+
+size_t ImageCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+size_t ImageCache::num_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,83 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_IMAGE_CACHE_H_
+#define SRC_IMAGE_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "src/base.h"
+#include "src/frame.h"
+
+#if defined(HAS_WEBP2)
+#include "third_party/libwebp2/src/wp2/base.h"
+#endif
+
+namespace codec_compare_gen {
+
+// Thread-safe cache of original images, so that each source file is read and
+// converted only once per sample format instead of once per task.
+// The least recently used entries are evicted once the pixels of all entries
+// exceed max_num_bytes. Returned images stay valid even if evicted.
+class ImageCache {
+ public:
+  explicit ImageCache(size_t max_num_bytes) : max_num_bytes_(max_num_bytes) {}
+
+#if defined(HAS_WEBP2)
+  // Returns the same as ReadStillImageOrAnimation(image_path, read_format),
+  // converted by CloneAs() to format if format is not read_format, and by
+  // SpreadTo8bit() if spread_to_8bit. Unless the unspread image is already
+  // cached, it is spread in place and not cached on its own.
+  StatusOr<std::shared_ptr<const Image>> Get(const std::string& image_path,
+                                             WP2SampleFormat read_format,
+                                             WP2SampleFormat format,
+                                             bool quiet,
+                                             bool spread_to_8bit = false);
+#endif
+
+  // Returns true if image_path is cached in any format.
+  bool Contains(const std::string& image_path) const;
+
+  size_t num_hits() const;
+  size_t num_misses() const;
+
+ private:
+  mutable std::mutex mutex_;  // Guards all fields below.
+#if defined(HAS_WEBP2)
+  using Key =
+      std::tuple<std::string, WP2SampleFormat, WP2SampleFormat, bool>;
+  struct Entry {
+    std::shared_ptr<const Image> image;
+    size_t num_bytes;
+    std::list<Key>::iterator lru_position;
+  };
+
+  std::map<Key, Entry> entries_;
+  std::list<Key> lru_keys_;  // Most recently used first.
+#endif
+  const size_t max_num_bytes_;
+  size_t num_bytes_ = 0;
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_IMAGE_CACHE_H_
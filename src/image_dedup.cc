@@ -0,0 +1,153 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_dedup.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/mapped_file.h"
+#include "src/serialization.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// TaskInput::Serialize() ignores the number of codec threads.
+std::string GetKey(const CodecSettings& codec_settings,
+                   const std::string& image_path) {
+  return TaskInput{codec_settings, image_path}.Serialize() + ", t" +
+         std::to_string(codec_settings.num_threads);
+}
+
+}  // namespace
+
+StatusOr<std::unordered_map<std::string, std::string>> FindDuplicateImages(
+    const std::vector<std::string>& image_paths, bool quiet) {
+  std::unordered_map<uintmax_t, std::vector<const std::string*>> paths_by_size;
+  for (const std::string& image_path : image_paths) {
+    std::error_code error_code;
+    const uintmax_t size = std::filesystem::file_size(image_path, error_code);
+    CHECK_OR_RETURN(!error_code, quiet) << "Could not read " << image_path;
+    paths_by_size[size].push_back(&image_path);
+  }
+
+  std::unordered_map<std::string, std::string> originals;
+  for (const auto& [size, paths] : paths_by_size) {
+    if (paths.size() < 2) continue;
+    // Files of the same size and hash, compared byte by byte to be sure.
+    std::unordered_map<uint64_t, std::vector<const std::string*>>
+        paths_by_hash;
+    for (const std::string* path : paths) {
+      MappedFile file;
+      OK_OR_RETURN(file.Open(*path, quiet));
+      paths_by_hash[StableHash(file.contents())].push_back(path);
+    }
+    for (const auto& [hash, same_hash_paths] : paths_by_hash) {
+      std::vector<std::unique_ptr<MappedFile>> distinct_files;
+      std::vector<const std::string*> distinct_paths;
+      for (const std::string* path : same_hash_paths) {
+        if (originals.count(*path) != 0) continue;  // Listed twice.
+        auto file = std::make_unique<MappedFile>();
+        OK_OR_RETURN(file->Open(*path, quiet));
+        bool is_duplicate = false;
+        for (size_t i = 0; i < distinct_paths.size(); ++i) {
+          if (distinct_files[i]->contents() == file->contents()) {
+            if (*distinct_paths[i] != *path) {
+              originals[*path] = *distinct_paths[i];
+            }
+            is_duplicate = true;
+            break;
+          }
+        }
+        if (!is_duplicate) {
+          distinct_files.push_back(std::move(file));
+          distinct_paths.push_back(path);
+        }
+      }
+    }
+  }
+  return originals;
+}
+
+DuplicateTasks::DuplicateTasks(
+    const std::unordered_map<std::string, std::string>& originals,
+    std::vector<TaskInput>& tasks) {
+  if (originals.empty()) return;
+  std::unordered_set<std::string> original_keys;
+  for (const TaskInput& task : tasks) {
+    if (originals.count(task.image_path) == 0) {
+      original_keys.insert(GetKey(task.codec_settings, task.image_path));
+    }
+  }
+  std::vector<TaskInput> kept_tasks;
+  kept_tasks.reserve(tasks.size());
+  for (TaskInput& task : tasks) {
+    const auto original = originals.find(task.image_path);
+    if (original != originals.end()) {
+      std::string key = GetKey(task.codec_settings, original->second);
+      if (original_keys.count(key) != 0) {
+        tasks_[std::move(key)].push_back(std::move(task));
+        ++size_;
+        continue;
+      }
+    }
+    kept_tasks.push_back(std::move(task));
+  }
+  tasks = std::move(kept_tasks);
+}
+
+size_t DuplicateTasks::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+std::vector<TaskInput> DuplicateTasks::Take(const TaskInput& input) {
+  std::vector<TaskInput> taken;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tasks_.empty()) return taken;
+  const auto it = tasks_.find(GetKey(input.codec_settings, input.image_path));
+  if (it == tasks_.end()) return taken;
+  // The first remaining repetition of each duplicate image.
+  std::vector<TaskInput>& tasks = it->second;
+  std::unordered_set<std::string> image_paths;
+  std::vector<TaskInput> kept_tasks;
+  for (TaskInput& task : tasks) {
+    if (image_paths.insert(task.image_path).second) {
+      taken.push_back(std::move(task));
+    } else {
+      kept_tasks.push_back(std::move(task));
+    }
+  }
+  size_ -= taken.size();
+  if (kept_tasks.empty()) {
+    tasks_.erase(it);
+  } else {
+    tasks = std::move(kept_tasks);
+  }
+  return taken;
+}
+
+}  // namespace codec_compare_gen
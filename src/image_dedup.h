@@ -0,0 +1,61 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_IMAGE_DEDUP_H_
+#define SRC_IMAGE_DEDUP_H_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Returns the path of the first identical file in image_paths for each path
+// whose file bytes duplicate an earlier one. Only the files of the same size
+// are read and compared.
+StatusOr<std::unordered_map<std::string, std::string>> FindDuplicateImages(
+    const std::vector<std::string>& image_paths, bool quiet);
+
+// Thread-safe set of the tasks that are not run but copied from the identical
+// task of another image, its original.
+class DuplicateTasks {
+ public:
+  // Moves out of tasks the ones of the images in originals (duplicate path to
+  // original path) whose original has a task with the same codec settings in
+  // tasks too.
+  DuplicateTasks(const std::unordered_map<std::string, std::string>& originals,
+                 std::vector<TaskInput>& tasks);
+
+  // Number of tasks not returned by Take() yet.
+  size_t size() const;
+  // Removes and returns one task per duplicate of the image of input, with the
+  // same codec settings. The output of input is expected to be copied to them.
+  std::vector<TaskInput> Take(const TaskInput& input);
+
+ private:
+  mutable std::mutex mutex_;  // Guards the fields below.
+  // By TaskInput::Serialize() of the task of the original. Each vector lists
+  // the tasks of all duplicates and repetitions, in planning order.
+  std::unordered_map<std::string, std::vector<TaskInput>> tasks_;
+  size_t size_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_IMAGE_DEDUP_H_
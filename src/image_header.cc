@@ -0,0 +1,283 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_header.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace codec_compare_gen {
+
+namespace {
+
+uint32_t ReadBigEndian32(const uint8_t* bytes) {
+  return (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16) |
+         (uint32_t{bytes[2]} << 8) | uint32_t{bytes[3]};
+}
+
+uint32_t ReadLittleEndian(const uint8_t* bytes, size_t num_bytes) {
+  uint32_t value = 0;
+  for (size_t i = num_bytes; i > 0; --i) value = (value << 8) | bytes[i - 1];
+  return value;
+}
+
+bool Read(std::istream& file, uint8_t* bytes, size_t num_bytes) {
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char*>(bytes), num_bytes));
+}
+
+// The PNG stream starts after its signature.
+ImageHeader ProbePng(std::istream& file) {
+  // The IHDR chunk comes first. Its data starts with the width, the height,
+  // the bit depth and the color type.
+  uint8_t ihdr[8 + 13 + 4];
+  if (!Read(file, ihdr, sizeof(ihdr)) || ReadBigEndian32(ihdr) != 13 ||
+      std::memcmp(ihdr + 4, "IHDR", 4) != 0) {
+    return {};
+  }
+  ImageHeader header;
+  header.width = ReadBigEndian32(ihdr + 8);
+  header.height = ReadBigEndian32(ihdr + 12);
+  // Lower depths are expanded to 8 bits by the decoder.
+  header.bit_depth = ihdr[8 + 8] == 16 ? 16 : 8;
+  const uint8_t color_type = ihdr[8 + 9];
+  // Gray, RGB or palette, in which case the alpha channel would need decoding.
+  header.has_alpha = color_type != 0 && color_type != 2 && color_type != 3;
+
+  // The tRNS chunk and the acTL chunk of an animation come before the first
+  // IDAT chunk.
+  while (true) {
+    uint8_t chunk[8];
+    if (!Read(file, chunk, sizeof(chunk))) return {};
+    const uint32_t length = ReadBigEndian32(chunk);
+    const char* type = reinterpret_cast<const char*>(chunk + 4);
+    if (std::memcmp(type, "IDAT", 4) == 0) {
+      header.num_frames = 1;
+      return header;
+    }
+    if (std::memcmp(type, "acTL", 4) == 0) {
+      uint8_t num_frames[4];
+      if (length < 8 || !Read(file, num_frames, sizeof(num_frames))) return {};
+      header.num_frames = ReadBigEndian32(num_frames);
+      header.has_alpha = true;  // Frames can be disposed to transparent.
+      return header;
+    }
+    if (std::memcmp(type, "tRNS", 4) == 0) {
+      // A transparent color for gray and RGB, or an alpha per palette entry.
+      if (color_type == 3 && length <= 256) {
+        uint8_t alphas[256];
+        if (!Read(file, alphas, length)) return {};
+        header.has_alpha |=
+            !std::all_of(alphas, alphas + length,
+                         [](uint8_t alpha) { return alpha == 0xFF; });
+        if (!file.seekg(4, std::ios::cur)) return {};  // CRC.
+        continue;
+      }
+      header.has_alpha = true;
+    }
+    if (!file.seekg(length + 4, std::ios::cur)) return {};  // Data and CRC.
+  }
+}
+
+// The JPEG stream starts after its start-of-image marker.
+ImageHeader ProbeJpeg(std::istream& file) {
+  // The frame header comes before the first scan.
+  while (true) {
+    uint8_t marker[2 + 2];  // Marker and length of the segment.
+    if (!Read(file, marker, sizeof(marker)) || marker[0] != 0xFF) return {};
+    const uint32_t length = (uint32_t{marker[2]} << 8) | marker[3];
+    if (length < 2) return {};
+    // Start-of-frame markers, except DHT, JPG and DAC.
+    if (marker[1] >= 0xC0 && marker[1] <= 0xCF && marker[1] != 0xC4 &&
+        marker[1] != 0xC8 && marker[1] != 0xCC) {
+      uint8_t frame[5];  // Sample precision, height and width.
+      if (length < 2 + sizeof(frame) || !Read(file, frame, sizeof(frame))) {
+        return {};
+      }
+      ImageHeader header;
+      header.width = (uint32_t{frame[3]} << 8) | frame[4];
+      header.height = (uint32_t{frame[1]} << 8) | frame[2];
+      header.bit_depth = 8;
+      header.num_frames = 1;
+      header.has_alpha = false;
+      return header;
+    }
+    if (marker[1] == 0xDA) return {};  // Start of scan.
+    if (!file.seekg(length - 2, std::ios::cur)) return {};
+  }
+}
+
+// Skips the data sub-blocks of a GIF extension or image.
+bool SkipGifSubBlocks(std::istream& file) {
+  while (true) {
+    uint8_t size;
+    if (!Read(file, &size, 1)) return false;
+    if (size == 0) return true;
+    if (!file.seekg(size, std::ios::cur)) return false;
+  }
+}
+
+// The GIF stream starts after its 6-byte signature.
+ImageHeader ProbeGif(std::istream& file) {
+  uint8_t screen[7];  // Logical screen descriptor.
+  if (!Read(file, screen, sizeof(screen))) return {};
+  ImageHeader header;
+  header.width = ReadLittleEndian(screen, 2);
+  header.height = ReadLittleEndian(screen + 2, 2);
+  header.bit_depth = 8;
+  if (screen[4] & 0x80) {  // Global color table.
+    if (!file.seekg(3 << ((screen[4] & 7) + 1), std::ios::cur)) return {};
+  }
+
+  // Each image descriptor is a frame.
+  uint32_t num_frames = 0;
+  while (true) {
+    uint8_t introducer;
+    if (!Read(file, &introducer, 1)) break;  // Missing trailer is tolerated.
+    if (introducer == 0x3B) break;           // Trailer.
+    if (introducer == 0x21) {                // Extension.
+      if (!file.seekg(1, std::ios::cur) || !SkipGifSubBlocks(file)) return {};
+    } else if (introducer == 0x2C) {  // Image descriptor.
+      uint8_t descriptor[9];
+      if (!Read(file, descriptor, sizeof(descriptor))) return {};
+      if (descriptor[8] & 0x80) {  // Local color table.
+        if (!file.seekg(3 << ((descriptor[8] & 7) + 1), std::ios::cur)) {
+          return {};
+        }
+      }
+      // LZW minimum code size, then the image data.
+      if (!file.seekg(1, std::ios::cur) || !SkipGifSubBlocks(file)) return {};
+      ++num_frames;
+    } else {
+      return {};
+    }
+  }
+  header.num_frames = num_frames;
+  return header;
+}
+
+// The WebP stream starts after its 12-byte RIFF header.
+ImageHeader ProbeWebp(std::istream& file) {
+  uint8_t chunk[8 + 10];  // Type, size and the first bytes of the data.
+  if (!Read(file, chunk, sizeof(chunk))) return {};
+  const uint8_t* data = chunk + 8;
+  ImageHeader header;
+  header.bit_depth = 8;
+  header.num_frames = 1;
+  if (std::memcmp(chunk, "VP8 ", 4) == 0) {
+    // Frame tag, then start code.
+    if (data[3] != 0x9D || data[4] != 0x01 || data[5] != 0x2A) return {};
+    header.width = ReadLittleEndian(data + 6, 2) & 0x3FFF;
+    header.height = ReadLittleEndian(data + 8, 2) & 0x3FFF;
+  } else if (std::memcmp(chunk, "VP8L", 4) == 0) {
+    if (data[0] != 0x2F) return {};
+    const uint32_t bits = ReadLittleEndian(data + 1, 4);
+    header.width = (bits & 0x3FFF) + 1;
+    header.height = ((bits >> 14) & 0x3FFF) + 1;
+  } else if (std::memcmp(chunk, "VP8X", 4) == 0) {
+    header.width = ReadLittleEndian(data + 4, 3) + 1;
+    header.height = ReadLittleEndian(data + 7, 3) + 1;
+    const bool is_animated = (data[0] & 0x02) != 0;
+    if (is_animated) {
+      // Count the ANMF chunks following the VP8X one.
+      uint32_t size = ReadLittleEndian(chunk + 4, 4);
+      if (!file.seekg(size + (size & 1) - 10, std::ios::cur)) return {};
+      header.num_frames = 0;
+      uint8_t next_chunk[8];
+      while (Read(file, next_chunk, sizeof(next_chunk))) {
+        if (std::memcmp(next_chunk, "ANMF", 4) == 0) ++header.num_frames;
+        size = ReadLittleEndian(next_chunk + 4, 4);
+        if (!file.seekg(size + (size & 1), std::ios::cur)) return {};
+      }
+    }
+  } else {
+    return {};
+  }
+  return header;
+}
+
+}  // namespace
+
+ImageHeader ProbeImageHeader(const std::string& file_path) {
+  std::ifstream file(file_path, std::ios::binary);
+  uint8_t signature[12];
+  if (!Read(file, signature, 6)) return {};
+  static constexpr uint8_t kPngSignature[8] = {0x89, 'P',  'N',  'G',
+                                               '\r', '\n', 0x1A, '\n'};
+  ImageHeader header;
+  if (std::equal(signature, signature + 6, kPngSignature)) {
+    if (!Read(file, signature + 6, 2) ||
+        !std::equal(signature, signature + 8, kPngSignature)) {
+      return {};
+    }
+    header = ProbePng(file);
+  } else if (signature[0] == 0xFF && signature[1] == 0xD8 &&
+             signature[2] == 0xFF) {
+    if (!file.seekg(2)) return {};  // Right after the start-of-image marker.
+    header = ProbeJpeg(file);
+  } else if (std::memcmp(signature, "GIF87a", 6) == 0 ||
+             std::memcmp(signature, "GIF89a", 6) == 0) {
+    header = ProbeGif(file);
+  } else if (std::memcmp(signature, "RIFF", 4) == 0) {
+    if (!Read(file, signature + 6, 6) ||
+        std::memcmp(signature + 8, "WEBP", 4) != 0) {
+      return {};
+    }
+    header = ProbeWebp(file);
+  }
+  return header.IsKnown() ? header : ImageHeader();
+}
+
+std::unordered_map<std::string, ImageHeader> ProbeImageHeaders(
+    const std::vector<std::string>& image_paths, size_t num_threads) {
+  std::vector<const std::string*> distinct_paths;
+  std::unordered_set<std::string> seen_paths;
+  for (const std::string& image_path : image_paths) {
+    if (seen_paths.insert(image_path).second) {
+      distinct_paths.push_back(&image_path);
+    }
+  }
+
+  std::vector<ImageHeader> headers(distinct_paths.size());
+  std::atomic<size_t> next_index(0);
+  const auto probe = [&]() {
+    for (size_t i = next_index++; i < distinct_paths.size(); i = next_index++) {
+      headers[i] = ProbeImageHeader(*distinct_paths[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(num_threads, distinct_paths.size()); ++i) {
+    threads.emplace_back(probe);
+  }
+  probe();
+  for (std::thread& thread : threads) thread.join();
+
+  std::unordered_map<std::string, ImageHeader> headers_by_path;
+  for (size_t i = 0; i < distinct_paths.size(); ++i) {
+    headers_by_path[*distinct_paths[i]] = headers[i];
+  }
+  return headers_by_path;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,57 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_IMAGE_HEADER_H_
+#define SRC_IMAGE_HEADER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace codec_compare_gen {
+
+// Properties of an image read from the header of its file, without decoding
+// any pixel. Zero means unknown.
+struct ImageHeader {
+  uint32_t width = 0;      // in pixels
+  uint32_t height = 0;     // in pixels
+  uint32_t bit_depth = 0;  // per sample, once decoded
+  uint32_t num_frames = 0;
+  // False only if there is no alpha channel, no transparent color and no
+  // animation whose frames could be disposed to transparent pixels.
+  bool has_alpha = true;
+
+  bool IsKnown() const {
+    return width > 0 && height > 0 && bit_depth > 0 && num_frames > 0;
+  }
+  // The alpha channel may still be fully opaque but it is unknown without
+  // decoding the pixels.
+  bool IsKnownOpaque() const { return IsKnown() && !has_alpha; }
+};
+
+// Reads the header of a PNG, APNG, JPEG, GIF or WebP file. Returns an unknown
+// header for any other format or if the file cannot be parsed. Only the GIF
+// and animated WebP files are read beyond their first bytes, to count their
+// frames, skipping the pixel data.
+ImageHeader ProbeImageHeader(const std::string& file_path);
+
+// Probes the distinct image_paths with up to num_threads threads.
+std::unordered_map<std::string, ImageHeader> ProbeImageHeaders(
+    const std::vector<std::string>& image_paths, size_t num_threads);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_IMAGE_HEADER_H_
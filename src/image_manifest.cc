@@ -0,0 +1,430 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_manifest.h"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/image_header.h"
+#include "src/serialization.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// First line of the manifest file. The other lines are made of tab-separated
+// fields, the path coming last:
+//   folder <modification time> <path>
+//   file <num bytes> <modification time> <width> <height> <bit depth>
+//        <num frames> <has alpha> <path>
+//   subfolder <path>
+// The file and subfolder lines list the contents of the previous folder line.
+constexpr std::string_view kManifestSignature = "ccgen_image_manifest 2";
+
+struct ManifestFile {
+  std::string path;
+  uint64_t num_bytes = 0;
+  int64_t modification_time = 0;  // std::filesystem::file_time_type ticks
+  ImageHeader header;
+  bool is_probed = false;  // The header can be unknown even if probed.
+};
+
+struct ManifestFolder {
+  int64_t modification_time = 0;
+  std::vector<std::string> subfolder_paths;
+  std::vector<ManifestFile> files;  // Only the images.
+};
+
+// By folder path.
+using Manifest = std::unordered_map<std::string, ManifestFolder>;
+
+int64_t ToTicks(std::filesystem::file_time_type time) {
+  return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+template <typename T>
+bool ParseInteger(std::string_view str, T& value) {
+  const char* end = str.data() + str.size();
+  const auto result = std::from_chars(str.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end && !str.empty();
+}
+
+// Splits line into num_fields tab-separated fields. The last one takes the
+// rest of the line, tabs included.
+bool SplitFields(std::string_view line, size_t num_fields,
+                 std::vector<std::string_view>& fields) {
+  fields.clear();
+  while (fields.size() + 1 < num_fields) {
+    const size_t tab = line.find('\t');
+    if (tab == std::string_view::npos) return false;
+    fields.push_back(line.substr(0, tab));
+    line.remove_prefix(tab + 1);
+  }
+  fields.push_back(line);
+  return true;
+}
+
+// Returns an empty manifest if the file does not exist or cannot be parsed.
+Manifest LoadManifest(const std::string& manifest_path, bool quiet) {
+  std::ifstream file(manifest_path);
+  if (!file) return {};
+  std::string line;
+  if (!std::getline(file, line) || line != kManifestSignature) {
+    if (!quiet) {
+      std::cerr << "Warning: Ignoring " << manifest_path
+                << ", which is not an image manifest" << std::endl;
+    }
+    return {};
+  }
+
+  Manifest manifest;
+  ManifestFolder* folder = nullptr;
+  std::vector<std::string_view> fields;
+  size_t line_number = 1;
+  while (std::getline(file, line)) {
+    ++line_number;
+    bool is_valid = false;
+    if (StartsWith(line, "folder\t")) {
+      int64_t modification_time;
+      is_valid = SplitFields(line, 3, fields) &&
+                 ParseInteger(fields[1], modification_time);
+      if (is_valid) {
+        folder = &manifest[std::string(fields[2])];
+        *folder = ManifestFolder();
+        folder->modification_time = modification_time;
+      }
+    } else if (StartsWith(line, "subfolder\t") && folder != nullptr) {
+      is_valid = SplitFields(line, 2, fields);
+      if (is_valid) folder->subfolder_paths.emplace_back(fields[1]);
+    } else if (StartsWith(line, "file\t") && folder != nullptr) {
+      ManifestFile manifest_file;
+      is_valid = SplitFields(line, 9, fields) &&
+                 ParseInteger(fields[1], manifest_file.num_bytes) &&
+                 ParseInteger(fields[2], manifest_file.modification_time) &&
+                 ParseInteger(fields[3], manifest_file.header.width) &&
+                 ParseInteger(fields[4], manifest_file.header.height) &&
+                 ParseInteger(fields[5], manifest_file.header.bit_depth) &&
+                 ParseInteger(fields[6], manifest_file.header.num_frames) &&
+                 (fields[7] == "0" || fields[7] == "1");
+      if (is_valid) {
+        manifest_file.header.has_alpha = fields[7] == "1";
+        manifest_file.path = fields[8];
+        manifest_file.is_probed = true;
+        folder->files.push_back(std::move(manifest_file));
+      }
+    }
+    if (!is_valid) {
+      if (!quiet) {
+        std::cerr << "Warning: Ignoring " << manifest_path
+                  << ", which is malformed at line " << line_number
+                  << std::endl;
+      }
+      return {};
+    }
+  }
+  return manifest;
+}
+
+Status SaveManifest(const Manifest& manifest, const std::string& manifest_path,
+                    bool quiet) {
+  std::vector<const std::pair<const std::string, ManifestFolder>*> folders;
+  folders.reserve(manifest.size());
+  for (const auto& folder : manifest) folders.push_back(&folder);
+  std::sort(folders.begin(), folders.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+
+  // Written next to it and renamed, so that an interrupted run leaves the
+  // previous manifest intact.
+  const std::string temp_path = manifest_path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::trunc);
+    CHECK_OR_RETURN(file.is_open(), quiet) << "Could not open " << temp_path;
+    file << kManifestSignature << "\n";
+    for (const auto* folder : folders) {
+      file << "folder\t" << folder->second.modification_time << "\t"
+           << folder->first << "\n";
+      for (const std::string& subfolder_path :
+           folder->second.subfolder_paths) {
+        file << "subfolder\t" << subfolder_path << "\n";
+      }
+      for (const ManifestFile& manifest_file : folder->second.files) {
+        file << "file\t" << manifest_file.num_bytes << "\t"
+             << manifest_file.modification_time << "\t"
+             << manifest_file.header.width << "\t"
+             << manifest_file.header.height << "\t"
+             << manifest_file.header.bit_depth << "\t"
+             << manifest_file.header.num_frames << "\t"
+             << manifest_file.header.has_alpha << "\t" << manifest_file.path
+             << "\n";
+      }
+    }
+    CHECK_OR_RETURN(file.good(), quiet) << "Could not write " << temp_path;
+  }
+  std::error_code error;
+  std::filesystem::rename(temp_path, manifest_path, error);
+  CHECK_OR_RETURN(!error, quiet)
+      << "Could not rename " << temp_path << " to " << manifest_path << ": "
+      << error.message();
+  return Status::kOk;
+}
+
+// Lists the subfolders and the images of the folder, or takes them from the
+// previous manifest if the folder did not change. Only uses previous if
+// track_changes.
+StatusOr<ManifestFolder> ListFolder(const std::string& folder_path,
+                                    const Manifest& previous,
+                                    bool track_changes, bool quiet) {
+  std::error_code error;
+  ManifestFolder folder;
+  const ManifestFolder* previous_folder = nullptr;
+  if (track_changes) {
+    const std::filesystem::file_time_type modification_time =
+        std::filesystem::last_write_time(folder_path, error);
+    CHECK_OR_RETURN(!error, quiet)
+        << "Could not read " << folder_path << ": " << error.message();
+    folder.modification_time = ToTicks(modification_time);
+    const auto it = previous.find(folder_path);
+    if (it != previous.end()) {
+      if (it->second.modification_time == folder.modification_time) {
+        // Files can still be rewritten in place without touching the folder.
+        ManifestFolder unchanged_folder = it->second;
+        bool is_listing_valid = true;
+        for (ManifestFile& file : unchanged_folder.files) {
+          std::error_code size_error, time_error;
+          const uint64_t num_bytes =
+              std::filesystem::file_size(file.path, size_error);
+          const int64_t modification_time = ToTicks(
+              std::filesystem::last_write_time(file.path, time_error));
+          if (size_error || time_error) {
+            is_listing_valid = false;  // List the folder again.
+            break;
+          }
+          if (num_bytes != file.num_bytes ||
+              modification_time != file.modification_time) {
+            file.num_bytes = num_bytes;
+            file.modification_time = modification_time;
+            file.header = ImageHeader();
+            file.is_probed = false;
+          }
+        }
+        if (is_listing_valid) return unchanged_folder;
+      }
+      previous_folder = &it->second;
+    }
+  }
+
+  for (std::filesystem::directory_iterator it(folder_path, error), end;
+       !error && it != end; it.increment(error)) {
+    const std::filesystem::directory_entry& entry = *it;
+    std::error_code entry_error;
+    if (entry.is_directory(entry_error)) {
+      folder.subfolder_paths.push_back(entry.path().string());
+      continue;
+    }
+    ManifestFile file;
+    file.path = entry.path().string();
+    if (!HasImageExtension(file.path)) continue;
+    if (track_changes) {
+      file.num_bytes = entry.file_size(entry_error);
+      file.modification_time = ToTicks(entry.last_write_time(entry_error));
+      CHECK_OR_RETURN(!entry_error, quiet)
+          << "Could not read " << file.path << ": " << entry_error.message();
+    }
+    folder.files.push_back(std::move(file));
+  }
+  CHECK_OR_RETURN(!error, quiet)
+      << "Could not list " << folder_path << ": " << error.message();
+
+  if (previous_folder != nullptr) {
+    // Keep the headers of the unchanged files.
+    std::unordered_map<std::string_view, const ManifestFile*> previous_files;
+    for (const ManifestFile& file : previous_folder->files) {
+      previous_files[file.path] = &file;
+    }
+    for (ManifestFile& file : folder.files) {
+      const auto it = previous_files.find(file.path);
+      if (it != previous_files.end() &&
+          it->second->num_bytes == file.num_bytes &&
+          it->second->modification_time == file.modification_time) {
+        file.header = it->second->header;
+        file.is_probed = it->second->is_probed;
+      }
+    }
+  }
+  return folder;
+}
+
+// Lists the folder_paths and all their subfolders with up to num_threads
+// threads.
+StatusOr<Manifest> ListFolders(const std::vector<std::string>& folder_paths,
+                               const Manifest& previous, bool track_changes,
+                               size_t num_threads, bool quiet) {
+  std::mutex mutex;  // Guards the variables below.
+  std::condition_variable condition;
+  std::vector<std::string> pending_paths;
+  std::unordered_set<std::string> seen_paths;
+  size_t num_busy_threads = 0;
+  Manifest listed;
+  Status status = Status::kOk;
+  for (const std::string& folder_path : folder_paths) {
+    if (seen_paths.insert(folder_path).second) {
+      pending_paths.push_back(folder_path);
+    }
+  }
+
+  const auto list = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      condition.wait(lock, [&]() {
+        return !pending_paths.empty() || num_busy_threads == 0;
+      });
+      // Nothing left to list and no thread listing anything that could add
+      // more.
+      if (pending_paths.empty()) return;
+      std::string folder_path = std::move(pending_paths.back());
+      pending_paths.pop_back();
+      ++num_busy_threads;
+      lock.unlock();
+      StatusOr<ManifestFolder> folder =
+          ListFolder(folder_path, previous, track_changes, quiet);
+      lock.lock();
+      --num_busy_threads;
+      if (folder.status != Status::kOk) {
+        if (status == Status::kOk) status = folder.status;
+        pending_paths.clear();  // Stop early.
+      } else if (status == Status::kOk) {
+        for (const std::string& subfolder_path :
+             folder.value.subfolder_paths) {
+          if (seen_paths.insert(subfolder_path).second) {
+            pending_paths.push_back(subfolder_path);
+          }
+        }
+        listed[folder_path] = std::move(folder.value);
+      }
+      condition.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) threads.emplace_back(list);
+  list();
+  for (std::thread& thread : threads) thread.join();
+  OK_OR_RETURN(status);
+  return listed;
+}
+
+// Appends the files of the folder and of all its subfolders to files.
+void CollectFiles(const Manifest& listed, const std::string& folder_path,
+                  std::vector<const ManifestFile*>& files) {
+  const auto it = listed.find(folder_path);
+  if (it == listed.end()) return;  // Reached through another path.
+  for (const ManifestFile& file : it->second.files) files.push_back(&file);
+  for (const std::string& subfolder_path : it->second.subfolder_paths) {
+    CollectFiles(listed, subfolder_path, files);
+  }
+}
+
+}  // namespace
+
+bool HasImageExtension(const std::string& file_path) {
+  const std::filesystem::path path(file_path);
+  if (!path.has_extension()) return false;
+  const std::string extension = path.extension().string();
+  for (const char* image_extension :
+       {".png", ".PNG", ".jpg", ".JPG", ".jpeg", ".JPEG", ".gif", ".GIF",
+        ".webp", ".WEBP"}) {
+    if (extension == image_extension) return true;
+  }
+  return false;
+}
+
+StatusOr<std::vector<FoundImage>> FindImageFiles(
+    const std::vector<std::string>& file_or_folder_paths,
+    const std::string& manifest_path, size_t num_threads, bool quiet) {
+  const bool track_changes = !manifest_path.empty();
+  Manifest manifest;
+  if (track_changes) manifest = LoadManifest(manifest_path, quiet);
+
+  std::vector<std::string> folder_paths;
+  for (const std::string& path : file_or_folder_paths) {
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error)) {
+      folder_paths.push_back(path);
+    }
+  }
+  ASSIGN_OR_RETURN(
+      Manifest listed,
+      ListFolders(folder_paths, manifest, track_changes, num_threads, quiet));
+
+  if (track_changes) {
+    std::vector<std::string> unprobed_paths;
+    for (const auto& [folder_path, folder] : listed) {
+      for (const ManifestFile& file : folder.files) {
+        if (!file.is_probed) unprobed_paths.push_back(file.path);
+      }
+    }
+    const std::unordered_map<std::string, ImageHeader> headers =
+        ProbeImageHeaders(unprobed_paths, num_threads);
+    for (auto& [folder_path, folder] : listed) {
+      for (ManifestFile& file : folder.files) {
+        if (file.is_probed) continue;
+        file.header = headers.at(file.path);
+        file.is_probed = true;
+      }
+    }
+    // The folders not listed this time are kept for later runs.
+    for (auto& [folder_path, folder] : listed) manifest[folder_path] = folder;
+    OK_OR_RETURN(SaveManifest(manifest, manifest_path, quiet));
+  }
+
+  std::vector<FoundImage> images;
+  for (const std::string& path : file_or_folder_paths) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error)) {
+      if (HasImageExtension(path)) {
+        images.push_back(
+            {path, track_changes ? ProbeImageHeader(path) : ImageHeader()});
+      }
+      continue;
+    }
+    std::vector<const ManifestFile*> files;
+    CollectFiles(listed, path, files);
+    std::sort(files.begin(), files.end(),
+              [](const ManifestFile* a, const ManifestFile* b) {
+                return a->path < b->path;
+              });
+    for (const ManifestFile* file : files) {
+      images.push_back({file->path, file->header});
+    }
+  }
+  return images;
+}
+
+}  // namespace codec_compare_gen
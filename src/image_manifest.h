@@ -0,0 +1,53 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_IMAGE_MANIFEST_H_
+#define SRC_IMAGE_MANIFEST_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "src/base.h"
+#include "src/image_header.h"
+
+namespace codec_compare_gen {
+
+// Image file found by FindImageFiles().
+struct FoundImage {
+  std::string path;
+  ImageHeader header;  // Unknown if not probed.
+};
+
+// Returns true if the extension of the file path is the one of an image format
+// that can be read (PNG, JPEG, GIF or WebP).
+bool HasImageExtension(const std::string& file_path);
+
+// Lists the image files among file_or_folder_paths and, recursively, in their
+// folders, in the order of file_or_folder_paths and sorted within each folder
+// tree. The folders are listed by up to num_threads threads at once.
+// If manifest_path is not empty, the folders whose modification time did not
+// change since the manifest file was written are not listed again: their
+// contents are taken from the manifest. The files whose size and modification
+// time did not change keep their recorded header, including the files
+// rewritten in place without touching their folder. The remaining ones are
+// probed, as well as the files given directly. The manifest file is then
+// rewritten. Without manifest_path, no header is probed.
+StatusOr<std::vector<FoundImage>> FindImageFiles(
+    const std::vector<std::string>& file_or_folder_paths,
+    const std::string& manifest_path, size_t num_threads, bool quiet);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_IMAGE_MANIFEST_H_
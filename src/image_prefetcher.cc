@@ -0,0 +1,174 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_prefetcher.h"
+
+#ifdef HAVE_UNISTD_H
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Number of read files remembered, for all the tasks of each image to wait for
+// them.
+constexpr size_t kMaxNumReadFiles = 256;
+
+// Reads the whole file and discards its contents, to fill the page cache.
+void ReadFile(const std::string& file_path) {
+  std::vector<char> buffer(size_t{1} << 20);
+#ifdef HAVE_UNISTD_H
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+#if defined(POSIX_FADV_WILLNEED)
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    while (read(fd, buffer.data(), buffer.size()) > 0) {
+    }
+    close(fd);
+    return;
+  }
+#endif
+  // Errors are reported by the task decoding the file.
+  std::ifstream file(file_path, std::ios::binary);
+  while (file.read(buffer.data(), buffer.size())) {
+  }
+}
+
+}  // namespace
+
+ImagePrefetcher::ImagePrefetcher() : thread_([this]() { Run(); }) {}
+
+ImagePrefetcher::~ImagePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_one();
+  thread_.join();
+}
+
+void ImagePrefetcher::Prefetch(const std::vector<std::string>& image_paths) {
+  bool is_queued = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::string& image_path : image_paths) {
+      if (files_.emplace(image_path, State::kQueued).second) {
+        queue_.push_back(image_path);
+        is_queued = true;
+      }
+    }
+  }
+  if (is_queued) queued_.notify_one();
+}
+
+void ImagePrefetcher::Wait(const std::string& image_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = files_.find(image_path);
+  if (it != files_.end() && it->second == State::kRead) {
+    // Kept for the next tasks of the same image.
+    ++num_hits_;
+    return;
+  }
+  ++num_misses_;
+  const auto start = std::chrono::steady_clock::now();
+  if (it != files_.end() && it->second == State::kReading) {
+    read_.wait(lock, [&]() {
+      const auto file = files_.find(image_path);
+      return file == files_.end() || file->second != State::kReading;
+    });
+  } else {
+    if (it != files_.end()) {
+      // Not started yet. Read it right away instead.
+      for (auto queued = queue_.begin(); queued != queue_.end(); ++queued) {
+        if (*queued == image_path) {
+          queue_.erase(queued);
+          break;
+        }
+      }
+    }
+    files_[image_path] = State::kReading;
+    lock.unlock();
+    ReadFile(image_path);
+    lock.lock();
+    SetRead(image_path);
+    read_.notify_all();
+  }
+  stall_seconds_ += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+}
+
+void ImagePrefetcher::SetRead(const std::string& image_path) {
+  const auto it = files_.find(image_path);
+  if (it == files_.end() || it->second != State::kReading) return;
+  it->second = State::kRead;
+  read_files_.push_back(image_path);
+  if (read_files_.size() > kMaxNumReadFiles) {
+    const auto oldest = files_.find(read_files_.front());
+    if (oldest != files_.end() && oldest->second == State::kRead) {
+      files_.erase(oldest);
+    }
+    read_files_.pop_front();
+  }
+}
+
+void ImagePrefetcher::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+    if (stop_) return;
+    const std::string image_path = std::move(queue_.front());
+    queue_.pop_front();
+    files_[image_path] = State::kReading;
+    lock.unlock();
+    ReadFile(image_path);
+    lock.lock();
+    ++num_prefetched_;
+    SetRead(image_path);
+    read_.notify_all();
+  }
+}
+
+size_t ImagePrefetcher::num_prefetched() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_prefetched_;
+}
+
+size_t ImagePrefetcher::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+size_t ImagePrefetcher::num_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+double ImagePrefetcher::stall_seconds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stall_seconds_;
+}
+
+}  // namespace codec_compare_gen
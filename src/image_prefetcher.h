@@ -0,0 +1,78 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_IMAGE_PREFETCHER_H_
+#define SRC_IMAGE_PREFETCHER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace codec_compare_gen {
+
+// Reads the original image files ahead of the tasks in a separate thread, so
+// that they are in the page cache of the operating system by the time a task
+// decodes them, instead of blocking it on disk or network latency.
+// Thread-safe.
+class ImagePrefetcher {
+ public:
+  ImagePrefetcher();
+  ImagePrefetcher(const ImagePrefetcher&) = delete;
+  ImagePrefetcher& operator=(const ImagePrefetcher&) = delete;
+  ~ImagePrefetcher();
+
+  // Queues the files to read, unless they are already read or queued.
+  void Prefetch(const std::vector<std::string>& image_paths);
+  // Returns once image_path was read, by the prefetching thread or by the
+  // calling thread if it was not prefetched yet. To call before decoding it.
+  // The most recently read files are remembered, so the next tasks of the same
+  // image do not wait for it again.
+  void Wait(const std::string& image_path);
+
+  size_t num_prefetched() const;  // Files read by the prefetching thread.
+  size_t num_hits() const;        // Waits that did not block.
+  size_t num_misses() const;
+  double stall_seconds() const;   // Total duration of the blocking waits.
+
+ private:
+  enum class State { kQueued, kReading, kRead };
+
+  void Run();
+  // Moves image_path from kReading to kRead, forgetting the oldest read file
+  // if there are too many. mutex_ must be locked.
+  void SetRead(const std::string& image_path);
+
+  mutable std::mutex mutex_;  // Guards all fields below.
+  std::condition_variable queued_;
+  std::condition_variable read_;
+  std::unordered_map<std::string, State> files_;
+  std::deque<std::string> queue_;  // Files in the kQueued state.
+  // Files in the kRead state, oldest first, forgotten once too many.
+  std::deque<std::string> read_files_;
+  bool stop_ = false;
+  size_t num_prefetched_ = 0;
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
+  double stall_seconds_ = 0;
+  std::thread thread_;  // Last so that the fields above exist when it starts.
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_IMAGE_PREFETCHER_H_
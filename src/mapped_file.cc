@@ -0,0 +1,74 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/mapped_file.h"
+
+#ifdef HAVE_UNISTD_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+MappedFile::~MappedFile() {
+#ifdef HAVE_UNISTD_H
+  if (is_mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+Status MappedFile::Open(const std::string& file_path, bool quiet) {
+  CHECK_OR_RETURN(data_ == nullptr && size_ == 0, quiet);
+#ifdef HAVE_UNISTD_H
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  CHECK_OR_RETURN(fd >= 0, quiet)
+      << "Could not open " << file_path << " for reading";
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size),
+                      PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      // The mapping stays valid after closing the file descriptor.
+      close(fd);
+      data_ = static_cast<const char*>(data);
+      size_ = static_cast<size_t>(file_stat.st_size);
+      is_mapped_ = true;
+      // Each part of the file is only read once, in order.
+      (void)madvise(data, size_, MADV_SEQUENTIAL);
+      return Status::kOk;
+    }
+  }
+  close(fd);
+#endif
+
+  std::ifstream file(file_path, std::ios::binary);
+  CHECK_OR_RETURN(file.is_open(), quiet)
+      << "Could not open " << file_path << " for reading";
+  read_contents_.assign(std::istreambuf_iterator<char>(file),
+                        std::istreambuf_iterator<char>());
+  CHECK_OR_RETURN(!file.bad(), quiet) << "Could not read " << file_path;
+  data_ = read_contents_.data();
+  size_ = read_contents_.size();
+  return Status::kOk;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,47 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MAPPED_FILE_H_
+#define SRC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Read-only view of the whole content of a file. The file is memory-mapped
+// where supported, and read into memory otherwise.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  ~MappedFile();
+
+  Status Open(const std::string& file_path, bool quiet);
+  // Valid until destruction.
+  std::string_view contents() const { return {data_, size_}; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool is_mapped_ = false;
+  std::string read_contents_;  // Used if the file could not be mapped.
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_MAPPED_FILE_H_
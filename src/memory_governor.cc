@@ -0,0 +1,141 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_governor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include "src/base.h"
+#include "src/image_header.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+uint64_t GetDecodedNumBytes(uint32_t width, uint32_t height,
+                            uint32_t bit_depth, uint32_t num_frames) {
+  const uint64_t num_bytes_per_pixel = bit_depth > 8 ? 8 : 4;
+  return uint64_t{width} * height * std::max(num_frames, 1u) *
+         num_bytes_per_pixel;
+}
+
+uint64_t EstimateTaskPeakMemory(Codec codec, uint64_t decoded_num_bytes) {
+  // The original, converted, decoded and decoded converted images.
+  constexpr uint64_t kNumImageCopies = 4;
+  // Rough multiples of the decoded size used internally by each codec.
+  uint64_t num_codec_copies = 1;
+  switch (codec) {
+    case Codec::kAvif:
+    case Codec::kAvifSsim:
+    case Codec::kAvifIq:
+    case Codec::kAvifExp:
+    case Codec::kAvifAvm:
+    case Codec::kAvifLibheif:
+      num_codec_copies = 4;  // YUV planes, reference frames and lookahead.
+      break;
+    case Codec::kCombination:
+      num_codec_copies = 6;  // Concurrent candidates of several codecs.
+      break;
+    case Codec::kJpegXl:
+      num_codec_copies = 3;
+      break;
+    case Codec::kWebp2:
+    case Codec::kBasis:
+    case Codec::kJp2:
+      num_codec_copies = 2;
+      break;
+    default:
+      break;
+  }
+  return decoded_num_bytes * (kNumImageCopies + num_codec_copies);
+}
+
+TaskMemoryModel::TaskMemoryModel(
+    const std::vector<TaskOutput>& completed_tasks) {
+  for (const TaskOutput& task : completed_tasks) Learn(task);
+}
+
+uint64_t TaskMemoryModel::Estimate(const TaskInput& task) {
+  uint64_t decoded_num_bytes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto image = image_num_bytes_.find(task.image_path);
+    const ImageHeader& header = task.image_header;
+    if (image != image_num_bytes_.end()) {
+      decoded_num_bytes = image->second;
+    } else if (header.IsKnown()) {
+      decoded_num_bytes = GetDecodedNumBytes(header.width, header.height,
+                                             header.bit_depth,
+                                             header.num_frames);
+    } else {
+      std::error_code error;
+      const uintmax_t file_size =
+          std::filesystem::file_size(task.image_path, error);
+      decoded_num_bytes =
+          error ? 0 : uint64_t{file_size} * kDecodedNumBytesPerFileByte;
+      image_num_bytes_[task.image_path] = decoded_num_bytes;
+    }
+  }
+  return EstimateTaskPeakMemory(task.codec_settings.codec, decoded_num_bytes);
+}
+
+void TaskMemoryModel::Learn(const TaskOutput& task) {
+  const uint64_t decoded_num_bytes =
+      GetDecodedNumBytes(task.image_width, task.image_height, task.bit_depth,
+                         task.num_frames);
+  if (decoded_num_bytes == 0) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  image_num_bytes_[task.task_input.image_path] = decoded_num_bytes;
+}
+
+void MemoryGovernor::Admit(uint64_t num_bytes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto fits = [&]() {
+    return num_admitted_tasks_ == 0 ||
+           num_admitted_bytes_ + num_bytes <= max_num_bytes_;
+  };
+  if (!fits()) {
+    ++num_waits_;
+    released_.wait(lock, fits);
+  }
+  num_admitted_bytes_ += num_bytes;
+  ++num_admitted_tasks_;
+}
+
+void MemoryGovernor::Release(uint64_t num_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_admitted_bytes_ -= num_bytes;
+    --num_admitted_tasks_;
+  }
+  // Each waiting caller checks whether its own task fits.
+  released_.notify_all();
+}
+
+uint64_t MemoryGovernor::num_admitted_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_admitted_bytes_;
+}
+
+size_t MemoryGovernor::num_waits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_waits_;
+}
+
+}  // namespace codec_compare_gen
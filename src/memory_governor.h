@@ -0,0 +1,132 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MEMORY_GOVERNOR_H_
+#define SRC_MEMORY_GOVERNOR_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Returns the number of bytes of the decoded pixels of an image, in the
+// interleaved RGBA layout of WP2::ArgbBuffer or of the converted frames.
+uint64_t GetDecodedNumBytes(uint32_t width, uint32_t height,
+                            uint32_t bit_depth, uint32_t num_frames);
+
+// Returns the estimated peak number of bytes used by one task encoding and
+// decoding an image of decoded_num_bytes with the codec: the original, the
+// converted and the decoded images, and the internal state of the codec.
+uint64_t EstimateTaskPeakMemory(Codec codec, uint64_t decoded_num_bytes);
+
+// Thread-safe estimation of the peak memory used by tasks, from the image
+// dimensions recorded by completed tasks or learned from the ones ending
+// during this run.
+class TaskMemoryModel {
+ public:
+  explicit TaskMemoryModel(const std::vector<TaskOutput>& completed_tasks);
+
+  // Returns the estimated peak number of bytes of the task. The decoded size
+  // of an image that was never seen is computed from the image_header of the
+  // task, or guessed from its file size if unknown.
+  uint64_t Estimate(const TaskInput& task);
+  // Records the dimensions of the image of the task.
+  void Learn(const TaskOutput& task);
+
+ private:
+  // A decoded size too small for an image that was never seen would let too
+  // many tasks run at once, so compressed files are assumed very compressed.
+  static constexpr uint64_t kDecodedNumBytesPerFileByte = 16;
+
+  std::mutex mutex_;
+  // Decoded number of bytes by image path, learned or guessed.
+  std::unordered_map<std::string, uint64_t> image_num_bytes_;
+};
+
+// Limits the sum of the estimated peak memory of the tasks running at once.
+class MemoryGovernor {
+ public:
+  explicit MemoryGovernor(uint64_t max_num_bytes)
+      : max_num_bytes_(max_num_bytes) {}
+
+  // Blocks until num_bytes fit in the budget with the ones already admitted.
+  // A task larger than the whole budget is admitted once nothing else is, so
+  // that it runs alone instead of never.
+  void Admit(uint64_t num_bytes);
+  // Returns to the budget num_bytes given to Admit(). The callers waiting for
+  // a large task do not prevent the others from admitting smaller ones.
+  void Release(uint64_t num_bytes);
+
+  uint64_t num_admitted_bytes() const;
+  // Number of calls to Admit() that had to wait.
+  size_t num_waits() const;
+
+ private:
+  const uint64_t max_num_bytes_;
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  uint64_t num_admitted_bytes_ = 0;
+  size_t num_admitted_tasks_ = 0;
+  size_t num_waits_ = 0;
+};
+
+// Admits num_bytes for its lifetime. Does nothing if governor is null.
+// Movable so that the admission can follow the images of a task to the thread
+// releasing them.
+class MemoryAdmission {
+ public:
+  MemoryAdmission() = default;
+  MemoryAdmission(MemoryGovernor* governor, uint64_t num_bytes)
+      : governor_(governor), num_bytes_(num_bytes) {
+    if (governor_ != nullptr) governor_->Admit(num_bytes_);
+  }
+  MemoryAdmission(const MemoryAdmission&) = delete;
+  MemoryAdmission& operator=(const MemoryAdmission&) = delete;
+  MemoryAdmission(MemoryAdmission&& other)
+      : governor_(std::exchange(other.governor_, nullptr)),
+        num_bytes_(std::exchange(other.num_bytes_, 0)) {}
+  MemoryAdmission& operator=(MemoryAdmission&& other) {
+    if (this != &other) {
+      Reset();
+      governor_ = std::exchange(other.governor_, nullptr);
+      num_bytes_ = std::exchange(other.num_bytes_, 0);
+    }
+    return *this;
+  }
+  ~MemoryAdmission() { Reset(); }
+
+  // Returns num_bytes to the governor now instead of at destruction.
+  void Reset() {
+    if (governor_ != nullptr) governor_->Release(num_bytes_);
+    governor_ = nullptr;
+    num_bytes_ = 0;
+  }
+
+ private:
+  MemoryGovernor* governor_ = nullptr;
+  uint64_t num_bytes_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_MEMORY_GOVERNOR_H_
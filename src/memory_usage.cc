@@ -0,0 +1,92 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_usage.h"
+
+#ifdef HAVE_UNISTD_H
+#include <sys/resource.h>
+#endif
+
+#include <cstddef>
+#if defined(__linux__)
+#include <fstream>
+#include <string>
+#endif
+
+namespace codec_compare_gen {
+
+size_t GetPeakResidentSetSize() {
+#ifdef HAVE_UNISTD_H
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return static_cast<size_t>(usage.ru_maxrss);  // Already in bytes.
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;  // In kilobytes.
+#endif
+#else
+  return 0;
+#endif
+}
+
+namespace {
+
+#if defined(__linux__)
+// Returns the given field of /proc/self/status converted from kilobytes to
+// bytes, or 0.
+size_t GetProcStatusSize(const std::string& field) {
+  std::ifstream file("/proc/self/status");
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, field.size(), field) != 0) continue;
+    try {
+      return std::stoull(line.substr(field.size())) * 1024;
+    } catch (...) {
+      return 0;
+    }
+  }
+  return 0;
+}
+#endif
+
+}  // namespace
+
+bool ResetPeakResidentSetSize() {
+#if defined(__linux__)
+  std::ofstream file("/proc/self/clear_refs");
+  file << "5";  // Resets the peak resident set size.
+  file.close();
+  return !file.fail();
+#else
+  return false;
+#endif
+}
+
+size_t GetResidentSetSize() {
+#if defined(__linux__)
+  return GetProcStatusSize("VmRSS:");
+#else
+  return 0;
+#endif
+}
+
+size_t GetPeakResidentSetSizeSinceReset() {
+#if defined(__linux__)
+  return GetProcStatusSize("VmHWM:");
+#else
+  return 0;
+#endif
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,39 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_MEMORY_USAGE_H_
+#define SRC_MEMORY_USAGE_H_
+
+#include <cstddef>
+
+namespace codec_compare_gen {
+
+// Returns the maximum resident set size of the current process so far, in
+// bytes, or 0 if unavailable on this platform.
+size_t GetPeakResidentSetSize();
+
+// Lowers the peak resident set size of the current process to its current
+// resident set size. Returns false if unavailable on this platform (Linux
+// only). GetPeakResidentSetSize() is lowered too.
+bool ResetPeakResidentSetSize();
+
+// Returns the resident set size of the current process and its maximum since
+// the last ResetPeakResidentSetSize() call, in bytes, or 0 if unavailable on
+// this platform (Linux only).
+size_t GetResidentSetSize();
+size_t GetPeakResidentSetSizeSinceReset();
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_MEMORY_USAGE_H_
@@ -0,0 +1,113 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/output_file.h"
+
+#include <zlib.h>
+
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Compresses the bytes written to it in batches.
+class OutputFile::GzipBuffer : public std::streambuf {
+ public:
+  explicit GzipBuffer(gzFile file) : file_(file) {
+    setp(buffer_, buffer_ + kBufferSize);
+  }
+  GzipBuffer(const GzipBuffer&) = delete;
+  ~GzipBuffer() override { Close(); }
+
+  // Returns false if anything failed since construction.
+  bool Close() {
+    if (file_ != nullptr) {
+      is_ok_ &= Compress();
+      is_ok_ &= gzclose(file_) == Z_OK;
+      file_ = nullptr;
+    }
+    return is_ok_;
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!Compress()) return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+  // Called by std::flush(). gzwrite() still buffers, so this is cheap.
+  int sync() override { return Compress() ? 0 : -1; }
+
+ private:
+  bool Compress() {
+    const int num_bytes = static_cast<int>(pptr() - pbase());
+    if (num_bytes > 0 && gzwrite(file_, pbase(), num_bytes) != num_bytes) {
+      is_ok_ = false;
+    }
+    setp(buffer_, buffer_ + kBufferSize);
+    return is_ok_;
+  }
+
+  static constexpr int kBufferSize = 1 << 16;
+  gzFile file_;
+  char buffer_[kBufferSize];
+  bool is_ok_ = true;
+};
+
+OutputFile::OutputFile() : stream_(nullptr) {}
+
+OutputFile::~OutputFile() { (void)Close(/*quiet=*/true); }
+
+Status OutputFile::Open(const std::string& file_path, bool gzip, bool quiet) {
+  CHECK_OR_RETURN(!file_.is_open() && gzip_buffer_ == nullptr, quiet);
+  file_path_ = file_path;
+  if (gzip) {
+    const gzFile file = gzopen(file_path.c_str(), "wb");
+    CHECK_OR_RETURN(file != nullptr, quiet)
+        << "Failed to open " << file_path << " for writing";
+    gzip_buffer_ = std::make_unique<GzipBuffer>(file);
+    stream_.rdbuf(gzip_buffer_.get());
+  } else {
+    file_.open(file_path, std::ios::trunc);
+    CHECK_OR_RETURN(file_.is_open(), quiet)
+        << "Failed to open " << file_path << " for writing";
+    stream_.rdbuf(file_.rdbuf());
+  }
+  stream_.clear();
+  return Status::kOk;
+}
+
+Status OutputFile::Close(bool quiet) {
+  if (!file_.is_open() && gzip_buffer_ == nullptr) return Status::kOk;
+  bool is_ok = !stream_.fail();
+  stream_.rdbuf(nullptr);
+  if (gzip_buffer_ != nullptr) {
+    is_ok &= gzip_buffer_->Close();
+    gzip_buffer_.reset();
+  } else {
+    file_.close();
+    is_ok &= !file_.fail();
+  }
+  CHECK_OR_RETURN(is_ok, quiet) << "Failed to write " << file_path_;
+  return Status::kOk;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,53 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_OUTPUT_FILE_H_
+#define SRC_OUTPUT_FILE_H_
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// File written through a std::ostream, optionally compressed with gzip on the
+// fly so that the uncompressed contents are never held whole.
+class OutputFile {
+ public:
+  OutputFile();
+  OutputFile(const OutputFile&) = delete;
+  ~OutputFile();  // Closes the file if still open, ignoring any error.
+
+  // Opens file_path for writing and truncates it.
+  Status Open(const std::string& file_path, bool gzip, bool quiet);
+  std::ostream& stream() { return stream_; }
+  // Writes what remains and closes the file. Returns an error if anything
+  // could not be written since Open().
+  Status Close(bool quiet);
+
+ private:
+  class GzipBuffer;
+
+  std::string file_path_;
+  std::ofstream file_;
+  std::unique_ptr<GzipBuffer> gzip_buffer_;  // Null if not compressed.
+  std::ostream stream_;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_OUTPUT_FILE_H_
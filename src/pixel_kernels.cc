@@ -0,0 +1,236 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/pixel_kernels.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define CCGEN_PIXEL_KERNELS_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CCGEN_PIXEL_KERNELS_NEON
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace codec_compare_gen {
+
+namespace {
+
+// The 32-bit lane sums of squared 8-bit differences are flushed to 64 bits
+// at least every that many bytes, way before they could overflow.
+constexpr size_t kMaxNumBytesBetweenFlushes = size_t{1} << 16;
+
+#if defined(CCGEN_PIXEL_KERNELS_X86)
+
+// SSE2 is part of x86-64.
+bool BytesEqualSse2(const uint8_t* a, const uint8_t* b, size_t num_bytes) {
+  size_t i = 0;
+  for (; i + 64 <= num_bytes; i += 64) {
+    __m128i diff = _mm_setzero_si128();
+    for (size_t j = 0; j < 64; j += 16) {
+      const __m128i va =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + j));
+      const __m128i vb =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + j));
+      diff = _mm_or_si128(diff, _mm_xor_si128(va, vb));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) !=
+        0xFFFF) {
+      return false;
+    }
+  }
+  return BytesEqualScalar(a + i, b + i, num_bytes - i);
+}
+
+uint64_t SumOfSquaredDifferencesSse2(const uint8_t* a, const uint8_t* b,
+                                     size_t num_samples) {
+  uint64_t sum = 0;
+  size_t i = 0;
+  while (i + 16 <= num_samples) {
+    const size_t end =
+        i + std::min(num_samples - i, kMaxNumBytesBetweenFlushes) / 16 * 16;
+    __m128i lane_sums = _mm_setzero_si128();
+    for (; i < end; i += 16) {
+      const __m128i va =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      const __m128i vb =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero),
+                                        _mm_unpacklo_epi8(vb, zero));
+      const __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero),
+                                         _mm_unpackhi_epi8(vb, zero));
+      lane_sums = _mm_add_epi32(lane_sums, _mm_madd_epi16(low, low));
+      lane_sums = _mm_add_epi32(lane_sums, _mm_madd_epi16(high, high));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), lane_sums);
+    sum += uint64_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+  }
+  return sum + SumOfSquaredDifferencesScalar(a + i, b + i, num_samples - i);
+}
+
+__attribute__((target("avx2"))) bool BytesEqualAvx2(const uint8_t* a,
+                                                    const uint8_t* b,
+                                                    size_t num_bytes) {
+  size_t i = 0;
+  for (; i + 128 <= num_bytes; i += 128) {
+    __m256i diff = _mm256_setzero_si256();
+    for (size_t j = 0; j < 128; j += 32) {
+      const __m256i va =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j));
+      const __m256i vb =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + j));
+      diff = _mm256_or_si256(diff, _mm256_xor_si256(va, vb));
+    }
+    if (!_mm256_testz_si256(diff, diff)) return false;
+  }
+  return BytesEqualSse2(a + i, b + i, num_bytes - i);
+}
+
+__attribute__((target("avx2"))) uint64_t SumOfSquaredDifferencesAvx2(
+    const uint8_t* a, const uint8_t* b, size_t num_samples) {
+  uint64_t sum = 0;
+  size_t i = 0;
+  while (i + 32 <= num_samples) {
+    const size_t end =
+        i + std::min(num_samples - i, kMaxNumBytesBetweenFlushes) / 32 * 32;
+    __m256i lane_sums = _mm256_setzero_si256();
+    for (; i < end; i += 32) {
+      for (size_t j = 0; j < 32; j += 16) {
+        const __m256i va = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + j)));
+        const __m256i vb = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + j)));
+        const __m256i diff = _mm256_sub_epi16(va, vb);
+        lane_sums = _mm256_add_epi32(lane_sums, _mm256_madd_epi16(diff, diff));
+      }
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), lane_sums);
+    for (uint32_t lane : lanes) sum += lane;
+  }
+  return sum + SumOfSquaredDifferencesSse2(a + i, b + i, num_samples - i);
+}
+
+#elif defined(CCGEN_PIXEL_KERNELS_NEON)
+
+// NEON is part of AArch64.
+bool BytesEqualNeon(const uint8_t* a, const uint8_t* b, size_t num_bytes) {
+  size_t i = 0;
+  for (; i + 64 <= num_bytes; i += 64) {
+    uint8x16_t diff = vdupq_n_u8(0);
+    for (size_t j = 0; j < 64; j += 16) {
+      diff = vorrq_u8(diff, veorq_u8(vld1q_u8(a + i + j), vld1q_u8(b + i + j)));
+    }
+    if (vmaxvq_u8(diff) != 0) return false;
+  }
+  return BytesEqualScalar(a + i, b + i, num_bytes - i);
+}
+
+uint64_t SumOfSquaredDifferencesNeon(const uint8_t* a, const uint8_t* b,
+                                     size_t num_samples) {
+  uint64_t sum = 0;
+  size_t i = 0;
+  while (i + 16 <= num_samples) {
+    const size_t end =
+        i + std::min(num_samples - i, kMaxNumBytesBetweenFlushes) / 16 * 16;
+    uint32x4_t lane_sums = vdupq_n_u32(0);
+    for (; i < end; i += 16) {
+      const uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+      // The squares of 8-bit differences fit in 16 bits.
+      lane_sums = vpadalq_u16(
+          lane_sums, vmull_u8(vget_low_u8(diff), vget_low_u8(diff)));
+      lane_sums = vpadalq_u16(lane_sums, vmull_high_u8(diff, diff));
+    }
+    sum += vaddlvq_u32(lane_sums);
+  }
+  return sum + SumOfSquaredDifferencesScalar(a + i, b + i, num_samples - i);
+}
+
+#endif
+
+struct PixelKernels {
+  bool (*bytes_equal)(const uint8_t*, const uint8_t*, size_t);
+  uint64_t (*sum_of_squared_differences)(const uint8_t*, const uint8_t*,
+                                         size_t);
+  const char* instruction_set;
+};
+
+PixelKernels SelectPixelKernels() {
+#if defined(CCGEN_PIXEL_KERNELS_X86)
+  if (__builtin_cpu_supports("avx2")) {
+    return {&BytesEqualAvx2, &SumOfSquaredDifferencesAvx2, "AVX2"};
+  }
+  return {&BytesEqualSse2, &SumOfSquaredDifferencesSse2, "SSE2"};
+#elif defined(CCGEN_PIXEL_KERNELS_NEON)
+  return {&BytesEqualNeon, &SumOfSquaredDifferencesNeon, "NEON"};
+#else
+  return {&BytesEqualScalar, &SumOfSquaredDifferencesScalar, "scalar"};
+#endif
+}
+
+const PixelKernels& GetPixelKernels() {
+  static const PixelKernels kPixelKernels = SelectPixelKernels();
+  return kPixelKernels;
+}
+
+}  // namespace
+
+bool BytesEqualScalar(const uint8_t* a, const uint8_t* b, size_t num_bytes) {
+  for (size_t i = 0; i < num_bytes; ++i) {
+    if (a[i] != b[i]) return false;
+  }
+  return true;
+}
+
+uint64_t SumOfSquaredDifferencesScalar(const uint8_t* a, const uint8_t* b,
+                                       size_t num_samples) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < num_samples; ++i) {
+    const int32_t diff = int32_t{a[i]} - int32_t{b[i]};
+    sum += static_cast<uint64_t>(diff * diff);
+  }
+  return sum;
+}
+
+bool BytesEqual(const uint8_t* a, const uint8_t* b, size_t num_bytes) {
+  return GetPixelKernels().bytes_equal(a, b, num_bytes);
+}
+
+uint64_t SumOfSquaredDifferences(const uint8_t* a, const uint8_t* b,
+                                 size_t num_samples) {
+  return GetPixelKernels().sum_of_squared_differences(a, b, num_samples);
+}
+
+uint64_t SumOfSquaredDifferences(const uint16_t* a, const uint16_t* b,
+                                 size_t num_samples) {
+  // Squared 16-bit differences need 64-bit lanes, which leaves little to win
+  // by hand over the auto-vectorized loop.
+  uint64_t sum = 0;
+  for (size_t i = 0; i < num_samples; ++i) {
+    const int64_t diff = int64_t{a[i]} - int64_t{b[i]};
+    sum += static_cast<uint64_t>(diff * diff);
+  }
+  return sum;
+}
+
+const char* PixelKernelsInstructionSet() {
+  return GetPixelKernels().instruction_set;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,47 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_PIXEL_KERNELS_H_
+#define SRC_PIXEL_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace codec_compare_gen {
+
+// Comparisons of raw samples, dispatched at runtime to the widest instruction
+// set supported by the CPU: AVX2 or SSE2 on x86-64, NEON on AArch64, plain C++
+// otherwise.
+
+// Returns true if the num_bytes first bytes of a and b are the same.
+bool BytesEqual(const uint8_t* a, const uint8_t* b, size_t num_bytes);
+
+// Returns the sum of the squared differences of the num_samples first samples
+// of a and b.
+uint64_t SumOfSquaredDifferences(const uint8_t* a, const uint8_t* b,
+                                 size_t num_samples);
+uint64_t SumOfSquaredDifferences(const uint16_t* a, const uint16_t* b,
+                                 size_t num_samples);
+
+// Returns the name of the instruction set used by the functions above.
+const char* PixelKernelsInstructionSet();
+
+// Plain C++ implementations of the functions above, for tests and benchmarks.
+bool BytesEqualScalar(const uint8_t* a, const uint8_t* b, size_t num_bytes);
+uint64_t SumOfSquaredDifferencesScalar(const uint8_t* a, const uint8_t* b,
+                                       size_t num_samples);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_PIXEL_KERNELS_H_
@@ -0,0 +1,173 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/progress_tracker.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/serialization.h"
+#include "src/task.h"
+#include "src/task_cost.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Weight of the last completed task in the moving average of the durations.
+// Low enough to smooth the variations between images, high enough to follow
+// the warm-up of the caches and the changes of machine load.
+constexpr double kMovingAverageWeight = 0.05;
+
+std::pair<Codec, int> GetKey(const TaskInput& task) {
+  return {task.codec_settings.codec, task.codec_settings.effort};
+}
+
+}  // namespace
+
+ProgressTracker::ProgressTracker(const std::vector<TaskInput>& remaining_tasks,
+                                 const TaskCostModel* history)
+    : history_(history != nullptr && !history->IsEmpty() ? history : nullptr) {
+  for (const TaskInput& task : remaining_tasks) {
+    ++stats_[GetKey(task)].num_remaining_tasks;
+  }
+}
+
+void ProgressTracker::OnCompleted(const TaskOutput& task) {
+  Stats& stats = stats_[GetKey(task.task_input)];
+  if (stats.num_remaining_tasks > 0) --stats.num_remaining_tasks;
+  ++stats.num_completed_tasks;
+  stats.num_pixels += static_cast<double>(task.image_width) *
+                      task.image_height * std::max(task.num_frames, 1u);
+  const double seconds = std::max(task.encoding_duration, 0.) +
+                         std::max(task.decoding_duration, 0.);
+  stats.mean_seconds =
+      stats.mean_seconds < 0
+          ? seconds
+          : stats.mean_seconds +
+                kMovingAverageWeight * (seconds - stats.mean_seconds);
+}
+
+void ProgressTracker::OnFailed(const TaskInput& task) {
+  Stats& stats = stats_[GetKey(task)];
+  if (stats.num_remaining_tasks > 0) --stats.num_remaining_tasks;
+}
+
+double ProgressTracker::EstimateSeconds(const std::pair<Codec, int>& key,
+                                        const Stats& stats) const {
+  if (stats.mean_seconds >= 0) return stats.mean_seconds;
+  if (history_ != nullptr) {
+    // Average image of the history, since the actual ones are unknown.
+    return history_->Estimate({{key.first, Subsampling::kDefault, key.second,
+                                /*quality=*/0},
+                               /*image_path=*/""});
+  }
+  return -1;
+}
+
+double ProgressTracker::EstimateSecondsLeft(double elapsed_seconds,
+                                            size_t num_remaining_tasks) const {
+  double completed_seconds = 0, remaining_seconds = 0, known_seconds = 0;
+  size_t num_known_remaining_tasks = 0, num_known_tasks = 0;
+  for (const auto& [key, stats] : stats_) {
+    if (stats.mean_seconds >= 0) {
+      completed_seconds += stats.num_completed_tasks * stats.mean_seconds;
+    }
+    const double seconds = EstimateSeconds(key, stats);
+    if (seconds < 0) continue;
+    remaining_seconds += stats.num_remaining_tasks * seconds;
+    num_known_remaining_tasks += stats.num_remaining_tasks;
+    known_seconds += seconds;
+    ++num_known_tasks;
+  }
+  if (completed_seconds <= 0 || num_known_tasks == 0) return -1;
+  // The tasks of unknown cost are assumed to cost the average of the others.
+  if (num_remaining_tasks > num_known_remaining_tasks) {
+    remaining_seconds += (num_remaining_tasks - num_known_remaining_tasks) *
+                         known_seconds / num_known_tasks;
+  }
+  // The ratio between the elapsed time and the encoding and decoding
+  // durations accounts for the parallelism and for what is not timed.
+  return elapsed_seconds / completed_seconds * remaining_seconds;
+}
+
+std::map<Codec, ProgressTracker::CodecThroughput>
+ProgressTracker::GetThroughputs() const {
+  std::map<Codec, CodecThroughput> throughputs;
+  for (const auto& [key, stats] : stats_) {
+    CodecThroughput& throughput = throughputs[key.first];
+    throughput.num_remaining_tasks += stats.num_remaining_tasks;
+    throughput.num_completed_tasks += stats.num_completed_tasks;
+    throughput.num_pixels += stats.num_pixels;
+  }
+  return throughputs;
+}
+
+std::string ProgressTracker::ThroughputToString(double elapsed_seconds) const {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(1);
+  for (const auto& [codec, throughput] : GetThroughputs()) {
+    if (throughput.num_completed_tasks == 0 || elapsed_seconds <= 0) continue;
+    if (stream.tellp() > 0) stream << ", ";
+    stream << CodecName(codec) << ": "
+           << throughput.num_completed_tasks / elapsed_seconds << " tasks/s, "
+           << throughput.num_pixels / elapsed_seconds / 1e6 << " MP/s";
+  }
+  return stream.str();
+}
+
+std::string ProgressTracker::ToJson(double elapsed_seconds, size_t num_tasks,
+                                    size_t num_completed_tasks,
+                                    size_t num_failed_tasks,
+                                    size_t num_remaining_tasks,
+                                    bool is_done) const {
+  const double seconds_per_elapsed =
+      elapsed_seconds > 0 ? 1 / elapsed_seconds : 0;
+  std::ostringstream stream;
+  stream << "{\n  \"elapsed_seconds\": " << elapsed_seconds
+         << ",\n  \"estimated_seconds_left\": "
+         << (is_done ? 0
+                     : EstimateSecondsLeft(elapsed_seconds,
+                                           num_remaining_tasks))
+         << ",\n  \"num_tasks\": " << num_tasks
+         << ",\n  \"num_completed_tasks\": " << num_completed_tasks
+         << ",\n  \"num_failed_tasks\": " << num_failed_tasks
+         << ",\n  \"num_remaining_tasks\": " << num_remaining_tasks
+         << ",\n  \"done\": " << (is_done ? "true" : "false")
+         << ",\n  \"codecs\": [";
+  bool is_first = true;
+  for (const auto& [codec, throughput] : GetThroughputs()) {
+    stream << (is_first ? "\n" : ",\n") << "    {\"codec\": "
+           << Escape(CodecName(codec))
+           << ", \"num_completed_tasks\": " << throughput.num_completed_tasks
+           << ", \"num_remaining_tasks\": " << throughput.num_remaining_tasks
+           << ", \"tasks_per_second\": "
+           << throughput.num_completed_tasks * seconds_per_elapsed
+           << ", \"megapixels_per_second\": "
+           << throughput.num_pixels / 1e6 * seconds_per_elapsed << "}";
+    is_first = false;
+  }
+  stream << (is_first ? "]\n}\n" : "\n  ]\n}\n");
+  return stream.str();
+}
+
+}  // namespace codec_compare_gen
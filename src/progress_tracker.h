@@ -0,0 +1,84 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_PROGRESS_TRACKER_H_
+#define SRC_PROGRESS_TRACKER_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+#include "src/task_cost.h"
+
+namespace codec_compare_gen {
+
+// Estimates the time left and the throughput of a run from the tasks completed
+// so far. The cost of a task is a moving average of the encoding and decoding
+// durations of the completed tasks of the same codec and effort, so that the
+// estimate holds on sweeps mixing fast and slow configurations. Not
+// thread-safe.
+class ProgressTracker {
+ public:
+  // The history is used for the codecs and efforts that did not complete any
+  // task yet in this run. Can be null.
+  ProgressTracker(const std::vector<TaskInput>& remaining_tasks,
+                  const TaskCostModel* history);
+
+  void OnCompleted(const TaskOutput& task);
+  void OnFailed(const TaskInput& task);
+
+  // Returns the estimated number of seconds left to run num_remaining_tasks,
+  // including the tasks that were not known at construction (at the average
+  // cost), or -1 if unknown yet.
+  double EstimateSecondsLeft(double elapsed_seconds,
+                             size_t num_remaining_tasks) const;
+  // Returns the tasks/s and MP/s of each codec, such as
+  // "webp: 12.5 tasks/s, 40.3 MP/s".
+  std::string ThroughputToString(double elapsed_seconds) const;
+  // Returns a JSON object describing the whole progress. The counts are the
+  // ones of the caller for consistency with its display.
+  std::string ToJson(double elapsed_seconds, size_t num_tasks,
+                     size_t num_completed_tasks, size_t num_failed_tasks,
+                     size_t num_remaining_tasks, bool is_done) const;
+
+ private:
+  struct Stats {
+    size_t num_remaining_tasks = 0;
+    size_t num_completed_tasks = 0;
+    double num_pixels = 0;  // Of the completed tasks.
+    double mean_seconds = -1;  // Moving average. Negative means unknown.
+  };
+  struct CodecThroughput {
+    size_t num_remaining_tasks = 0;
+    size_t num_completed_tasks = 0;
+    double num_pixels = 0;
+  };
+
+  // Returns the expected encoding and decoding seconds of a task with the
+  // given stats and key, or -1 if unknown.
+  double EstimateSeconds(const std::pair<Codec, int>& key,
+                         const Stats& stats) const;
+  std::map<Codec, CodecThroughput> GetThroughputs() const;
+
+  const TaskCostModel* const history_;
+  std::map<std::pair<Codec, int>, Stats> stats_;  // Keyed by codec and effort.
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_PROGRESS_TRACKER_H_
@@ -0,0 +1,359 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/quality_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/framework.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Returns the same string for all the qualities of a codec settings and image
+// pair.
+std::string GetSearchKey(const TaskInput& input) {
+  TaskInput key = {input.codec_settings, input.image_path, ""};
+  key.codec_settings.quality = 0;
+  return key.Serialize();
+}
+
+// Returns the distance between the middle point and the linear interpolation
+// of its neighbors.
+double InterpolationError(const RateDistortionPoint& first,
+                          const RateDistortionPoint& middle,
+                          const RateDistortionPoint& last) {
+  const double range = last.bits_per_pixel - first.bits_per_pixel;
+  const double t =
+      range != 0 ? (middle.bits_per_pixel - first.bits_per_pixel) / range : 0.5;
+  const double interpolated =
+      first.distortion + t * (last.distortion - first.distortion);
+  return std::abs(middle.distortion - interpolated);
+}
+
+}  // namespace
+
+bool IsHigherBetter(DistortionMetric metric) {
+  return metric == DistortionMetric::kLibwebp2Psnr ||
+         metric == DistortionMetric::kLibwebp2Ssim ||
+         metric == DistortionMetric::kLibjxlSsimulacra2 ||
+         metric == DistortionMetric::kSamplePsnr;
+}
+
+RateDistortionPoint GetRateDistortionPoint(
+    const QualitySearchSettings& settings, const TaskOutput& task) {
+  const double num_pixels = static_cast<double>(task.image_width) *
+                            task.image_height * task.num_frames;
+  return {num_pixels > 0 ? task.encoded_size * 8 / num_pixels : 0,
+          task.distortions[static_cast<size_t>(settings.metric)]};
+}
+
+bool ReachesTarget(const QualitySearchSettings& settings,
+                   const RateDistortionPoint& point) {
+  if (settings.target == QualitySearchTarget::kBitsPerPixel) {
+    return point.bits_per_pixel > settings.value;
+  }
+  if (std::isnan(point.distortion)) return false;  // kDistortionNotComputed
+  if (point.distortion >= kNoDistortion) return true;  // Pixel equality.
+  return IsHigherBetter(settings.metric) ? point.distortion >= settings.value
+                                         : point.distortion <= settings.value;
+}
+
+std::vector<size_t> NextCurveSamples(
+    const std::vector<std::optional<RateDistortionPoint>>& points,
+    size_t num_initial_samples, double max_error) {
+  std::vector<size_t> samples;
+  if (points.empty()) return samples;
+  // Evenly spread, including both ends.
+  const size_t num_initial = std::min(
+      points.size(), std::max(num_initial_samples, static_cast<size_t>(2)));
+  std::vector<size_t> initial;
+  for (size_t i = 0; i < num_initial; ++i) {
+    initial.push_back(num_initial == 1
+                          ? 0
+                          : i * (points.size() - 1) / (num_initial - 1));
+    if (!points[initial.back()].has_value()) samples.push_back(initial.back());
+  }
+  if (!samples.empty()) return samples;
+
+  std::vector<std::pair<size_t, size_t>> intervals;  // Inclusive.
+  for (size_t i = 0; i + 1 < initial.size(); ++i) {
+    intervals.emplace_back(initial[i], initial[i + 1]);
+  }
+  while (!intervals.empty()) {
+    const auto [first, last] = intervals.back();
+    intervals.pop_back();
+    if (last - first < 2) continue;
+    const size_t middle = (first + last) / 2;
+    if (!points[middle].has_value()) {
+      samples.push_back(middle);
+    } else if (InterpolationError(*points[first], *points[middle],
+                                  *points[last]) > max_error) {
+      intervals.emplace_back(first, middle);
+      intervals.emplace_back(middle, last);
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples;
+}
+
+bool IsSaturated(const std::vector<const TaskOutput*>& outputs,
+                 size_t index) {
+  const TaskOutput* output = outputs[index];
+  if (output == nullptr) return false;
+  const auto is_lossless = [](float d) { return d >= kNoDistortion; };
+  if (std::all_of(output->distortions,
+                  output->distortions + kNumDistortionMetrics, is_lossless)) {
+    return true;  // Pixel equality.
+  }
+  // A single repeated size is common with codecs mapping several qualities to
+  // the same quantizer.
+  constexpr size_t kNumUnchangedSizes = 3;
+  if (index + 1 < kNumUnchangedSizes) return false;
+  for (size_t i = index + 1 - kNumUnchangedSizes; i < index; ++i) {
+    if (outputs[i] == nullptr ||
+        outputs[i]->encoded_size != output->encoded_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+QualitySearch::QualitySearch(std::vector<int> qualities)
+    : qualities_(std::move(qualities)), last_(qualities_.size()) {}
+
+void QualitySearch::Record(bool reaches_target) {
+  const size_t middle = (first_ + last_) / 2;
+  if (reaches_target) {
+    last_ = middle;
+  } else {
+    first_ = middle + 1;
+  }
+}
+
+size_t QualitySearch::MaxNumProbes() const {
+  size_t num_probes = 0;
+  for (size_t size = last_ - first_; size > 0; size /= 2) ++num_probes;
+  return num_probes;
+}
+
+//------------------------------------------------------------------------------
+
+QualitySearches::QualitySearches(const QualitySearchSettings& settings,
+                                 const std::vector<TaskInput>& remaining_tasks,
+                                 const std::vector<TaskOutput>& completed_tasks)
+    : settings_(settings) {
+  struct Grid {
+    std::map<int, std::vector<TaskInput>> remaining_tasks;
+    std::map<int, RateDistortionPoint> points;
+    std::map<int, const TaskOutput*> outputs;
+    std::map<int, size_t> num_tasks;
+  };
+  std::vector<Grid> grids;
+  auto get_grid = [&](const TaskInput& input) -> Grid& {
+    const auto [it, was_inserted] =
+        key_to_search_index_.insert({GetSearchKey(input), grids.size()});
+    if (was_inserted) grids.emplace_back();
+    return grids[it->second];
+  };
+  for (const TaskInput& input : remaining_tasks) {
+    Grid& grid = get_grid(input);
+    grid.remaining_tasks[input.codec_settings.quality].push_back(input);
+    ++grid.num_tasks[input.codec_settings.quality];
+  }
+  for (const TaskOutput& task : completed_tasks) {
+    Grid& grid = get_grid(task.task_input);
+    const int quality = task.task_input.codec_settings.quality;
+    grid.points.emplace(quality, GetRateDistortionPoint(settings_, task));
+    grid.outputs.emplace(quality, &task);
+    ++grid.num_tasks[quality];
+  }
+
+  searches_.reserve(grids.size());
+  for (Grid& grid : grids) {
+    std::vector<int> qualities;
+    size_t num_tasks_per_quality = 0;
+    for (const auto& [quality, num_tasks] : grid.num_tasks) {
+      qualities.push_back(quality);  // Sorted by std::map.
+      num_tasks_per_quality = std::max(num_tasks_per_quality, num_tasks);
+    }
+    searches_.emplace_back(std::move(qualities));
+    Search& search = searches_.back();
+    for (const auto& [quality, tasks] : grid.remaining_tasks) {
+      search.num_remaining_tasks += tasks.size();
+    }
+    search.remaining_tasks = std::move(grid.remaining_tasks);
+    search.points = std::move(grid.points);
+    if (settings_.prune_saturated) {
+      for (const auto& [quality, output] : grid.outputs) {
+        search.outputs.emplace(quality, *output);
+      }
+    }
+    search.num_tasks_per_quality = num_tasks_per_quality;
+  }
+}
+
+std::vector<TaskInput> QualitySearches::TakeFirstTasks(
+    std::vector<TaskOutput>& extrapolated_tasks) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<TaskInput> tasks;
+  for (Search& search : searches_) {
+    std::vector<TaskInput> search_tasks = Advance(search, extrapolated_tasks);
+    std::move(search_tasks.begin(), search_tasks.end(),
+              std::back_inserter(tasks));
+  }
+  return tasks;
+}
+
+std::vector<TaskInput> QualitySearches::OnTaskCompleted(
+    const TaskOutput& task, std::vector<TaskOutput>& extrapolated_tasks) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto index = key_to_search_index_.find(GetSearchKey(task.task_input));
+  if (index == key_to_search_index_.end()) return {};
+  Search& search = searches_[index->second];
+  Record(search, task);
+  if (search.num_pending_tasks == 0 || --search.num_pending_tasks > 0) {
+    return {};
+  }
+  return Advance(search, extrapolated_tasks);
+}
+
+size_t QualitySearches::MaxNumRemainingTasks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t num_tasks = 0;
+  for (const Search& search : searches_) {
+    if (search.is_done) continue;
+    if (settings_.target == QualitySearchTarget::kNone ||
+        settings_.target == QualitySearchTarget::kRateDistortionCurve) {
+      num_tasks += search.num_remaining_tasks + search.num_pending_tasks;
+    } else {
+      num_tasks +=
+          search.bisection.MaxNumProbes() * search.num_tasks_per_quality;
+    }
+  }
+  return num_tasks;
+}
+
+std::vector<TaskInput> QualitySearches::Advance(
+    Search& search, std::vector<TaskOutput>& extrapolated_tasks) {
+  std::vector<TaskInput> tasks =
+      settings_.target == QualitySearchTarget::kNone
+          ? AdvanceSweep(search, extrapolated_tasks)
+      : settings_.target == QualitySearchTarget::kRateDistortionCurve
+          ? AdvanceCurveSampling(search)
+          : AdvanceBisection(search);
+  search.num_pending_tasks = tasks.size();
+  search.is_done = tasks.empty();
+  return tasks;
+}
+
+std::vector<TaskInput> QualitySearches::AdvanceBisection(Search& search) {
+  std::vector<TaskInput> tasks;
+  while (!search.bisection.IsDone()) {
+    const int quality = search.bisection.NextQuality();
+    TakeTasks(search, quality, tasks);
+    if (!tasks.empty()) break;
+    const auto point = search.points.find(quality);
+    if (point == search.points.end()) break;  // Failed.
+    search.bisection.Record(ReachesTarget(settings_, point->second));
+  }
+  return tasks;
+}
+
+std::vector<TaskInput> QualitySearches::AdvanceCurveSampling(Search& search) {
+  std::vector<std::optional<RateDistortionPoint>> points;
+  points.reserve(search.qualities.size());
+  for (int quality : search.qualities) {
+    // Also run the remaining repetitions of partially completed qualities.
+    const auto point = search.points.find(quality);
+    points.push_back(point == search.points.end() ||
+                             search.remaining_tasks.count(quality) != 0
+                         ? std::nullopt
+                         : std::optional<RateDistortionPoint>(point->second));
+  }
+  std::vector<TaskInput> tasks;
+  // Failed qualities are sampled again but have no task left.
+  for (size_t index :
+       NextCurveSamples(points, settings_.num_initial_curve_qualities,
+                        settings_.value)) {
+    TakeTasks(search, search.qualities[index], tasks);
+  }
+  return tasks;
+}
+
+std::vector<TaskInput> QualitySearches::AdvanceSweep(
+    Search& search, std::vector<TaskOutput>& extrapolated_tasks) {
+  std::vector<const TaskOutput*> outputs;
+  outputs.reserve(search.qualities.size());
+  for (int quality : search.qualities) {
+    const auto output = search.outputs.find(quality);
+    outputs.push_back(output == search.outputs.end() ? nullptr
+                                                     : &output->second);
+  }
+
+  std::vector<TaskInput> tasks;
+  for (; search.num_swept_qualities < search.qualities.size();
+       ++search.num_swept_qualities) {
+    const size_t index = search.num_swept_qualities;
+    TakeTasks(search, search.qualities[index], tasks);
+    if (!tasks.empty()) return tasks;
+    // Failed qualities are skipped.
+    if (!IsSaturated(outputs, index)) continue;
+
+    for (size_t i = index + 1; i < search.qualities.size(); ++i) {
+      TakeTasks(search, search.qualities[i], tasks);
+    }
+    for (TaskInput& input : tasks) {
+      TaskOutput extrapolated_task = *outputs[index];
+      extrapolated_task.task_input = std::move(input);
+      extrapolated_task.is_extrapolated = true;
+      extrapolated_tasks.push_back(std::move(extrapolated_task));
+    }
+    search.num_swept_qualities = search.qualities.size();
+    return {};
+  }
+  return {};
+}
+
+void QualitySearches::Record(Search& search, const TaskOutput& task) {
+  const int quality = task.task_input.codec_settings.quality;
+  search.points.emplace(quality, GetRateDistortionPoint(settings_, task));
+  if (settings_.prune_saturated) search.outputs.emplace(quality, task);
+}
+
+void QualitySearches::TakeTasks(Search& search, int quality,
+                                std::vector<TaskInput>& tasks) {
+  const auto quality_tasks = search.remaining_tasks.find(quality);
+  if (quality_tasks == search.remaining_tasks.end()) return;
+  search.num_remaining_tasks -= quality_tasks->second.size();
+  std::move(quality_tasks->second.begin(), quality_tasks->second.end(),
+            std::back_inserter(tasks));
+  search.remaining_tasks.erase(quality_tasks);
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,154 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_QUALITY_SEARCH_H_
+#define SRC_QUALITY_SEARCH_H_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/base.h"
+#include "src/framework.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Returns true if a greater value of the metric means less distortion.
+bool IsHigherBetter(DistortionMetric metric);
+
+// Size and distortion of the settings metric of an encoded image.
+struct RateDistortionPoint {
+  double bits_per_pixel;
+  float distortion;
+};
+RateDistortionPoint GetRateDistortionPoint(
+    const QualitySearchSettings& settings, const TaskOutput& task);
+
+// Returns true if the point reaches the target of the settings: its distortion
+// is at least as good as the target, or its size exceeds the bits per pixel
+// budget. Both become true as the quality increases.
+bool ReachesTarget(const QualitySearchSettings& settings,
+                   const RateDistortionPoint& point);
+
+// Adaptive sampling of a rate-distortion curve given its points at sorted
+// qualities, unset if not probed yet. Starts with num_initial_samples evenly
+// spread qualities, then recursively probes the middle quality between two
+// sampled neighbors while the distortion of the middle point differs by more
+// than max_error from the linear interpolation of its neighbors. Returns the
+// indices of the qualities to probe next, or nothing once done.
+std::vector<size_t> NextCurveSamples(
+    const std::vector<std::optional<RateDistortionPoint>>& points,
+    size_t num_initial_samples, double max_error);
+
+// Bisection of sorted qualities to find the lowest one reaching a target,
+// assuming that reaching it is monotonic with the quality.
+class QualitySearch {
+ public:
+  explicit QualitySearch(std::vector<int> qualities);
+
+  bool IsDone() const { return first_ == last_; }
+  // Requires !IsDone().
+  int NextQuality() const { return qualities_[(first_ + last_) / 2]; }
+  // Narrows the search given the outcome of NextQuality().
+  void Record(bool reaches_target);
+  // Index of the lowest quality reaching the target, or the number of
+  // qualities if none does. Requires IsDone().
+  size_t result() const { return first_; }
+  // Maximum number of qualities left to probe.
+  size_t MaxNumProbes() const;
+
+ private:
+  std::vector<int> qualities_;
+  size_t first_ = 0;
+  size_t last_ = 0;  // Exclusive.
+};
+
+// Returns true if the qualities above the one at index in outputs (sorted by
+// quality, null if not run) would be wasted work: the encoding is lossless or
+// its size is the same as the ones of the previous qualities.
+bool IsSaturated(const std::vector<const TaskOutput*>& outputs, size_t index);
+
+// Thread-safe set of the QualitySearch, curve sampling or pruned sweep of each
+// codec settings and image pair, depending on QualitySearchSettings. Only the
+// qualities on the path of the bisection, sampled on the curve or below the
+// saturation are run. All repetitions of the qualities being run are completed
+// before the next ones are chosen.
+class QualitySearches {
+ public:
+  // remaining_tasks and completed_tasks are the full grid of planned tasks.
+  // The completed tasks on the path of each search are not run again.
+  QualitySearches(const QualitySearchSettings& settings,
+                  const std::vector<TaskInput>& remaining_tasks,
+                  const std::vector<TaskOutput>& completed_tasks);
+
+  // Returns the tasks of the first qualities to run of each search, in the
+  // order of the remaining_tasks given to the constructor. The pruned tasks
+  // are appended to extrapolated_tasks.
+  std::vector<TaskInput> TakeFirstTasks(
+      std::vector<TaskOutput>& extrapolated_tasks);
+  // Records the outcome of a task returned by this. Returns the tasks of the
+  // next qualities to run of its search, if all the repetitions of the
+  // qualities being run are completed. The pruned tasks are appended to
+  // extrapolated_tasks.
+  std::vector<TaskInput> OnTaskCompleted(
+      const TaskOutput& task, std::vector<TaskOutput>& extrapolated_tasks);
+  // Upper bound of the number of tasks not recorded by OnTaskCompleted() yet,
+  // including the ones returned and still running.
+  size_t MaxNumRemainingTasks() const;
+
+ private:
+  struct Search {
+    explicit Search(const std::vector<int>& sorted_qualities)
+        : qualities(sorted_qualities), bisection(sorted_qualities) {}
+    std::vector<int> qualities;  // Sorted.
+    QualitySearch bisection;     // Unused for kRateDistortionCurve.
+    std::map<int, std::vector<TaskInput>> remaining_tasks;  // By quality.
+    std::map<int, RateDistortionPoint> points;  // By quality, once known.
+    // Only for QualitySearchSettings::prune_saturated.
+    std::map<int, TaskOutput> outputs;  // By quality, once known.
+    size_t num_swept_qualities = 0;
+    size_t num_remaining_tasks = 0;  // In remaining_tasks.
+    size_t num_tasks_per_quality = 0;
+    size_t num_pending_tasks = 0;  // Of the qualities being run.
+    bool is_done = false;
+  };
+
+  // Skips the qualities whose tasks are all completed. Returns the tasks of
+  // the next qualities to run, if any.
+  std::vector<TaskInput> Advance(Search& search,
+                                 std::vector<TaskOutput>& extrapolated_tasks);
+  std::vector<TaskInput> AdvanceBisection(Search& search);
+  std::vector<TaskInput> AdvanceCurveSampling(Search& search);
+  std::vector<TaskInput> AdvanceSweep(
+      Search& search, std::vector<TaskOutput>& extrapolated_tasks);
+  // Records the output of a task of the search.
+  void Record(Search& search, const TaskOutput& task);
+  // Moves the remaining tasks of the quality to tasks.
+  static void TakeTasks(Search& search, int quality,
+                        std::vector<TaskInput>& tasks);
+
+  const QualitySearchSettings settings_;
+  mutable std::mutex mutex_;  // Guards the fields below.
+  std::vector<Search> searches_;  // In order of first remaining task.
+  std::unordered_map<std::string, size_t> key_to_search_index_;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_QUALITY_SEARCH_H_
@@ -0,0 +1,275 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/remote_tasks.h"
+
+#ifdef HAVE_UNISTD_H
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/serialization.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+std::string SerializeRemoteTask(const TaskInput& input,
+                                EncodeMode encode_mode) {
+  std::stringstream ss;
+  ss << static_cast<int>(encode_mode) << ", "
+     << Escape(CodecName(input.codec_settings.codec)) << ", "
+     << SubsamplingToString(input.codec_settings.chroma_subsampling) << ", "
+     << input.codec_settings.effort << ", " << input.codec_settings.quality
+     << ", " << input.codec_settings.num_threads << ", "
+     << Escape(input.image_path) << ", " << Escape(input.encoded_path);
+  return ss.str();
+}
+
+Status UnserializeRemoteTask(std::string_view serialized_task,
+                             TaskInput& input, EncodeMode& encode_mode,
+                             bool quiet) {
+  std::vector<std::string_view> tokens;
+  SplitViews(serialized_task, ',', tokens);
+  CHECK_OR_RETURN(tokens.size() == 8, quiet)
+      << "Expected 8 tokens in \"" << serialized_task << "\" but found "
+      << tokens.size();
+  int mode;
+  CHECK_OR_RETURN(ParseNumber(tokens[0], mode) &&
+                      mode >= static_cast<int>(EncodeMode::kEncode) &&
+                      mode <= static_cast<int>(EncodeMode::kLoadFromDisk),
+                  quiet)
+      << "Unknown encode mode in \"" << serialized_task << "\"";
+  encode_mode = static_cast<EncodeMode>(mode);
+  ASSIGN_OR_RETURN(const std::string codec_name, Unescape(tokens[1], quiet));
+  ASSIGN_OR_RETURN(input.codec_settings.codec,
+                   CodecFromName(codec_name, quiet));
+  ASSIGN_OR_RETURN(input.codec_settings.chroma_subsampling,
+                   SubsamplingFromString(tokens[2], quiet));
+  CodecSettings& codec_settings = input.codec_settings;
+  CHECK_OR_RETURN(ParseNumber(tokens[3], codec_settings.effort) &&
+                      ParseNumber(tokens[4], codec_settings.quality) &&
+                      ParseNumber(tokens[5], codec_settings.num_threads) &&
+                      codec_settings.num_threads > 0,
+                  quiet)
+      << "Bad codec settings in \"" << serialized_task << "\"";
+  ASSIGN_OR_RETURN(input.image_path, Unescape(tokens[6], quiet));
+  ASSIGN_OR_RETURN(input.encoded_path, Unescape(tokens[7], quiet));
+  return Status::kOk;
+}
+
+//------------------------------------------------------------------------------
+
+LineConnection::~LineConnection() {
+#ifdef HAVE_UNISTD_H
+  if (fd_ >= 0) close(fd_);
+#endif
+}
+
+Status LineConnection::Connect(const std::string& address, bool quiet) {
+  CHECK_OR_RETURN(fd_ < 0, quiet) << "Already connected";
+  const size_t colon = address.rfind(':');
+  CHECK_OR_RETURN(colon != std::string::npos && colon + 1 < address.size(),
+                  quiet)
+      << "Expected host:port but got \"" << address << "\"";
+#ifdef HAVE_UNISTD_H
+  const std::string host = address.substr(0, colon);
+  const std::string port = address.substr(colon + 1);
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  CHECK_OR_RETURN(
+      getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0, quiet)
+      << "Could not resolve " << address;
+  for (addrinfo* a = addresses; a != nullptr && fd_ < 0; a = a->ai_next) {
+    fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd_ >= 0 && connect(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  CHECK_OR_RETURN(fd_ >= 0, quiet) << "Could not connect to " << address;
+  // The lines are short and each one waits for an answer.
+  const int one = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return Status::kOk;
+#else
+  CHECK_OR_RETURN(false, quiet) << "Remote tasks are not supported";
+#endif
+}
+
+bool LineConnection::WriteLine(std::string_view line) {
+#ifdef HAVE_UNISTD_H
+  std::string bytes(line);
+  bytes.push_back('\n');
+#if defined(MSG_NOSIGNAL)
+  constexpr int kFlags = MSG_NOSIGNAL;  // Fail instead of raising SIGPIPE.
+#else
+  constexpr int kFlags = 0;
+#endif
+  for (size_t offset = 0; offset < bytes.size();) {
+    const ssize_t num_bytes =
+        send(fd_, bytes.data() + offset, bytes.size() - offset, kFlags);
+    if (num_bytes < 0 && errno == EINTR) continue;
+    if (num_bytes <= 0) return false;
+    offset += static_cast<size_t>(num_bytes);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool LineConnection::ReadLine(std::string& line) {
+#ifdef HAVE_UNISTD_H
+  size_t end;
+  while ((end = buffer_.find('\n')) == std::string::npos) {
+    char bytes[4096];
+    const ssize_t num_bytes = recv(fd_, bytes, sizeof(bytes), 0);
+    if (num_bytes < 0 && errno == EINTR) continue;
+    if (num_bytes <= 0) return false;  // Including EAGAIN after a timeout.
+    buffer_.append(bytes, static_cast<size_t>(num_bytes));
+  }
+  line = buffer_.substr(0, end);
+  buffer_.erase(0, end + 1);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void LineConnection::SetReadTimeout(double seconds) {
+#ifdef HAVE_UNISTD_H
+  if (fd_ < 0) return;
+  timeval timeout{};
+  timeout.tv_sec = static_cast<time_t>(seconds);
+  timeout.tv_usec = static_cast<suseconds_t>(
+      (seconds - static_cast<double>(timeout.tv_sec)) * 1000000);
+  setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+void LineConnection::Shutdown() {
+#ifdef HAVE_UNISTD_H
+  if (fd_ >= 0) shutdown(fd_, SHUT_RDWR);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+Status TaskServer::Start(const std::string& address, uint16_t port,
+                         Handler handle, bool quiet) {
+  CHECK_OR_RETURN(listen_fd_ < 0, quiet) << "Already started";
+#ifdef HAVE_UNISTD_H
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo* addresses = nullptr;
+  CHECK_OR_RETURN(
+      getaddrinfo(address.empty() ? nullptr : address.c_str(),
+                  std::to_string(port).c_str(), &hints, &addresses) == 0,
+      quiet)
+      << "Could not resolve " << address << ":" << port;
+  for (addrinfo* a = addresses; a != nullptr && listen_fd_ < 0;
+       a = a->ai_next) {
+    listen_fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (listen_fd_ < 0) continue;
+    const int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listen_fd_, a->ai_addr, a->ai_addrlen) != 0 ||
+        listen(listen_fd_, /*backlog=*/64) != 0) {
+      close(listen_fd_);
+      listen_fd_ = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  CHECK_OR_RETURN(listen_fd_ >= 0, quiet)
+      << "Could not listen on " << address << ":" << port;
+
+  sockaddr_storage bound_address{};
+  socklen_t bound_address_size = sizeof(bound_address);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bound_address),
+              &bound_address_size);
+  port_ = ntohs(bound_address.ss_family == AF_INET6
+                    ? reinterpret_cast<sockaddr_in6*>(&bound_address)->sin6_port
+                    : reinterpret_cast<sockaddr_in*>(&bound_address)->sin_port);
+  handle_ = std::move(handle);
+  accept_thread_ = std::thread(&TaskServer::Accept, this);
+  return Status::kOk;
+#else
+  CHECK_OR_RETURN(false, quiet) << "Remote tasks are not supported";
+#endif
+}
+
+void TaskServer::Accept() {
+#ifdef HAVE_UNISTD_H
+  while (true) {
+    const int fd = accept(listen_fd_, /*addr=*/nullptr, /*addrlen=*/nullptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_stopped_) {
+      if (fd >= 0) close(fd);
+      return;
+    }
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return;
+    }
+    // Detects the hosts that vanished without closing the connection.
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    LineConnection& connection = connections_.emplace_back(fd);
+    connection_threads_.emplace_back(
+        [this, &connection]() { handle_(connection); });
+  }
+#endif
+}
+
+void TaskServer::Stop() {
+#ifdef HAVE_UNISTD_H
+  if (listen_fd_ < 0) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopped_ = true;
+    for (LineConnection& connection : connections_) connection.Shutdown();
+  }
+  shutdown(listen_fd_, SHUT_RDWR);  // Wakes accept() up.
+  accept_thread_.join();
+  for (std::thread& thread : connection_threads_) thread.join();
+  connection_threads_.clear();
+  connections_.clear();
+  close(listen_fd_);
+  listen_fd_ = -1;
+#endif
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,113 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_REMOTE_TASKS_H_
+#define SRC_REMOTE_TASKS_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// The tasks of a comparison can be run by ccgen processes on other hosts. A
+// coordinator owns the remaining tasks and the completed tasks file, and hands
+// out one task at a time to each connected worker over TCP. Lines exchanged:
+//   worker: kRemoteTasksHello, then repeatedly:
+//   worker: "get"
+//   coordinator: "task " SerializeRemoteTask(), or "done" if there is none left
+//   worker: "result " TaskOutput::Serialize(), or "failed"
+// Workers can connect and disconnect at any time. The task of a lost
+// connection is handed out again.
+constexpr const char kRemoteTasksHello[] = "ccgen-tasks 1";
+
+// Unlike TaskInput::Serialize(), keeps all the fields needed to run the task.
+std::string SerializeRemoteTask(const TaskInput& input, EncodeMode encode_mode);
+Status UnserializeRemoteTask(std::string_view serialized_task,
+                             TaskInput& input, EncodeMode& encode_mode,
+                             bool quiet);
+
+// Blocking TCP connection exchanging lines of text.
+class LineConnection {
+ public:
+  LineConnection() = default;
+  explicit LineConnection(int fd) : fd_(fd) {}
+  LineConnection(const LineConnection&) = delete;
+  LineConnection& operator=(const LineConnection&) = delete;
+  ~LineConnection();
+
+  // Connects to "host:port".
+  Status Connect(const std::string& address, bool quiet);
+
+  // Both return false if the connection is closed or lost.
+  bool WriteLine(std::string_view line);
+  bool ReadLine(std::string& line);
+  // ReadLine() also returns false if nothing is received for that long, so
+  // that a host vanishing without closing the connection is noticed before
+  // TCP keepalive does. 0 waits forever.
+  void SetReadTimeout(double seconds);
+  // Makes the pending and future reads and writes fail. Thread-safe.
+  void Shutdown();
+
+ private:
+  int fd_ = -1;
+  std::string buffer_;  // Read but not returned yet.
+};
+
+// Accepts TCP connections and calls handle() for each of them in a dedicated
+// thread.
+class TaskServer {
+ public:
+  using Handler = std::function<void(LineConnection&)>;
+
+  TaskServer() = default;
+  TaskServer(const TaskServer&) = delete;
+  TaskServer& operator=(const TaskServer&) = delete;
+  ~TaskServer() { Stop(); }
+
+  // Listens on the given address, or on all interfaces if it is empty. Any
+  // free port is picked if port is 0. There is no authentication, so anyone
+  // who can reach the port can take tasks and send results.
+  Status Start(const std::string& address, uint16_t port, Handler handle,
+               bool quiet);
+  uint16_t port() const { return port_; }
+  // Stops accepting, shuts down the connections still open and waits for all
+  // handle() calls to return.
+  void Stop();
+
+ private:
+  void Accept();
+
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  Handler handle_;
+  std::thread accept_thread_;
+  std::mutex mutex_;  // Guards the fields below.
+  bool is_stopped_ = false;
+  std::list<LineConnection> connections_;  // Stable addresses.
+  std::vector<std::thread> connection_threads_;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_REMOTE_TASKS_H_
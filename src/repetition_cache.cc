@@ -0,0 +1,74 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/repetition_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+bool RepetitionCache::Reuse(size_t encoded_digest, TaskOutput& task) {
+  const std::string key = task.task_input.Serialize();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) return false;
+  Entry& entry = it->second;
+  // A nondeterministic encoder may produce other bytes, and thus another loss.
+  if (entry.encoded_size != task.encoded_size ||
+      entry.encoded_digest != encoded_digest) {
+    return false;
+  }
+  std::copy(entry.distortions, entry.distortions + kNumDistortionMetrics,
+            task.distortions);
+  ++num_hits_;
+  if (entry.num_remaining_repetitions <= 1) {
+    entries_.erase(it);
+  } else {
+    --entry.num_remaining_repetitions;
+  }
+  return true;
+}
+
+void RepetitionCache::Insert(const TaskOutput& task, size_t encoded_digest) {
+  if (num_repetitions_ == 0) return;
+  std::string key = task.task_input.Serialize();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto [it, was_inserted] = entries_.try_emplace(std::move(key));
+  Entry& entry = it->second;
+  if (was_inserted) {
+    entry.encoded_size = task.encoded_size;
+    entry.encoded_digest = encoded_digest;
+    std::copy(task.distortions, task.distortions + kNumDistortionMetrics,
+              entry.distortions);
+    entry.num_remaining_repetitions = num_repetitions_;
+  } else if (entry.num_remaining_repetitions <= 1) {
+    // A repetition that ran concurrently or was encoded differently.
+    entries_.erase(it);
+  } else {
+    --entry.num_remaining_repetitions;
+  }
+}
+
+size_t RepetitionCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+}  // namespace codec_compare_gen
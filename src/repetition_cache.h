@@ -0,0 +1,65 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_REPETITION_CACHE_H_
+#define SRC_REPETITION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Thread-safe distortions of the tasks already run, shared with their pending
+// repetitions. A repetition encoded to the same bytes decodes to the same
+// image, so only its encoding and decoding need to be timed again.
+class RepetitionCache {
+ public:
+  // Each task is expected to run 1 + num_repetitions times. An entry is
+  // dropped once all repetitions of its task went through the cache.
+  explicit RepetitionCache(uint32_t num_repetitions)
+      : num_repetitions_(num_repetitions) {}
+
+  // Copies the distortions of a previous repetition of task into task if it
+  // was encoded to the same encoded_size and encoded_digest. Returns false
+  // otherwise, in which case Insert() is expected after computing them.
+  bool Reuse(size_t encoded_digest, TaskOutput& task);
+  // Records the distortions of task, unless a repetition already did.
+  void Insert(const TaskOutput& task, size_t encoded_digest);
+
+  size_t num_hits() const;
+
+ private:
+  struct Entry {
+    size_t encoded_size;
+    size_t encoded_digest;
+    float distortions[kNumDistortionMetrics];
+    uint32_t num_remaining_repetitions;
+  };
+
+  const uint32_t num_repetitions_;
+  mutable std::mutex mutex_;  // Guards all fields below.
+  // Keyed by TaskInput::Serialize(), which is shared by all repetitions.
+  std::unordered_map<std::string, Entry> entries_;
+  size_t num_hits_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_REPETITION_CACHE_H_
@@ -0,0 +1,154 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/resource_usage.h"
+
+#ifdef HAVE_UNISTD_H
+#include <time.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#include "src/memory_usage.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// Returns the CPU time of the calling thread in seconds, or -1.
+double GetThreadCpuTime() {
+#if defined(HAVE_UNISTD_H) && defined(CLOCK_THREAD_CPUTIME_ID)
+  timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return -1;
+  return static_cast<double>(time.tv_sec) + time.tv_nsec / 1e9;
+#else
+  return -1;
+#endif
+}
+
+#if defined(__linux__)
+// Returns the file descriptor of a user-space counter of the calling thread
+// and its future children, or -1.
+int OpenHardwareCounter(uint64_t config) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;  // Usually required by perf_event_paranoid.
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, /*pid=*/0,
+                                  /*cpu=*/-1, /*group_fd=*/-1, /*flags=*/0));
+}
+#endif
+
+// Returns the current value of the counter, or -1.
+int64_t ReadHardwareCounter(int fd) {
+#if defined(__linux__)
+  uint64_t value;
+  if (fd >= 0 && read(fd, &value, sizeof(value)) == sizeof(value)) {
+    return static_cast<int64_t>(value);
+  }
+#endif
+  return -1;
+}
+
+void AddIfMeasured(int64_t other, int64_t& value) {
+  value = (value >= 0 && other >= 0) ? value + other : -1;
+}
+
+}  // namespace
+
+void ResourceUsage::Add(const ResourceUsage& other) {
+  cpu_time = (cpu_time >= 0 && other.cpu_time >= 0) ? cpu_time + other.cpu_time
+                                                    : -1;
+  AddIfMeasured(other.cycles, cycles);
+  AddIfMeasured(other.instructions, instructions);
+  AddIfMeasured(other.cache_misses, cache_misses);
+  AddIfMeasured(other.peak_memory, peak_memory);
+}
+
+void ResourceUsage::Divide(uint32_t count) {
+  if (cpu_time >= 0) cpu_time /= count;
+  for (int64_t* value : {&cycles, &instructions, &cache_misses, &peak_memory}) {
+    if (*value >= 0) *value /= count;
+  }
+}
+
+ResourceUsageMeter::ResourceUsageMeter(const ResourceUsageSettings& settings)
+    : settings_(settings) {
+#if defined(__linux__)
+  if (settings_.hardware_counters) {
+    const uint64_t configs[kNumHardwareCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES};
+    for (size_t i = 0; i < kNumHardwareCounters; ++i) {
+      counter_fds_[i] = OpenHardwareCounter(configs[i]);
+    }
+  }
+#endif
+}
+
+ResourceUsageMeter::~ResourceUsageMeter() {
+#if defined(__linux__)
+  for (int fd : counter_fds_) {
+    if (fd >= 0) close(fd);
+  }
+#endif
+}
+
+void ResourceUsageMeter::Start() {
+  if (settings_.cpu_time) start_cpu_time_ = GetThreadCpuTime();
+  for (size_t i = 0; i < kNumHardwareCounters; ++i) {
+    start_counters_[i] = ReadHardwareCounter(counter_fds_[i]);
+  }
+  if (settings_.peak_memory) {
+    start_memory_ = ResetPeakResidentSetSize() ? GetResidentSetSize() : 0;
+  }
+}
+
+ResourceUsage ResourceUsageMeter::Stop() const {
+  ResourceUsage usage;
+  if (settings_.cpu_time && start_cpu_time_ >= 0) {
+    const double cpu_time = GetThreadCpuTime();
+    if (cpu_time >= 0) usage.cpu_time = cpu_time - start_cpu_time_;
+  }
+  int64_t* values[kNumHardwareCounters] = {&usage.cycles, &usage.instructions,
+                                           &usage.cache_misses};
+  for (size_t i = 0; i < kNumHardwareCounters; ++i) {
+    const int64_t value = ReadHardwareCounter(counter_fds_[i]);
+    if (value >= 0 && start_counters_[i] >= 0) {
+      *values[i] = value - start_counters_[i];
+    }
+  }
+  if (settings_.peak_memory && start_memory_ > 0) {
+    const size_t peak_memory = GetPeakResidentSetSizeSinceReset();
+    if (peak_memory > 0) {
+      usage.peak_memory = static_cast<int64_t>(
+          peak_memory > start_memory_ ? peak_memory - start_memory_ : 0);
+    }
+  }
+  return usage;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,80 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_RESOURCE_USAGE_H_
+#define SRC_RESOURCE_USAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace codec_compare_gen {
+
+// What a ResourceUsageMeter measures.
+struct ResourceUsageSettings {
+  bool cpu_time = false;
+  bool hardware_counters = false;  // Only on Linux, and if permitted.
+  // Only on Linux. Process-wide so only meaningful if nothing else runs.
+  bool peak_memory = false;
+};
+
+// Resources used by an encoding or a decoding. Negative means not measured.
+struct ResourceUsage {
+  // In seconds, only the calling thread. See ResourceUsageMeter.
+  double cpu_time = -1;
+  // Hardware counters, including the threads created by the calling thread.
+  int64_t cycles = -1;
+  int64_t instructions = -1;
+  int64_t cache_misses = -1;
+  // In bytes, the peak resident set size of the process above the resident set
+  // size at the start of the measurement.
+  int64_t peak_memory = -1;
+
+  bool IsMeasured() const {
+    return cpu_time >= 0 || cycles >= 0 || instructions >= 0 ||
+           cache_misses >= 0 || peak_memory >= 0;
+  }
+  // Sums the fields measured in both.
+  void Add(const ResourceUsage& other);
+  // Turns a sum of count measurements into their average.
+  void Divide(uint32_t count);
+};
+
+// Measures the resources used by the calling thread between Start() and
+// Stop(). The codec threads are included in the hardware counters if they are
+// created after the ResourceUsageMeter, but not in cpu_time, so Compare()
+// rejects cpu_time with more than one codec thread.
+class ResourceUsageMeter {
+ public:
+  explicit ResourceUsageMeter(const ResourceUsageSettings& settings);
+  ResourceUsageMeter(const ResourceUsageMeter&) = delete;
+  ResourceUsageMeter& operator=(const ResourceUsageMeter&) = delete;
+  ~ResourceUsageMeter();
+
+  void Start();
+  ResourceUsage Stop() const;
+
+ private:
+  static constexpr size_t kNumHardwareCounters = 3;
+
+  const ResourceUsageSettings settings_;
+  double start_cpu_time_ = 0;
+  // Closed if -1, for example if perf_event_open() is not permitted.
+  int counter_fds_[kNumHardwareCounters] = {-1, -1, -1};
+  int64_t start_counters_[kNumHardwareCounters] = {0, 0, 0};
+  size_t start_memory_ = 0;  // 0 if unavailable.
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_RESOURCE_USAGE_H_
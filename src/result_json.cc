@@ -16,18 +16,26 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "src/base.h"
 #include "src/codec.h"
 #include "src/framework.h"
+#include "src/output_file.h"
+#include "src/resource_usage.h"
 #include "src/serialization.h"
 #include "src/task.h"
 
@@ -35,6 +43,56 @@ namespace codec_compare_gen {
 
 namespace {
 
+// Optional fields measured by a ResourceUsageMeter.
+struct UsageField {
+  const char* name;
+  const char* description;
+  ResourceUsage TaskOutput::*usage;
+  int64_t ResourceUsage::*counter;  // ResourceUsage::cpu_time if null.
+
+  bool IsMeasured(const TaskOutput& task) const {
+    const ResourceUsage& u = task.*usage;
+    return counter == nullptr ? u.cpu_time >= 0 : u.*counter >= 0;
+  }
+  void Write(const TaskOutput& task, std::ostream& stream) const {
+    const ResourceUsage& u = task.*usage;
+    if (counter == nullptr) {
+      stream << u.cpu_time;
+    } else {
+      stream << u.*counter;
+    }
+  }
+};
+
+constexpr UsageField kUsageFields[] = {
+    {"encoding_cpu_time",
+     "Encoding CPU time in seconds of the calling thread, without the codec "
+     "threads",
+     &TaskOutput::encoding_usage, nullptr},
+    {"decoding_cpu_time",
+     "Decoding CPU time in seconds of the calling thread, without the codec "
+     "threads",
+     &TaskOutput::decoding_usage, nullptr},
+    {"encoding_cycles", "CPU cycles spent in user space to encode",
+     &TaskOutput::encoding_usage, &ResourceUsage::cycles},
+    {"encoding_instructions", "Instructions retired in user space to encode",
+     &TaskOutput::encoding_usage, &ResourceUsage::instructions},
+    {"encoding_cache_misses", "Cache misses in user space to encode",
+     &TaskOutput::encoding_usage, &ResourceUsage::cache_misses},
+    {"decoding_cycles", "CPU cycles spent in user space to decode",
+     &TaskOutput::decoding_usage, &ResourceUsage::cycles},
+    {"decoding_instructions", "Instructions retired in user space to decode",
+     &TaskOutput::decoding_usage, &ResourceUsage::instructions},
+    {"decoding_cache_misses", "Cache misses in user space to decode",
+     &TaskOutput::decoding_usage, &ResourceUsage::cache_misses},
+    {"encoding_peak_memory",
+     "Peak resident memory in bytes added by the encoding",
+     &TaskOutput::encoding_usage, &ResourceUsage::peak_memory},
+    {"decoding_peak_memory",
+     "Peak resident memory in bytes added by the decoding",
+     &TaskOutput::decoding_usage, &ResourceUsage::peak_memory}};
+constexpr size_t kNumUsageFields = sizeof(kUsageFields) / sizeof(UsageField);
+
 std::string DateTime() {
   const std::time_t time = std::time(nullptr);
   const std::tm localtime = *std::localtime(&time);
@@ -43,35 +101,6 @@ std::string DateTime() {
       .str();
 }
 
-// Returns the path of the deepest folder containing all assets.
-std::filesystem::path GetCommonParent(const std::vector<TaskOutput>& tasks,
-                                      bool get_encoded_path) {
-  std::filesystem::path prefix;
-  for (size_t i = 0; i < tasks.size(); ++i) {
-    const std::filesystem::path parent =
-        std::filesystem::path(get_encoded_path
-                                  ? tasks[i].task_input.encoded_path
-                                  : tasks[i].task_input.image_path)
-            .parent_path();
-    if (i == 0) {
-      prefix = parent;
-    } else {
-      const auto mismatch = std::mismatch(parent.begin(), parent.end(),
-                                          prefix.begin(), prefix.end())
-                                .second;
-      if (mismatch != prefix.end()) {
-        // parent does not begin as prefix.
-        std::filesystem::path common_prefix;
-        for (auto it = prefix.begin(); it != mismatch; ++it) {
-          common_prefix.append(it->string());
-        }
-        prefix = common_prefix;
-      }
-    }
-  }
-  return prefix;
-}
-
 std::filesystem::path RemovePrefix(const std::filesystem::path& prefix,
                                    const std::filesystem::path& path) {
   std::filesystem::path stripped_path;
@@ -94,39 +123,144 @@ std::string AppendDirectorySeparator(const std::filesystem::path& path) {
       0, path_with_fake_file.size() - fake_file.string().size());
 }
 
+// Finds the deepest folder containing all image or encoded paths, and strips
+// it from these paths. Both are done once per distinct parent folder rather
+// than once per path, because batches usually have far fewer folders than
+// tasks.
+class CommonParentStripper {
+ public:
+  CommonParentStripper(const std::vector<TaskOutput>& tasks,
+                       bool get_encoded_path) {
+    // Keys are views of the task paths.
+    std::unordered_map<std::string_view, std::filesystem::path> parents;
+    for (const TaskOutput& task : tasks) {
+      const std::string& path = get_encoded_path ? task.task_input.encoded_path
+                                                 : task.task_input.image_path;
+      const auto [it, was_inserted] = parents.insert({ParentKey(path), {}});
+      if (was_inserted) {
+        it->second = std::filesystem::path(path).parent_path();
+      }
+    }
+
+    bool is_first = true;
+    for (const auto& [key, parent] : parents) {
+      if (is_first) {
+        common_parent_ = parent;
+        is_first = false;
+        continue;
+      }
+      const auto mismatch = std::mismatch(parent.begin(), parent.end(),
+                                          common_parent_.begin(),
+                                          common_parent_.end())
+                                .second;
+      if (mismatch != common_parent_.end()) {
+        // parent does not begin as common_parent_.
+        std::filesystem::path common_prefix;
+        for (auto it = common_parent_.begin(); it != mismatch; ++it) {
+          common_prefix.append(it->string());
+        }
+        common_parent_ = common_prefix;
+      }
+    }
+
+    for (const auto& [key, parent] : parents) {
+      stripped_parents_.insert(
+          {key, RemovePrefix(/*prefix=*/common_parent_, parent).string()});
+    }
+  }
+
+  const std::filesystem::path& common_parent() const { return common_parent_; }
+
+  // Same as RemovePrefix(common_parent(), path) for any of the task paths.
+  std::string Strip(const std::string& path) const {
+    const std::string_view key = ParentKey(path);
+    const std::string& stripped_parent = stripped_parents_.at(key);
+    const std::string_view file_name =
+        std::string_view(path).substr(key.size());
+    if (stripped_parent.empty()) return std::string(file_name);
+    std::string stripped_path = stripped_parent;
+    if (stripped_path.back() != std::filesystem::path::preferred_separator) {
+      stripped_path += std::filesystem::path::preferred_separator;
+    }
+    stripped_path += file_name;
+    return stripped_path;
+  }
+
+ private:
+  // Returns the part of the path up to its last separator included, which is
+  // the same for paths sharing the same parent folder.
+  static std::string_view ParentKey(std::string_view path) {
+    const size_t separator =
+        path.rfind(std::filesystem::path::preferred_separator);
+    return separator == std::string_view::npos ? std::string_view()
+                                               : path.substr(0, separator + 1);
+  }
+
+  std::filesystem::path common_parent_;
+  std::unordered_map<std::string_view, std::string> stripped_parents_;
+};
+
 }  // namespace
 
+std::string ResultsFileExtension(const ResultsFormat& results_format) {
+  return results_format.gzip ? ".json.gz" : ".json";
+}
+
 Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
-                   const std::vector<TaskOutput>& tasks, bool quiet,
+                   TimingStatistic timing_statistic,
+                   const std::vector<TaskOutput>& tasks,
+                   const ResultsFormat& results_format, bool quiet,
                    const std::string& results_file_path) {
   bool lossless = true;
   bool has_encoded_path = true;
+  // Only keep the distortion metrics that were computed for all tasks.
+  bool has_distortion[kNumDistortionMetrics];
+  std::fill(has_distortion, has_distortion + kNumDistortionMetrics, true);
+  // Same for the resource usage.
+  bool has_usage[kNumUsageFields];
+  std::fill(has_usage, has_usage + kNumUsageFields, !tasks.empty());
+  // Same for the spread of the durations of the repetitions.
+  bool has_stddev = !tasks.empty();
   for (size_t i = 0; i < tasks.size(); ++i) {
     const CodecSettings& codec_settings = tasks[i].task_input.codec_settings;
     CHECK_OR_RETURN(
         codec_settings.codec == settings.codec &&
             codec_settings.chroma_subsampling == settings.chroma_subsampling &&
-            codec_settings.effort == settings.effort,
+            codec_settings.effort == settings.effort &&
+            codec_settings.num_threads == settings.num_threads,
         quiet)
         << "Codec settings do not match";
     lossless &= codec_settings.quality == kQualityLossless;
     has_encoded_path &= !tasks[i].task_input.encoded_path.empty();
+    for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+      has_distortion[m] &= !std::isnan(tasks[i].distortions[m]);
+    }
+    for (size_t f = 0; f < kNumUsageFields; ++f) {
+      has_usage[f] &= kUsageFields[f].IsMeasured(tasks[i]);
+    }
+    has_stddev &= tasks[i].encoding_duration_stddev >= 0 &&
+                  tasks[i].decoding_duration_stddev >= 0;
   }
 
   // See EncodeDecode().
   const bool has_decoded_path =
       has_encoded_path && !CodecIsSupportedByBrowsers(settings.codec);
 
-  std::ofstream file(results_file_path, std::ios::trunc);
-  CHECK_OR_RETURN(file.is_open(), quiet) << "Failed to open results file at "
-                                         << results_file_path << " for writing";
+  OutputFile results_file;
+  OK_OR_RETURN(
+      results_file.Open(results_file_path, results_format.gzip, quiet));
+  std::ostream& file = results_file.stream();
 
   // Keep only the file name as original_name, eventually with any leading
   // differentiating parent folders. Find out what to strip.
-  const std::filesystem::path image_common_parent =
-      GetCommonParent(tasks, /*get_encoded_path=*/false);
-  const std::filesystem::path encoded_common_parent =
-      GetCommonParent(tasks, /*get_encoded_path=*/true);
+  const CommonParentStripper image_stripper(tasks,
+                                            /*get_encoded_path=*/false);
+  const CommonParentStripper encoded_stripper(tasks,
+                                              /*get_encoded_path=*/true);
+  const std::filesystem::path& image_common_parent =
+      image_stripper.common_parent();
+  const std::filesystem::path& encoded_common_parent =
+      encoded_stripper.common_parent();
   // Only keep the relative parent folder as original_path root. The full
   // absolute path is less likely to be useful.
   const std::string image_parent = AppendDirectorySeparator(RemovePrefix(
@@ -152,6 +286,9 @@ Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
   std::string encoding_cmd =
       "codec-compare-gen/build/ccgen --codec " + CodecName(settings.codec) +
       " " + SubsamplingToString(settings.chroma_subsampling) + effort_str;
+  if (settings.num_threads != 1) {
+    encoding_cmd += " --codec_threads " + std::to_string(settings.num_threads);
+  }
   if (settings.quality == kQualityLossless) {
     encoding_cmd += " --lossless";
   } else {
@@ -168,7 +305,9 @@ Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
     {"time": "Timestamp of when this data was generated"},
     {"original_path": "Path to the original image"},
     {"build_command": "The command used to generate the codec binaries"},
-    {"encoding_cmd": "The command used to encode the original image"})json";
+    {"encoding_cmd": "The command used to encode the original image"},
+    {"codec_threads": "Threads used by the codec to encode and decode"},
+    {"timing_statistic": "How the durations of the repetitions are aggregated"})json";
   if (has_encoded_path) {
     file << R"json(,
     {"encoded_path": "Path to the encoded image"})json";
@@ -195,7 +334,11 @@ Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
     )json"
        << Escape(build_cmd) << R"json(,
     )json"
-       << Escape(encoding_cmd);
+       << Escape(encoding_cmd) << R"json(,
+    )json"
+       << Escape(std::to_string(settings.num_threads)) << R"json(,
+    )json"
+       << Escape(TimingStatisticToString(timing_statistic));
   if (has_encoded_path) {
     file << R"json(,
     )json"
@@ -236,30 +379,246 @@ Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
     {"decoding_time": "Decoding duration in seconds. Warning: Timings are environment-dependent and inaccurate."},
     {"dec_time_no_col_conv": "Decoding duration in seconds without color conversion. Warning: Only different from regular decoding for codecs without built-in conversion."})json";
   if (!lossless) {
-    static_assert(kNumDistortionMetrics == 7);
+    static_assert(kNumDistortionMetrics == 8);
     // In DistortionMetric order.
+    static constexpr const char* kDistortionDescriptions[] = {
+        R"json({"psnr": "Distortion metric Peak Signal-to-Noise Ratio (libwebp2 implementation). See https://en.wikipedia.org/wiki/Peak_signal-to-noise_ratio. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"ssim": "Distortion metric Structural Similarity Index Measure (libwebp2 implementation). See https://en.wikipedia.org/wiki/Structural_similarity. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"dssim": "Distortion metric Structural Dissimilarity (kornelski implementation). See https://en.wikipedia.org/wiki/Structural_similarity_index_measure#Structural_Dissimilarity. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"butteraugli": "Distortion metric Butteraugli (libjxl implementation). See https://en.wikipedia.org/wiki/Guetzli#Butteraugli. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"ssimulacra": "Distortion metric SSIMULACRA (libjxl implementation). See https://en.wikipedia.org/wiki/Structural_similarity#SSIMULACRA. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"ssimulacra2": "Distortion metric SSIMULACRA2 (libjxl implementation). See https://en.wikipedia.org/wiki/Structural_similarity#SSIMULACRA. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"p3norm": "Distortion metric P3-norm (libjxl implementation). See https://en.wikipedia.org/wiki/Norm_(mathematics)#p-norm. Warning: There is no scientific consensus on which objective distortion metric to use."})json",
+        R"json({"sample_psnr": "Distortion metric Peak Signal-to-Noise Ratio over all samples of all channels at once, without alpha blending. See https://en.wikipedia.org/wiki/Peak_signal-to-noise_ratio. Warning: There is no scientific consensus on which objective distortion metric to use."})json"};
+    for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+      if (has_distortion[m]) {
+        file << R"json(,
+    )json"
+             << kDistortionDescriptions[m];
+      }
+    }
+  }
+  if (has_stddev) {
     file << R"json(,
-    {"psnr": "Distortion metric Peak Signal-to-Noise Ratio (libwebp2 implementation). See https://en.wikipedia.org/wiki/Peak_signal-to-noise_ratio. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"ssim": "Distortion metric Structural Similarity Index Measure (libwebp2 implementation). See https://en.wikipedia.org/wiki/Structural_similarity. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"dssim": "Distortion metric Structural Dissimilarity (kornelski implementation). See https://en.wikipedia.org/wiki/Structural_similarity_index_measure#Structural_Dissimilarity. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"butteraugli": "Distortion metric Butteraugli (libjxl implementation). See https://en.wikipedia.org/wiki/Guetzli#Butteraugli. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"ssimulacra": "Distortion metric SSIMULACRA (libjxl implementation). See https://en.wikipedia.org/wiki/Structural_similarity#SSIMULACRA. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"ssimulacra2": "Distortion metric SSIMULACRA2 (libjxl implementation). See https://en.wikipedia.org/wiki/Structural_similarity#SSIMULACRA. Warning: There is no scientific consensus on which objective distortion metric to use."},
-    {"p3norm": "Distortion metric P3-norm (libjxl implementation). See https://en.wikipedia.org/wiki/Norm_(mathematics)#p-norm. Warning: There is no scientific consensus on which objective distortion metric to use."})json";
+    {"encoding_time_stddev": "Standard deviation of the encoding durations in seconds"},
+    {"decoding_time_stddev": "Standard deviation of the decoding durations in seconds"})json";
+  }
+  for (size_t f = 0; f < kNumUsageFields; ++f) {
+    if (has_usage[f]) {
+      file << R"json(,
+    {)json" << Escape(kUsageFields[f].name) << ": "
+           << Escape(std::string(kUsageFields[f].description) +
+                     ". Warning: Environment-dependent.")
+           << "}";
+    }
+  }
+  auto write_row = [&](const TaskOutput& task, std::ostream& stream) {
+    stream << "[";
+    stream << Escape(image_stripper.Strip(task.task_input.image_path)) << ",";
+    stream << task.image_width << ",";
+    stream << task.image_height << ",";
+    stream << task.bit_depth << ",";
+    stream << task.num_frames << ",";
+    if (!lossless) {
+      stream << SubsamplingToString(
+                    task.task_input.codec_settings.chroma_subsampling)
+             << ",";
+    }
+    stream << task.task_input.codec_settings.effort << ",";
+    if (!lossless) {
+      stream << task.task_input.codec_settings.quality << ",";
+    }
+    if (has_encoded_path) {
+      stream << Escape(encoded_stripper.Strip(task.task_input.encoded_path))
+             << ",";
+    }
+    stream << task.encoded_size << ",";
+    stream << task.encoding_duration << ",";
+    stream << task.decoding_duration << ",";
+    stream << (task.decoding_duration -
+               task.decoding_color_conversion_duration);
+    if (!lossless) {
+      for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+        if (has_distortion[m]) stream << "," << task.distortions[m];
+      }
+    }
+    if (has_stddev) {
+      stream << "," << task.encoding_duration_stddev << ","
+             << task.decoding_duration_stddev;
+    }
+    for (size_t f = 0; f < kNumUsageFields; ++f) {
+      if (has_usage[f]) {
+        stream << ",";
+        kUsageFields[f].Write(task, stream);
+      }
+    }
+    stream << "]";
+  };
+
+  if (results_format.chunk_num_rows == 0) {
+    file << R"json(
+  ],
+  "field_values": [
+)json";
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      file << "    ";
+      write_row(tasks[i], file);
+      if (i + 1 < tasks.size()) file << ",";
+      file << "\n";  // Flushing each row is too slow for large batches.
+    }
+    file << "  ]" << std::endl << "}" << std::endl;
+    return results_file.Close(quiet);
+  }
+
+  // Split layout. Each chunk file is a JSON array of rows.
+  const std::string extension = ResultsFileExtension(results_format);
+  std::string chunk_path_prefix = results_file_path;
+  if (chunk_path_prefix.size() >= extension.size() &&
+      chunk_path_prefix.compare(chunk_path_prefix.size() - extension.size(),
+                                extension.size(), extension) == 0) {
+    chunk_path_prefix.resize(chunk_path_prefix.size() - extension.size());
+  }
+  chunk_path_prefix += "_rows";
+  file << R"json(
+  ],
+  "field_value_chunks": [)json";
+  for (size_t first_row = 0, chunk = 0; first_row < tasks.size();
+       first_row += results_format.chunk_num_rows, ++chunk) {
+    const size_t end_row =
+        std::min(first_row + results_format.chunk_num_rows, tasks.size());
+    const std::string chunk_path =
+        chunk_path_prefix + std::to_string(chunk) + extension;
+    OutputFile chunk_file;
+    OK_OR_RETURN(chunk_file.Open(chunk_path, results_format.gzip, quiet));
+    std::ostream& chunk_stream = chunk_file.stream();
+    chunk_stream << "[\n";
+    for (size_t i = first_row; i < end_row; ++i) {
+      write_row(tasks[i], chunk_stream);
+      if (i + 1 < end_row) chunk_stream << ",";
+      chunk_stream << "\n";
+    }
+    chunk_stream << "]" << std::endl;
+    OK_OR_RETURN(chunk_file.Close(quiet));
+
+    // Relative to the JSON file.
+    file << (chunk == 0 ? "\n" : ",\n") << R"json(    {"path": )json"
+         << Escape(std::filesystem::path(chunk_path).filename().string())
+         << R"json(, "num_rows": )json" << (end_row - first_row) << "}";
+  }
+  file << "\n  ]" << std::endl << "}" << std::endl;
+  return results_file.Close(quiet);
+}
+
+Status DecodingBenchmarksToJson(
+    const std::string& batch_pretty_name, CodecSettings settings,
+    uint32_t num_warmups, const std::vector<DecodingBenchmark>& benchmarks,
+    bool quiet, const std::string& results_file_path) {
+  bool lossless = true;
+  std::vector<TaskOutput> tasks;  // For the CommonParentStrippers.
+  tasks.reserve(benchmarks.size());
+  for (const DecodingBenchmark& benchmark : benchmarks) {
+    const CodecSettings& codec_settings =
+        benchmark.task.task_input.codec_settings;
+    CHECK_OR_RETURN(
+        codec_settings.codec == settings.codec &&
+            codec_settings.chroma_subsampling == settings.chroma_subsampling &&
+            codec_settings.effort == settings.effort &&
+            codec_settings.num_threads == settings.num_threads,
+        quiet)
+        << "Codec settings do not match";
+    CHECK_OR_RETURN(!benchmark.decoding_durations.empty(), quiet);
+    lossless &= codec_settings.quality == kQualityLossless;
+    tasks.push_back(benchmark.task);
+  }
+
+  std::ofstream file(results_file_path, std::ios::trunc);
+  CHECK_OR_RETURN(file.is_open(), quiet) << "Failed to open results file at "
+                                         << results_file_path << " for writing";
+
+  const CommonParentStripper image_stripper(tasks,
+                                            /*get_encoded_path=*/false);
+  const CommonParentStripper encoded_stripper(tasks,
+                                              /*get_encoded_path=*/true);
+  const std::filesystem::path& image_common_parent =
+      image_stripper.common_parent();
+  const std::filesystem::path& encoded_common_parent =
+      encoded_stripper.common_parent();
+  const std::string image_parent = AppendDirectorySeparator(RemovePrefix(
+      /*prefix=*/image_common_parent.parent_path(), image_common_parent));
+  const std::string encoded_parent = AppendDirectorySeparator(RemovePrefix(
+      /*prefix=*/encoded_common_parent.parent_path(), encoded_common_parent));
+
+  file << R"json({
+  "constant_descriptions": [
+    {"name": "Name of this batch"},
+    {"codec": "Name of the codec used to generate this data"},
+    {"version": "Version of the codec used to generate this data"},
+    {"time": "Timestamp of when this data was generated"},
+    {"original_path": "Path to the original image"},
+    {"encoded_path": "Path to the encoded image"},
+    {"codec_threads": "Threads used by the codec to decode"},
+    {"decoding_warmups": "Discarded decodings before the measured ones"}
+  ],
+  "constant_values": [
+    )json"
+       << Escape(batch_pretty_name) << R"json(,
+    )json"
+       << Escape(CodecName(settings.codec)) << R"json(,
+    )json"
+       << Escape(CodecVersion(settings.codec) + "_" +
+                 SubsamplingToString(settings.chroma_subsampling))
+       << R"json(,
+    )json"
+       << Escape(DateTime()) << R"json(,
+    )json"
+       << Escape(image_parent + "${original_name}") << R"json(,
+    )json"
+       << Escape(encoded_parent + "${encoded_name}") << R"json(,
+    )json"
+       << Escape(std::to_string(settings.num_threads)) << R"json(,
+    )json"
+       << Escape(std::to_string(std::max(num_warmups, 1u))) << R"json(
+  ],)json";
+
+  file << R"json(
+  "field_descriptions": [
+    {"original_name": "Original image file name"},
+    {"width": "Pixel columns in the decoded image"},
+    {"height": "Pixel rows in the decoded image"},
+    {"depth": "Bit depth of the decoded image"},
+    {"frame_count": "Number of frames in the decoded image"},)json";
+  if (!lossless) {
+    file << R"json(
+    {"chroma_subsampling": "Compression chroma subsampling parameter"},)json";
+  }
+  file << R"json(
+    {"effort": "Compression effort parameter"},)json";
+  if (!lossless) {
+    file << R"json(
+    {"quality": "Compression quality parameter"},)json";
   }
   file << R"json(
+    {"encoded_name": "Name of the encoded image"},
+    {"encoded_size": "Size of the encoded image file in bytes"},
+    {"decoding_count": "Number of measured back-to-back decodings"},
+    {"decoding_mps": "Decoded megapixels per second over all measured decodings, frames included. Warning: Timings are environment-dependent and inaccurate."},
+    {"decoding_time_min": "Fastest decoding duration in seconds"},
+    {"decoding_time_p50": "Median decoding duration in seconds"},
+    {"decoding_time_p90": "90th percentile of the decoding durations in seconds"},
+    {"decoding_time_p99": "99th percentile of the decoding durations in seconds"}
   ],
   "field_values": [
 )json";
 
-  for (size_t i = 0; i < tasks.size(); ++i) {
-    const TaskOutput& task = tasks[i];
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    const TaskOutput& task = benchmarks[i].task;
+    const std::vector<double>& durations = benchmarks[i].decoding_durations;
+    double total_duration = 0;
+    for (double duration : durations) total_duration += duration;
+    const double num_megapixels = static_cast<double>(task.image_width) *
+                                  task.image_height * task.num_frames / 1e6;
     file << "    [";
-    file << Escape(
-                RemovePrefix(/*prefix=*/image_common_parent,
-                             std::filesystem::path(task.task_input.image_path))
-                    .string())
-         << ",";
+    file << Escape(image_stripper.Strip(task.task_input.image_path)) << ",";
     file << task.image_width << ",";
     file << task.image_height << ",";
     file << task.bit_depth << ",";
@@ -273,25 +632,21 @@ Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
     if (!lossless) {
       file << task.task_input.codec_settings.quality << ",";
     }
-    if (has_encoded_path) {
-      file << Escape(RemovePrefix(
-                         /*prefix=*/encoded_common_parent,
-                         std::filesystem::path(task.task_input.encoded_path))
-                         .string())
-           << ",";
-    }
+    file << Escape(encoded_stripper.Strip(task.task_input.encoded_path))
+         << ",";
     file << task.encoded_size << ",";
-    file << task.encoding_duration << ",";
-    file << task.decoding_duration << ",";
-    file << (task.decoding_duration - task.decoding_color_conversion_duration);
-    if (!lossless) {
-      for (const float distortion : task.distortions) {
-        file << "," << distortion;
-      }
-    }
+    file << durations.size() << ",";
+    file << (total_duration > 0
+                 ? num_megapixels * durations.size() / total_duration
+                 : 0)
+         << ",";
+    file << durations.front() << ",";
+    file << DurationPercentile(durations, 0.5) << ",";
+    file << DurationPercentile(durations, 0.9) << ",";
+    file << DurationPercentile(durations, 0.99);
     file << "]";
-    if (i + 1 < tasks.size()) file << ",";
-    file << std::endl;
+    if (i + 1 < benchmarks.size()) file << ",";
+    file << "\n";
   }
 
   file << "  ]" << std::endl << "}" << std::endl;
@@ -15,6 +15,7 @@
 #ifndef SRC_RESULT_JSON_H_
 #define SRC_RESULT_JSON_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -24,10 +25,27 @@
 
 namespace codec_compare_gen {
 
+// Returns ".json", or ".json.gz" if results_format.gzip.
+std::string ResultsFileExtension(const ResultsFormat& results_format);
+
+// The durations of the tasks are expected to be aggregated with
+// timing_statistic, which is recorded in the file. results_file_path should
+// end with ResultsFileExtension(results_format). The chunk files, if any, are
+// written next to it, with "_rows" and their index inserted before that
+// extension.
 Status TasksToJson(const std::string& batch_pretty_name, CodecSettings settings,
-                   const std::vector<TaskOutput>& tasks, bool quiet,
+                   TimingStatistic timing_statistic,
+                   const std::vector<TaskOutput>& tasks,
+                   const ResultsFormat& results_format, bool quiet,
                    const std::string& results_file_path);
 
+// Writes the throughput and the latency percentiles of the decodings of each
+// encoded image. All benchmarks must share the codec settings but the quality.
+Status DecodingBenchmarksToJson(
+    const std::string& batch_pretty_name, CodecSettings settings,
+    uint32_t num_warmups, const std::vector<DecodingBenchmark>& benchmarks,
+    bool quiet, const std::string& results_file_path);
+
 }  // namespace codec_compare_gen
 
 #endif  // SRC_RESULT_JSON_H_
@@ -14,9 +14,14 @@
 
 #include "src/serialization.h"
 
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <string>
+#include <system_error>
 #include <string_view>
 #include <vector>
 
@@ -24,6 +29,10 @@
 
 namespace codec_compare_gen {
 
+bool StartsWith(std::string_view str, std::string_view prefix) {
+  return str.substr(0, prefix.size()) == prefix;
+}
+
 bool EndsWith(std::string_view str, std::string_view suffix) {
   return suffix.empty() || (str.size() >= suffix.size() &&
                             str.substr(str.size() - suffix.size()) == suffix);
@@ -59,6 +68,79 @@ std::vector<std::string> Split(std::string_view str, char delimiter) {
   return tokens;
 }
 
+namespace {
+
+std::string_view TrimView(std::string_view str) {
+  while (!str.empty() && std::isspace(static_cast<unsigned char>(str[0]))) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() &&
+         std::isspace(static_cast<unsigned char>(str[str.size() - 1]))) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+template <typename T>
+bool ParseInteger(std::string_view str, T& value) {
+  const char* const end = str.data() + str.size();
+  const std::from_chars_result result = std::from_chars(str.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end && !str.empty();
+}
+
+template <typename T>
+bool ParseFloatingPoint(std::string_view str, T& value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const char* const end = str.data() + str.size();
+  const std::from_chars_result result = std::from_chars(str.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end && !str.empty();
+#else
+  // Floating-point std::from_chars() is not available everywhere.
+  const std::string null_terminated(str);
+  char* end = nullptr;
+  value = static_cast<T>(std::strtod(null_terminated.c_str(), &end));
+  return !str.empty() && end == null_terminated.c_str() + str.size();
+#endif
+}
+
+}  // namespace
+
+void SplitViews(std::string_view str, char delimiter,
+                std::vector<std::string_view>& tokens) {
+  tokens.clear();
+  size_t token_start = 0;
+  bool is_escaped = false;
+  bool in_literal_string = false;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == delimiter && !in_literal_string) {
+      tokens.push_back(TrimView(str.substr(token_start, i - token_start)));
+      token_start = i + 1;
+      continue;
+    }
+    if (str[i] == '"' && !is_escaped) {
+      in_literal_string = !in_literal_string;
+    }
+    is_escaped = (!is_escaped && str[i] == '\\');
+  }
+  tokens.push_back(TrimView(str.substr(token_start)));
+}
+
+bool ParseNumber(std::string_view str, int& value) {
+  return ParseInteger(str, value);
+}
+bool ParseNumber(std::string_view str, uint32_t& value) {
+  return ParseInteger(str, value);
+}
+bool ParseNumber(std::string_view str, size_t& value) {
+  return ParseInteger(str, value);
+}
+bool ParseNumber(std::string_view str, float& value) {
+  return ParseFloatingPoint(str, value);
+}
+bool ParseNumber(std::string_view str, double& value) {
+  return ParseFloatingPoint(str, value);
+}
+
 std::string Escape(std::string_view str) {
   std::string escaped_str("\"");
   for (size_t i = 0; i < str.size(); ++i) {
@@ -89,6 +171,12 @@ StatusOr<std::string> Unescape(std::string_view escaped_str, bool quiet) {
   return str;
 }
 
+uint64_t StableHash(std::string_view bytes, uint64_t hash) {
+  constexpr uint64_t kPrime = 1099511628211ull;
+  for (char c : bytes) hash = (hash ^ static_cast<uint8_t>(c)) * kPrime;
+  return hash;
+}
+
 std::string SubsamplingToString(Subsampling chroma_subsampling) {
   switch (chroma_subsampling) {
     case Subsampling::k444:
@@ -108,4 +196,36 @@ StatusOr<Subsampling> SubsamplingFromString(std::string_view str, bool quiet) {
   return Status::kUnknownError;
 }
 
+StatusOr<DistortionMetric> DistortionMetricFromString(std::string_view str,
+                                                      bool quiet) {
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    const std::string_view name = kDistortionMetricToStr[m];
+    if (std::equal(str.begin(), str.end(), name.begin(), name.end(),
+                   [](char a, char b) {
+                     return std::tolower(static_cast<unsigned char>(a)) ==
+                            std::tolower(static_cast<unsigned char>(b));
+                   })) {
+      return static_cast<DistortionMetric>(m);
+    }
+  }
+  CHECK_OR_RETURN(false, quiet)
+      << "Unknown distortion metric \"" << str << "\"";
+  return Status::kUnknownError;
+}
+
+std::string TimingStatisticToString(TimingStatistic timing_statistic) {
+  return timing_statistic == TimingStatistic::kMedian ? "median"
+         : timing_statistic == TimingStatistic::kMin  ? "min"
+                                                      : "mean";
+}
+
+StatusOr<TimingStatistic> TimingStatisticFromString(std::string_view str,
+                                                    bool quiet) {
+  if (str == "mean") return TimingStatistic::kMean;
+  if (str == "median") return TimingStatistic::kMedian;
+  CHECK_OR_RETURN(str == "min", quiet)
+      << "Unknown timing statistic \"" << str << "\"";
+  return TimingStatistic::kMin;
+}
+
 }  // namespace codec_compare_gen
@@ -15,6 +15,8 @@
 #ifndef SRC_SERIALIZATION_H_
 #define SRC_SERIALIZATION_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,6 +25,7 @@
 
 namespace codec_compare_gen {
 
+bool StartsWith(std::string_view str, std::string_view prefix);
 bool EndsWith(std::string_view str, std::string_view suffix);
 
 // Removes trailing or tailing spaces.
@@ -31,15 +34,39 @@ std::string Trim(std::string_view str);
 // Splits the input string into tokens separated by delimiter.
 // Keeps escaped tokens as is. Example: "a,b",c gives two tokens.
 std::vector<std::string> Split(std::string_view str, char delimiter);
+// Same as Split() but the tokens point to str. Reusing the same tokens vector
+// avoids any allocation.
+void SplitViews(std::string_view str, char delimiter,
+                std::vector<std::string_view>& tokens);
 
 // Escapes the quotes in the input string and adds leading and trailing quotes.
 std::string Escape(std::string_view str);
 // Removes leading and trailing quotes and replaces each \" by ".
 StatusOr<std::string> Unescape(std::string_view escaped_str, bool quiet);
 
+// Parses the whole str as a number. Returns false if there is any other
+// character, including spaces.
+bool ParseNumber(std::string_view str, int& value);
+bool ParseNumber(std::string_view str, uint32_t& value);
+bool ParseNumber(std::string_view str, size_t& value);
+bool ParseNumber(std::string_view str, float& value);
+bool ParseNumber(std::string_view str, double& value);
+
+// FNV-1a hash of the bytes, continuing from hash. Unlike std::hash, it is the
+// same on all hosts and builds, so it can be stored or shared.
+constexpr uint64_t kStableHashSeed = 14695981039346656037ull;
+uint64_t StableHash(std::string_view bytes, uint64_t hash = kStableHashSeed);
+
 // Enum/string conversions.
 std::string SubsamplingToString(Subsampling chroma_subsampling);
 StatusOr<Subsampling> SubsamplingFromString(std::string_view str, bool quiet);
+// Case-insensitive match of kDistortionMetricToStr.
+StatusOr<DistortionMetric> DistortionMetricFromString(std::string_view str,
+                                                      bool quiet);
+// "mean", "median" or "min".
+std::string TimingStatisticToString(TimingStatistic timing_statistic);
+StatusOr<TimingStatistic> TimingStatisticFromString(std::string_view str,
+                                                    bool quiet);
 
 }  // namespace codec_compare_gen
 
@@ -0,0 +1,75 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shard.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/codec.h"
+#include "src/serialization.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+void HashNumber(int64_t number, uint64_t& hash) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char>(number >> (i * 8));
+  hash = StableHash(std::string_view(bytes, sizeof(bytes)), hash);
+}
+
+}  // namespace
+
+uint32_t GetShardIndex(const TaskInput& task_input, uint32_t num_shards) {
+  if (num_shards <= 1) return 0;
+  const CodecSettings& codec_settings = task_input.codec_settings;
+  // Names rather than enum values, in case the enums are reordered.
+  uint64_t hash = StableHash(CodecName(codec_settings.codec));
+  hash = StableHash(SubsamplingToString(codec_settings.chroma_subsampling),
+                    hash);
+  HashNumber(codec_settings.effort, hash);
+  HashNumber(codec_settings.num_threads, hash);
+  hash = StableHash(
+      std::filesystem::path(task_input.image_path).filename().string(), hash);
+  return static_cast<uint32_t>(hash % num_shards);
+}
+
+void KeepShardTasks(uint32_t shard_index, uint32_t num_shards,
+                    std::vector<TaskInput>& tasks) {
+  if (num_shards <= 1) return;
+  tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                             [&](const TaskInput& task) {
+                               return GetShardIndex(task, num_shards) !=
+                                      shard_index;
+                             }),
+              tasks.end());
+}
+
+std::string GetShardFilePath(const std::string& completed_tasks_file_path,
+                             uint32_t shard_index, uint32_t num_shards) {
+  const std::filesystem::path path(completed_tasks_file_path);
+  return (path.parent_path() /
+          (path.stem().string() + "_shard" + std::to_string(shard_index) +
+           "of" + std::to_string(num_shards) + path.extension().string()))
+      .string();
+}
+
+}  // namespace codec_compare_gen
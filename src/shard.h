@@ -0,0 +1,49 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_SHARD_H_
+#define SRC_SHARD_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// A comparison can be split into num_shards independent runs, for example on
+// as many hosts sharing the same images and settings. Each task belongs to
+// exactly one shard.
+
+// Returns the shard in [0:num_shards) of the task. Stable across hosts and
+// runs: it only depends on the codec settings without the quality, and on the
+// image file name without its folder. All qualities and repetitions of a codec
+// settings and image pair thus belong to the same shard, as required by the
+// quality searches and by the repetition checks.
+uint32_t GetShardIndex(const TaskInput& task_input, uint32_t num_shards);
+
+// Removes the tasks that do not belong to shard_index.
+void KeepShardTasks(uint32_t shard_index, uint32_t num_shards,
+                    std::vector<TaskInput>& tasks);
+
+// Returns the path of the completed tasks file of shard_index, next to
+// completed_tasks_file_path and with the same extension. For example
+// "dir/progress.csv" becomes "dir/progress_shard2of8.csv".
+std::string GetShardFilePath(const std::string& completed_tasks_file_path,
+                             uint32_t shard_index, uint32_t num_shards);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_SHARD_H_
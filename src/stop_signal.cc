@@ -0,0 +1,77 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "src/stop_signal.h"
+
+#ifdef HAVE_UNISTD_H
+#include <signal.h>
+#endif
+
+#include <atomic>
+#include <csignal>
+
+namespace codec_compare_gen {
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+static_assert(std::atomic<bool>::is_always_lock_free,
+              "Needed to be set from a signal handler");
+
+extern "C" void OnStopSignal(int /*signal_number*/) {
+  // The handler of that signal is then reset to SIG_DFL, by SA_RESETHAND or
+  // by std::signal().
+  stop_requested.store(true, std::memory_order_relaxed);
+}
+
+constexpr int kStopSignals[] = {SIGINT, SIGTERM};
+
+#ifdef HAVE_UNISTD_H
+struct sigaction previous_actions[2];
+#else
+void (*previous_handlers[2])(int);
+#endif
+
+}  // namespace
+
+StopSignalCatcher::StopSignalCatcher() {
+  stop_requested.store(false, std::memory_order_relaxed);
+  for (int i = 0; i < 2; ++i) {
+#ifdef HAVE_UNISTD_H
+    struct sigaction action = {};
+    action.sa_handler = OnStopSignal;
+    sigemptyset(&action.sa_mask);
+    // Back to the default action once caught.
+    action.sa_flags = SA_RESETHAND | SA_RESTART;
+    sigaction(kStopSignals[i], &action, &previous_actions[i]);
+#else
+    previous_handlers[i] = std::signal(kStopSignals[i], OnStopSignal);
+#endif
+  }
+}
+
+StopSignalCatcher::~StopSignalCatcher() {
+  for (int i = 0; i < 2; ++i) {
+#ifdef HAVE_UNISTD_H
+    sigaction(kStopSignals[i], &previous_actions[i], nullptr);
+#else
+    std::signal(kStopSignals[i], previous_handlers[i]);
+#endif
+  }
+}
+
+bool StopSignalCatcher::IsStopRequested() {
+  return stop_requested.load(std::memory_order_relaxed);
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,36 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef SRC_STOP_SIGNAL_H_
+#define SRC_STOP_SIGNAL_H_
+
+namespace codec_compare_gen {
+
+// Catches SIGINT and SIGTERM while alive, so that a run can stop handing out
+// tasks and save what it completed instead of being killed. Each signal is
+// only caught once: a second one has its usual effect. The previous handlers
+// are restored at destruction. At most one instance should exist at a time.
+class StopSignalCatcher {
+ public:
+  StopSignalCatcher();
+  StopSignalCatcher(const StopSignalCatcher&) = delete;
+  ~StopSignalCatcher();
+
+  // Thread-safe. Returns true once SIGINT or SIGTERM was received since
+  // construction.
+  static bool IsStopRequested();
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_STOP_SIGNAL_H_
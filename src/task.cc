@@ -15,21 +15,30 @@
 #include "src/task.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <filesystem>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "src/base.h"
 #include "src/codec.h"
 #include "src/framework.h"
+#include "src/image_header.h"
 #include "src/serialization.h"
 
 namespace codec_compare_gen {
@@ -58,6 +67,8 @@ std::string GetEncodedFilePath(const std::string& folder_path,
   } else {
     ext << "q" << std::setfill('0') << std::setw(3) << codec_settings.quality;
   }
+  // Multithreading may change the bitstream of some codecs.
+  if (codec_settings.num_threads != 1) ext << "t" << codec_settings.num_threads;
   ext << "." << CodecExtension(codec_settings.codec);
   path.replace_extension(ext.str());
   return path;
@@ -65,7 +76,8 @@ std::string GetEncodedFilePath(const std::string& folder_path,
 
 bool operator==(const CodecSettings& a, const CodecSettings& b) {
   return a.codec == b.codec && a.chroma_subsampling == b.chroma_subsampling &&
-         a.effort == b.effort && a.quality == b.quality;
+         a.effort == b.effort && a.quality == b.quality &&
+         a.num_threads == b.num_threads;
 }
 
 }  // namespace
@@ -87,6 +99,52 @@ std::string TaskInput::Serialize() const {
   return ss.str();
 }
 
+namespace {
+
+// Optional columns of ResourceUsage fields, prefixed by "enc_" or "dec_".
+constexpr std::string_view kEncodingUsagePrefix = "enc_";
+constexpr std::string_view kDecodingUsagePrefix = "dec_";
+constexpr const char kCpuTimeColumn[] = "cpu_time";
+constexpr const char kCyclesColumn[] = "cycles";
+constexpr const char kInstructionsColumn[] = "instructions";
+constexpr const char kCacheMissesColumn[] = "cache_misses";
+constexpr const char kPeakMemoryColumn[] = "peak_memory";
+constexpr const char kExtrapolatedColumn[] = "extrapolated";
+
+void SerializeUsage(std::string_view prefix, const ResourceUsage& usage,
+                    std::stringstream& ss) {
+  if (usage.cpu_time >= 0) {
+    ss << ", " << prefix << kCpuTimeColumn << "=" << usage.cpu_time;
+  }
+  for (const auto& [column, value] :
+       {std::make_pair(kCyclesColumn, usage.cycles),
+        std::make_pair(kInstructionsColumn, usage.instructions),
+        std::make_pair(kCacheMissesColumn, usage.cache_misses),
+        std::make_pair(kPeakMemoryColumn, usage.peak_memory)}) {
+    if (value >= 0) ss << ", " << prefix << column << "=" << value;
+  }
+}
+
+// Returns false if name is not a column of ResourceUsage or if value is
+// invalid.
+bool UnserializeUsage(std::string_view name, std::string_view value,
+                      ResourceUsage& usage) {
+  if (name == kCpuTimeColumn) {
+    return ParseNumber(value, usage.cpu_time) && usage.cpu_time >= 0;
+  }
+  int64_t* counter = name == kCyclesColumn         ? &usage.cycles
+                     : name == kInstructionsColumn ? &usage.instructions
+                     : name == kCacheMissesColumn  ? &usage.cache_misses
+                     : name == kPeakMemoryColumn   ? &usage.peak_memory
+                                                   : nullptr;
+  size_t count;
+  if (counter == nullptr || !ParseNumber(value, count)) return false;
+  *counter = static_cast<int64_t>(count);
+  return true;
+}
+
+}  // namespace
+
 std::string TaskOutput::Serialize() const {
   std::stringstream ss;
   ss << task_input.Serialize() << ", " << image_width << ", " << image_height
@@ -99,20 +157,68 @@ std::string TaskOutput::Serialize() const {
       ss << ", " << distortions[metric];
     }
   }
+  // Optional columns are named and omitted when equal to their default value.
+  if (task_input.codec_settings.num_threads != 1) {
+    ss << ", " << kCodecThreadsColumn << "="
+       << task_input.codec_settings.num_threads;
+  }
+  SerializeUsage(kEncodingUsagePrefix, encoding_usage, ss);
+  SerializeUsage(kDecodingUsagePrefix, decoding_usage, ss);
+  if (is_extrapolated) ss << ", " << kExtrapolatedColumn << "=1";
   return ss.str();
 }
 
 namespace {
 
 constexpr size_t kNumNonDistortionTokens = 14;
+// Number of distortion columns of the lines written before kSamplePsnr existed.
+constexpr size_t kNumDistortionMetricsBeforeSamplePsnr =
+    static_cast<size_t>(DistortionMetric::kSamplePsnr);
+
+// Parses a trailing "name=value" token into the task.
+Status UnserializeOptionalToken(std::string_view serialized_task,
+                                std::string_view token, TaskOutput& task,
+                                bool quiet) {
+  const size_t separator = token.find('=');
+  const std::string_view name = token.substr(0, separator);
+  const std::string_view value = token.substr(separator + 1);
+  bool is_valid;
+  if (name == kCodecThreadsColumn) {
+    is_valid = ParseNumber(value, task.task_input.codec_settings.num_threads) &&
+               task.task_input.codec_settings.num_threads > 0;
+  } else if (name == kExtrapolatedColumn) {
+    is_valid = value == "1";
+    task.is_extrapolated = true;
+  } else if (StartsWith(name, kEncodingUsagePrefix)) {
+    is_valid = UnserializeUsage(name.substr(kEncodingUsagePrefix.size()),
+                                value, task.encoding_usage);
+  } else if (StartsWith(name, kDecodingUsagePrefix)) {
+    is_valid = UnserializeUsage(name.substr(kDecodingUsagePrefix.size()),
+                                value, task.decoding_usage);
+  } else {
+    CHECK_OR_RETURN(false, quiet) << "Unknown column \"" << name << "\" in \""
+                                  << serialized_task << "\"";
+  }
+  CHECK_OR_RETURN(is_valid, quiet)
+      << "Bad " << name << " in \"" << serialized_task << "\"";
+  return Status::kOk;
+}
 
-StatusOr<TaskOutput> UnserializeNoDistortion(
-    const std::string& serialized_task, const std::vector<std::string> tokens,
+// Unserializes the tokens of serialized_task, with or without the distortions.
+StatusOr<TaskOutput> UnserializeTokens(
+    std::string_view serialized_task,
+    const std::vector<std::string_view>& tokens,
     const std::vector<std::unordered_set<int>>& qualities_per_codec,
-    bool quiet) {
-  CHECK_OR_RETURN(tokens.size() >= kNumNonDistortionTokens, quiet)
+    bool with_distortions, bool quiet) {
+  // Named optional columns follow the distortions, if any.
+  size_t num_tokens = tokens.size();
+  while (num_tokens > kNumNonDistortionTokens &&
+         tokens[num_tokens - 1].find('=') != std::string_view::npos) {
+    --num_tokens;
+  }
+  CHECK_OR_RETURN(num_tokens >= kNumNonDistortionTokens, quiet)
       << "Expected " << kNumNonDistortionTokens << "+ tokens in \""
-      << serialized_task << "\" but found " << tokens.size();
+      << serialized_task << "\" but found " << num_tokens;
   size_t t = 0;
 
   TaskOutput task;
@@ -127,33 +233,44 @@ StatusOr<TaskOutput> UnserializeNoDistortion(
   ASSIGN_OR_RETURN(task.task_input.codec_settings.chroma_subsampling,
                    SubsamplingFromString(tokens[t++], quiet));
 
-  task.task_input.codec_settings.effort = std::stoul(tokens[t++]);
-  CHECK_OR_RETURN(task.task_input.codec_settings.effort <= 10 ||
-                      (task.task_input.codec_settings.codec == Codec::kJpegXl &&
-                       task.task_input.codec_settings.effort <= 11),
-                  quiet)
+  CHECK_OR_RETURN(
+      ParseNumber(tokens[t++], task.task_input.codec_settings.effort) &&
+          task.task_input.codec_settings.effort >= 0 &&
+          (task.task_input.codec_settings.effort <= 10 ||
+           (task.task_input.codec_settings.codec == Codec::kJpegXl &&
+            task.task_input.codec_settings.effort <= 11)),
+      quiet)
       << "Unknown effort in \"" << serialized_task << "\"";
 
-  task.task_input.codec_settings.quality = std::stoi(tokens[t++]);
-  CHECK_OR_RETURN(task.task_input.codec_settings.quality == kQualityLossless ||
-                      qualities.find(task.task_input.codec_settings.quality) !=
-                          qualities.end(),
-                  quiet)
+  CHECK_OR_RETURN(
+      ParseNumber(tokens[t++], task.task_input.codec_settings.quality) &&
+          (task.task_input.codec_settings.quality == kQualityLossless ||
+           qualities.find(task.task_input.codec_settings.quality) !=
+               qualities.end()),
+      quiet)
       << "Unknown quality in \"" << serialized_task << "\"";
 
   ASSIGN_OR_RETURN(task.task_input.image_path, Unescape(tokens[t++], quiet));
-  task.image_width = std::stoul(tokens[t++]);
-  task.image_height = std::stoul(tokens[t++]);
-  task.bit_depth = std::stoul(tokens[t++]);
-  task.num_frames = std::stoul(tokens[t++]);
+  CHECK_OR_RETURN(ParseNumber(tokens[t++], task.image_width) &&
+                      ParseNumber(tokens[t++], task.image_height) &&
+                      ParseNumber(tokens[t++], task.bit_depth) &&
+                      ParseNumber(tokens[t++], task.num_frames),
+                  quiet)
+      << "Bad image dimensions in \"" << serialized_task << "\"";
 
   ASSIGN_OR_RETURN(task.task_input.encoded_path, Unescape(tokens[t++], quiet));
-  task.encoded_size = std::stoul(tokens[t++]);
-  task.encoding_duration = std::stod(tokens[t++]);
-  task.decoding_duration = std::stod(tokens[t++]);
-  task.decoding_color_conversion_duration = std::stod(tokens[t++]);
+  CHECK_OR_RETURN(ParseNumber(tokens[t++], task.encoded_size), quiet)
+      << "Bad encoded size in \"" << serialized_task << "\"";
+  CHECK_OR_RETURN(ParseNumber(tokens[t++], task.encoding_duration) &&
+                      ParseNumber(tokens[t++], task.decoding_duration) &&
+                      ParseNumber(tokens[t++],
+                                  task.decoding_color_conversion_duration),
+                  quiet)
+      << "Bad duration in \"" << serialized_task << "\"";
 
   CHECK_OR_RETURN(t == kNumNonDistortionTokens, quiet);
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+            kDistortionNotComputed);
 
   CHECK_OR_RETURN(task.image_width > 0 && task.image_height > 0 &&
                       task.bit_depth > 0 && task.num_frames > 0,
@@ -167,50 +284,144 @@ StatusOr<TaskOutput> UnserializeNoDistortion(
       << "Bad decoded duration in \"" << serialized_task << "\"";
   CHECK_OR_RETURN(task.decoding_duration >= 0, quiet)
       << "Bad color conversion duration in \"" << serialized_task << "\"";
+  for (size_t i = num_tokens; i < tokens.size(); ++i) {
+    OK_OR_RETURN(UnserializeOptionalToken(serialized_task, tokens[i], task,
+                                          quiet));
+  }
+  if (!with_distortions) return task;
+
+  if (num_tokens == kNumNonDistortionTokens) {
+    // Likely lossless.
+    std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+              kNoDistortion);
+  } else {
+    // Lines written before kSamplePsnr was added lack it.
+    const size_t num_metrics = num_tokens - kNumNonDistortionTokens;
+    CHECK_OR_RETURN(num_metrics == kNumDistortionMetrics ||
+                        num_metrics == kNumDistortionMetricsBeforeSamplePsnr,
+                    quiet)
+        << "Expected " << kNumNonDistortionTokens + kNumDistortionMetrics
+        << " tokens instead of " << num_tokens << " in \"" << serialized_task
+        << "\", try the flag --recompute_distortion";
+
+    for (size_t metric = 0; metric < num_metrics; ++metric) {
+      CHECK_OR_RETURN(ParseNumber(tokens[kNumNonDistortionTokens + metric],
+                                  task.distortions[metric]),
+                      quiet)
+          << "Bad " << kDistortionMetricToStr[metric] << " metric value in \""
+          << serialized_task << "\"";
+      if (metric != static_cast<size_t>(DistortionMetric::kLibjxlButteraugli) &&
+          metric != static_cast<size_t>(DistortionMetric::kLibjxlSsimulacra2)) {
+        CHECK_OR_RETURN(std::isnan(task.distortions[metric]) ||
+                            task.distortions[metric] <= 99,
+                        quiet)
+            << "Bad " << kDistortionMetricToStr[metric] << " metric value "
+            << task.distortions[metric] << " in \"" << serialized_task << "\"";
+      }
+    }
+  }
   return task;
 }
 
+// Unserializes the lines of serialized_tasks in order.
+Status UnserializeLines(
+    std::string_view serialized_tasks,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, bool quiet, std::vector<TaskOutput>& tasks) {
+  std::vector<std::string_view> tokens;
+  tokens.reserve(kNumNonDistortionTokens + kNumDistortionMetrics);
+  while (!serialized_tasks.empty()) {
+    const size_t line_end = serialized_tasks.find('\n');
+    const std::string_view line = serialized_tasks.substr(0, line_end);
+    serialized_tasks.remove_prefix(
+        line_end == std::string_view::npos ? serialized_tasks.size()
+                                           : line_end + 1);
+    SplitViews(line, ',', tokens);
+    ASSIGN_OR_RETURN(TaskOutput task,
+                     UnserializeTokens(line, tokens, qualities_per_codec,
+                                       with_distortions, quiet));
+    tasks.push_back(std::move(task));
+  }
+  return Status::kOk;
+}
+
 }  // namespace
 
 StatusOr<TaskOutput> TaskOutput::UnserializeNoDistortion(
     const std::string& serialized_task,
     const std::vector<std::unordered_set<int>>& qualities_per_codec,
     bool quiet) {
-  return ::codec_compare_gen::UnserializeNoDistortion(
-      serialized_task, Split(serialized_task, ','), qualities_per_codec, quiet);
+  std::vector<std::string_view> tokens;
+  SplitViews(serialized_task, ',', tokens);
+  return UnserializeTokens(serialized_task, tokens, qualities_per_codec,
+                           /*with_distortions=*/false, quiet);
 }
 
 StatusOr<TaskOutput> TaskOutput::Unserialize(
     const std::string& serialized_task,
     const std::vector<std::unordered_set<int>>& qualities_per_codec,
     bool quiet) {
-  const std::vector<std::string> tokens = Split(serialized_task, ',');
-  ASSIGN_OR_RETURN(TaskOutput task,
-                   ::codec_compare_gen::UnserializeNoDistortion(
-                       serialized_task, tokens, qualities_per_codec, quiet));
-  if (tokens.size() == kNumNonDistortionTokens) {
-    // Likely lossless.
-    std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
-              kNoDistortion);
-  } else {
-    CHECK_OR_RETURN(
-        tokens.size() == kNumNonDistortionTokens + kNumDistortionMetrics, quiet)
-        << "Expected " << kNumNonDistortionTokens + kNumDistortionMetrics
-        << " tokens instead of " << tokens.size() << " in \"" << serialized_task
-        << "\", try the flag --recompute_distortion";
+  std::vector<std::string_view> tokens;
+  SplitViews(serialized_task, ',', tokens);
+  return UnserializeTokens(serialized_task, tokens, qualities_per_codec,
+                           /*with_distortions=*/true, quiet);
+}
 
-    for (size_t metric = 0; metric < kNumDistortionMetrics; ++metric) {
-      task.distortions[metric] =
-          std::stof(tokens[kNumNonDistortionTokens + metric]);
-      if (metric != static_cast<size_t>(DistortionMetric::kLibjxlButteraugli) &&
-          metric != static_cast<size_t>(DistortionMetric::kLibjxlSsimulacra2)) {
-        CHECK_OR_RETURN(task.distortions[metric] <= 99, quiet)
-            << "Bad " << kDistortionMetricToStr[metric] << " metric value "
-            << task.distortions[metric] << " in \"" << serialized_task << "\"";
-      }
+StatusOr<std::vector<TaskOutput>> UnserializeTaskOutputs(
+    std::string_view serialized_tasks,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, size_t num_threads, bool quiet) {
+  // Chunks that are too small are not worth a thread.
+  constexpr size_t kMinChunkSize = size_t{1} << 20;
+  const size_t num_chunks = std::max<size_t>(
+      1, std::min(num_threads, serialized_tasks.size() / kMinChunkSize));
+  // Split at line breaks.
+  std::vector<std::string_view> chunks;
+  size_t chunk_start = 0;
+  for (size_t i = 1; i <= num_chunks && chunk_start < serialized_tasks.size();
+       ++i) {
+    size_t chunk_end = serialized_tasks.size();
+    if (i < num_chunks) {
+      chunk_end = serialized_tasks.find(
+          '\n', std::max(chunk_start,
+                         serialized_tasks.size() / num_chunks * i));
+      chunk_end = chunk_end == std::string_view::npos
+                      ? serialized_tasks.size()
+                      : chunk_end + 1;
     }
+    chunks.push_back(
+        serialized_tasks.substr(chunk_start, chunk_end - chunk_start));
+    chunk_start = chunk_end;
   }
-  return task;
+
+  std::vector<std::vector<TaskOutput>> chunk_tasks(chunks.size());
+  std::vector<Status> chunk_statuses(chunks.size(), Status::kOk);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < chunks.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      chunk_statuses[i] =
+          UnserializeLines(chunks[i], qualities_per_codec, with_distortions,
+                           quiet, chunk_tasks[i]);
+    });
+  }
+  if (!chunks.empty()) {
+    chunk_statuses[0] = UnserializeLines(chunks[0], qualities_per_codec,
+                                         with_distortions, quiet,
+                                         chunk_tasks[0]);
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  size_t num_tasks = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    OK_OR_RETURN(chunk_statuses[i]);
+    num_tasks += chunk_tasks[i].size();
+  }
+  std::vector<TaskOutput> tasks;
+  tasks.reserve(num_tasks);
+  for (std::vector<TaskOutput>& chunk : chunk_tasks) {
+    std::move(chunk.begin(), chunk.end(), std::back_inserter(tasks));
+  }
+  return tasks;
 }
 
 //------------------------------------------------------------------------------
@@ -223,11 +434,18 @@ StatusOr<std::vector<TaskInput>> PlanTasks(
       << "No specified input image file path";
   CHECK_OR_RETURN(!settings.codec_settings.empty(), settings.quiet)
       << "No specified codec";
+  CHECK_OR_RETURN(settings.num_codec_threads > 0, settings.quiet)
+      << "The number of codec threads must be at least 1";
+  CHECK_OR_RETURN(settings.timing.max_relative_error >= 0 &&
+                      settings.timing.max_seconds >= 0,
+                  settings.quiet)
+      << "The timing repetition settings must not be negative";
 
   std::vector<TaskInput> tasks;
   tasks.reserve(settings.codec_settings.size() * image_paths.size() *
                 (1 + settings.num_repetitions));
-  for (const CodecSettings& codec_settings : settings.codec_settings) {
+  for (CodecSettings codec_settings : settings.codec_settings) {
+    codec_settings.num_threads = settings.num_codec_threads;
     for (const std::string& image_path : image_paths) {
       const std::string encoded_file_path = GetEncodedFilePath(
           settings.encoded_folder_path, image_path, codec_settings);
@@ -240,10 +458,64 @@ StatusOr<std::vector<TaskInput>> PlanTasks(
   return tasks;
 }
 
+void AnnotateImageHeaders(
+    size_t num_threads,
+    const std::unordered_map<std::string, ImageHeader>& known_headers,
+    std::vector<TaskInput>& tasks) {
+  std::vector<std::string> image_paths;
+  image_paths.reserve(tasks.size());
+  for (const TaskInput& task : tasks) {
+    if (known_headers.count(task.image_path) == 0) {
+      image_paths.push_back(task.image_path);
+    }
+  }
+  const std::unordered_map<std::string, ImageHeader> headers =
+      ProbeImageHeaders(image_paths, num_threads);
+  for (TaskInput& task : tasks) {
+    const auto known_header = known_headers.find(task.image_path);
+    task.image_header = known_header != known_headers.end()
+                            ? known_header->second
+                            : headers.at(task.image_path);
+  }
+}
+
+bool IsKnownUnsupported(const TaskInput& task) {
+  // A lossless 16-bit image is spread to twice as many 8-bit samples instead.
+  return task.image_header.bit_depth > 8 &&
+         task.codec_settings.quality != kQualityLossless &&
+         !CodecSupportsBitDepth(task.codec_settings.codec,
+                                task.image_header.bit_depth);
+}
+
+void GroupTasksByImage(std::mt19937* rng, std::vector<TaskInput>& tasks) {
+  std::vector<std::vector<TaskInput>> batches;
+  std::unordered_map<std::string, size_t> image_path_to_batch_index;
+  for (TaskInput& task : tasks) {
+    const auto [it, was_inserted] =
+        image_path_to_batch_index.insert({task.image_path, batches.size()});
+    if (was_inserted) batches.emplace_back();
+    batches[it->second].push_back(std::move(task));
+  }
+
+  if (rng != nullptr) {
+    std::shuffle(batches.begin(), batches.end(), *rng);
+    for (std::vector<TaskInput>& batch : batches) {
+      std::shuffle(batch.begin(), batch.end(), *rng);
+    }
+  }
+
+  tasks.clear();
+  for (std::vector<TaskInput>& batch : batches) {
+    for (TaskInput& task : batch) tasks.push_back(std::move(task));
+  }
+}
+
 namespace {
 
 // Returns true if a and b can be considered the same amount of loss.
 bool SameDistortion(float a, float b) {
+  if (std::isnan(a)) return std::isnan(b);  // kDistortionNotComputed
+  if (std::isnan(b)) return false;
   if (a >= kNoDistortion) return b >= kNoDistortion;
   if (b >= kNoDistortion) return false;
   return std::abs(a - b) < 0.001f;
@@ -266,40 +538,60 @@ bool TaskOutputsAreRepetitions(const TaskOutput& a, const TaskOutput& b) {
 }
 
 StatusOr<std::vector<TaskOutput>> AggregateResultsByImageAndQuality(
-    const std::vector<TaskOutput>& results, bool quiet) {
+    const std::vector<const TaskOutput*>& results,
+    TimingStatistic timing_statistic, bool quiet) {
   struct AggregatedTaskOutput {
     TaskOutput task_output;
-    uint32_t count;
+    std::vector<double> encoding_durations;
+    std::vector<double> decoding_durations;
+    std::vector<double> decoding_color_conversion_durations;
   };
-  std::unordered_map<std::string, std::unordered_map<int, AggregatedTaskOutput>>
+  // The keys point to the image paths of the results.
+  std::unordered_map<std::string_view,
+                     std::unordered_map<int, AggregatedTaskOutput>>
       image_and_quality_to_results;
-  for (const TaskOutput& result : results) {
+  for (const TaskOutput* result : results) {
     std::unordered_map<int, AggregatedTaskOutput>& quality_to_results =
-        image_and_quality_to_results[result.task_input.image_path];
-    auto [it, was_inserted] =
-        quality_to_results.emplace(result.task_input.codec_settings.quality,
-                                   AggregatedTaskOutput{result, /*count=*/1});
-    TaskOutput& task_output = it->second.task_output;
+        image_and_quality_to_results[result->task_input.image_path];
+    auto [it, was_inserted] = quality_to_results.emplace(
+        result->task_input.codec_settings.quality,
+        AggregatedTaskOutput{*result, {}, {}, {}});
+    AggregatedTaskOutput& aggregate = it->second;
     if (!was_inserted) {
-      CHECK_OR_RETURN(TaskOutputsAreRepetitions(task_output, result), quiet)
-          << task_output.Serialize() << " != " << result.Serialize();
-      task_output.encoding_duration += result.encoding_duration;
-      task_output.decoding_duration += result.decoding_duration;
-      task_output.decoding_color_conversion_duration +=
-          result.decoding_color_conversion_duration;
-      ++it->second.count;
+      CHECK_OR_RETURN(TaskOutputsAreRepetitions(aggregate.task_output, *result),
+                      quiet)
+          << aggregate.task_output.Serialize() << " != " << result->Serialize();
+      aggregate.task_output.encoding_usage.Add(result->encoding_usage);
+      aggregate.task_output.decoding_usage.Add(result->decoding_usage);
     }
+    aggregate.encoding_durations.push_back(result->encoding_duration);
+    aggregate.decoding_durations.push_back(result->decoding_duration);
+    aggregate.decoding_color_conversion_durations.push_back(
+        result->decoding_color_conversion_duration);
   }
 
   std::vector<TaskOutput> aggregated_results;
   aggregated_results.reserve(image_and_quality_to_results.size());
-  for (const auto& [image, qualities] : image_and_quality_to_results) {
-    for (const auto& [quality, aggregated_rows] : qualities) {
-      aggregated_results.push_back(aggregated_rows.task_output);
-      aggregated_results.back().encoding_duration /= aggregated_rows.count;
-      aggregated_results.back().decoding_duration /= aggregated_rows.count;
-      aggregated_results.back().decoding_color_conversion_duration /=
-          aggregated_rows.count;
+  for (auto& [image, qualities] : image_and_quality_to_results) {
+    for (auto& [quality, aggregate] : qualities) {
+      aggregated_results.push_back(std::move(aggregate.task_output));
+      TaskOutput& task = aggregated_results.back();
+      const uint32_t count =
+          static_cast<uint32_t>(aggregate.encoding_durations.size());
+      if (count > 1) {
+        task.encoding_duration_stddev =
+            StandardDeviation(aggregate.encoding_durations);
+        task.decoding_duration_stddev =
+            StandardDeviation(aggregate.decoding_durations);
+      }
+      task.encoding_duration =
+          AggregateDurations(aggregate.encoding_durations, timing_statistic);
+      task.decoding_duration =
+          AggregateDurations(aggregate.decoding_durations, timing_statistic);
+      task.decoding_color_conversion_duration = AggregateDurations(
+          aggregate.decoding_color_conversion_durations, timing_statistic);
+      task.encoding_usage.Divide(count);
+      task.decoding_usage.Divide(count);
     }
   }
   return aggregated_results;
@@ -307,36 +599,71 @@ StatusOr<std::vector<TaskOutput>> AggregateResultsByImageAndQuality(
 
 }  // namespace
 
-StatusOr<std::vector<std::vector<TaskOutput>>>
-SplitByCodecSettingsAndAggregateByImageAndQuality(
-    const std::vector<TaskOutput>& results, bool quiet) {
-  std::vector<std::vector<TaskOutput>> aggregated_results;
+double StandardDeviation(const std::vector<double>& durations) {
+  if (durations.size() < 2) return 0;
+  double mean = 0;
+  for (double duration : durations) mean += duration;
+  mean /= durations.size();
+  double sum_of_squares = 0;
+  for (double duration : durations) {
+    sum_of_squares += (duration - mean) * (duration - mean);
+  }
+  return std::sqrt(sum_of_squares / (durations.size() - 1));
+}
 
+double AggregateDurations(std::vector<double>& durations,
+                          TimingStatistic timing_statistic) {
+  if (timing_statistic == TimingStatistic::kMin) {
+    return *std::min_element(durations.begin(), durations.end());
+  }
+  if (timing_statistic == TimingStatistic::kMedian) {
+    const size_t middle = durations.size() / 2;
+    std::nth_element(durations.begin(), durations.begin() + middle,
+                     durations.end());
+    const double upper = durations[middle];
+    if (durations.size() % 2 != 0) return upper;
+    const double lower =
+        *std::max_element(durations.begin(), durations.begin() + middle);
+    return (lower + upper) / 2;
+  }
+  double sum = 0;
+  for (double duration : durations) sum += duration;
+  return sum / durations.size();
+}
+
+double DurationPercentile(const std::vector<double>& sorted_durations,
+                          double ratio) {
+  const double rank = ratio * (sorted_durations.size() - 1);
+  const size_t lower = static_cast<size_t>(std::floor(rank));
+  const size_t upper = std::min(lower + 1, sorted_durations.size() - 1);
+  return sorted_durations[lower] +
+         (sorted_durations[upper] - sorted_durations[lower]) * (rank - lower);
+}
+
+Status ForEachCodecSettingsAggregatedByImageAndQuality(
+    const std::vector<const TaskOutput*>& results,
+    TimingStatistic timing_statistic, bool quiet,
+    const std::function<Status(const std::vector<TaskOutput>&)>& visit) {
   auto cmp = [](const CodecSettings& a, const CodecSettings& b) {
     // Multiple qualities can coexist in the same aggregate (meaning in the same
-    // output JSON single file). Only split by codec, chroma subsampling and
-    // effort.
-    return a.codec < b.codec ||
-           (a.codec == b.codec &&
-            a.chroma_subsampling < b.chroma_subsampling) ||
-           (a.codec == b.codec &&
-            a.chroma_subsampling == b.chroma_subsampling &&
-            a.effort < b.effort);
+    // output JSON single file). Only split by codec, chroma subsampling,
+    // effort and number of codec threads.
+    return std::tie(a.codec, a.chroma_subsampling, a.effort, a.num_threads) <
+           std::tie(b.codec, b.chroma_subsampling, b.effort, b.num_threads);
   };
-  std::map<CodecSettings, std::vector<TaskOutput>, decltype(cmp)> map(cmp);
-  for (const TaskOutput& result : results) {
-    map[result.task_input.codec_settings].push_back(result);
+  std::map<CodecSettings, std::vector<const TaskOutput*>, decltype(cmp)> map(
+      cmp);
+  for (const TaskOutput* result : results) {
+    map[result->task_input.codec_settings].push_back(result);
   }
 
-  aggregated_results.reserve(map.size());
   for (const auto& [codec_settings, results] : map) {
-    aggregated_results.push_back({});
-    std::vector<TaskOutput>& aggregate = aggregated_results.back();
-    ASSIGN_OR_RETURN(aggregate,
-                     AggregateResultsByImageAndQuality(results, quiet));
+    ASSIGN_OR_RETURN(std::vector<TaskOutput> aggregate,
+                     AggregateResultsByImageAndQuality(
+                         results, timing_statistic, quiet));
 
-    // codec, chroma subsampling and effort are the same in these results so
-    // only sort by original image name and quality.
+    // codec, chroma subsampling, effort and threads are the same in these
+    // results so only sort by original image name and quality.
     std::sort(aggregate.begin(), aggregate.end(),
               [](const TaskOutput& a, const TaskOutput& b) {
                 return a.task_input.image_path < b.task_input.image_path ||
@@ -344,7 +671,26 @@ SplitByCodecSettingsAndAggregateByImageAndQuality(
                         a.task_input.codec_settings.quality <
                             b.task_input.codec_settings.quality);
               });
+    OK_OR_RETURN(visit(aggregate));
   }
+  return Status::kOk;
+}
+
+StatusOr<std::vector<std::vector<TaskOutput>>>
+SplitByCodecSettingsAndAggregateByImageAndQuality(
+    const std::vector<TaskOutput>& results, TimingStatistic timing_statistic,
+    bool quiet) {
+  std::vector<const TaskOutput*> result_pointers;
+  result_pointers.reserve(results.size());
+  for (const TaskOutput& result : results) result_pointers.push_back(&result);
+
+  std::vector<std::vector<TaskOutput>> aggregated_results;
+  OK_OR_RETURN(ForEachCodecSettingsAggregatedByImageAndQuality(
+      result_pointers, timing_statistic, quiet,
+      [&](const std::vector<TaskOutput>& aggregate) {
+        aggregated_results.push_back(aggregate);
+        return Status::kOk;
+      }));
   return aggregated_results;
 }
 
@@ -17,26 +17,47 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "src/base.h"
 #include "src/framework.h"
+#include "src/image_header.h"
+#include "src/resource_usage.h"
 
 namespace codec_compare_gen {
 
 struct TaskInput {
+  TaskInput() = default;
+  // Not an aggregate so that image_header does not have to be listed.
+  TaskInput(const CodecSettings& codec_settings, std::string image_path,
+            std::string encoded_path = "")
+      : codec_settings(codec_settings),
+        image_path(std::move(image_path)),
+        encoded_path(std::move(encoded_path)) {}
+
   CodecSettings codec_settings;
   std::string image_path;    // Original image file path.
   std::string encoded_path;  // Encoded image file path.
                              // Can be empty to avoid saving to disk.
+  // Read from the file at planning time by AnnotateImageHeaders(). Unknown
+  // otherwise. Neither serialized nor compared.
+  ImageHeader image_header;
 
   std::string Serialize() const;
 };
 
 bool operator==(const TaskInput& a, const TaskInput& b);
 
+// Named optional column of the serialized TaskOutput, omitted if 1.
+constexpr const char kCodecThreadsColumn[] = "codec_threads";
+
 struct TaskOutput {
   TaskInput task_input;  // For convenience.
 
@@ -51,6 +72,20 @@ struct TaskOutput {
 
   float distortions[kNumDistortionMetrics];
 
+  // Only measured if ComparisonSettings::resource_usage asks for it.
+  ResourceUsage encoding_usage;
+  ResourceUsage decoding_usage;
+
+  // True if copied from a lower quality instead of being run. See
+  // QualitySearchSettings::prune_saturated.
+  bool is_extrapolated = false;
+
+  // Only set when aggregating repetitions: sample standard deviations of the
+  // durations above, in seconds. Negative means not aggregated. Not
+  // serialized.
+  double encoding_duration_stddev = -1;
+  double decoding_duration_stddev = -1;
+
   std::string Serialize() const;
   static StatusOr<TaskOutput> UnserializeNoDistortion(
       const std::string& serialized_task,
@@ -62,17 +97,72 @@ struct TaskOutput {
       bool quiet);
 };
 
+// Repeated in-memory decodings of an already encoded image, without any
+// encoding nor distortion. See BenchmarkDecoding().
+struct DecodingBenchmark {
+  // The encoded_size and the dimensions of the decoded image are set. The
+  // durations and the distortions are not.
+  TaskOutput task;
+  std::vector<double> decoding_durations;  // In seconds, sorted.
+};
+
+// Unserializes each line of serialized_tasks with TaskOutput::Unserialize(),
+// or with TaskOutput::UnserializeNoDistortion() if !with_distortions. Large
+// inputs are split into up to num_threads chunks parsed in parallel. The order
+// is kept.
+StatusOr<std::vector<TaskOutput>> UnserializeTaskOutputs(
+    std::string_view serialized_tasks,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, size_t num_threads, bool quiet);
+
 StatusOr<std::vector<TaskInput>> PlanTasks(
     const std::vector<std::string>& image_paths,
     const ComparisonSettings& settings);
 
+// Sets the image_header of each task, from known_headers or by probing the
+// other distinct images with up to num_threads threads. See ProbeImageHeader().
+void AnnotateImageHeaders(
+    size_t num_threads,
+    const std::unordered_map<std::string, ImageHeader>& known_headers,
+    std::vector<TaskInput>& tasks);
+// Returns true if the image_header of the task tells that the encoding would
+// fail once the image is decoded, such as a lossy 16-bit image for a codec
+// that only supports 8 bits. False means supported or unknown.
+bool IsKnownUnsupported(const TaskInput& task);
+
+// Reorders the tasks so that the ones sharing the same image_path are
+// contiguous. If rng is not null, the batches and the tasks within each batch
+// are shuffled. Otherwise the order of first occurrence is kept.
+void GroupTasksByImage(std::mt19937* rng, std::vector<TaskInput>& tasks);
+
 // Used for the map below.
 bool operator<(const CodecSettings& a, const CodecSettings& b);
 
-// Returns unique pairs of image,quality results grouped by codec,effort.
+// Returns the sample standard deviation of the durations, or 0 if fewer than 2.
+double StandardDeviation(const std::vector<double>& durations);
+// Returns the timing_statistic of the durations, which must not be empty.
+double AggregateDurations(std::vector<double>& durations,
+                          TimingStatistic timing_statistic);
+// Returns the duration below which that ratio in [0:1] of the durations fall,
+// linearly interpolated between the closest ranks. sorted_durations must be
+// sorted and not empty.
+double DurationPercentile(const std::vector<double>& sorted_durations,
+                          double ratio);
+
+// Returns unique pairs of image,quality results grouped by codec,effort. The
+// durations of the repetitions are aggregated with timing_statistic, the
+// resource usages are averaged.
 StatusOr<std::vector<std::vector<TaskOutput>>>
 SplitByCodecSettingsAndAggregateByImageAndQuality(
-    const std::vector<TaskOutput>& results, bool quiet);
+    const std::vector<TaskOutput>& results, TimingStatistic timing_statistic,
+    bool quiet);
+
+// Same as above but calls visit() for each codec,effort group instead, so that
+// only one aggregated group is in memory at a time. The results are not copied.
+Status ForEachCodecSettingsAggregatedByImageAndQuality(
+    const std::vector<const TaskOutput*>& results,
+    TimingStatistic timing_statistic, bool quiet,
+    const std::function<Status(const std::vector<TaskOutput>&)>& visit);
 
 }  // namespace codec_compare_gen
 
@@ -0,0 +1,373 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_binary.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/serialization.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+constexpr char kMagic[] = {'C', 'C', 'G', 'E', 'N', 'B', 'I', 'N'};
+constexpr uint32_t kVersion = 3;
+constexpr size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t);
+
+constexpr char kStringChunk = 'S';
+constexpr char kTaskChunk = 'T';
+// Optional, precedes the task chunk it belongs to, so that a file cut between
+// the two cannot be read as a complete record without its usage.
+constexpr char kUsageChunk = 'U';
+// Optional and empty, precedes the task chunk it belongs to, after the usage
+// chunk if any.
+constexpr char kExtrapolatedChunk = 'X';
+// Codec name, subsampling, effort, quality, codec threads, image path,
+// image_width, image_height, bit_depth, num_frames, encoded path, encoded_size,
+// durations and distortions.
+constexpr size_t kRecordSize = 11 * sizeof(uint32_t) + sizeof(uint64_t) +
+                               3 * sizeof(double) +
+                               kNumDistortionMetrics * sizeof(float);
+// CPU time and hardware counters of the encoding, then of the decoding.
+constexpr size_t kUsageRecordSize =
+    2 * (sizeof(double) + 4 * sizeof(int64_t));
+
+template <typename T>
+void Put(T value, std::string& bytes) {
+  char value_bytes[sizeof(T)];
+  std::memcpy(value_bytes, &value, sizeof(T));
+  bytes.append(value_bytes, sizeof(T));
+}
+
+// No alignment is required.
+template <typename T>
+T Get(const char*& data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  data += sizeof(T);
+  return value;
+}
+
+struct Record {
+  const char* task;
+  const char* usage;  // Can be null.
+  bool is_extrapolated;
+};
+
+// Splits the contents into strings and records. A run interrupted while
+// appending a record leaves it incomplete at the end of the contents: it is
+// ignored and complete_size is set to the size of what precedes it.
+Status ParseChunks(std::string_view contents,
+                   std::vector<std::string_view>& strings,
+                   std::vector<Record>& records, size_t& complete_size,
+                   bool quiet) {
+  CHECK_OR_RETURN(contents.size() >= kHeaderSize &&
+                      std::memcmp(contents.data(), kMagic, sizeof(kMagic)) == 0,
+                  quiet)
+      << "Not a binary tasks file";
+  const char* data = contents.data() + sizeof(kMagic);
+  const uint32_t version = Get<uint32_t>(data);
+  CHECK_OR_RETURN(version == kVersion, quiet)
+      << "Unsupported binary tasks file version " << version
+      << " (or byte order)";
+  const uint32_t num_distortion_metrics = Get<uint32_t>(data);
+  CHECK_OR_RETURN(num_distortion_metrics == kNumDistortionMetrics, quiet)
+      << "Expected " << kNumDistortionMetrics
+      << " distortion metrics in binary tasks file but found "
+      << num_distortion_metrics;
+
+  const char* end = contents.data() + contents.size();
+  // Start of the first incomplete chunk, if any.
+  const char* truncated = nullptr;
+  // Usage and extrapolated chunks waiting for the task chunk they belong to.
+  const char* pending_start = nullptr;
+  const char* pending_usage = nullptr;
+  bool pending_extrapolated = false;
+  while (data < end) {
+    const char* chunk_start = data;
+    const char chunk = *data++;
+    if (chunk == kStringChunk) {
+      CHECK_OR_RETURN(pending_start == nullptr, quiet)
+          << "Unexpected string chunk in binary tasks file";
+      if (static_cast<size_t>(end - data) < sizeof(uint32_t)) {
+        truncated = chunk_start;
+        break;
+      }
+      const uint32_t length = Get<uint32_t>(data);
+      if (static_cast<size_t>(end - data) < length) {
+        truncated = chunk_start;
+        break;
+      }
+      strings.emplace_back(data, length);
+      data += length;
+    } else if (chunk == kTaskChunk) {
+      if (static_cast<size_t>(end - data) < kRecordSize) {
+        // The pending chunks belong to the record and are dropped with it.
+        truncated = pending_start != nullptr ? pending_start : chunk_start;
+        break;
+      }
+      records.push_back({data, pending_usage, pending_extrapolated});
+      data += kRecordSize;
+      pending_start = nullptr;
+      pending_usage = nullptr;
+      pending_extrapolated = false;
+    } else if (chunk == kUsageChunk) {
+      CHECK_OR_RETURN(pending_start == nullptr, quiet)
+          << "Unexpected usage chunk in binary tasks file";
+      if (static_cast<size_t>(end - data) < kUsageRecordSize) {
+        truncated = chunk_start;
+        break;
+      }
+      pending_start = chunk_start;
+      pending_usage = data;
+      data += kUsageRecordSize;
+    } else if (chunk == kExtrapolatedChunk) {
+      CHECK_OR_RETURN(!pending_extrapolated, quiet)
+          << "Unexpected extrapolated chunk in binary tasks file";
+      if (pending_start == nullptr) pending_start = chunk_start;
+      pending_extrapolated = true;
+    } else {
+      CHECK_OR_RETURN(false, quiet)
+          << "Unknown chunk at byte " << (data - 1 - contents.data())
+          << " of binary tasks file";
+    }
+  }
+  if (truncated == nullptr && pending_start != nullptr) {
+    // The file was cut right before the task chunk of the pending chunks.
+    truncated = pending_start;
+  }
+  complete_size = truncated == nullptr
+                      ? contents.size()
+                      : static_cast<size_t>(truncated - contents.data());
+  if (truncated != nullptr && !quiet) {
+    std::cout << "Ignoring the incomplete last "
+              << (contents.size() - complete_size)
+              << " bytes of the binary tasks file" << std::endl;
+  }
+  return Status::kOk;
+}
+
+void PutUsage(const ResourceUsage& usage, std::string& bytes) {
+  Put(usage.cpu_time, bytes);
+  Put(usage.cycles, bytes);
+  Put(usage.instructions, bytes);
+  Put(usage.cache_misses, bytes);
+  Put(usage.peak_memory, bytes);
+}
+
+ResourceUsage GetUsage(const char*& data) {
+  ResourceUsage usage;
+  usage.cpu_time = Get<double>(data);
+  usage.cycles = Get<int64_t>(data);
+  usage.instructions = Get<int64_t>(data);
+  usage.cache_misses = Get<int64_t>(data);
+  usage.peak_memory = Get<int64_t>(data);
+  return usage;
+}
+
+StatusOr<TaskOutput> UnserializeRecord(
+    const Record& record, size_t record_index,
+    const std::vector<std::string_view>& strings,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, bool quiet) {
+  const char* data = record.task;
+  auto get_string = [&](std::string& str) {
+    const uint32_t id = Get<uint32_t>(data);
+    if (id >= strings.size()) return false;
+    str = strings[id];
+    return true;
+  };
+
+  TaskOutput task;
+  CodecSettings& codec_settings = task.task_input.codec_settings;
+  std::string codec_name, subsampling;
+  CHECK_OR_RETURN(get_string(codec_name) && get_string(subsampling), quiet)
+      << "Unknown string in binary task #" << record_index;
+  ASSIGN_OR_RETURN(codec_settings.codec, CodecFromName(codec_name, quiet));
+  const size_t codec_index = static_cast<size_t>(codec_settings.codec);
+  CHECK_OR_RETURN(codec_index < qualities_per_codec.size(), quiet);
+  const std::unordered_set<int>& qualities = qualities_per_codec[codec_index];
+  ASSIGN_OR_RETURN(codec_settings.chroma_subsampling,
+                   SubsamplingFromString(subsampling, quiet));
+
+  codec_settings.effort = Get<int32_t>(data);
+  CHECK_OR_RETURN(codec_settings.effort >= 0 &&
+                      (codec_settings.effort <= 10 ||
+                       (codec_settings.codec == Codec::kJpegXl &&
+                        codec_settings.effort <= 11)),
+                  quiet)
+      << "Unknown effort in binary task #" << record_index;
+  codec_settings.quality = Get<int32_t>(data);
+  CHECK_OR_RETURN(codec_settings.quality == kQualityLossless ||
+                      qualities.find(codec_settings.quality) != qualities.end(),
+                  quiet)
+      << "Unknown quality in binary task #" << record_index;
+  codec_settings.num_threads = Get<uint32_t>(data);
+  CHECK_OR_RETURN(codec_settings.num_threads > 0, quiet)
+      << "Bad codec threads in binary task #" << record_index;
+
+  CHECK_OR_RETURN(get_string(task.task_input.image_path), quiet)
+      << "Unknown image path in binary task #" << record_index;
+  task.image_width = Get<uint32_t>(data);
+  task.image_height = Get<uint32_t>(data);
+  task.bit_depth = Get<uint32_t>(data);
+  task.num_frames = Get<uint32_t>(data);
+  CHECK_OR_RETURN(task.image_width > 0 && task.image_height > 0 &&
+                      task.bit_depth > 0 && task.num_frames > 0,
+                  quiet)
+      << "Bad image dimensions in binary task #" << record_index;
+
+  CHECK_OR_RETURN(get_string(task.task_input.encoded_path), quiet)
+      << "Unknown encoded path in binary task #" << record_index;
+  task.encoded_size = static_cast<size_t>(Get<uint64_t>(data));
+  CHECK_OR_RETURN(task.encoded_size > 0, quiet)
+      << "Bad encoded size in binary task #" << record_index;
+  task.encoding_duration = Get<double>(data);
+  task.decoding_duration = Get<double>(data);
+  task.decoding_color_conversion_duration = Get<double>(data);
+  CHECK_OR_RETURN(task.encoding_duration > 0 && task.decoding_duration > 0 &&
+                      task.decoding_color_conversion_duration >= 0,
+                  quiet)
+      << "Bad duration in binary task #" << record_index;
+
+  for (float& distortion : task.distortions) {
+    distortion = with_distortions ? Get<float>(data) : kDistortionNotComputed;
+  }
+
+  if (record.usage != nullptr) {
+    const char* usage_data = record.usage;
+    task.encoding_usage = GetUsage(usage_data);
+    task.decoding_usage = GetUsage(usage_data);
+  }
+  task.is_extrapolated = record.is_extrapolated;
+  return task;
+}
+
+}  // namespace
+
+bool IsBinaryTasksFilePath(const std::string& file_path) {
+  return std::filesystem::path(file_path).extension() ==
+         kBinaryTasksFileExtension;
+}
+
+std::string BinaryTaskEncoder::Header() {
+  std::string bytes(kMagic, sizeof(kMagic));
+  Put(kVersion, bytes);
+  Put(static_cast<uint32_t>(kNumDistortionMetrics), bytes);
+  return bytes;
+}
+
+StatusOr<size_t> BinaryTaskEncoder::Resume(std::string_view contents,
+                                           bool quiet) {
+  CHECK_OR_RETURN(string_ids_.empty(), quiet);
+  std::vector<std::string_view> strings;
+  std::vector<Record> records;
+  size_t complete_size;
+  OK_OR_RETURN(ParseChunks(contents, strings, records, complete_size, quiet));
+  for (size_t id = 0; id < strings.size(); ++id) {
+    string_ids_.insert({std::string(strings[id]), static_cast<uint32_t>(id)});
+  }
+  // Duplicates would shift the ids of the next strings.
+  CHECK_OR_RETURN(string_ids_.size() == strings.size(), quiet)
+      << "Duplicate strings in binary tasks file";
+  return complete_size;
+}
+
+uint32_t BinaryTaskEncoder::GetStringId(const std::string& str,
+                                        std::string& bytes) {
+  const auto [it, was_inserted] =
+      string_ids_.insert({str, static_cast<uint32_t>(string_ids_.size())});
+  if (was_inserted) {
+    bytes += kStringChunk;
+    Put(static_cast<uint32_t>(str.size()), bytes);
+    bytes += str;
+  }
+  return it->second;
+}
+
+std::string BinaryTaskEncoder::Encode(const TaskOutput& task) {
+  const CodecSettings& codec_settings = task.task_input.codec_settings;
+  std::string bytes;
+  const uint32_t codec_id = GetStringId(CodecName(codec_settings.codec), bytes);
+  const uint32_t subsampling_id = GetStringId(
+      SubsamplingToString(codec_settings.chroma_subsampling), bytes);
+  const uint32_t image_path_id =
+      GetStringId(task.task_input.image_path, bytes);
+  const uint32_t encoded_path_id =
+      GetStringId(task.task_input.encoded_path, bytes);
+
+  if (task.encoding_usage.IsMeasured() || task.decoding_usage.IsMeasured()) {
+    bytes += kUsageChunk;
+    PutUsage(task.encoding_usage, bytes);
+    PutUsage(task.decoding_usage, bytes);
+  }
+  if (task.is_extrapolated) bytes += kExtrapolatedChunk;
+
+  bytes.reserve(bytes.size() + 1 + kRecordSize);
+  bytes += kTaskChunk;
+  Put(codec_id, bytes);
+  Put(subsampling_id, bytes);
+  Put(static_cast<int32_t>(codec_settings.effort), bytes);
+  Put(static_cast<int32_t>(codec_settings.quality), bytes);
+  Put(codec_settings.num_threads, bytes);
+  Put(image_path_id, bytes);
+  Put(task.image_width, bytes);
+  Put(task.image_height, bytes);
+  Put(task.bit_depth, bytes);
+  Put(task.num_frames, bytes);
+  Put(encoded_path_id, bytes);
+  Put(static_cast<uint64_t>(task.encoded_size), bytes);
+  Put(task.encoding_duration, bytes);
+  Put(task.decoding_duration, bytes);
+  Put(task.decoding_color_conversion_duration, bytes);
+  for (float distortion : task.distortions) Put(distortion, bytes);
+  return bytes;
+}
+
+StatusOr<std::vector<TaskOutput>> UnserializeBinaryTaskOutputs(
+    std::string_view contents,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, bool quiet) {
+  std::vector<std::string_view> strings;
+  std::vector<Record> records;
+  size_t complete_size;
+  OK_OR_RETURN(ParseChunks(contents, strings, records, complete_size, quiet));
+
+  std::vector<TaskOutput> tasks;
+  tasks.reserve(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSIGN_OR_RETURN(TaskOutput task,
+                     UnserializeRecord(records[i], i, strings,
+                                       qualities_per_codec, with_distortions,
+                                       quiet));
+    tasks.push_back(std::move(task));
+  }
+  return tasks;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,79 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TASK_BINARY_H_
+#define SRC_TASK_BINARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Alternative to the CSV format of TaskOutput::Serialize() for progress files.
+// The file starts with a header followed by an append-only list of chunks:
+//   - a string (codec name, chroma subsampling, image or encoded path) stored
+//     once and then referred to by its index in the order of appearance,
+//   - optionally, the resource usage of the following record,
+//   - optionally, an empty chunk marking the following record as extrapolated,
+//   - a fixed-width record of all TaskOutput fields, the strings being
+//     referred to by index.
+// The record comes last so that an interrupted run cannot leave a record that
+// looks complete but misses its optional chunks.
+// Numbers are stored in the byte order of the host, which is checked through
+// the header. The whole file can be read from a memory mapping.
+
+// Progress files with this extension use the binary format.
+constexpr const char kBinaryTasksFileExtension[] = ".ccgenbin";
+bool IsBinaryTasksFilePath(const std::string& file_path);
+
+// Not thread-safe.
+class BinaryTaskEncoder {
+ public:
+  // Returns the bytes starting any binary tasks file.
+  static std::string Header();
+
+  // Registers the strings already stored in the contents of an existing
+  // binary tasks file, so that the output of Encode() can be appended to it.
+  // Returns the size the file must be truncated to first, which excludes its
+  // last record if a run was interrupted while appending it.
+  StatusOr<size_t> Resume(std::string_view contents, bool quiet);
+
+  // Returns the bytes to append to store the task: the strings that were not
+  // stored yet followed by the record.
+  std::string Encode(const TaskOutput& task);
+
+ private:
+  uint32_t GetStringId(const std::string& str, std::string& bytes);
+
+  std::unordered_map<std::string, uint32_t> string_ids_;
+};
+
+// Same as UnserializeTaskOutputs() for the contents of a binary tasks file.
+// An incomplete last record is ignored.
+StatusOr<std::vector<TaskOutput>> UnserializeBinaryTaskOutputs(
+    std::string_view contents,
+    const std::vector<std::unordered_set<int>>& qualities_per_codec,
+    bool with_distortions, bool quiet);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_TASK_BINARY_H_
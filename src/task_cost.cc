@@ -0,0 +1,131 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_cost.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/image_header.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+TaskCostModel::TaskCostModel(const std::vector<TaskOutput>& completed_tasks) {
+  std::map<std::pair<Codec, int>, Rate> codec_effort_rates;
+  std::map<Codec, Rate> codec_rates;
+  Rate rate;
+  for (const TaskOutput& task : completed_tasks) {
+    const CodecSettings& settings = task.task_input.codec_settings;
+    const double num_pixels = static_cast<double>(task.image_width) *
+                              task.image_height *
+                              std::max(task.num_frames, 1u);
+    const double num_seconds =
+        std::max(task.encoding_duration, 0.) +
+        std::max(task.decoding_duration, 0.);
+    if (num_pixels <= 0 || num_seconds <= 0) continue;
+    image_num_pixels_[task.task_input.image_path] = num_pixels;
+    for (Rate* r : {&codec_effort_rates[{settings.codec, settings.effort}],
+                    &codec_rates[settings.codec], &rate}) {
+      r->num_seconds += num_seconds;
+      r->num_pixels += num_pixels;
+    }
+  }
+
+  for (const auto& [key, r] : codec_effort_rates) {
+    codec_effort_seconds_per_pixel_[key] = r.num_seconds / r.num_pixels;
+  }
+  for (const auto& [codec, r] : codec_rates) {
+    codec_seconds_per_pixel_[codec] = r.num_seconds / r.num_pixels;
+  }
+  if (rate.num_pixels > 0) {
+    num_seconds_per_pixel_ = rate.num_seconds / rate.num_pixels;
+  }
+  if (!image_num_pixels_.empty()) {
+    double sum = 0;
+    for (const auto& [image_path, num_pixels] : image_num_pixels_) {
+      sum += num_pixels;
+    }
+    average_image_num_pixels_ = sum / image_num_pixels_.size();
+  }
+}
+
+double TaskCostModel::Estimate(const TaskInput& task) const {
+  const auto image = image_num_pixels_.find(task.image_path);
+  const ImageHeader& header = task.image_header;
+  const double num_pixels =
+      image != image_num_pixels_.end() ? image->second
+      : header.IsKnown() ? static_cast<double>(header.width) * header.height *
+                               header.num_frames
+                         : average_image_num_pixels_;
+  const CodecSettings& settings = task.codec_settings;
+  const auto codec_effort =
+      codec_effort_seconds_per_pixel_.find({settings.codec, settings.effort});
+  if (codec_effort != codec_effort_seconds_per_pixel_.end()) {
+    return codec_effort->second * num_pixels;
+  }
+  const auto codec = codec_seconds_per_pixel_.find(settings.codec);
+  if (codec != codec_seconds_per_pixel_.end()) {
+    return codec->second * num_pixels;
+  }
+  return num_seconds_per_pixel_ * num_pixels;
+}
+
+void SortByDecreasingCost(const TaskCostModel& model, std::mt19937* rng,
+                          std::vector<TaskInput>& tasks) {
+  std::vector<std::pair<double, size_t>> costs;  // With the task indices.
+  costs.reserve(tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    costs.emplace_back(model.Estimate(tasks[i]), i);
+  }
+  std::stable_sort(costs.begin(), costs.end(),
+                   [](const std::pair<double, size_t>& a,
+                      const std::pair<double, size_t>& b) {
+                     return a.first > b.first;
+                   });
+
+  if (rng != nullptr) {
+    // Same bucket if the integral part of log2(cost) is the same.
+    const auto bucket = [](double cost) {
+      return cost > 0 ? std::ilogb(cost) : std::numeric_limits<int>::min();
+    };
+    for (auto begin = costs.begin(); begin != costs.end();) {
+      const int begin_bucket = bucket(begin->first);
+      const auto end = std::find_if(
+          begin, costs.end(), [&](const std::pair<double, size_t>& cost) {
+            return bucket(cost.first) != begin_bucket;
+          });
+      std::shuffle(begin, end, *rng);
+      begin = end;
+    }
+  }
+
+  std::vector<TaskInput> sorted_tasks;
+  sorted_tasks.reserve(tasks.size());
+  for (const auto& [cost, index] : costs) {
+    sorted_tasks.push_back(std::move(tasks[index]));
+  }
+  tasks = std::move(sorted_tasks);
+}
+
+}  // namespace codec_compare_gen
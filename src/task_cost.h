@@ -0,0 +1,67 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TASK_COST_H_
+#define SRC_TASK_COST_H_
+
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Estimates the duration of tasks from the encoding and decoding durations of
+// completed ones, per pixel for each codec and effort.
+class TaskCostModel {
+ public:
+  explicit TaskCostModel(const std::vector<TaskOutput>& completed_tasks);
+
+  // Returns true if no completed task had any duration.
+  bool IsEmpty() const { return num_seconds_per_pixel_ <= 0; }
+  // Returns the expected duration in seconds of one encoding and decoding of
+  // the task. The number of pixels of an image not among the completed tasks
+  // is read from its TaskInput::image_header, or assumed to be the average one
+  // if unknown.
+  double Estimate(const TaskInput& task) const;
+
+ private:
+  struct Rate {
+    double num_seconds = 0;
+    double num_pixels = 0;
+  };
+
+  // Falls back to any effort of the codec, then to any codec.
+  std::map<std::pair<Codec, int>, double> codec_effort_seconds_per_pixel_;
+  std::map<Codec, double> codec_seconds_per_pixel_;
+  double num_seconds_per_pixel_ = 0;
+  std::unordered_map<std::string, double> image_num_pixels_;
+  double average_image_num_pixels_ = 1;
+};
+
+// Sorts the tasks by decreasing estimated cost so that the longest ones start
+// first and do not end last on a single thread. The tasks whose costs are
+// within the same power of two are shuffled if rng is not null, for fair
+// timings.
+void SortByDecreasingCost(const TaskCostModel& model, std::mt19937* rng,
+                          std::vector<TaskInput>& tasks);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_TASK_COST_H_
@@ -0,0 +1,292 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_diff.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+// The codec configuration, as in the name of a JSON result file.
+using GroupKey = std::tuple<Codec, Subsampling, int, uint32_t, bool>;
+// The image path and the quality, within a GroupKey.
+using TaskKey = std::pair<std::string, int>;
+
+// Repetitions of a TaskInput run by one build.
+struct Repetitions {
+  std::vector<double> encoding_durations;
+  std::vector<double> decoding_durations;
+  double encoded_size_sum = 0;
+  double distortion_sum = 0;
+  size_t num_distortions = 0;  // The other repetitions did not compute it.
+
+  size_t size() const { return encoding_durations.size(); }
+};
+
+using Builds = std::array<Repetitions, 2>;  // Old and new.
+
+double Mean(const std::vector<double>& values) {
+  double sum = 0;
+  for (double value : values) sum += value;
+  return sum / values.size();
+}
+
+bool IsValidDistortion(float distortion) {
+  return !std::isnan(distortion) && distortion != kNoDistortion;
+}
+
+// Accumulates the log-ratios of the mean durations of several tasks.
+class DurationDeltaBuilder {
+ public:
+  void Add(const std::vector<double>& old_durations,
+           const std::vector<double>& new_durations) {
+    const double old_mean = Mean(old_durations);
+    const double new_mean = Mean(new_durations);
+    if (old_mean <= 0 || new_mean <= 0) return;  // Not measured.
+    sum_log_ratios_ += std::log(new_mean / old_mean);
+    if (old_durations.size() < 2 || new_durations.size() < 2) {
+      all_repeated_ = false;
+    } else {
+      // Variance of the log of each mean, by the delta method.
+      const double old_stddev = StandardDeviation(old_durations) / old_mean;
+      const double new_stddev = StandardDeviation(new_durations) / new_mean;
+      sum_variances_ += old_stddev * old_stddev / old_durations.size() +
+                        new_stddev * new_stddev / new_durations.size();
+    }
+    ++num_tasks_;
+  }
+
+  DurationDelta Build(double z_score) const {
+    DurationDelta delta;
+    if (num_tasks_ == 0) return delta;
+    delta.ratio = std::exp(sum_log_ratios_ / num_tasks_);
+    if (all_repeated_) {
+      delta.relative_error =
+          z_score * std::sqrt(sum_variances_) / num_tasks_;
+    }
+    return delta;
+  }
+
+ private:
+  double sum_log_ratios_ = 0;
+  double sum_variances_ = 0;
+  bool all_repeated_ = true;
+  size_t num_tasks_ = 0;
+};
+
+// Returns the points sorted by distortion, with the sizes of equal
+// distortions averaged and replaced by their logarithm.
+std::vector<std::pair<double, double>> ToLogCurve(
+    std::vector<std::pair<double, double>> points) {
+  std::sort(points.begin(), points.end());
+  std::vector<std::pair<double, double>> curve;
+  size_t num_merged = 0;
+  for (const auto& [distortion, size] : points) {
+    if (size <= 0) continue;
+    if (!curve.empty() && curve.back().first == distortion) {
+      curve.back().second += std::log(size);
+      ++num_merged;
+      continue;
+    }
+    if (num_merged > 0) curve.back().second /= num_merged + 1;
+    num_merged = 0;
+    curve.emplace_back(distortion, std::log(size));
+  }
+  if (num_merged > 0) curve.back().second /= num_merged + 1;
+  return curve;
+}
+
+// Returns the piecewise linear interpolation of the curve at distortion, which
+// must be within the range of the curve.
+double Interpolate(const std::vector<std::pair<double, double>>& curve,
+                   double distortion) {
+  auto next = std::lower_bound(
+      curve.begin(), curve.end(), distortion,
+      [](const std::pair<double, double>& point, double value) {
+        return point.first < value;
+      });
+  if (next == curve.begin()) return next->second;
+  if (next == curve.end()) return curve.back().second;
+  const auto previous = next - 1;
+  const double t =
+      (distortion - previous->first) / (next->first - previous->first);
+  return previous->second + t * (next->second - previous->second);
+}
+
+}  // namespace
+
+bool DurationDelta::IsSignificant() const {
+  return relative_error < 0 || std::abs(std::log(ratio)) > relative_error;
+}
+
+bool TaskDiff::HasRegression() const {
+  return std::any_of(
+      codec_settings.begin(), codec_settings.end(),
+      [](const CodecSettingsDiff& diff) { return diff.is_regression; });
+}
+
+double BjontegaardDeltaRate(std::vector<std::pair<double, double>> old_points,
+                            std::vector<std::pair<double, double>> new_points) {
+  constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<std::pair<double, double>> old_curve =
+      ToLogCurve(std::move(old_points));
+  const std::vector<std::pair<double, double>> new_curve =
+      ToLogCurve(std::move(new_points));
+  if (old_curve.size() < 2 || new_curve.size() < 2) return kNaN;
+  const double min_distortion =
+      std::max(old_curve.front().first, new_curve.front().first);
+  const double max_distortion =
+      std::min(old_curve.back().first, new_curve.back().first);
+  if (min_distortion >= max_distortion) return kNaN;
+
+  // The difference of both curves is linear between their joint points, so
+  // the trapezoidal rule is exact.
+  std::vector<double> distortions = {min_distortion, max_distortion};
+  for (const auto* curve : {&old_curve, &new_curve}) {
+    for (const auto& point : *curve) {
+      if (point.first > min_distortion && point.first < max_distortion) {
+        distortions.push_back(point.first);
+      }
+    }
+  }
+  std::sort(distortions.begin(), distortions.end());
+  double integral = 0;
+  double previous_difference = 0;
+  for (size_t i = 0; i < distortions.size(); ++i) {
+    const double difference = Interpolate(new_curve, distortions[i]) -
+                              Interpolate(old_curve, distortions[i]);
+    if (i > 0) {
+      integral += (distortions[i] - distortions[i - 1]) *
+                  (difference + previous_difference) / 2;
+    }
+    previous_difference = difference;
+  }
+  return std::exp(integral / (max_distortion - min_distortion)) - 1;
+}
+
+StatusOr<TaskDiff> DiffTasks(const std::vector<TaskOutput>& old_tasks,
+                             const std::vector<TaskOutput>& new_tasks,
+                             const TaskDiffSettings& settings, bool quiet) {
+  CHECK_OR_RETURN(!old_tasks.empty() && !new_tasks.empty(), quiet)
+      << "Nothing to compare";
+  const size_t metric = static_cast<size_t>(settings.metric);
+
+  std::map<GroupKey, std::map<TaskKey, Builds>> groups;
+  for (size_t build = 0; build < 2; ++build) {
+    for (const TaskOutput& task : build == 0 ? old_tasks : new_tasks) {
+      if (task.is_extrapolated) continue;
+      const CodecSettings& codec_settings = task.task_input.codec_settings;
+      const GroupKey group_key = {
+          codec_settings.codec, codec_settings.chroma_subsampling,
+          codec_settings.effort, codec_settings.num_threads,
+          codec_settings.quality == kQualityLossless};
+      Repetitions& repetitions =
+          groups[group_key][{task.task_input.image_path,
+                             codec_settings.quality}][build];
+      repetitions.encoding_durations.push_back(task.encoding_duration);
+      repetitions.decoding_durations.push_back(task.decoding_duration);
+      repetitions.encoded_size_sum += task.encoded_size;
+      if (IsValidDistortion(task.distortions[metric])) {
+        repetitions.distortion_sum += task.distortions[metric];
+        ++repetitions.num_distortions;
+      }
+    }
+  }
+
+  TaskDiff diff;
+  for (const auto& [group_key, tasks] : groups) {
+    CodecSettingsDiff group;
+    std::tie(group.codec, group.chroma_subsampling, group.effort,
+             group.num_threads, group.lossless) = group_key;
+    DurationDeltaBuilder encoding;
+    DurationDeltaBuilder decoding;
+    double sum_log_size_ratios = 0;
+    size_t num_size_ratios = 0;
+    // Points of each build for the BD-rate of each image.
+    std::map<std::string, std::array<std::vector<std::pair<double, double>>, 2>>
+        curves;
+    for (const auto& [task_key, builds] : tasks) {
+      if (builds[0].size() == 0) {
+        ++diff.num_new_only_tasks;
+        continue;
+      }
+      if (builds[1].size() == 0) {
+        ++diff.num_old_only_tasks;
+        continue;
+      }
+      ++group.num_tasks;
+      encoding.Add(builds[0].encoding_durations, builds[1].encoding_durations);
+      decoding.Add(builds[0].decoding_durations, builds[1].decoding_durations);
+      const double old_size = builds[0].encoded_size_sum / builds[0].size();
+      const double new_size = builds[1].encoded_size_sum / builds[1].size();
+      if (old_size > 0 && new_size > 0) {
+        sum_log_size_ratios += std::log(new_size / old_size);
+        ++num_size_ratios;
+      }
+      if (!group.lossless) {
+        for (size_t build = 0; build < 2; ++build) {
+          const Repetitions& repetitions = builds[build];
+          if (repetitions.num_distortions == 0) continue;
+          curves[task_key.first][build].emplace_back(
+              repetitions.distortion_sum / repetitions.num_distortions,
+              repetitions.encoded_size_sum / repetitions.size());
+        }
+      }
+    }
+    if (group.num_tasks == 0) continue;
+    group.encoding = encoding.Build(settings.z_score);
+    group.decoding = decoding.Build(settings.z_score);
+    if (num_size_ratios > 0) {
+      group.size_ratio = std::exp(sum_log_size_ratios / num_size_ratios);
+    }
+    double sum_bd_rates = 0;
+    for (const auto& [image_path, image_curves] : curves) {
+      const double bd_rate =
+          BjontegaardDeltaRate(image_curves[0], image_curves[1]);
+      if (std::isnan(bd_rate)) continue;
+      sum_bd_rates += bd_rate;
+      ++group.num_bd_rate_images;
+    }
+    group.bd_rate = group.num_bd_rate_images > 0
+                        ? sum_bd_rates / group.num_bd_rate_images
+                        : std::numeric_limits<double>::quiet_NaN();
+
+    group.is_regression =
+        (group.encoding.ratio - 1 > settings.max_encoding_slowdown &&
+         group.encoding.IsSignificant()) ||
+        (group.decoding.ratio - 1 > settings.max_decoding_slowdown &&
+         group.decoding.IsSignificant()) ||
+        (group.lossless && group.size_ratio - 1 > settings.max_size_increase) ||
+        (!std::isnan(group.bd_rate) && group.bd_rate > settings.max_bd_rate);
+    diff.codec_settings.push_back(group);
+  }
+  return diff;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,101 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TASK_DIFF_H_
+#define SRC_TASK_DIFF_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Thresholds beyond which DiffTasks() reports a regression. All are ratios.
+struct TaskDiffSettings {
+  // Used for the BD-rate. Defaults to PSNR because it is always computed.
+  DistortionMetric metric = DistortionMetric::kLibwebp2Psnr;
+  double max_encoding_slowdown = 0.05;  // Only if significant.
+  double max_decoding_slowdown = 0.05;  // Only if significant.
+  double max_size_increase = 0.005;  // Geometric mean of the lossless sizes.
+  double max_bd_rate = 0.005;  // Average of the lossy BD-rates of the images.
+  // Two-sided quantile of the normal distribution used by the significance
+  // tests of the durations. 1.96 is a 95% confidence.
+  double z_score = 1.96;
+};
+
+// Change of the durations of the tasks that ran with both builds.
+struct DurationDelta {
+  double ratio = 1;  // Geometric mean of the new to old mean durations.
+  // Half-width of the confidence interval of ratio, relative to ratio, based
+  // on the variance of the repetitions of each task. Negative if any task was
+  // not repeated in both builds, in which case the significance is unknown.
+  double relative_error = -1;
+
+  // Returns true if the confidence interval excludes 1, or if unknown.
+  bool IsSignificant() const;
+};
+
+// Comparison of the tasks of one codec configuration, as in a JSON file.
+struct CodecSettingsDiff {
+  Codec codec;
+  Subsampling chroma_subsampling;
+  int effort;
+  uint32_t num_threads;
+  bool lossless;
+
+  size_t num_tasks = 0;  // Distinct image,quality pairs in both builds.
+  DurationDelta encoding;
+  DurationDelta decoding;
+  double size_ratio = 1;  // Geometric mean of the new to old encoded sizes.
+  // Average BjontegaardDeltaRate() of the images, only for lossy tasks.
+  // NaN if no image has overlapping curves.
+  double bd_rate;
+  size_t num_bd_rate_images = 0;
+  bool is_regression = false;  // Beyond the thresholds of TaskDiffSettings.
+};
+
+struct TaskDiff {
+  std::vector<CodecSettingsDiff> codec_settings;  // Sorted by CodecSettings.
+  // TaskInputs that only ran with one of the builds, ignoring the repetitions.
+  size_t num_old_only_tasks = 0;
+  size_t num_new_only_tasks = 0;
+
+  bool HasRegression() const;
+};
+
+// Joins the old and new tasks on their TaskInput, ignoring the encoded_path,
+// and compares each codec configuration. The repetitions of a TaskInput are
+// averaged and used to test the significance of the duration changes.
+// The extrapolated tasks are ignored.
+StatusOr<TaskDiff> DiffTasks(const std::vector<TaskOutput>& old_tasks,
+                             const std::vector<TaskOutput>& new_tasks,
+                             const TaskDiffSettings& settings, bool quiet);
+
+// Returns the average relative difference of the encoded size of the new
+// curve compared to the old one, at equal distortion, over the distortion
+// range covered by both curves. The points are {distortion, encoded size} at
+// several qualities. The logarithm of the size is linearly interpolated
+// between the points rather than fitted by a cubic polynomial, so that 2
+// qualities are enough and the curves cannot oscillate. Returns NaN if the
+// ranges do not overlap.
+double BjontegaardDeltaRate(std::vector<std::pair<double, double>> old_points,
+                            std::vector<std::pair<double, double>> new_points);
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_TASK_DIFF_H_
@@ -0,0 +1,207 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/temp_file_cache.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+TempFile::~TempFile() {
+  std::error_code error_code;  // Ignored.
+  std::filesystem::remove(path, error_code);
+}
+
+namespace {
+
+std::mutex fast_temp_directory_mutex;  // Guards fast_temp_directory.
+std::string fast_temp_directory;       // Empty by default.
+std::atomic<bool> use_memory_files{false};
+
+}  // namespace
+
+std::string GetFastTempDirectory() {
+  {
+    std::lock_guard<std::mutex> lock(fast_temp_directory_mutex);
+    if (!fast_temp_directory.empty()) return fast_temp_directory;
+  }
+  std::error_code error_code;
+  if (std::filesystem::is_directory("/dev/shm", error_code)) return "/dev/shm";
+  return std::filesystem::temp_directory_path().string();
+}
+
+void SetFastTempDirectory(const std::string& folder_path) {
+  std::lock_guard<std::mutex> lock(fast_temp_directory_mutex);
+  fast_temp_directory = folder_path;
+}
+
+MemoryFile::~MemoryFile() {
+#if defined(__linux__)
+  if (fd_ >= 0) close(fd_);
+#endif
+}
+
+bool MemoryFile::IsSupported() {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  return true;
+#else
+  return false;
+#endif
+}
+
+Status MemoryFile::Create(const std::string& name, bool quiet) {
+  CHECK_OR_RETURN(fd_ < 0, quiet);
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  // Not inherited. The other processes open it through this process instead,
+  // even if they were started before.
+  fd_ = memfd_create(name.c_str(), MFD_CLOEXEC);
+  CHECK_OR_RETURN(fd_ >= 0, quiet) << "memfd_create(" << name << ") failed";
+  path_ = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd_);
+  return Status::kOk;
+#else
+  CHECK_OR_RETURN(false, quiet)
+      << "Memory files are only supported on Linux, not for " << name;
+#endif
+}
+
+void SetUseMemoryFiles(bool use) { use_memory_files = use; }
+
+bool UseMemoryFiles() {
+  return use_memory_files && MemoryFile::IsSupported();
+}
+
+TempFileCache::TempFileCache(size_t max_num_bytes)
+    : max_num_bytes_(max_num_bytes) {}
+
+TempFileCache::~TempFileCache() {
+  entries_.clear();
+  lru_keys_.clear();
+  if (!folder_path_.empty()) {
+    std::error_code error_code;  // Ignored.
+    std::filesystem::remove_all(folder_path_, error_code);
+  }
+}
+
+StatusOr<std::string> TempFileCache::GetFolderPath(bool quiet) {
+  if (folder_path_.empty()) {
+    // Process-safe and instance-safe folder name.
+    static std::atomic<size_t> num_instances{0};
+    std::string folder_name = "codec_compare_gen";
+#ifdef HAVE_UNISTD_H
+    folder_name += "_process";
+    folder_name += std::to_string(getpid());
+#endif
+    folder_name += "_cache";
+    folder_name += std::to_string(num_instances++);
+    const std::filesystem::path folder_path =
+        std::filesystem::path(GetFastTempDirectory()) / folder_name;
+    std::error_code error_code;
+    std::filesystem::create_directories(folder_path, error_code);
+    CHECK_OR_RETURN(!error_code, quiet)
+        << "Could not create " << folder_path << ": " << error_code.message();
+    folder_path_ = folder_path.string();
+  }
+  return std::string(folder_path_);
+}
+
+StatusOr<std::shared_ptr<const TempFile>> TempFileCache::Get(
+    const std::string& content_key,
+    const std::function<Status(const std::string& path)>& write, bool quiet) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSIGN_OR_RETURN(const std::string folder_path, GetFolderPath(quiet));
+    auto [it, was_inserted] = entries_.insert({content_key, nullptr});
+    if (was_inserted) {
+      it->second = std::make_shared<Entry>();
+      // The counter avoids any clash with an evicted file still in use.
+      it->second->file_path =
+          (std::filesystem::path(folder_path) /
+           (std::to_string(num_misses_) + "_" + content_key))
+              .string();
+      lru_keys_.push_front(content_key);
+      it->second->lru_position = lru_keys_.begin();
+      ++num_misses_;
+    } else {
+      lru_keys_.splice(lru_keys_.begin(), lru_keys_, it->second->lru_position);
+      ++num_hits_;
+    }
+    entry = it->second;
+  }
+
+  // Only block the threads asking for the same file while it is written.
+  std::shared_ptr<TempFile> file;
+  size_t num_written_bytes = 0;
+  {
+    std::lock_guard<std::mutex> entry_lock(entry->mutex);
+    if (entry->file == nullptr) {
+      auto new_file = std::make_shared<TempFile>(entry->file_path);
+      OK_OR_RETURN(write(new_file->path));
+      std::error_code error_code;
+      new_file->num_bytes =
+          std::filesystem::file_size(new_file->path, error_code);
+      CHECK_OR_RETURN(!error_code, quiet)
+          << "Could not write " << new_file->path << ": "
+          << error_code.message();
+      num_written_bytes = new_file->num_bytes;
+      entry->file = std::move(new_file);
+    }
+    file = entry->file;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_written_bytes > 0 && !entry->is_evicted) {
+    entry->num_accounted_bytes = num_written_bytes;
+    num_bytes_ += num_written_bytes;
+  }
+  // Always keep the most recent entry even if it is bigger than the budget.
+  while (num_bytes_ > max_num_bytes_ && lru_keys_.size() > 1) {
+    const auto evicted = entries_.find(lru_keys_.back());
+    // The file is deleted once no task uses it anymore.
+    num_bytes_ -= evicted->second->num_accounted_bytes;
+    evicted->second->is_evicted = true;
+    entries_.erase(evicted);
+    lru_keys_.pop_back();
+  }
+  return std::shared_ptr<const TempFile>(std::move(file));
+}
+
+size_t TempFileCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+size_t TempFileCache::num_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,117 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TEMP_FILE_CACHE_H_
+#define SRC_TEMP_FILE_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+// Temporary file deleted at destruction.
+struct TempFile {
+  explicit TempFile(std::string path) : path(std::move(path)) {}
+  TempFile(const TempFile&) = delete;
+  ~TempFile();
+
+  const std::string path;
+  size_t num_bytes = 0;
+};
+
+// Returns the folder set by SetFastTempDirectory() if any, otherwise /dev/shm
+// if it exists, otherwise the system temporary directory.
+std::string GetFastTempDirectory();
+// To call before any task runs. An empty folder_path restores the default.
+void SetFastTempDirectory(const std::string& folder_path);
+
+// Anonymous file that only exists in memory, without any file system write.
+// Its path() is readable and writable by this process and by the other
+// processes of the same user, until destruction. Only supported on Linux.
+class MemoryFile {
+ public:
+  MemoryFile() = default;
+  MemoryFile(const MemoryFile&) = delete;
+  MemoryFile& operator=(const MemoryFile&) = delete;
+  ~MemoryFile();
+
+  static bool IsSupported();
+  // The name is only used for debugging.
+  Status Create(const std::string& name, bool quiet);
+  const std::string& path() const { return path_; }
+
+ private:
+  int fd_ = -1;
+  std::string path_;
+};
+
+// If true and MemoryFile::IsSupported(), the temporary files read by the
+// metric binaries are MemoryFiles. To call before any task runs.
+void SetUseMemoryFiles(bool use);
+bool UseMemoryFiles();
+
+// Thread-safe set of temporary files shared across tasks and identified by
+// their content, so that each one is only written once. The least recently
+// used files are deleted once the total size exceeds max_num_bytes, as soon as
+// they are not in use anymore. All files are deleted at destruction.
+class TempFileCache {
+ public:
+  // The files are created in a subfolder of GetFastTempDirectory().
+  explicit TempFileCache(size_t max_num_bytes);
+  ~TempFileCache();
+
+  // Returns the file matching the content_key (which must include its
+  // extension), calling write(path) to create it first if needed. The file
+  // exists as long as the returned pointer is held.
+  StatusOr<std::shared_ptr<const TempFile>> Get(
+      const std::string& content_key,
+      const std::function<Status(const std::string& path)>& write, bool quiet);
+
+  size_t num_hits() const;
+  size_t num_misses() const;
+
+ private:
+  struct Entry {
+    std::string file_path;
+    std::mutex mutex;                // Held while writing the file.
+    std::shared_ptr<TempFile> file;  // Guarded by mutex. Null until written.
+    // Guarded by TempFileCache::mutex_.
+    std::list<std::string>::iterator lru_position;
+    size_t num_accounted_bytes = 0;
+    bool is_evicted = false;
+  };
+
+  StatusOr<std::string> GetFolderPath(bool quiet);  // Requires mutex_.
+
+  const size_t max_num_bytes_;
+  mutable std::mutex mutex_;  // Guards all fields below.
+  std::string folder_path_;   // Created on first use.
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+  std::list<std::string> lru_keys_;  // Most recently used first.
+  size_t num_bytes_ = 0;
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_TEMP_FILE_CACHE_H_
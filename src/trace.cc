@@ -0,0 +1,140 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+namespace {
+
+struct TraceEvent {
+  const char* name;
+  int64_t start_us;
+  int64_t end_us;
+};
+
+// Events of a single thread. Only contended by TraceRecorder::Stop().
+struct ThreadEvents {
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+};
+
+std::mutex threads_mutex;  // Guards the fields below.
+std::vector<std::unique_ptr<ThreadEvents>> thread_events;
+// Incremented by each TraceRecorder::Start() so that the threads register new
+// ThreadEvents instead of reusing the ones of a previous recording.
+uint64_t recording_id = 0;
+
+std::chrono::steady_clock::time_point start_time;
+
+// Returns the events of the calling thread for the current recording.
+ThreadEvents& GetThreadEvents() {
+  thread_local ThreadEvents* events = nullptr;
+  thread_local uint64_t events_recording_id = 0;
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  if (events == nullptr || events_recording_id != recording_id) {
+    thread_events.push_back(std::make_unique<ThreadEvents>());
+    events = thread_events.back().get();
+    events_recording_id = recording_id;
+  }
+  return *events;
+}
+
+}  // namespace
+
+namespace internal {
+
+std::atomic<bool> is_tracing(false);
+
+int64_t GetTraceMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start_time)
+      .count();
+}
+
+void AddTraceEvent(const char* name, int64_t start_us, int64_t end_us) {
+  if (!IsTracing()) return;  // Stopped since the start of the TraceScope.
+  ThreadEvents& events = GetThreadEvents();
+  std::lock_guard<std::mutex> lock(events.mutex);
+  events.events.push_back({name, start_us, end_us});
+}
+
+}  // namespace internal
+
+TraceRecorder::~TraceRecorder() {
+  if (!trace_file_path_.empty()) (void)Stop();
+}
+
+Status TraceRecorder::Start(const std::string& trace_file_path, bool quiet) {
+  CHECK_OR_RETURN(!trace_file_path.empty(), quiet) << "Empty trace file path";
+  CHECK_OR_RETURN(!IsTracing(), quiet) << "Already tracing";
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    thread_events.clear();
+    ++recording_id;
+  }
+  start_time = std::chrono::steady_clock::now();
+  internal::is_tracing.store(true, std::memory_order_release);
+  trace_file_path_ = trace_file_path;
+  quiet_ = quiet;
+  return Status::kOk;
+}
+
+Status TraceRecorder::Stop() {
+  CHECK_OR_RETURN(!trace_file_path_.empty(), quiet_) << "Not tracing";
+  internal::is_tracing.store(false, std::memory_order_release);
+  const std::string trace_file_path = std::move(trace_file_path_);
+  trace_file_path_.clear();
+  std::vector<std::unique_ptr<ThreadEvents>> events;
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    events = std::move(thread_events);
+    thread_events.clear();
+    ++recording_id;  // The ThreadEvents pointed to by the threads are gone.
+  }
+
+  std::ofstream file(trace_file_path, std::ios::trunc);
+  CHECK_OR_RETURN(file.is_open(), quiet_)
+      << "Could not open " << trace_file_path << " for writing";
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool is_first = true;
+  for (size_t tid = 0; tid < events.size(); ++tid) {
+    std::lock_guard<std::mutex> lock(events[tid]->mutex);
+    for (const TraceEvent& event : events[tid]->events) {
+      file << (is_first ? "\n" : ",\n") << "{\"name\": \"" << event.name
+           << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+           << ", \"ts\": " << event.start_us
+           << ", \"dur\": " << (event.end_us - event.start_us) << "}";
+      is_first = false;
+    }
+  }
+  file << "\n]}\n";
+  CHECK_OR_RETURN(file.good(), quiet_)
+      << "Could not write " << trace_file_path;
+  return Status::kOk;
+}
+
+}  // namespace codec_compare_gen
@@ -0,0 +1,84 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "src/base.h"
+
+namespace codec_compare_gen {
+
+namespace internal {
+extern std::atomic<bool> is_tracing;
+// Returns the number of microseconds since tracing started.
+int64_t GetTraceMicroseconds();
+// Records an event of the calling thread. The name must outlive the tracing.
+void AddTraceEvent(const char* name, int64_t start_us, int64_t end_us);
+}  // namespace internal
+
+// Returns true if a TraceRecorder is started.
+inline bool IsTracing() {
+  return internal::is_tracing.load(std::memory_order_acquire);
+}
+
+// Records the time spent by the calling thread between its construction and
+// its destruction, if IsTracing(). Otherwise costs one atomic load.
+class TraceScope {
+ public:
+  // The name must be a string literal or otherwise outlive the tracing.
+  explicit TraceScope(const char* name)
+      : name_(IsTracing() ? name : nullptr),
+        start_us_(name_ != nullptr ? internal::GetTraceMicroseconds() : 0) {}
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+  ~TraceScope() {
+    if (name_ != nullptr) {
+      internal::AddTraceEvent(name_, start_us_,
+                              internal::GetTraceMicroseconds());
+    }
+  }
+
+ private:
+  const char* const name_;  // Null if not tracing.
+  const int64_t start_us_;
+};
+
+// Collects the TraceScope events of all threads between Start() and Stop(),
+// and writes them to a Chrome trace JSON file, with one track per thread. The
+// file can be opened in chrome://tracing or https://ui.perfetto.dev.
+// At most one TraceRecorder can be started at a time.
+class TraceRecorder {
+ public:
+  TraceRecorder() = default;
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+  // Calls Stop() if started.
+  ~TraceRecorder();
+
+  Status Start(const std::string& trace_file_path, bool quiet);
+  // Writes the events recorded since Start(). The threads should be done.
+  Status Stop();
+
+ private:
+  std::string trace_file_path_;  // Empty if not started.
+  bool quiet_ = true;
+};
+
+}  // namespace codec_compare_gen
+
+#endif  // SRC_TRACE_H_
@@ -15,11 +15,18 @@
 #ifndef SRC_WORKER_H_
 #define SRC_WORKER_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <mutex>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "src/cpu_affinity.h"
+#include "src/trace.h"
+
 namespace codec_compare_gen {
 
 template <typename WorkerContext, typename WorkerImpl>
@@ -34,7 +41,10 @@ class Worker {
   virtual void DoTask() = 0;
   // Run after DoTask().
   virtual void EndTask(WorkerContext& context) {}
-  // At most one worker at a time is in AssignTask() or EndTask().
+  // At most one worker at a time is in AssignTask() or EndTask(), unless
+  // WorkerImpl::kIsThreadSafe is set to true. In that case, these functions
+  // must synchronize the access to the context themselves.
+  static constexpr bool kIsThreadSafe = false;
 
  protected:
   const size_t worker_id_;  // Mostly for debugging.
@@ -47,14 +57,25 @@ class Worker {
         mutex_(mutex),
         context_(context) {}
 
-  bool LockAndAssignTask() {
+  // Locks mutex_ and traces the time spent waiting for it, if any.
+  void Lock() {
+    if (mutex_.try_lock()) return;
+    TraceScope trace("wait for lock");
     mutex_.lock();
+  }
+  bool LockAndAssignTask() {
+    if constexpr (WorkerImpl::kIsThreadSafe) return AssignTask(context_);
+    Lock();
     const bool assign = AssignTask(context_);
     mutex_.unlock();
     return assign;
   }
   void LockAndEndTask() {
-    mutex_.lock();
+    if constexpr (WorkerImpl::kIsThreadSafe) {
+      EndTask(context_);
+      return;
+    }
+    Lock();
     EndTask(context_);
     mutex_.unlock();
   }
@@ -67,10 +88,22 @@ class Worker {
     }
   }
   void Run() {
+    // Best effort. The main thread gets its affinity back afterwards.
+    std::vector<int> previous_cpus;
+    if (!cpus_.empty()) {
+      if (!multithreaded_) previous_cpus = GetAllowedCpus();
+      (void)SetAllowedCpus(cpus_, /*quiet=*/true);
+    }
     while (LockAndAssignTask()) {
-      DoTask();
+      {
+        TraceScope trace("task");
+        DoTask();
+      }
       LockAndEndTask();
     }
+    if (!previous_cpus.empty()) {
+      (void)SetAllowedCpus(previous_cpus, /*quiet=*/true);
+    }
   }
   void Finish() {
     if (multithreaded_) thread_.join();
@@ -81,6 +114,7 @@ class Worker {
   std::thread thread_;        // Used only if multithreaded_.
   std::mutex& mutex_;         // Reference to WorkerPool::mutex_.
   WorkerContext& context_;
+  std::vector<int> cpus_;  // The CPUs this worker is restricted to, if any.
 
   template <typename A, typename B>
   friend class WorkerPool;
@@ -89,7 +123,16 @@ class Worker {
 template <typename WorkerContext, typename WorkerImpl>
 class WorkerPool {
  public:
-  explicit WorkerPool(size_t num_workers) : num_workers_(num_workers) {}
+  explicit WorkerPool(size_t num_workers)
+      : num_workers_(num_workers), mutex_(own_mutex_) {}
+  // Pools sharing the same mutex can run concurrently on the same context.
+  WorkerPool(size_t num_workers, std::mutex& mutex)
+      : num_workers_(num_workers), mutex_(mutex) {}
+
+  // Restricts the i-th worker to cpus_per_worker[i % cpus_per_worker.size()].
+  void SetCpusPerWorker(std::vector<std::vector<int>> cpus_per_worker) {
+    cpus_per_worker_ = std::move(cpus_per_worker);
+  }
 
   void Run(WorkerContext& context) {
     std::vector<WorkerImpl> workers;
@@ -97,6 +140,9 @@ class WorkerPool {
     for (size_t i = 0; i < num_workers_; ++i) {
       const bool multithreaded = i + 1 < num_workers_;
       workers.push_back(WorkerImpl(i, mutex_, multithreaded, context));
+      if (!cpus_per_worker_.empty()) {
+        workers.back().cpus_ = cpus_per_worker_[i % cpus_per_worker_.size()];
+      }
       workers.back().Start();
     }
     for (WorkerImpl& worker : workers) {
@@ -106,7 +152,179 @@ class WorkerPool {
 
  private:
   const size_t num_workers_;
-  std::mutex mutex_;
+  std::vector<std::vector<int>> cpus_per_worker_;
+  std::mutex own_mutex_;  // Unused if another mutex is given.
+  std::mutex& mutex_;
+};
+
+// Thread-safe first-in first-out queue of at most capacity items. Used to pass
+// work from one WorkerPool to another running concurrently.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  // Blocks while the queue is full.
+  void Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (items_.size() >= capacity_) {
+      TraceScope trace("wait for queue space");
+      not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+  }
+
+  // Blocks while the queue is empty and not closed. Returns false if there is
+  // no item left and none will come.
+  bool Pop(T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (items_.empty() && !closed_) {
+      TraceScope trace("wait for queue item");
+      not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    }
+    if (items_.empty()) return false;
+    item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // To be called once all items were pushed.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+
+  bool IsClosedAndEmpty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_ && items_.empty();
+  }
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;  // Guards all fields below.
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+// Thread-safe set of items split into one deque per worker, so that workers
+// rarely contend on the same lock. Each worker takes the items of its own
+// deque from the front, so in the given order, then steals the items of the
+// other deques from the back once its own is empty.
+template <typename T>
+class WorkStealingQueue {
+ public:
+  // The items are split into num_shards contiguous ranges. If interleave,
+  // item i goes to shard i % num_shards instead, so that each shard starts
+  // with its share of the first items.
+  WorkStealingQueue(std::vector<T> items, size_t num_shards,
+                    bool interleave = false)
+      : shards_(num_shards == 0 ? 1 : num_shards), size_(items.size()) {
+    for (size_t i = 0; i < items.size(); ++i) {
+      const size_t shard_index = interleave
+                                     ? i % shards_.size()
+                                     : i * shards_.size() / items.size();
+      shards_[shard_index].items.push_back(std::move(items[i]));
+    }
+  }
+
+  // Returns false if there is no item left.
+  bool Pop(size_t shard_index, T& item) {
+    Shard& own_shard = shards_[shard_index % shards_.size()];
+    {
+      std::lock_guard<std::mutex> lock(own_shard.mutex);
+      if (!own_shard.items.empty()) {
+        item = std::move(own_shard.items.front());
+        own_shard.items.pop_front();
+        --size_;
+        return true;
+      }
+    }
+    for (size_t i = 1; i < shards_.size(); ++i) {
+      Shard& shard = shards_[(shard_index + i) % shards_.size()];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (!shard.items.empty()) {
+        item = std::move(shard.items.back());
+        shard.items.pop_back();
+        --size_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Calls visit() on the items that Pop(shard_index) returns next from the
+  // deque of that shard, in order, until visit() returns false.
+  template <typename Visitor>
+  void ForEachNext(size_t shard_index, Visitor visit) {
+    Shard& own_shard = shards_[shard_index % shards_.size()];
+    std::lock_guard<std::mutex> lock(own_shard.mutex);
+    for (const T& item : own_shard.items) {
+      if (!visit(item)) return;
+    }
+  }
+
+  // Same as Pop() but for items whose completion may produce new items: blocks
+  // while there is no item left but some are held, and holds the returned item
+  // until Release().
+  bool PopAndHold(size_t shard_index, T& item) {
+    std::unique_lock<std::mutex> lock(held_mutex_);
+    while (!Pop(shard_index, item)) {
+      if (num_held_ == 0) return false;
+      TraceScope trace("wait for released item");
+      released_.wait(lock);
+    }
+    ++num_held_;
+    return true;
+  }
+
+  // Ends the hold of an item returned by PopAndHold() and pushes the items it
+  // produced to the front of the given shard, unless Clear() was called.
+  void Release(size_t shard_index, std::vector<T> items) {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    if (!is_cleared_) {
+      Shard& shard = shards_[shard_index % shards_.size()];
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      for (auto item = items.rbegin(); item != items.rend(); ++item) {
+        shard.items.push_front(std::move(*item));
+      }
+      size_ += items.size();
+    }
+    --num_held_;
+    released_.notify_all();
+  }
+
+  // Also drops the items released afterwards.
+  void Clear() {
+    {
+      std::lock_guard<std::mutex> lock(held_mutex_);
+      is_cleared_ = true;
+    }
+    for (Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      size_ -= shard.items.size();
+      shard.items.clear();
+    }
+  }
+
+  // Number of remaining items.
+  size_t size() const { return size_; }
+
+ private:
+  struct Shard {
+    std::mutex mutex;  // Guards items.
+    std::deque<T> items;
+  };
+  std::vector<Shard> shards_;
+  std::atomic<size_t> size_;
+  std::mutex held_mutex_;  // Guards the fields below.
+  std::condition_variable released_;
+  size_t num_held_ = 0;
+  bool is_cleared_ = false;
 };
 
 }  // namespace codec_compare_gen
@@ -0,0 +1,98 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/artifact_writer.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/distortion.h"
+#include "src/frame.h"
+#include "third_party/libwebp2/src/wp2/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+constexpr bool kQuiet = false;
+
+//------------------------------------------------------------------------------
+
+TEST(ArtifactWriterTest, StillImagesAndAnimation) {
+  for (bool fast : {false, true}) {
+    ArtifactWriter writer(/*num_threads=*/2, /*max_num_queued_images=*/1, fast,
+                          kQuiet);
+    const std::string folder = std::filesystem::temp_directory_path().string();
+    for (const char* file_name : {"gradient32x32.png", "alpha1x17.png",
+                                  "gradient32x32.png", "anim80x80.gif"}) {
+      const std::string path = std::string(data_path) + file_name;
+      StatusOr<Image> image =
+          ReadStillImageOrAnimation(path.c_str(), WP2_ARGB_32, kQuiet);
+      ASSERT_EQ(image.status, Status::kOk);
+      writer.Write(std::move(image.value),
+                   folder + "/ccgen_artifact_" + file_name + ".png");
+    }
+    ASSERT_EQ(writer.Close(), Status::kOk);
+
+    for (const char* file_name : {"alpha1x17.png", "anim80x80.gif"}) {
+      const std::string path = std::string(data_path) + file_name;
+      const std::string artifact_path =
+          folder + "/ccgen_artifact_" + file_name + ".png";
+      const StatusOr<Image> image =
+          ReadStillImageOrAnimation(path.c_str(), WP2_ARGB_32, kQuiet);
+      const StatusOr<Image> artifact = ReadStillImageOrAnimation(
+          artifact_path.c_str(), WP2_ARGB_32, kQuiet);
+      ASSERT_EQ(image.status, Status::kOk);
+      ASSERT_EQ(artifact.status, Status::kOk);
+      const StatusOr<bool> equality =
+          PixelEquality(image.value, artifact.value, kQuiet);
+      ASSERT_EQ(equality.status, Status::kOk);
+      EXPECT_TRUE(equality.value);  // Lossless.
+    }
+  }
+}
+
+TEST(ArtifactWriterTest, Error) {
+  ArtifactWriter writer(/*num_threads=*/1, /*max_num_queued_images=*/4,
+                        /*fast=*/false, /*quiet=*/true);
+  StatusOr<Image> image = ReadStillImageOrAnimation(
+      (std::string(data_path) + "gradient32x32.png").c_str(), WP2_ARGB_32,
+      kQuiet);
+  ASSERT_EQ(image.status, Status::kOk);
+  writer.Write(std::move(image.value), "/missing/folder/image.png");
+  EXPECT_NE(writer.Close(), Status::kOk);
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  codec_compare_gen::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/async_line_writer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr bool kQuiet = false;
+
+std::string TempPath() {
+  return (std::filesystem::path(::testing::TempDir()) /
+          (testing::UnitTest::GetInstance()->current_test_info()->name() +
+           std::string(".csv")))
+      .string();
+}
+
+std::vector<std::string> ReadLines(const std::string& path) {
+  std::ifstream file(path);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(file, line)) lines.push_back(line);
+  return lines;
+}
+
+//------------------------------------------------------------------------------
+
+TEST(AsyncLineWriterTest, FlushAndClose) {
+  const std::string path = TempPath();
+  std::filesystem::remove(path);
+  AsyncLineWriter writer(/*max_num_buffered_bytes=*/1 << 20,
+                         /*max_delay_seconds=*/1000);
+  ASSERT_EQ(writer.Open(path, kQuiet), Status::kOk);
+  writer.Append("a,b");
+  writer.Append("c");
+  // Not written until flushed because of the huge delay and buffer.
+  ASSERT_EQ(writer.Flush(), Status::kOk);
+  EXPECT_EQ(ReadLines(path), (std::vector<std::string>{"a,b", "c"}));
+  writer.Append("d");
+  ASSERT_EQ(writer.Close(), Status::kOk);
+  EXPECT_EQ(ReadLines(path), (std::vector<std::string>{"a,b", "c", "d"}));
+  EXPECT_EQ(writer.Close(), Status::kOk);  // Noop.
+}
+
+TEST(AsyncLineWriterTest, AppendToExistingFile) {
+  const std::string path = TempPath();
+  std::ofstream(path, std::ios::trunc) << "old" << std::endl;
+  {
+    AsyncLineWriter writer(/*max_num_buffered_bytes=*/1,
+                           /*max_delay_seconds=*/0.01);
+    ASSERT_EQ(writer.Open(path, kQuiet), Status::kOk);
+    writer.Append("new");
+  }  // Closed at destruction.
+  EXPECT_EQ(ReadLines(path), (std::vector<std::string>{"old", "new"}));
+}
+
+TEST(AsyncLineWriterTest, ManyThreadsSmallBuffer) {
+  const std::string path = TempPath();
+  std::filesystem::remove(path);
+  AsyncLineWriter writer(/*max_num_buffered_bytes=*/16,
+                         /*max_delay_seconds=*/0.001);
+  ASSERT_EQ(writer.Open(path, kQuiet), Status::kOk);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&writer, t]() {
+      for (int i = 0; i < 250; ++i) {
+        writer.Append(std::to_string(t) + "_" + std::to_string(i));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  ASSERT_EQ(writer.Close(), Status::kOk);
+  EXPECT_EQ(ReadLines(path).size(), 1000);
+}
+
+TEST(AsyncLineWriterTest, OpenFailure) {
+  AsyncLineWriter writer(/*max_num_buffered_bytes=*/1,
+                         /*max_delay_seconds=*/1);
+  EXPECT_NE(writer.Open("/nonexistent_folder/file.csv", /*quiet=*/true),
+            Status::kOk);
+  EXPECT_EQ(writer.Close(), Status::kOk);
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,109 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/buffer_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr size_t kLarge = size_t{1} << 20;
+
+TEST(BufferPoolTest, ReusedBySameThread) {
+  const size_t num_pooled_bytes = GetNumPooledBytes();
+  const uint8_t* data;
+  {
+    const PooledBuffer buffer = GetPooledBuffer(kLarge);
+    ASSERT_NE(buffer.data(), nullptr);
+    EXPECT_EQ(buffer.capacity(), kLarge);
+    data = buffer.data();
+  }
+  EXPECT_EQ(GetNumPooledBytes(), num_pooled_bytes + kLarge);
+  // Same size class. The last given block is taken first.
+  const PooledBuffer buffer = GetPooledBuffer(kLarge - 1000);
+  EXPECT_EQ(buffer.data(), data);
+  EXPECT_EQ(GetNumPooledBytes(), num_pooled_bytes);
+
+  // Not reused while in use.
+  const PooledBuffer other = GetPooledBuffer(kLarge);
+  EXPECT_NE(other.data(), data);
+}
+
+TEST(BufferPoolTest, SizeClasses) {
+  EXPECT_EQ(GetPooledBuffer(kLarge + 1).capacity(), kLarge + kLarge / 4);
+  EXPECT_EQ(GetPooledBuffer(kLarge * 2 - 1).capacity(), kLarge * 2);
+  EXPECT_EQ(GetPooledBuffer(100).capacity(), 100u);  // Not pooled.
+}
+
+TEST(BufferPoolTest, GivenBackToDestroyingThread) {
+  PooledBuffer buffer = GetPooledBuffer(kLarge * 3);
+  const size_t num_pooled_bytes = GetNumPooledBytes();
+  std::thread thread([&buffer]() {
+    GetPooledBuffer(kLarge);  // Kept from now on.
+    buffer = PooledBuffer();
+    EXPECT_EQ(GetNumPooledBytes(), kLarge + kLarge * 3);
+  });
+  thread.join();
+  EXPECT_EQ(GetNumPooledBytes(), num_pooled_bytes);
+}
+
+TEST(BufferPoolTest, NotKeptByThreadsThatDoNotAllocate) {
+  PooledBuffer buffer = GetPooledBuffer(kLarge);
+  std::thread thread([&buffer]() {
+    buffer = PooledBuffer();
+    EXPECT_EQ(GetNumPooledBytes(), 0u);
+  });
+  thread.join();
+}
+
+TEST(BufferPoolTest, MaxNumPooledBytes) {
+  const size_t total_num_pooled_bytes = GetTotalNumPooledBytes();
+  SetMaxNumPooledBytes(total_num_pooled_bytes + kLarge * 3);
+  // With an empty pool.
+  std::thread thread([total_num_pooled_bytes]() {
+    PooledBuffer kept = GetPooledBuffer(kLarge * 2);
+    PooledBuffer freed = GetPooledBuffer(kLarge * 2 + kLarge / 2);
+    kept = PooledBuffer();
+    freed = PooledBuffer();
+    EXPECT_EQ(GetNumPooledBytes(), kLarge * 2);
+    EXPECT_EQ(GetTotalNumPooledBytes(), total_num_pooled_bytes + kLarge * 2);
+    // Taken back.
+    const PooledBuffer buffer = GetPooledBuffer(kLarge * 2);
+    EXPECT_EQ(GetTotalNumPooledBytes(), total_num_pooled_bytes);
+
+    SetMaxNumPooledBytes(0);
+    GetPooledBuffer(kLarge);  // Freed.
+    EXPECT_EQ(GetTotalNumPooledBytes(), total_num_pooled_bytes);
+  });
+  thread.join();
+  SetMaxNumPooledBytes(kDefaultMaxNumPooledBytes);
+}
+
+TEST(BufferPoolTest, Move) {
+  PooledBuffer buffer = GetPooledBuffer(kLarge);
+  const uint8_t* data = buffer.data();
+  PooledBuffer moved(std::move(buffer));
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_EQ(buffer.data(), nullptr);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(buffer.capacity(), 0u);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,71 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/candidate_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TaskInput GetTask(Codec codec, int quality, const char* image_path = "a.png") {
+  return {{codec, Subsampling::k420, /*effort=*/6, quality, /*num_threads=*/1},
+          image_path};
+}
+
+TEST(CandidateCacheTest, OnlyExpectedCandidatesAreKept) {
+  CandidateCache cache;
+  cache.Expect(GetTask(Codec::kWebp, 50));
+  cache.Insert(GetTask(Codec::kWebp, 50), "webp", 1.5);
+  cache.Insert(GetTask(Codec::kWebp, 60), "other", 2.);     // Not expected.
+  cache.Insert(GetTask(Codec::kWebp, 50), "duplicate", 3.);  // Already kept.
+
+  std::string encoded_image;
+  double encoding_duration = 0;
+  EXPECT_FALSE(
+      cache.Take(GetTask(Codec::kWebp, 60), encoded_image, encoding_duration));
+  EXPECT_FALSE(cache.Take(GetTask(Codec::kWebp, 50, "b.png"), encoded_image,
+                          encoding_duration));
+  ASSERT_TRUE(
+      cache.Take(GetTask(Codec::kWebp, 50), encoded_image, encoding_duration));
+  EXPECT_EQ(encoded_image, "webp");
+  EXPECT_EQ(encoding_duration, 1.5);
+  // Released after the only expected Take().
+  EXPECT_FALSE(
+      cache.Take(GetTask(Codec::kWebp, 50), encoded_image, encoding_duration));
+  EXPECT_EQ(cache.num_hits(), 1u);
+}
+
+TEST(CandidateCacheTest, TakenAsManyTimesAsExpected) {
+  CandidateCache cache;
+  cache.Expect(GetTask(Codec::kJpegXl, 50));
+  cache.Expect(GetTask(Codec::kJpegXl, 50));
+  std::string encoded_image;
+  double encoding_duration = 0;
+  // Too early for the first one.
+  EXPECT_FALSE(cache.Take(GetTask(Codec::kJpegXl, 50), encoded_image,
+                          encoding_duration));
+  cache.Insert(GetTask(Codec::kJpegXl, 50), "jxl", 1.);
+  EXPECT_TRUE(cache.Take(GetTask(Codec::kJpegXl, 50), encoded_image,
+                         encoding_duration));
+  EXPECT_FALSE(cache.Take(GetTask(Codec::kJpegXl, 50), encoded_image,
+                          encoding_duration));
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -15,10 +15,12 @@
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "src/base.h"
 #include "src/codec.h"
+#include "src/codec_context.h"
 #include "src/framework.h"
 #include "src/task.h"
 
@@ -29,8 +31,12 @@ namespace {
 const char* data_path = nullptr;
 
 Status EncodeDecodeTest(const TaskInput& input, bool quiet = false) {
-  return EncodeDecode(input, /*metric_binary_folder_path=*/"", /*thread_id=*/0,
-                      EncodeMode::kEncode, quiet)
+  return EncodeDecode(input, /*metric_binary_folder_path=*/"",
+                      /*distortion_metrics=*/{}, /*thread_id=*/0,
+                      EncodeMode::kEncode, /*timing=*/{},
+                      /*resource_usage=*/{},
+                      /*original_image_cache=*/nullptr,
+                      /*reference_file_cache=*/nullptr, quiet)
       .status;
 }
 
@@ -189,6 +195,28 @@ TEST(CodecTest, JpegXlAnimatedLossless) {
   EXPECT_EQ(EncodeDecodeTest(input), Status::kOk);
 }
 
+TEST(CodecTest, JpegXlReusedContexts) {
+  TaskInput input;
+  input.codec_settings = {Codec::kJpegXl, kDef, /*effort=*/5, /*quality=*/75,
+                          /*num_threads=*/2};
+  input.image_path = std::string(data_path) + "anim80x80.webp";
+  std::vector<size_t> encoded_sizes;
+  for (bool reuse : {false, true, true}) {
+    SetReuseCodecContexts(reuse);
+    const StatusOr<TaskOutput> output = EncodeDecode(
+        input, /*metric_binary_folder_path=*/"", /*distortion_metrics=*/{},
+        /*thread_id=*/0, EncodeMode::kEncode, /*timing=*/{},
+        /*resource_usage=*/{}, /*original_image_cache=*/nullptr,
+        /*reference_file_cache=*/nullptr, /*quiet=*/false);
+    ASSERT_EQ(output.status, Status::kOk);
+    encoded_sizes.push_back(output.value.encoded_size);
+  }
+  SetReuseCodecContexts(true);  // Default.
+  // Same output with a fresh or a reset encoder.
+  EXPECT_EQ(encoded_sizes[0], encoded_sizes[1]);
+  EXPECT_EQ(encoded_sizes[0], encoded_sizes[2]);
+}
+
 //------------------------------------------------------------------------------
 
 TEST(CodecTest, AvifMinEffort) {
@@ -452,10 +480,13 @@ TEST(CodecTest, EncodeToDiskAndLoadFromDisk) {
   input.image_path = std::string(data_path) + "alpha1x17.png";
   input.encoded_path =
       std::filesystem::path(::testing::TempDir()) / "alpha1x17_webp_e2q95.webp";
-  EXPECT_EQ(EncodeDecode(input, "", 0, EncodeMode::kEncodeAndSaveToDisk, false)
+  EXPECT_EQ(EncodeDecode(input, "", {}, 0, EncodeMode::kEncodeAndSaveToDisk,
+                         {}, {}, nullptr, nullptr, false)
                 .status,
             Status::kOk);
-  EXPECT_EQ(EncodeDecode(input, "", 0, EncodeMode::kLoadFromDisk, false).status,
+  EXPECT_EQ(EncodeDecode(input, "", {}, 0, EncodeMode::kLoadFromDisk, {},
+                         {}, nullptr, nullptr, false)
+                .status,
             Status::kOk);
 }
 
@@ -465,13 +496,41 @@ TEST(CodecTest, EncodeToDiskAndLoadFromDiskAnimated) {
   input.image_path = std::string(data_path) + "anim80x80.gif";
   input.encoded_path =
       std::filesystem::path(::testing::TempDir()) / "anim80x80_webp_e2q95.webp";
-  EXPECT_EQ(EncodeDecode(input, "", 0, EncodeMode::kEncodeAndSaveToDisk, false)
+  EXPECT_EQ(EncodeDecode(input, "", {}, 0, EncodeMode::kEncodeAndSaveToDisk,
+                         {}, {}, nullptr, nullptr, false)
                 .status,
             Status::kOk);
-  EXPECT_EQ(EncodeDecode(input, "", 0, EncodeMode::kLoadFromDisk, false).status,
+  EXPECT_EQ(EncodeDecode(input, "", {}, 0, EncodeMode::kLoadFromDisk, {},
+                         {}, nullptr, nullptr, false)
+                .status,
             Status::kOk);
 }
 
+TEST(CodecTest, WarmupsAndRepetitions) {
+  TaskInput input;
+  input.codec_settings = {Codec::kWebp, kDef, /*effort=*/2, /*quality=*/95};
+  input.image_path = std::string(data_path) + "alpha1x17.png";
+  const StatusOr<TaskOutput> once =
+      EncodeDecode(input, "", {}, 0, EncodeMode::kEncode, /*timing=*/{}, {},
+                   nullptr, nullptr, false);
+  ASSERT_EQ(once.status, Status::kOk);
+
+  TimingSettings timing;
+  timing.num_warmups = 2;
+  timing.max_relative_error = 0.5;
+  timing.max_seconds = 1;
+  timing.statistic = TimingStatistic::kMedian;
+  const StatusOr<TaskOutput> repeated = EncodeDecode(
+      input, "", {}, 0, EncodeMode::kEncode, timing, {}, nullptr, nullptr,
+      false);
+  ASSERT_EQ(repeated.status, Status::kOk);
+  // Only the timings may differ.
+  EXPECT_EQ(repeated.value.encoded_size, once.value.encoded_size);
+  EXPECT_EQ(repeated.value.distortions[0], once.value.distortions[0]);
+  EXPECT_GT(repeated.value.encoding_duration, 0);
+  EXPECT_GT(repeated.value.decoding_duration, 0);
+}
+
 //------------------------------------------------------------------------------
 
 }  // namespace
@@ -35,12 +35,16 @@ TEST(SjpegTest, Subsamplings) {
       image_path};
 
   const StatusOr<TaskOutput> result444 =
-      EncodeDecode(input, "", 0, EncodeMode::kEncode, /*quiet=*/false);
+      EncodeDecode(input, "", {}, 0, EncodeMode::kEncode, /*timing=*/{},
+                   /*resource_usage=*/{}, /*original_image_cache=*/nullptr,
+                   /*reference_file_cache=*/nullptr, /*quiet=*/false);
   ASSERT_EQ(result444.status, Status::kOk);
 
   input.codec_settings.chroma_subsampling = Subsampling::k420;
   const StatusOr<TaskOutput> result420 =
-      EncodeDecode(input, "", 0, EncodeMode::kEncode, /*quiet=*/false);
+      EncodeDecode(input, "", {}, 0, EncodeMode::kEncode, /*timing=*/{},
+                   /*resource_usage=*/{}, /*original_image_cache=*/nullptr,
+                   /*reference_file_cache=*/nullptr, /*quiet=*/false);
   ASSERT_EQ(result420.status, Status::kOk);
 
   EXPECT_GT(result444.value.encoded_size, result420.value.encoded_size);
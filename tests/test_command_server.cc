@@ -0,0 +1,86 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_server.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TEST(CommandServerTest, Run) {
+  if (!CommandServer::IsSupported()) GTEST_SKIP() << "Unsupported platform";
+  CommandServer server;
+  for (int i = 0; i < 3; ++i) {
+    const StatusOr<std::string> output =
+        server.Run("echo " + std::to_string(i), /*quiet=*/false);
+    ASSERT_EQ(output.status, Status::kOk);
+    EXPECT_EQ(output.value, std::to_string(i) + "\n");
+  }
+  EXPECT_EQ(server.num_starts(), 1);
+
+  // Same as popen(): no trailing line break added, exit status ignored.
+  EXPECT_EQ(server.Run("printf abc", /*quiet=*/false).value, "abc");
+  EXPECT_EQ(server.Run("false", /*quiet=*/false).value, "");
+  // The standard input of the commands is not the one of the shell.
+  EXPECT_EQ(server.Run("cat", /*quiet=*/false).value, "");
+  EXPECT_EQ(server.Run("echo a; echo b", /*quiet=*/false).value, "a\nb\n");
+  EXPECT_EQ(server.num_starts(), 1);
+}
+
+TEST(CommandServerTest, RestartedAfterCrash) {
+  if (!CommandServer::IsSupported()) GTEST_SKIP() << "Unsupported platform";
+  CommandServer server;
+  ASSERT_EQ(server.Run("echo before", /*quiet=*/false).value, "before\n");
+  // Killing the shell itself loses the command, which is then run again.
+  ASSERT_EQ(server.Run("kill -9 $$", /*quiet=*/true).status,
+            Status::kUnknownError);
+  EXPECT_EQ(server.num_starts(), 2);
+  EXPECT_EQ(server.Run("echo after", /*quiet=*/false).value, "after\n");
+  EXPECT_EQ(server.num_starts(), 3);
+}
+
+TEST(CommandServerTest, PoolOutlivesThreads) {
+  if (!CommandServer::IsSupported()) GTEST_SKIP() << "Unsupported platform";
+  CommandServerPool pool;
+  // Threads created one after the other reuse the same shell.
+  for (int i = 0; i < 3; ++i) {
+    std::thread thread([&pool, i]() {
+      EXPECT_EQ(pool.Run("echo " + std::to_string(i), /*quiet=*/false).value,
+                std::to_string(i) + "\n");
+    });
+    thread.join();
+  }
+  EXPECT_EQ(pool.num_servers(), 1);
+
+  // Concurrent commands get a shell each, at most one per thread.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&pool]() {
+      EXPECT_EQ(pool.Run("sleep 0.05; echo a", /*quiet=*/false).value,
+                "a\n");
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_GE(pool.num_servers(), 1);
+  EXPECT_LE(pool.num_servers(), 4);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,55 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cpu_affinity.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TEST(CpuAffinityTest, ParseCpuList) {
+  const StatusOr<std::vector<int>> cpus =
+      ParseCpuList("8, 0-3,10-11,2", /*quiet=*/false);
+  ASSERT_EQ(cpus.status, Status::kOk);
+  EXPECT_EQ(cpus.value, std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+
+  EXPECT_TRUE(ParseCpuList("", /*quiet=*/false).value.empty());
+  EXPECT_NE(ParseCpuList("3-1", /*quiet=*/true).status, Status::kOk);
+  EXPECT_NE(ParseCpuList("a", /*quiet=*/true).status, Status::kOk);
+  EXPECT_NE(ParseCpuList("-1", /*quiet=*/true).status, Status::kOk);
+}
+
+TEST(CpuAffinityTest, SetAllowedCpus) {
+  const std::vector<int> all_cpus = GetAllowedCpus();
+  if (all_cpus.empty()) GTEST_SKIP() << "Unsupported platform";
+
+  // Pin a separate thread to keep the affinity of the test thread.
+  std::thread thread([&]() {
+    ASSERT_EQ(SetAllowedCpus({all_cpus.back()}, /*quiet=*/false),
+              Status::kOk);
+    EXPECT_EQ(GetAllowedCpus(), std::vector<int>({all_cpus.back()}));
+  });
+  thread.join();
+  EXPECT_EQ(GetAllowedCpus(), all_cpus);
+
+  EXPECT_NE(SetAllowedCpus({}, /*quiet=*/true), Status::kOk);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -12,9 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "src/base.h"
@@ -122,6 +125,154 @@ TEST(DistortionTest, DifferentFrameCount) {
   EXPECT_GT(distortion.value, 20.0f);
 }
 
+TEST(DistortionTest, MultipleMetrics) {
+  const std::string gif_path = std::string(data_path) + "anim80x80.gif";
+  const std::string webp_path = std::string(data_path) + "anim80x80.webp";
+  const StatusOr<Image> gif =
+      ReadStillImageOrAnimation(gif_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(gif.status, Status::kOk);
+  const StatusOr<Image> webp =
+      ReadStillImageOrAnimation(webp_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(webp.status, Status::kOk);
+
+  const std::vector<DistortionMetric> metrics = {
+      DistortionMetric::kLibwebp2Psnr, DistortionMetric::kLibjxlButteraugli,
+      DistortionMetric::kLibwebp2Ssim, DistortionMetric::kLibjxlP3norm};
+  const StatusOr<std::vector<float>> distortions = GetAverageDistortions(
+      "", gif.value, "", webp.value, {}, "", metrics, kThreadId,
+      /*num_frame_threads=*/1, /*reference_file_cache=*/nullptr, kQuiet);
+  ASSERT_EQ(distortions.status, Status::kOk);
+  ASSERT_EQ(distortions.value.size(), metrics.size());
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const StatusOr<float> distortion = GetAverageDistortion(
+        "", gif.value, "", webp.value, {}, "", metrics[i], kThreadId, kQuiet);
+    ASSERT_EQ(distortion.status, Status::kOk);
+    EXPECT_EQ(distortions.value[i], distortion.value);
+  }
+  // No metric binary folder path was given.
+  EXPECT_EQ(distortions.value[1], -1.0f);
+  EXPECT_EQ(distortions.value[3], -1.0f);
+}
+
+TEST(DistortionTest, ParallelFrames) {
+  const std::string gif_path = std::string(data_path) + "anim80x80.gif";
+  const std::string webp_path = std::string(data_path) + "anim80x80.webp";
+  const StatusOr<Image> gif =
+      ReadStillImageOrAnimation(gif_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(gif.status, Status::kOk);
+  StatusOr<Image> webp =
+      ReadStillImageOrAnimation(webp_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(webp.status, Status::kOk);
+
+  // Split the last frame in two identical ones, evaluated together.
+  webp.value.back().duration_ms -= 3;
+  webp.value.emplace_back(WP2::ArgbBuffer(WP2_ARGB_32), 3);
+  ASSERT_EQ(webp.value.back().pixels.SetView(
+                webp.value[webp.value.size() - 2].pixels),
+            WP2_STATUS_OK);
+
+  const std::vector<DistortionMetric> metrics = {
+      DistortionMetric::kLibwebp2Psnr, DistortionMetric::kLibwebp2Ssim};
+  const StatusOr<std::vector<float>> sequential = GetAverageDistortions(
+      "", gif.value, "", webp.value, {}, "", metrics, kThreadId,
+      /*num_frame_threads=*/1, /*reference_file_cache=*/nullptr, kQuiet);
+  ASSERT_EQ(sequential.status, Status::kOk);
+  const StatusOr<std::vector<float>> parallel = GetAverageDistortions(
+      "", gif.value, "", webp.value, {}, "", metrics, kThreadId,
+      /*num_frame_threads=*/4, /*reference_file_cache=*/nullptr, kQuiet);
+  ASSERT_EQ(parallel.status, Status::kOk);
+  EXPECT_EQ(parallel.value, sequential.value);
+
+  EXPECT_NE(GetAverageDistortions("", gif.value, "", webp.value, {}, "",
+                                  metrics, kThreadId, /*num_frame_threads=*/0,
+                                  /*reference_file_cache=*/nullptr,
+                                  /*quiet=*/true)
+                .status,
+            Status::kOk);
+}
+
+TEST(DistortionTest, PsnrAndSsimWithoutAlpha) {
+  const std::string path = std::string(data_path) + "gradient32x32.png";
+  const StatusOr<Image> original =
+      ReadStillImageOrAnimation(path.c_str(), WP2_RGB_24, kQuiet);
+  ASSERT_EQ(original.status, Status::kOk);
+  StatusOr<Image> modified =
+      ReadStillImageOrAnimation(path.c_str(), WP2_RGB_24, kQuiet);
+  ASSERT_EQ(modified.status, Status::kOk);
+  for (uint32_t y = 0; y < modified.value.front().pixels.height(); y += 3) {
+    modified.value.front().pixels.GetRow8(y)[0] ^= 0x0F;
+  }
+
+  // Both metrics are evaluated together, in any order.
+  const std::vector<DistortionMetric> metrics = {
+      DistortionMetric::kLibwebp2Ssim, DistortionMetric::kLibwebp2Psnr};
+  const StatusOr<std::vector<float>> distortions = GetAverageDistortions(
+      "", original.value, "", modified.value, {}, "", metrics, kThreadId,
+      /*num_frame_threads=*/1, /*reference_file_cache=*/nullptr, kQuiet);
+  ASSERT_EQ(distortions.status, Status::kOk);
+  ASSERT_EQ(distortions.value.size(), metrics.size());
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const StatusOr<float> distortion =
+        GetAverageDistortion("", original.value, "", modified.value, {}, "",
+                             metrics[i], kThreadId, kQuiet);
+    ASSERT_EQ(distortion.status, Status::kOk);
+    EXPECT_EQ(distortions.value[i], distortion.value);
+    EXPECT_LT(distortion.value, kNoDistortion);
+  }
+}
+
+TEST(DistortionTest, RowDistortion) {
+  const std::string path = std::string(data_path) + "gradient32x32.png";
+  const StatusOr<Image> original =
+      ReadStillImageOrAnimation(path.c_str(), WP2_RGB_24, kQuiet);
+  ASSERT_EQ(original.status, Status::kOk);
+  const WP2::ArgbBuffer& pixels = original.value.front().pixels;
+
+  RowDistortion same(pixels);
+  // Rows split in two segments and given in reverse order.
+  const uint32_t half_width = pixels.width() / 2;
+  for (uint32_t y = pixels.height(); y-- > 0;) {
+    same.AddRow(half_width, y, pixels.width() - half_width,
+                pixels.GetRow8(y) + half_width * 3);
+    same.AddRow(0, y, half_width, pixels.GetRow8(y));
+  }
+  const StatusOr<bool> equality = same.PixelEquality(kQuiet);
+  ASSERT_EQ(equality.status, Status::kOk);
+  EXPECT_TRUE(equality.value);
+  const StatusOr<float> psnr = same.Psnr(kQuiet);
+  ASSERT_EQ(psnr.status, Status::kOk);
+  EXPECT_EQ(psnr.value, kNoDistortion);
+
+  RowDistortion different(pixels);
+  StatusOr<Image> modified =
+      ReadStillImageOrAnimation(path.c_str(), WP2_RGB_24, kQuiet);
+  ASSERT_EQ(modified.status, Status::kOk);
+  WP2::ArgbBuffer& modified_pixels = modified.value.front().pixels;
+  for (uint32_t y = 0; y < pixels.height(); ++y) {
+    modified_pixels.GetRow8(y)[0] ^= 0x0F;
+    different.AddRow(0, y, pixels.width(), modified_pixels.GetRow8(y));
+  }
+  const StatusOr<bool> inequality = different.PixelEquality(kQuiet);
+  ASSERT_EQ(inequality.status, Status::kOk);
+  EXPECT_FALSE(inequality.value);
+  const StatusOr<float> lower_psnr = different.Psnr(kQuiet);
+  ASSERT_EQ(lower_psnr.status, Status::kOk);
+  EXPECT_LT(lower_psnr.value, kNoDistortion);
+  EXPECT_GT(lower_psnr.value, 20.0f);
+
+  // Same as the SamplePSNR of the whole images, not the libwebp2 PSNR column.
+  const StatusOr<float> sample_psnr = GetAverageDistortion(
+      "", original.value, "", modified.value, {}, "",
+      DistortionMetric::kSamplePsnr, kThreadId, kQuiet);
+  ASSERT_EQ(sample_psnr.status, Status::kOk);
+  EXPECT_EQ(sample_psnr.value, lower_psnr.value);
+
+  // Missing rows are an error.
+  RowDistortion incomplete(pixels);
+  incomplete.AddRow(0, 0, pixels.width(), pixels.GetRow8(0));
+  EXPECT_NE(incomplete.PixelEquality(kQuiet).status, Status::kOk);
+}
+
 //------------------------------------------------------------------------------
 
 }  // namespace
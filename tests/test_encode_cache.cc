@@ -0,0 +1,153 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/encode_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::string TempPath(const std::string& suffix) {
+  return (std::filesystem::path(::testing::TempDir()) /
+          (testing::UnitTest::GetInstance()->current_test_info()->name() +
+           suffix))
+      .string();
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+}
+
+TaskOutput MakeOutput(const TaskInput& input, double encoding_duration) {
+  TaskOutput output =
+      MakeTaskOutput(input, /*image_width=*/8, /*image_height=*/8);
+  output.encoded_size = 100;
+  output.encoding_duration = encoding_duration;
+  output.decoding_duration = 0.5;
+  for (float& distortion : output.distortions) distortion = 1;
+  return output;
+}
+
+class EncodeCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(folder_path_);
+    std::filesystem::create_directories(folder_path_);
+    WriteFile(image_path_, "original");
+  }
+
+  const std::string folder_path_ = TempPath("_cache");
+  const std::string image_path_ = TempPath(".png");
+  const TaskInput input_{{Codec::kWebp, Subsampling::k420, /*effort=*/2,
+                          /*quality=*/50},
+                         image_path_};
+};
+
+TEST_F(EncodeCacheTest, ReusedByNextRuns) {
+  {
+    EncodeCache cache(folder_path_, "key");
+    TaskOutput output;
+    EXPECT_FALSE(cache.Reuse(input_, /*save_encoded=*/false, {}, output));
+    // Both repetitions are recorded.
+    cache.Insert(MakeOutput(input_, 1));
+    cache.Insert(MakeOutput(input_, 2));
+    // Not within the same run.
+    EXPECT_FALSE(cache.Reuse(input_, /*save_encoded=*/false, {}, output));
+  }
+
+  EncodeCache cache(folder_path_, "key");
+  // Another image path with the same contents.
+  TaskInput input = input_;
+  input.image_path = TempPath("_copy.png");
+  WriteFile(input.image_path, "original");
+  TaskOutput output;
+  ASSERT_TRUE(cache.Reuse(input, /*save_encoded=*/false, {}, output));
+  EXPECT_EQ(output.task_input.image_path, input.image_path);
+  EXPECT_EQ(output.encoding_duration, 1);
+  ASSERT_TRUE(cache.Reuse(input, /*save_encoded=*/false, {}, output));
+  EXPECT_EQ(output.encoding_duration, 2);
+  EXPECT_FALSE(cache.Reuse(input, /*save_encoded=*/false, {}, output));
+  EXPECT_EQ(cache.num_hits(), 2u);
+}
+
+TEST_F(EncodeCacheTest, OtherKeys) {
+  EncodeCache(folder_path_, "key").Insert(MakeOutput(input_, 1));
+  TaskOutput output;
+  EXPECT_FALSE(EncodeCache(folder_path_, "other key")
+                   .Reuse(input_, /*save_encoded=*/false, {}, output));
+  TaskInput other_quality = input_;
+  other_quality.codec_settings.quality = 60;
+  EXPECT_FALSE(EncodeCache(folder_path_, "key")
+                   .Reuse(other_quality, /*save_encoded=*/false, {}, output));
+
+  // A missing distortion is not reused.
+  TaskOutput incomplete = MakeOutput(other_quality, 1);
+  incomplete.distortions[0] = kDistortionNotComputed;
+  EncodeCache(folder_path_, "key").Insert(incomplete);
+  EXPECT_FALSE(EncodeCache(folder_path_, "key")
+                   .Reuse(other_quality, /*save_encoded=*/false, {}, output));
+  EXPECT_TRUE(EncodeCache(folder_path_, "key")
+                  .Reuse(other_quality, /*save_encoded=*/false,
+                         {static_cast<DistortionMetric>(1)}, output));
+
+  // Modified original image.
+  WriteFile(image_path_, "modified");
+  EXPECT_FALSE(EncodeCache(folder_path_, "key")
+                   .Reuse(input_, /*save_encoded=*/false, {}, output));
+}
+
+TEST_F(EncodeCacheTest, EncodedFile) {
+  TaskInput input = input_;
+  input.encoded_path = TempPath(".webp");
+  WriteFile(input.encoded_path, "encoded");
+  {
+    EncodeCache cache(folder_path_, "key");
+    cache.InsertEncodedFile(input);
+    cache.Insert(MakeOutput(input, 1));
+  }
+  std::filesystem::remove(input.encoded_path);
+
+  TaskOutput output;
+  ASSERT_TRUE(EncodeCache(folder_path_, "key")
+                  .Reuse(input, /*save_encoded=*/true, {}, output));
+  EXPECT_EQ(ReadFile(input.encoded_path), "encoded");
+
+  // Cannot be reused without any recorded encoded file.
+  TaskInput other_effort = input;
+  other_effort.codec_settings.effort = 3;
+  EncodeCache(folder_path_, "key").Insert(MakeOutput(other_effort, 1));
+  EXPECT_FALSE(EncodeCache(folder_path_, "key")
+                   .Reuse(other_effort, /*save_encoded=*/true, {}, output));
+  EXPECT_TRUE(EncodeCache(folder_path_, "key")
+                  .Reuse(other_effort, /*save_encoded=*/false, {}, output));
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,107 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/frame.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/distortion.h"
+#include "third_party/libwebp2/src/wp2/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+constexpr bool kQuiet = false;
+
+//------------------------------------------------------------------------------
+
+TEST(FrameTest, ReadStillImageInFormat) {
+  const std::string png_path = std::string(data_path) + "gradient32x32.png";
+  for (WP2SampleFormat format : {WP2_ARGB_32, WP2_RGB_24}) {
+    const StatusOr<Image> image =
+        ReadStillImageOrAnimation(png_path.c_str(), format, kQuiet);
+    ASSERT_EQ(image.status, Status::kOk);
+    ASSERT_EQ(image.value.size(), 1);
+    EXPECT_EQ(image.value.front().pixels.format(), format);
+    EXPECT_EQ(image.value.front().pixels.width(), 32);
+    EXPECT_FALSE(image.value.front().pixels.IsView());
+  }
+}
+
+TEST(FrameTest, CloneAsReusesPixelMemory) {
+  Image image;
+  image.emplace_back(WP2::ArgbBuffer(WP2_ARGB_32), /*duration_ms=*/0);
+  ASSERT_EQ(image.front().pixels.Resize(256, 256), WP2_STATUS_OK);
+  for (uint32_t y = 0; y < 256; ++y) {
+    std::memset(image.front().pixels.GetRow8(y), 10, 256 * 4);
+  }
+
+  const uint8_t* pixels;
+  {
+    const StatusOr<Image> clone = CloneAs(image, WP2_RGBA_32, kQuiet);
+    ASSERT_EQ(clone.status, Status::kOk);
+    pixels = clone.value.front().pixels.GetRow8(0);
+  }
+  const StatusOr<Image> clone = CloneAs(image, WP2_RGBA_32, kQuiet);
+  ASSERT_EQ(clone.status, Status::kOk);
+  EXPECT_EQ(clone.value.front().pixels.GetRow8(0), pixels);
+  EXPECT_EQ(clone.value.front().pixels.GetRow8(255)[4 * 255], 10);  // Red.
+}
+
+TEST(FrameTest, SpreadTo8bitInPlace) {
+  const std::string png_path =
+      std::string(data_path) + "alpha31x32_16bits.png";
+  StatusOr<Image> image =
+      ReadStillImageOrAnimation(png_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(image.status, Status::kOk);
+  ASSERT_EQ(WP2Formatbpc(image.value.front().pixels.format()), 16);
+  const StatusOr<Image> copy = SpreadTo8bit(image.value, kQuiet);
+  ASSERT_EQ(copy.status, Status::kOk);
+
+  const void* pixels = image.value.front().pixels.GetRow(0);
+  const StatusOr<Image> view = SpreadTo8bit(std::move(image.value), kQuiet);
+  ASSERT_EQ(view.status, Status::kOk);
+  ASSERT_EQ(view.value.size(), 1);
+  EXPECT_EQ(view.value.front().pixels.GetRow(0), pixels);
+  EXPECT_TRUE(view.value.front().pixels.IsView());
+  EXPECT_EQ(view.value.front().pixels.width(), 31 * 2);
+  const StatusOr<bool> equality = PixelEquality(view.value, copy.value, kQuiet);
+  ASSERT_EQ(equality.status, Status::kOk);
+  EXPECT_TRUE(equality.value);
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  codec_compare_gen::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -208,6 +208,22 @@ TEST_F(FrameworkTest, LosslessOnlyCodecs) {
       Status::kOk);
 }
 
+TEST_F(FrameworkTest, SeparateMetricThreads) {
+  ComparisonSettings settings;
+  settings.codec_settings.push_back(
+      {Codec::kWebp, Subsampling::k420, /*effort=*/0, /*quality=*/50});
+  settings.codec_settings.push_back(
+      {Codec::kWebp2, Subsampling::k444, /*effort=*/0, kQualityLossless});
+  settings.num_extra_threads = 1;
+  settings.num_metric_threads = 2;
+  EXPECT_EQ(
+      CompareAndVerify({std::string(data_path) + "gradient32x32.png",
+                        std::string(data_path) + "alpha1x17.png",
+                        std::string(data_path) + "anim80x80.webp"},
+                       settings, TempPath("completed_tasks.csv"), TempPath()),
+      Status::kOk);
+}
+
 //------------------------------------------------------------------------------
 
 TEST_F(FrameworkTest, Incremental) {
@@ -264,6 +280,124 @@ TEST_F(FrameworkTest, Incremental) {
             Status::kOk);
 }
 
+TEST_F(FrameworkTest, RateDistortionCurveSavesAllSamples) {
+  ComparisonSettings settings;
+  for (int quality = 0; quality <= 100; quality += 5) {
+    settings.codec_settings.push_back(
+        {Codec::kWebp, Subsampling::k420, /*effort=*/0, quality});
+  }
+  settings.distortion_metrics = {DistortionMetric::kLibwebp2Psnr};
+  settings.quality_search.target = QualitySearchTarget::kRateDistortionCurve;
+  settings.quality_search.metric = DistortionMetric::kLibwebp2Psnr;
+  // Tight enough to sample more than one quality between the initial ones.
+  settings.quality_search.value = 0.01;
+  settings.quality_search.num_initial_curve_qualities = 3;
+  settings.encoded_folder_path = TempPath("encoded").string();
+  std::filesystem::create_directory(settings.encoded_folder_path);
+  ASSERT_EQ(Compare({std::string(data_path) + "gradient32x32.png"}, settings,
+                    TempPath("completed_tasks.csv"), TempPath()),
+            Status::kOk);
+
+  std::ifstream completed_tasks_file(TempPath("completed_tasks.csv"));
+  std::string completed_task;
+  size_t num_tasks = 0;
+  while (std::getline(completed_tasks_file, completed_task)) {
+    if (!completed_task.empty()) ++num_tasks;
+  }
+  // The initial qualities then at least two samples in the same batch.
+  EXPECT_GE(num_tasks, 3 + 2);
+  // Each sampled quality is saved, not only the first of each batch.
+  size_t num_encoded_files = 0;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(settings.encoded_folder_path)) {
+    if (entry.is_regular_file()) ++num_encoded_files;
+  }
+  EXPECT_EQ(num_encoded_files, num_tasks);
+}
+
+TEST_F(FrameworkTest, OnlyOutdatedResultsAreWritten) {
+  ComparisonSettings settings;
+  settings.codec_settings.push_back(
+      {Codec::kWebp, Subsampling::k444, /*effort=*/0, kQualityLossless});
+  const std::vector<std::string> images = {std::string(data_path) +
+                                           "gradient32x32.png"};
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  const std::string webp_results_file_path = TempPath("webp_444_0.json");
+  ASSERT_TRUE(std::filesystem::exists(webp_results_file_path));
+  const uintmax_t webp_results_file_size =
+      std::filesystem::file_size(webp_results_file_path);
+  // Newer than the completed tasks file, so considered up to date.
+  std::ofstream(webp_results_file_path, std::ios::trunc) << "untouched";
+
+  settings.codec_settings.push_back(
+      {Codec::kWebp2, Subsampling::k444, /*effort=*/0, kQualityLossless});
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(TempPath("webp2_444_0.json")));
+  EXPECT_EQ(std::filesystem::file_size(webp_results_file_path),
+            std::string("untouched").size());
+
+  // Missing files are written again.
+  std::filesystem::remove(webp_results_file_path);
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  EXPECT_EQ(std::filesystem::file_size(webp_results_file_path),
+            webp_results_file_size);
+
+  // Files written with other output settings are written again.
+  std::ofstream(webp_results_file_path, std::ios::trunc) << "untouched";
+  settings.timing.statistic = TimingStatistic::kMedian;
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  EXPECT_NE(std::filesystem::file_size(webp_results_file_path),
+            std::string("untouched").size());
+}
+
+TEST_F(FrameworkTest, CompressedChunkedResults) {
+  ComparisonSettings settings;
+  settings.codec_settings.push_back(
+      {Codec::kWebp, Subsampling::k444, /*effort=*/0, kQualityLossless});
+  settings.results_format.gzip = true;
+  settings.results_format.chunk_num_rows = 1;
+  const std::vector<std::string> images = {
+      std::string(data_path) + "alpha1x17.png",
+      std::string(data_path) + "gradient32x32.png"};
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(TempPath("webp_444_0.json.gz")));
+  EXPECT_TRUE(std::filesystem::exists(TempPath("webp_444_0_rows0.json.gz")));
+  EXPECT_TRUE(std::filesystem::exists(TempPath("webp_444_0_rows1.json.gz")));
+  EXPECT_FALSE(std::filesystem::exists(TempPath("webp_444_0_rows2.json.gz")));
+  EXPECT_FALSE(std::filesystem::exists(TempPath("webp_444_0.json")));
+}
+
+TEST_F(FrameworkTest, TimeBudget) {
+  ComparisonSettings settings;
+  settings.codec_settings.push_back(
+      {Codec::kWebp, Subsampling::k444, /*effort=*/0, kQualityLossless});
+  const std::vector<std::string> images = {
+      std::string(data_path) + "alpha1x17.png",
+      std::string(data_path) + "gradient32x32.png"};
+  settings.time_budget = 1e-9;  // Spent before any task starts.
+  EXPECT_EQ(Compare(images, settings, TempPath("completed_tasks.csv"),
+                    TempPath()),
+            Status::kOk);
+  EXPECT_FALSE(std::filesystem::exists(TempPath("webp_444_0.json")));
+
+  // The next run resumes.
+  settings.time_budget = 0;
+  EXPECT_EQ(CompareAndVerify(images, settings, TempPath("completed_tasks.csv"),
+                             TempPath()),
+            Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(TempPath("webp_444_0.json")));
+}
+
 //------------------------------------------------------------------------------
 
 TEST_F(FrameworkTest, InconvenientFilePaths) {
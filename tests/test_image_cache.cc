@@ -0,0 +1,144 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_cache.h"
+
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/distortion.h"
+#include "src/frame.h"
+#include "src/image_header.h"
+#include "src/task.h"
+#include "third_party/libwebp2/src/wp2/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+constexpr bool kQuiet = false;
+
+//------------------------------------------------------------------------------
+
+TEST(ImageCacheTest, HitsAndMisses) {
+  const std::string gif_path = std::string(data_path) + "anim80x80.gif";
+  ImageCache cache(std::numeric_limits<size_t>::max());
+
+  const StatusOr<std::shared_ptr<const Image>> first =
+      cache.Get(gif_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(first.status, Status::kOk);
+  EXPECT_EQ(cache.num_hits(), 0);
+  EXPECT_EQ(cache.num_misses(), 1);
+
+  const StatusOr<std::shared_ptr<const Image>> second =
+      cache.Get(gif_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(second.status, Status::kOk);
+  EXPECT_EQ(first.value, second.value);  // Same pointer.
+  EXPECT_EQ(cache.num_hits(), 1);
+  EXPECT_EQ(cache.num_misses(), 1);
+}
+
+TEST(ImageCacheTest, SameAsReadAndConvert) {
+  const std::string png_path = std::string(data_path) + "gradient32x32.png";
+  ImageCache cache(std::numeric_limits<size_t>::max());
+
+  const StatusOr<std::shared_ptr<const Image>> converted =
+      cache.Get(png_path, WP2_ARGB_32, WP2_RGB_24, kQuiet);
+  ASSERT_EQ(converted.status, Status::kOk);
+  // The image read as WP2_ARGB_32 is cached as well.
+  EXPECT_EQ(cache.num_misses(), 2);
+
+  const StatusOr<Image> read =
+      ReadStillImageOrAnimation(png_path.c_str(), WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(read.status, Status::kOk);
+  const StatusOr<Image> expected = CloneAs(read.value, WP2_RGB_24, kQuiet);
+  ASSERT_EQ(expected.status, Status::kOk);
+  const StatusOr<bool> equality =
+      PixelEquality(*converted.value, expected.value, kQuiet);
+  ASSERT_EQ(equality.status, Status::kOk);
+  EXPECT_TRUE(equality.value);
+
+  ASSERT_EQ(cache.Get(png_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet).status,
+            Status::kOk);
+  EXPECT_EQ(cache.num_hits(), 1);
+}
+
+TEST(ImageCacheTest, Eviction) {
+  const std::string gif_path = std::string(data_path) + "anim80x80.gif";
+  const std::string png_path = std::string(data_path) + "gradient32x32.png";
+  ImageCache cache(/*max_num_bytes=*/1);  // Only keeps the newest image.
+
+  const StatusOr<std::shared_ptr<const Image>> gif =
+      cache.Get(gif_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet);
+  ASSERT_EQ(gif.status, Status::kOk);
+  ASSERT_EQ(cache.Get(png_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet).status,
+            Status::kOk);
+  // The evicted image is still usable.
+  EXPECT_FALSE(gif.value->empty());
+
+  ASSERT_EQ(cache.Get(gif_path, WP2_ARGB_32, WP2_ARGB_32, kQuiet).status,
+            Status::kOk);
+  EXPECT_EQ(cache.num_hits(), 0);
+  EXPECT_EQ(cache.num_misses(), 3);
+}
+
+TEST(ImageCacheTest, OnlySpreadImageIsCached) {
+  TaskInput input;
+  input.codec_settings.codec = Codec::kWebp;  // 8-bit only.
+  input.codec_settings.quality = kQualityLossless;
+  input.image_path = std::string(data_path) + "gradient32x32_16bits.png";
+  input.image_header = ProbeImageHeader(input.image_path);
+  ASSERT_EQ(input.image_header.bit_depth, 16);
+  ImageCache cache(std::numeric_limits<size_t>::max());
+
+  const StatusOr<std::shared_ptr<const Image>> cached =
+      ReadImageForCodec(input, &cache, kQuiet);
+  ASSERT_EQ(cached.status, Status::kOk);
+  // The header tells the image must be spread, so the unspread one is not
+  // cached.
+  EXPECT_EQ(cache.num_misses(), 1);
+  EXPECT_EQ(WP2Formatbpc(cached.value->front().pixels.format()), 8);
+
+  const StatusOr<std::shared_ptr<const Image>> read =
+      ReadImageForCodec(input, /*original_image_cache=*/nullptr, kQuiet);
+  ASSERT_EQ(read.status, Status::kOk);
+  const StatusOr<bool> equality =
+      PixelEquality(*cached.value, *read.value, kQuiet);
+  ASSERT_EQ(equality.status, Status::kOk);
+  EXPECT_TRUE(equality.value);
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  codec_compare_gen::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
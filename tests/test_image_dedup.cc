@@ -0,0 +1,83 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_dedup.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::string WriteFile(const std::string& file_name,
+                      const std::string& contents) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / file_name).string();
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+  return path;
+}
+
+TEST(ImageDedupTest, FindDuplicateImages) {
+  const std::string a = WriteFile("dedup_a.png", "abcd");
+  const std::string b = WriteFile("dedup_b.png", "abce");  // Same size.
+  const std::string c = WriteFile("dedup_c.png", "abcd");
+  const std::string d = WriteFile("dedup_d.png", "abc");
+  const std::string e = WriteFile("dedup_e.png", "abcd");
+  const StatusOr<std::unordered_map<std::string, std::string>> originals =
+      FindDuplicateImages({a, b, c, d, e, a}, /*quiet=*/false);
+  ASSERT_EQ(originals.status, Status::kOk);
+  EXPECT_EQ(originals.value,
+            (std::unordered_map<std::string, std::string>{{c, a}, {e, a}}));
+
+  EXPECT_NE(FindDuplicateImages({a, "missing.png"}, /*quiet=*/true).status,
+            Status::kOk);
+}
+
+TEST(ImageDedupTest, DuplicateTasks) {
+  constexpr Subsampling k420 = Subsampling::k420;
+  std::vector<TaskInput> tasks;
+  for (int quality : {10, 90}) {
+    for (const char* image : {"a.png", "b.png", "c.png"}) {
+      tasks.push_back({{Codec::kWebp, k420, 4, quality}, image});
+    }
+  }
+  tasks.push_back({{Codec::kWebp, k420, 4, 10}, "c.png"});  // Repetition.
+  tasks.push_back({{Codec::kWebp, k420, 4, 50}, "c.png"});  // No original.
+
+  DuplicateTasks duplicates({{"c.png", "a.png"}}, tasks);
+  EXPECT_EQ(duplicates.size(), 3u);
+  ASSERT_EQ(tasks.size(), 5u);
+  EXPECT_EQ(tasks.back().image_path, "c.png");
+
+  const TaskInput original{{Codec::kWebp, k420, 4, 10}, "a.png"};
+  std::vector<TaskInput> taken = duplicates.Take(original);
+  ASSERT_EQ(taken.size(), 1u);
+  EXPECT_EQ(taken.front().image_path, "c.png");
+  EXPECT_EQ(taken.front().codec_settings.quality, 10);
+  EXPECT_EQ(duplicates.Take(original).size(), 1u);
+  EXPECT_TRUE(duplicates.Take(original).empty());
+  EXPECT_TRUE(duplicates.Take({{Codec::kWebp, k420, 4, 90}, "b.png"}).empty());
+  EXPECT_EQ(duplicates.size(), 1u);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
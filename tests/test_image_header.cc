@@ -0,0 +1,166 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_header.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+void ExpectHeader(const ImageHeader& header, uint32_t width, uint32_t height,
+                  uint32_t bit_depth, uint32_t num_frames) {
+  EXPECT_EQ(header.width, width);
+  EXPECT_EQ(header.height, height);
+  EXPECT_EQ(header.bit_depth, bit_depth);
+  EXPECT_EQ(header.num_frames, num_frames);
+}
+
+TEST(ImageHeaderTest, Png) {
+  const std::string data(data_path);
+  ExpectHeader(ProbeImageHeader(data + "gradient32x32.png"), 32, 32, 8, 1);
+  ExpectHeader(ProbeImageHeader(data + "alpha1x17.png"), 1, 17, 8, 1);
+  ExpectHeader(ProbeImageHeader(data + "alpha31x32_16bits.png"), 31, 32, 16,
+               1);
+}
+
+// Writes the PNG signature, an IHDR chunk of that color type and the given
+// chunks followed by an IDAT chunk. The CRCs are not checked.
+std::string WritePngHeader(
+    const std::string& file_name, uint8_t color_type,
+    const std::vector<std::pair<std::string, std::string>>& chunks) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / file_name).string();
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << "\x89PNG\r\n\x1a\n";
+  auto write_chunk = [&](const std::string& type, const std::string& data) {
+    const uint32_t length = static_cast<uint32_t>(data.size());
+    file << static_cast<char>(length >> 24) << static_cast<char>(length >> 16)
+         << static_cast<char>(length >> 8) << static_cast<char>(length) << type
+         << data << std::string(4, '\0');
+  };
+  write_chunk("IHDR", std::string("\0\0\0\1\0\0\0\1\x08", 9) +
+                          static_cast<char>(color_type) + std::string(3, '\0'));
+  for (const auto& [type, data] : chunks) write_chunk(type, data);
+  write_chunk("IDAT", "");
+  return path;
+}
+
+TEST(ImageHeaderTest, KnownOpaque) {
+  const std::string data(data_path);
+  EXPECT_TRUE(ProbeImageHeader(data + "gradient32x32.png").IsKnownOpaque());
+  // The alpha channel may still be fully opaque but it is unknown.
+  EXPECT_FALSE(ProbeImageHeader(data + "alpha1x17.png").IsKnownOpaque());
+  EXPECT_FALSE(
+      ProbeImageHeader(data + "alpha31x32_16bits.png").IsKnownOpaque());
+  EXPECT_FALSE(ProbeImageHeader(data + "anim80x80.gif").IsKnownOpaque());
+  EXPECT_FALSE(ProbeImageHeader(data + "missing.png").IsKnownOpaque());
+}
+
+TEST(ImageHeaderTest, KnownOpaquePngChunks) {
+  const uint8_t kRgb = 2, kPalette = 3;
+  EXPECT_TRUE(
+      ProbeImageHeader(WritePngHeader("rgb.png", kRgb, {{"gAMA", "1234"}}))
+          .IsKnownOpaque());
+  EXPECT_FALSE(ProbeImageHeader(
+                   WritePngHeader("rgb_key.png", kRgb, {{"tRNS", "123456"}}))
+                   .IsKnownOpaque());
+  const ImageHeader animation = ProbeImageHeader(WritePngHeader(
+      "rgb_anim.png", kRgb, {{"acTL", std::string("\0\0\0\2\0\0\0\0", 8)}}));
+  EXPECT_EQ(animation.num_frames, 2u);
+  EXPECT_FALSE(animation.IsKnownOpaque());
+  EXPECT_TRUE(ProbeImageHeader(
+                  WritePngHeader("palette.png", kPalette, {{"PLTE", "123"}}))
+                  .IsKnownOpaque());
+  EXPECT_TRUE(ProbeImageHeader(
+                  WritePngHeader("palette_opaque.png", kPalette,
+                                 {{"PLTE", "123456"}, {"tRNS", "\xff\xff"}}))
+                  .IsKnownOpaque());
+  EXPECT_FALSE(ProbeImageHeader(
+                   WritePngHeader("palette_alpha.png", kPalette,
+                                  {{"PLTE", "123456"}, {"tRNS", "\xff\x80"}}))
+                   .IsKnownOpaque());
+}
+
+TEST(ImageHeaderTest, Jpeg) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "header.jpg").string();
+  // Start of image, JFIF segment, then a baseline frame header of 3x2 pixels.
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      << std::string("\xff\xd8", 2)
+      << std::string("\xff\xe0\0\x10JFIF\0\1\1\0\0\1\0\1\0\0", 18)
+      << std::string("\xff\xc0\0\x11\x08\0\2\0\3\3", 10);
+  const ImageHeader header = ProbeImageHeader(path);
+  ExpectHeader(header, 3, 2, 8, 1);
+  EXPECT_TRUE(header.IsKnownOpaque());
+
+  // Cut before the frame header.
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      << std::string("\xff\xd8\xff\xe0\0\x10JFIF", 10);
+  EXPECT_FALSE(ProbeImageHeader(path).IsKnown());
+}
+
+TEST(ImageHeaderTest, Animations) {
+  const std::string data(data_path);
+  ExpectHeader(ProbeImageHeader(data + "anim80x80.gif"), 80, 80, 8, 10);
+  ExpectHeader(ProbeImageHeader(data + "anim80x80.webp"), 80, 80, 8, 10);
+}
+
+TEST(ImageHeaderTest, Unknown) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "header.png").string();
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "\x89PNG\r\n";
+  EXPECT_FALSE(ProbeImageHeader(path).IsKnown());
+  EXPECT_FALSE(ProbeImageHeader(path + ".missing").IsKnown());
+}
+
+TEST(ImageHeaderTest, ProbeInParallel) {
+  const std::string data(data_path);
+  const std::vector<std::string> paths = {
+      data + "gradient32x32.png", data + "anim80x80.webp",
+      data + "gradient32x32.png", data + "missing.png"};
+  const std::unordered_map<std::string, ImageHeader> headers =
+      ProbeImageHeaders(paths, /*num_threads=*/3);
+  ASSERT_EQ(headers.size(), 3);
+  ExpectHeader(headers.at(paths[0]), 32, 32, 8, 1);
+  ExpectHeader(headers.at(paths[1]), 80, 80, 8, 10);
+  EXPECT_FALSE(headers.at(paths[3]).IsKnown());
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  codec_compare_gen::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_manifest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+// Returns the first bytes of a PNG file of width x height pixels, enough for
+// ProbeImageHeader().
+std::string PngHeader(uint8_t width, uint8_t height) {
+  const char bytes[] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n',
+                        0, 0, 0, 13, 'I', 'H', 'D', 'R',
+                        0, 0, 0, static_cast<char>(width),
+                        0, 0, 0, static_cast<char>(height),
+                        8, 2, 0, 0, 0, 0, 0, 0, 0,
+                        0, 0, 0, 0, 'I', 'D', 'A', 'T'};
+  return std::string(bytes, sizeof(bytes));
+}
+
+void WriteFile(const std::filesystem::path& path,
+               const std::string& contents) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+
+std::vector<std::string> Paths(const std::vector<FoundImage>& images) {
+  std::vector<std::string> paths;
+  for (const FoundImage& image : images) paths.push_back(image.path);
+  return paths;
+}
+
+TEST(ImageManifestTest, FindsImagesRecursively) {
+  const std::filesystem::path root =
+      std::filesystem::path(::testing::TempDir()) / "manifest_recursive";
+  std::filesystem::remove_all(root);
+  WriteFile(root / "b.png", PngHeader(3, 2));
+  WriteFile(root / "notes.txt", "not an image");
+  WriteFile(root / "a" / "c.JPG", "");
+  WriteFile(root / "a" / "deeper" / "d.webp", "");
+  WriteFile(root / "e" / "f.gif", "");
+  const std::string file = (root / "b.png").string();
+
+  for (size_t num_threads : {1, 4}) {
+    const StatusOr<std::vector<FoundImage>> images = FindImageFiles(
+        {file, root.string(), "missing.png", "missing_folder"},
+        /*manifest_path=*/"", num_threads, /*quiet=*/false);
+    ASSERT_EQ(images.status, Status::kOk);
+    EXPECT_EQ(Paths(images.value),
+              (std::vector<std::string>{
+                  file, (root / "a" / "c.JPG").string(),
+                  (root / "a" / "deeper" / "d.webp").string(), file,
+                  (root / "e" / "f.gif").string(), "missing.png"}));
+    // Nothing is probed without manifest.
+    EXPECT_FALSE(images.value.front().header.IsKnown());
+  }
+}
+
+TEST(ImageManifestTest, ReusesUnchangedFolders) {
+  const std::filesystem::path root =
+      std::filesystem::path(::testing::TempDir()) / "manifest_reuse";
+  std::filesystem::remove_all(root);
+  const std::string manifest =
+      (std::filesystem::path(::testing::TempDir()) / "manifest_reuse.tsv")
+          .string();
+  std::filesystem::remove(manifest);
+  WriteFile(root / "a.png", PngHeader(3, 2));
+  WriteFile(root / "sub" / "b.png", PngHeader(5, 4));
+
+  StatusOr<std::vector<FoundImage>> images =
+      FindImageFiles({root.string()}, manifest, 2, /*quiet=*/false);
+  ASSERT_EQ(images.status, Status::kOk);
+  ASSERT_EQ(images.value.size(), 2u);
+  EXPECT_EQ(images.value[0].header.width, 3u);
+  EXPECT_EQ(images.value[1].header.width, 5u);
+  EXPECT_TRUE(std::filesystem::exists(manifest));
+
+  // An unchanged folder and its unchanged files are taken from the manifest.
+  images = FindImageFiles({root.string()}, manifest, 2, /*quiet=*/false);
+  ASSERT_EQ(images.status, Status::kOk);
+  ASSERT_EQ(images.value.size(), 2u);
+  EXPECT_EQ(images.value[0].header.width, 3u);
+  EXPECT_TRUE(images.value[0].header.IsKnownOpaque());
+
+  // Rewriting a file in place does not change its folder but the file is
+  // probed again.
+  const std::filesystem::file_time_type root_time =
+      std::filesystem::last_write_time(root);
+  const std::filesystem::file_time_type file_time =
+      std::filesystem::last_write_time(root / "a.png");
+  WriteFile(root / "a.png", PngHeader(7, 6));
+  std::filesystem::last_write_time(root / "a.png",
+                                   file_time + std::chrono::seconds(1));
+  std::filesystem::last_write_time(root, root_time);
+  images = FindImageFiles({root.string()}, manifest, 2, /*quiet=*/false);
+  ASSERT_EQ(images.status, Status::kOk);
+  ASSERT_EQ(images.value.size(), 2u);
+  EXPECT_EQ(images.value[0].header.width, 7u);
+
+  // A changed folder is listed again and its changed files are probed again.
+  WriteFile(root / "c.png", PngHeader(9, 8));
+  std::filesystem::last_write_time(root, root_time + std::chrono::seconds(1));
+  images = FindImageFiles({root.string()}, manifest, 2, /*quiet=*/false);
+  ASSERT_EQ(images.status, Status::kOk);
+  ASSERT_EQ(images.value.size(), 3u);
+  EXPECT_EQ(images.value[0].path, (root / "a.png").string());
+  EXPECT_EQ(images.value[0].header.width, 7u);
+  EXPECT_EQ(images.value[1].path, (root / "c.png").string());
+  EXPECT_EQ(images.value[1].header.width, 9u);
+  EXPECT_EQ(images.value[2].header.width, 5u);
+
+  // A corrupted manifest is ignored and rewritten.
+  WriteFile(manifest, "something else");
+  images = FindImageFiles({root.string()}, manifest, 2, /*quiet=*/true);
+  ASSERT_EQ(images.status, Status::kOk);
+  EXPECT_EQ(images.value.size(), 3u);
+  images = FindImageFiles({root.string()}, manifest, 2, /*quiet=*/false);
+  ASSERT_EQ(images.status, Status::kOk);
+  EXPECT_EQ(images.value.size(), 3u);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,86 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/image_prefetcher.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::string WriteFile(const std::string& file_name) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / file_name).string();
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << std::string(3 << 20, 'a');  // Several read() calls.
+  return path;
+}
+
+TEST(ImagePrefetcherTest, HitsAndMisses) {
+  const std::string a = WriteFile("prefetch_a.png");
+  const std::string b = WriteFile("prefetch_b.png");
+  ImagePrefetcher prefetcher;
+  prefetcher.Prefetch({a, a});
+  for (int i = 0; i < 1000 && prefetcher.num_prefetched() == 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(prefetcher.num_prefetched(), 1u);
+  prefetcher.Wait(a);
+  EXPECT_EQ(prefetcher.num_hits(), 1u);
+  EXPECT_EQ(prefetcher.num_misses(), 0u);
+  EXPECT_EQ(prefetcher.stall_seconds(), 0);
+
+  prefetcher.Wait(b);  // Not prefetched.
+  prefetcher.Wait("missing.png");
+  EXPECT_EQ(prefetcher.num_hits(), 1u);
+  EXPECT_EQ(prefetcher.num_misses(), 2u);
+  EXPECT_GT(prefetcher.stall_seconds(), 0);
+
+  // Remembered for the next tasks of the same images.
+  const double stall_seconds = prefetcher.stall_seconds();
+  prefetcher.Wait(a);
+  prefetcher.Wait(b);
+  EXPECT_EQ(prefetcher.num_hits(), 3u);
+  EXPECT_EQ(prefetcher.num_misses(), 2u);
+  EXPECT_EQ(prefetcher.stall_seconds(), stall_seconds);
+}
+
+TEST(ImagePrefetcherTest, Concurrent) {
+  std::vector<std::string> paths;
+  for (int i = 0; i < 8; ++i) {
+    paths.push_back(WriteFile("prefetch_" + std::to_string(i) + ".png"));
+  }
+  ImagePrefetcher prefetcher;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (const std::string& path : paths) {
+        prefetcher.Prefetch(paths);
+        prefetcher.Wait(path);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(prefetcher.num_hits() + prefetcher.num_misses(), 4u * 8u);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,143 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_governor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TEST(MemoryGovernorTest, EstimateFromDimensions) {
+  EXPECT_EQ(GetDecodedNumBytes(10, 20, 8, 1), 10 * 20 * 4);
+  EXPECT_EQ(GetDecodedNumBytes(10, 20, 16, 3), 10 * 20 * 8 * 3);
+  EXPECT_EQ(GetDecodedNumBytes(10, 20, 8, 0), 10 * 20 * 4);
+  EXPECT_GT(EstimateTaskPeakMemory(Codec::kAvif, 1000),
+            EstimateTaskPeakMemory(Codec::kWebp, 1000));
+  EXPECT_GT(EstimateTaskPeakMemory(Codec::kCombination, 1000),
+            EstimateTaskPeakMemory(Codec::kJpegXl, 1000));
+
+  TaskOutput completed;
+  completed.task_input.image_path = "completed.png";
+  completed.task_input.codec_settings.codec = Codec::kWebp;
+  completed.image_width = 100;
+  completed.image_height = 50;
+  completed.bit_depth = 8;
+  completed.num_frames = 2;
+  TaskMemoryModel model({completed});
+  TaskInput task = completed.task_input;
+  task.codec_settings.codec = Codec::kJpegXl;
+  EXPECT_EQ(model.Estimate(task),
+            EstimateTaskPeakMemory(Codec::kJpegXl, 100 * 50 * 4 * 2));
+
+  // Unknown and missing image.
+  task.image_path = "missing.png";
+  EXPECT_EQ(model.Estimate(task), 0);
+  completed.task_input.image_path = task.image_path;
+  model.Learn(completed);
+  EXPECT_EQ(model.Estimate(task),
+            EstimateTaskPeakMemory(Codec::kJpegXl, 100 * 50 * 4 * 2));
+}
+
+TEST(MemoryGovernorTest, AdmitUnderBudget) {
+  MemoryGovernor governor(100);
+  governor.Admit(60);
+  governor.Admit(40);
+  EXPECT_EQ(governor.num_admitted_bytes(), 100);
+  EXPECT_EQ(governor.num_waits(), 0);
+
+  std::atomic<bool> is_admitted(false);
+  std::thread thread([&]() {
+    governor.Admit(50);
+    is_admitted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(is_admitted);
+  governor.Release(40);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(is_admitted);  // 60 + 50 > 100.
+  governor.Release(60);
+  thread.join();
+  EXPECT_TRUE(is_admitted);
+  EXPECT_EQ(governor.num_admitted_bytes(), 50);
+  EXPECT_EQ(governor.num_waits(), 1);
+  governor.Release(50);
+}
+
+TEST(MemoryGovernorTest, SmallTasksFillIn) {
+  MemoryGovernor governor(100);
+  governor.Admit(70);
+  std::atomic<bool> is_large_admitted(false);
+  std::thread large([&]() {
+    governor.Admit(80);
+    is_large_admitted = true;
+  });
+  // Smaller tasks are not blocked by the waiting large one.
+  { const MemoryAdmission small(&governor, 20); }
+  { const MemoryAdmission small(&governor, 30); }
+  EXPECT_FALSE(is_large_admitted);
+  governor.Release(70);
+  large.join();
+  EXPECT_EQ(governor.num_admitted_bytes(), 80);
+  governor.Release(80);
+}
+
+TEST(MemoryGovernorTest, LargerThanBudgetRunsAlone) {
+  MemoryGovernor governor(100);
+  governor.Admit(1000);
+  std::atomic<bool> is_admitted(false);
+  std::thread thread([&]() {
+    const MemoryAdmission admission(&governor, 1);
+    is_admitted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(is_admitted);
+  governor.Release(1000);
+  thread.join();
+  EXPECT_TRUE(is_admitted);
+  EXPECT_EQ(governor.num_admitted_bytes(), 0);
+
+  const MemoryAdmission no_governor(nullptr, 1000);
+}
+
+TEST(MemoryGovernorTest, MovedAdmission) {
+  MemoryGovernor governor(100);
+  MemoryAdmission moved;
+  {
+    MemoryAdmission admission(&governor, 60);
+    moved = std::move(admission);
+  }
+  // Still admitted once the original admission is destroyed.
+  EXPECT_EQ(governor.num_admitted_bytes(), 60);
+  MemoryAdmission other(std::move(moved));
+  EXPECT_EQ(governor.num_admitted_bytes(), 60);
+  moved = MemoryAdmission(&governor, 10);
+  EXPECT_EQ(governor.num_admitted_bytes(), 70);
+  other.Reset();
+  EXPECT_EQ(governor.num_admitted_bytes(), 10);
+  moved = std::move(other);  // Releases the 10 bytes.
+  EXPECT_EQ(governor.num_admitted_bytes(), 0);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,90 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "src/output_file.h"
+
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr bool kQuiet = false;
+
+std::string TempPath(const std::string& extension) {
+  return (std::filesystem::path(::testing::TempDir()) /
+          (testing::UnitTest::GetInstance()->current_test_info()->name() +
+           extension))
+      .string();
+}
+
+// More than the internal buffer of OutputFile.
+std::string Contents() {
+  std::string contents;
+  for (int i = 0; i < 100000; ++i) contents += std::to_string(i) + ",";
+  return contents;
+}
+
+TEST(OutputFileTest, Plain) {
+  const std::string path = TempPath(".txt");
+  OutputFile file;
+  ASSERT_EQ(file.Open(path, /*gzip=*/false, kQuiet), Status::kOk);
+  file.stream() << Contents() << std::endl;
+  ASSERT_EQ(file.Close(kQuiet), Status::kOk);
+  EXPECT_EQ((std::ostringstream() << std::ifstream(path).rdbuf()).str(),
+            Contents() + "\n");
+}
+
+TEST(OutputFileTest, Gzip) {
+  const std::string path = TempPath(".txt.gz");
+  {
+    OutputFile file;
+    ASSERT_EQ(file.Open(path, /*gzip=*/true, kQuiet), Status::kOk);
+    file.stream() << Contents() << std::endl << "end";
+    ASSERT_EQ(file.Close(kQuiet), Status::kOk);
+  }
+  EXPECT_LT(std::filesystem::file_size(path), Contents().size() / 2);
+
+  const gzFile file = gzopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::string decompressed;
+  char buffer[4096];
+  int num_bytes;
+  while ((num_bytes = gzread(file, buffer, sizeof(buffer))) > 0) {
+    decompressed.append(buffer, num_bytes);
+  }
+  EXPECT_EQ(num_bytes, 0);
+  EXPECT_EQ(gzclose(file), Z_OK);
+  EXPECT_EQ(decompressed, Contents() + "\nend");
+}
+
+TEST(OutputFileTest, OpenFailure) {
+  OutputFile file;
+  EXPECT_NE(file.Open("/nonexistent_folder/file.txt", /*gzip=*/false,
+                      /*quiet=*/true),
+            Status::kOk);
+  EXPECT_NE(file.Open("/nonexistent_folder/file.txt.gz", /*gzip=*/true,
+                      /*quiet=*/true),
+            Status::kOk);
+  EXPECT_EQ(file.Close(kQuiet), Status::kOk);  // Nothing to close.
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,83 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/pixel_kernels.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::vector<uint8_t> RandomBytes(size_t size, std::mt19937& rng) {
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) byte = static_cast<uint8_t>(distribution(rng));
+  return bytes;
+}
+
+TEST(PixelKernelsTest, InstructionSet) {
+  EXPECT_NE(PixelKernelsInstructionSet(), nullptr);
+}
+
+TEST(PixelKernelsTest, BytesEqual) {
+  std::mt19937 rng(1);
+  // Cover the vector loops and their scalar tails.
+  for (size_t size : {0, 1, 15, 16, 63, 64, 127, 128, 1000, 4099}) {
+    const std::vector<uint8_t> a = RandomBytes(size, rng);
+    std::vector<uint8_t> b = a;
+    EXPECT_TRUE(BytesEqual(a.data(), b.data(), size)) << size;
+    for (size_t i : {size_t{0}, size / 2, size - 1}) {
+      if (i >= size) continue;
+      b[i] ^= 1;
+      EXPECT_FALSE(BytesEqual(a.data(), b.data(), size)) << size << " " << i;
+      EXPECT_FALSE(BytesEqualScalar(a.data(), b.data(), size));
+      b[i] ^= 1;
+    }
+  }
+}
+
+TEST(PixelKernelsTest, SumOfSquaredDifferences) {
+  std::mt19937 rng(2);
+  for (size_t size : {0, 1, 15, 16, 31, 32, 33, 1000, 4099}) {
+    const std::vector<uint8_t> a = RandomBytes(size, rng);
+    const std::vector<uint8_t> b = RandomBytes(size, rng);
+    EXPECT_EQ(SumOfSquaredDifferences(a.data(), b.data(), size),
+              SumOfSquaredDifferencesScalar(a.data(), b.data(), size))
+        << size;
+    EXPECT_EQ(SumOfSquaredDifferences(a.data(), a.data(), size), 0u);
+  }
+}
+
+TEST(PixelKernelsTest, SumOfSquaredDifferencesDoesNotOverflow) {
+  // Each lane accumulates many maximal differences between flushes.
+  const size_t size = (size_t{1} << 20) + 17;
+  const std::vector<uint8_t> a(size, 0), b(size, 255);
+  EXPECT_EQ(SumOfSquaredDifferences(a.data(), b.data(), size),
+            uint64_t{size} * 255 * 255);
+}
+
+TEST(PixelKernelsTest, SumOfSquaredDifferences16b) {
+  const std::vector<uint16_t> a = {0, 65535, 1000, 7};
+  const std::vector<uint16_t> b = {65535, 0, 1002, 7};
+  EXPECT_EQ(SumOfSquaredDifferences(a.data(), b.data(), a.size()),
+            uint64_t{65535} * 65535 * 2 + 4);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,90 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/progress_tracker.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+#include "src/task_cost.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr Codec kWebp = Codec::kWebp;
+constexpr Codec kJpegXl = Codec::kJpegXl;
+constexpr Subsampling kDef = Subsampling::kDefault;
+
+TaskOutput MakeCompletedTask(const TaskInput& input, double seconds) {
+  TaskOutput task = MakeTaskOutput(input, /*image_width=*/1000,
+                                   /*image_height=*/1000);
+  task.encoding_duration = seconds;
+  task.decoding_duration = 0;
+  return task;
+}
+
+TEST(ProgressTrackerTest, UnknownUntilCompleted) {
+  const std::vector<TaskInput> tasks = {{{kWebp, kDef, 0, 0}, "A"}};
+  ProgressTracker tracker(tasks, /*history=*/nullptr);
+  EXPECT_LT(tracker.EstimateSecondsLeft(10, 1), 0);
+  tracker.OnFailed(tasks[0]);
+  EXPECT_LT(tracker.EstimateSecondsLeft(10, 0), 0);
+  EXPECT_EQ(tracker.ThroughputToString(10), "");
+}
+
+TEST(ProgressTrackerTest, PerCodecEstimate) {
+  std::vector<TaskInput> tasks;
+  for (int quality = 0; quality < 10; ++quality) {
+    tasks.push_back({{kWebp, kDef, 0, quality}, "A"});
+    tasks.push_back({{kJpegXl, kDef, 9, quality}, "A"});
+  }
+  ProgressTracker tracker(tasks, /*history=*/nullptr);
+  tracker.OnCompleted(MakeCompletedTask(tasks[0], 1));   // WebP
+  tracker.OnCompleted(MakeCompletedTask(tasks[1], 99));  // JPEG XL
+  // 9 WebP at 1 second and 9 JPEG XL at 99 seconds are left, relatively to
+  // the 100 seconds completed in 10 elapsed seconds.
+  EXPECT_DOUBLE_EQ(tracker.EstimateSecondsLeft(10, 18), 90);
+  // Unknown tasks cost the average.
+  EXPECT_DOUBLE_EQ(tracker.EstimateSecondsLeft(10, 20), 100);
+
+  EXPECT_EQ(tracker.ThroughputToString(2),
+            "webp: 0.5 tasks/s, 0.5 MP/s, jpegxl: 0.5 tasks/s, 0.5 MP/s");
+  const std::string json = tracker.ToJson(
+      /*elapsed_seconds=*/2, /*num_tasks=*/20, /*num_completed_tasks=*/2,
+      /*num_failed_tasks=*/0, /*num_remaining_tasks=*/18, /*is_done=*/false);
+  EXPECT_NE(json.find("\"estimated_seconds_left\": 18,"), std::string::npos);
+  EXPECT_NE(json.find("{\"codec\": \"jpegxl\", \"num_completed_tasks\": 1, "
+                      "\"num_remaining_tasks\": 9"),
+            std::string::npos);
+  EXPECT_NE(json.find("\"done\": false"), std::string::npos);
+}
+
+TEST(ProgressTrackerTest, History) {
+  const TaskCostModel history({MakeCompletedTask({{kJpegXl, kDef, 9, 0}, "A"},
+                                                 /*seconds=*/50)});
+  const std::vector<TaskInput> tasks = {{{kWebp, kDef, 0, 0}, "A"},
+                                        {{kJpegXl, kDef, 9, 0}, "A"},
+                                        {{kJpegXl, kDef, 9, 1}, "A"}};
+  ProgressTracker tracker(tasks, &history);
+  tracker.OnCompleted(MakeCompletedTask(tasks[0], 1));
+  // 2 JPEG XL tasks at 50 seconds each as in the history.
+  EXPECT_DOUBLE_EQ(tracker.EstimateSecondsLeft(1, 2), 100);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
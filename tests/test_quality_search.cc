@@ -0,0 +1,254 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/quality_search.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/framework.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TEST(QualitySearchTest, Bisection) {
+  const std::vector<int> qualities = {0, 10, 20, 30, 40, 50, 60, 70, 80};
+  for (size_t expected = 0; expected <= qualities.size(); ++expected) {
+    QualitySearch search(qualities);
+    EXPECT_EQ(search.MaxNumProbes(), 4);
+    size_t num_probes = 0;
+    while (!search.IsDone()) {
+      const int quality = search.NextQuality();
+      search.Record(expected < qualities.size() &&
+                    quality >= qualities[expected]);
+      ++num_probes;
+    }
+    EXPECT_LE(num_probes, 4);
+    EXPECT_EQ(search.result(), expected);
+  }
+  EXPECT_TRUE(QualitySearch({}).IsDone());
+}
+
+TEST(QualitySearchTest, ReachesTarget) {
+  TaskOutput task = {};
+  task.image_width = 10;
+  task.image_height = 10;
+  task.num_frames = 1;
+  task.encoded_size = 25;  // 2 bits per pixel
+  for (float& distortion : task.distortions) {
+    distortion = kDistortionNotComputed;
+  }
+  task.distortions[static_cast<size_t>(DistortionMetric::kLibwebp2Psnr)] = 40;
+  task.distortions[static_cast<size_t>(DistortionMetric::kDssim)] = 0.01f;
+
+  QualitySearchSettings settings;
+  const auto reaches_target = [&]() {
+    return ReachesTarget(settings, GetRateDistortionPoint(settings, task));
+  };
+  settings.target = QualitySearchTarget::kBitsPerPixel;
+  settings.value = 1.5;
+  EXPECT_TRUE(reaches_target());
+  settings.value = 2.5;
+  EXPECT_FALSE(reaches_target());
+
+  settings.target = QualitySearchTarget::kDistortion;
+  settings.metric = DistortionMetric::kLibwebp2Psnr;
+  settings.value = 35;
+  EXPECT_TRUE(reaches_target());
+  settings.value = 45;
+  EXPECT_FALSE(reaches_target());
+  settings.metric = DistortionMetric::kDssim;
+  settings.value = 0.02;
+  EXPECT_TRUE(reaches_target());
+  settings.value = 0.005;
+  EXPECT_FALSE(reaches_target());
+  settings.metric = DistortionMetric::kLibjxlSsimulacra2;  // Not computed.
+  EXPECT_FALSE(reaches_target());
+}
+
+TEST(QualitySearchTest, NextCurveSamples) {
+  // Distortion is linear with bits per pixel but with a knee at index 6.
+  std::vector<std::optional<RateDistortionPoint>> points(17);
+  const auto probe = [&](const std::vector<size_t>& indices) {
+    for (size_t i : indices) {
+      points[i] = RateDistortionPoint{static_cast<double>(i),
+                                      i < 6 ? 10.f * i : 60.f + i - 6};
+    }
+  };
+  std::vector<size_t> samples =
+      NextCurveSamples(points, /*num_initial_samples=*/3, /*max_error=*/1);
+  EXPECT_EQ(samples, std::vector<size_t>({0, 8, 16}));
+  probe(samples);
+  samples = NextCurveSamples(points, 3, 1);
+  EXPECT_EQ(samples, std::vector<size_t>({4, 12}));
+  probe(samples);
+  // Index 12 is on a straight segment, so only [0:8] is refined.
+  samples = NextCurveSamples(points, 3, 1);
+  EXPECT_EQ(samples, std::vector<size_t>({2, 6}));
+  probe(samples);
+  samples = NextCurveSamples(points, 3, 1);
+  EXPECT_EQ(samples, std::vector<size_t>({5, 7}));
+  probe(samples);
+  EXPECT_TRUE(NextCurveSamples(points, 3, 1).empty());
+
+  EXPECT_TRUE(NextCurveSamples({}, 3, 1).empty());
+  EXPECT_EQ(NextCurveSamples({std::nullopt}, 3, 1), std::vector<size_t>({0}));
+}
+
+// Encoded size in bytes of a 1x1 image at the given quality.
+TaskOutput MakeOutput(const TaskInput& input) {
+  TaskOutput task = MakeTaskOutput(input);
+  task.encoded_size = input.codec_settings.quality;
+  return task;
+}
+
+TEST(QualitySearchTest, Searches) {
+  // Two images, qualities 0 to 9, two repetitions each.
+  std::vector<TaskInput> planned_tasks;
+  for (const char* image : {"a.png", "b.png"}) {
+    for (int quality = 0; quality < 10; ++quality) {
+      for (int repetition = 0; repetition < 2; ++repetition) {
+        planned_tasks.push_back(
+            {{Codec::kWebp, Subsampling::kDefault, /*effort=*/4, quality},
+             image,
+             ""});
+      }
+    }
+  }
+  // Lowest quality above 36 bits per pixel: 5.
+  QualitySearchSettings settings;
+  settings.target = QualitySearchTarget::kBitsPerPixel;
+  settings.value = 36;
+  // The first probe of image "b.png" was already done.
+  const std::vector<TaskOutput> completed_tasks = {
+      MakeOutput(planned_tasks[30]), MakeOutput(planned_tasks[31])};
+  planned_tasks.erase(planned_tasks.begin() + 30, planned_tasks.begin() + 32);
+
+  QualitySearches searches(settings, planned_tasks, completed_tasks);
+  EXPECT_EQ(searches.MaxNumRemainingTasks(), 2 * 4 * 2);
+  std::vector<TaskOutput> extrapolated_tasks;
+  std::vector<TaskInput> tasks = searches.TakeFirstTasks(extrapolated_tasks);
+  std::map<std::string, std::vector<int>> probed_qualities;
+  while (!tasks.empty()) {
+    const TaskInput task = tasks.back();
+    tasks.pop_back();
+    probed_qualities[task.image_path].push_back(task.codec_settings.quality);
+    for (const TaskInput& next_task :
+         searches.OnTaskCompleted(MakeOutput(task), extrapolated_tasks)) {
+      tasks.push_back(next_task);
+    }
+  }
+  // Bisection of [0:10): 5, 2, 4. Each quality is run twice.
+  EXPECT_EQ(probed_qualities["a.png"],
+            std::vector<int>({5, 5, 2, 2, 4, 4}));
+  EXPECT_TRUE(extrapolated_tasks.empty());
+  EXPECT_EQ(probed_qualities["b.png"], std::vector<int>({2, 2, 4, 4}));
+  EXPECT_EQ(searches.MaxNumRemainingTasks(), 0);
+}
+
+TEST(QualitySearchTest, CurveSampling) {
+  std::vector<TaskInput> planned_tasks;
+  for (int quality = 0; quality <= 8; ++quality) {
+    planned_tasks.push_back(
+        {{Codec::kWebp, Subsampling::kDefault, /*effort=*/4, quality},
+         "a.png",
+         ""});
+  }
+  QualitySearchSettings settings;
+  settings.target = QualitySearchTarget::kRateDistortionCurve;
+  settings.metric = DistortionMetric::kLibwebp2Psnr;
+  settings.value = 0.5;
+  settings.num_initial_curve_qualities = 3;
+  QualitySearches searches(settings, planned_tasks, {});
+  EXPECT_EQ(searches.MaxNumRemainingTasks(), 9);
+
+  std::vector<TaskOutput> extrapolated_tasks;
+  std::vector<TaskInput> tasks = searches.TakeFirstTasks(extrapolated_tasks);
+  std::vector<int> probed_qualities;
+  while (!tasks.empty()) {
+    const TaskInput task = tasks.front();
+    tasks.erase(tasks.begin());
+    probed_qualities.push_back(task.codec_settings.quality);
+    TaskOutput output = MakeOutput(task);
+    // A straight line.
+    output.distortions[static_cast<size_t>(settings.metric)] =
+        2.f * task.codec_settings.quality;
+    for (const TaskInput& next_task :
+         searches.OnTaskCompleted(output, extrapolated_tasks)) {
+      tasks.push_back(next_task);
+    }
+  }
+  EXPECT_EQ(probed_qualities, std::vector<int>({0, 4, 8, 2, 6}));
+  EXPECT_EQ(searches.MaxNumRemainingTasks(), 0);
+}
+
+TEST(QualitySearchTest, PruneSaturated) {
+  std::vector<TaskInput> planned_tasks;
+  for (const char* image : {"a.png", "b.png"}) {
+    for (int quality = 0; quality < 10; ++quality) {
+      planned_tasks.push_back(
+          {{Codec::kWebp, Subsampling::kDefault, /*effort=*/4, quality},
+           image,
+           ""});
+    }
+  }
+  QualitySearchSettings settings;
+  settings.prune_saturated = true;
+  QualitySearches searches(settings, planned_tasks, {});
+
+  std::vector<TaskOutput> extrapolated_tasks;
+  std::vector<TaskInput> tasks = searches.TakeFirstTasks(extrapolated_tasks);
+  std::map<std::string, std::vector<int>> probed_qualities;
+  while (!tasks.empty()) {
+    const TaskInput task = tasks.front();
+    tasks.erase(tasks.begin());
+    const int quality = task.codec_settings.quality;
+    probed_qualities[task.image_path].push_back(quality);
+    TaskOutput output = MakeOutput(task);
+    if (task.image_path == "a.png") {
+      output.encoded_size = std::min(quality, 4);  // Stops changing.
+    } else if (quality >= 2) {
+      std::fill(output.distortions, output.distortions + kNumDistortionMetrics,
+                kNoDistortion);  // Lossless.
+    }
+    for (const TaskInput& next_task :
+         searches.OnTaskCompleted(output, extrapolated_tasks)) {
+      tasks.push_back(next_task);
+    }
+  }
+  EXPECT_EQ(probed_qualities["a.png"],
+            std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(probed_qualities["b.png"], std::vector<int>({0, 1, 2}));
+  ASSERT_EQ(extrapolated_tasks.size(), 3 + 7);
+  for (const TaskOutput& task : extrapolated_tasks) {
+    EXPECT_TRUE(task.is_extrapolated);
+    EXPECT_GT(task.task_input.codec_settings.quality,
+              task.task_input.image_path == "a.png" ? 6 : 2);
+    if (task.task_input.image_path == "a.png") {
+      EXPECT_EQ(task.encoded_size, 4);
+    }
+  }
+  EXPECT_EQ(searches.MaxNumRemainingTasks(), 0);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,113 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/remote_tasks.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TEST(RemoteTasksTest, SerializeTask) {
+  TaskInput input{{Codec::kWebp, Subsampling::k420, /*effort=*/4,
+                   /*quality=*/75, /*num_threads=*/2},
+                  "images/with, comma \"and quotes\".png",
+                  "encoded/image.webp"};
+  const std::string serialized =
+      SerializeRemoteTask(input, EncodeMode::kEncodeAndSaveToDisk);
+
+  TaskInput unserialized;
+  EncodeMode encode_mode = EncodeMode::kEncode;
+  ASSERT_EQ(UnserializeRemoteTask(serialized, unserialized, encode_mode,
+                                  /*quiet=*/false),
+            Status::kOk);
+  EXPECT_EQ(unserialized, input);
+  EXPECT_EQ(unserialized.encoded_path, input.encoded_path);
+  EXPECT_EQ(unserialized.codec_settings.num_threads, 2u);
+  EXPECT_EQ(encode_mode, EncodeMode::kEncodeAndSaveToDisk);
+
+  EXPECT_NE(UnserializeRemoteTask(input.Serialize(), unserialized, encode_mode,
+                                  /*quiet=*/true),
+            Status::kOk);
+  EXPECT_NE(UnserializeRemoteTask("9" + serialized.substr(1), unserialized,
+                                  encode_mode, /*quiet=*/true),
+            Status::kOk);
+}
+
+TEST(RemoteTasksTest, Loopback) {
+  TaskServer server;
+  const Status status = server.Start(
+      /*address=*/"", /*port=*/0,
+      [](LineConnection& connection) {
+        std::string line;
+        while (connection.ReadLine(line)) {
+          if (!connection.WriteLine("echo " + line)) return;
+        }
+      },
+      /*quiet=*/false);
+  if (status != Status::kOk) GTEST_SKIP() << "No socket";
+  ASSERT_NE(server.port(), 0);
+  const std::string address = "localhost:" + std::to_string(server.port());
+
+  LineConnection client;
+  ASSERT_EQ(client.Connect(address, /*quiet=*/false), Status::kOk);
+  std::string line;
+  ASSERT_TRUE(client.WriteLine("a") && client.WriteLine("b"));
+  ASSERT_TRUE(client.ReadLine(line));
+  EXPECT_EQ(line, "echo a");
+  ASSERT_TRUE(client.ReadLine(line));
+  EXPECT_EQ(line, "echo b");
+
+  // Stop() does not wait for idle clients.
+  LineConnection idle_client;
+  ASSERT_EQ(idle_client.Connect(address, /*quiet=*/false), Status::kOk);
+  server.Stop();
+  EXPECT_FALSE(client.ReadLine(line));
+  EXPECT_FALSE(idle_client.ReadLine(line));
+}
+
+TEST(RemoteTasksTest, ReadTimeout) {
+  TaskServer server;
+  const Status status = server.Start(
+      /*address=*/"localhost", /*port=*/0,
+      [](LineConnection& connection) {
+        connection.SetReadTimeout(0.1);
+        std::string line;
+        while (connection.ReadLine(line)) {
+          if (!connection.WriteLine("echo " + line)) return;
+        }
+        (void)connection.WriteLine("timeout");
+      },
+      /*quiet=*/false);
+  if (status != Status::kOk) GTEST_SKIP() << "No socket";
+  LineConnection client;
+  ASSERT_EQ(client.Connect("localhost:" + std::to_string(server.port()),
+                           /*quiet=*/false),
+            Status::kOk);
+  std::string line;
+  ASSERT_TRUE(client.WriteLine("a"));
+  ASSERT_TRUE(client.ReadLine(line));
+  EXPECT_EQ(line, "echo a");
+  // The silent client is given up on without closing the connection.
+  ASSERT_TRUE(client.ReadLine(line));
+  EXPECT_EQ(line, "timeout");
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
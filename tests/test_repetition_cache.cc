@@ -0,0 +1,84 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/repetition_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+TaskOutput MakeTask(int quality, size_t encoded_size, float distortion) {
+  TaskOutput task = MakeTaskOutput(
+      {{Codec::kWebp, Subsampling::kDefault, /*effort=*/0, quality},
+       "img.png",
+       "img.webp"});
+  task.encoded_size = encoded_size;
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+            distortion);
+  return task;
+}
+
+TEST(RepetitionCacheTest, ReuseDistortions) {
+  RepetitionCache cache(/*num_repetitions=*/2);
+  TaskOutput repetition = MakeTask(/*quality=*/50, /*encoded_size=*/10, 0);
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/123, repetition));
+
+  cache.Insert(MakeTask(/*quality=*/50, /*encoded_size=*/10, 42),
+               /*encoded_digest=*/123);
+  // Another quality, another size or other bytes do not match.
+  TaskOutput other_quality = MakeTask(/*quality=*/60, /*encoded_size=*/10, 0);
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/123, other_quality));
+  TaskOutput other_size = MakeTask(/*quality=*/50, /*encoded_size=*/11, 0);
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/123, other_size));
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/456, repetition));
+
+  ASSERT_TRUE(cache.Reuse(/*encoded_digest=*/123, repetition));
+  EXPECT_EQ(repetition.distortions[0], 42);
+  EXPECT_EQ(repetition.distortions[kNumDistortionMetrics - 1], 42);
+  EXPECT_EQ(cache.num_hits(), 1);
+
+  // Each of the two repetitions goes through the cache once.
+  TaskOutput last = MakeTask(/*quality=*/50, /*encoded_size=*/10, 0);
+  EXPECT_TRUE(cache.Reuse(/*encoded_digest=*/123, last));
+  TaskOutput extra = MakeTask(/*quality=*/50, /*encoded_size=*/10, 0);
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/123, extra));
+  EXPECT_EQ(cache.num_hits(), 2);
+}
+
+TEST(RepetitionCacheTest, ConcurrentRepetitions) {
+  RepetitionCache cache(/*num_repetitions=*/1);
+  // Both repetitions miss, for example because they ran at the same time.
+  cache.Insert(MakeTask(/*quality=*/50, /*encoded_size=*/10, 42),
+               /*encoded_digest=*/123);
+  cache.Insert(MakeTask(/*quality=*/50, /*encoded_size=*/10, 42),
+               /*encoded_digest=*/123);
+  // The entry is dropped once both went through the cache.
+  TaskOutput task = MakeTask(/*quality=*/50, /*encoded_size=*/10, 0);
+  EXPECT_FALSE(cache.Reuse(/*encoded_digest=*/123, task));
+
+  RepetitionCache no_repetition(/*num_repetitions=*/0);
+  no_repetition.Insert(MakeTask(/*quality=*/50, /*encoded_size=*/10, 42),
+                       /*encoded_digest=*/123);
+  EXPECT_FALSE(no_repetition.Reuse(/*encoded_digest=*/123, task));
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,96 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/resource_usage.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+uint64_t BusyLoop() {
+  volatile uint64_t sum = 0;
+  for (uint64_t i = 0; i < 10000000; ++i) sum = sum + i;
+  return sum;
+}
+
+TEST(ResourceUsageTest, NothingMeasuredByDefault) {
+  ResourceUsageMeter meter(ResourceUsageSettings{});
+  meter.Start();
+  BusyLoop();
+  EXPECT_FALSE(meter.Stop().IsMeasured());
+}
+
+TEST(ResourceUsageTest, CpuTimeAndHardwareCounters) {
+  ResourceUsageSettings settings;
+  settings.cpu_time = true;
+  settings.hardware_counters = true;
+  ResourceUsageMeter meter(settings);
+  meter.Start();
+  BusyLoop();
+  const ResourceUsage usage = meter.Stop();
+#if defined(__linux__)
+  EXPECT_GT(usage.cpu_time, 0);
+#endif
+  // The hardware counters may not be permitted.
+  if (usage.instructions >= 0) {
+    EXPECT_GT(usage.instructions, 10000000);
+  }
+}
+
+TEST(ResourceUsageTest, PeakMemory) {
+  ResourceUsageSettings settings;
+  settings.peak_memory = true;
+  ResourceUsageMeter meter(settings);
+  meter.Start();
+  {
+    std::vector<char> buffer(64 << 20);
+    std::memset(buffer.data(), 1, buffer.size());  // Make it resident.
+  }
+  const ResourceUsage usage = meter.Stop();
+#if defined(__linux__)
+  // The kernel does not account the resident pages exactly.
+  EXPECT_GT(usage.peak_memory, 48 << 20);
+#endif
+  EXPECT_EQ(usage.cpu_time, -1);
+
+  // The peak is reset at each Start().
+  meter.Start();
+  EXPECT_LT(meter.Stop().peak_memory, 48 << 20);
+}
+
+TEST(ResourceUsageTest, Average) {
+  ResourceUsage sum;
+  sum.cpu_time = 1;
+  sum.cycles = 10;
+  ResourceUsage other;
+  other.cpu_time = 2;
+  other.cycles = 20;
+  other.peak_memory = 100;  // Not measured in sum so ignored.
+  other.instructions = 30;
+  sum.Add(other);
+  sum.Divide(2);
+  EXPECT_EQ(sum.cpu_time, 1.5);
+  EXPECT_EQ(sum.cycles, 15);
+  EXPECT_EQ(sum.instructions, -1);
+  EXPECT_EQ(sum.cache_misses, -1);
+  EXPECT_EQ(sum.peak_memory, -1);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -12,7 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -39,6 +43,41 @@ TEST(SerializationTest, Split) {
             std::vector<std::string>({"\"a, b\"", "c"}));
 }
 
+TEST(SerializationTest, SplitViews) {
+  std::vector<std::string_view> tokens;
+  SplitViews("", ',', tokens);
+  EXPECT_EQ(tokens, std::vector<std::string_view>{""});
+  SplitViews(" a ,b,", ',', tokens);
+  EXPECT_EQ(tokens, std::vector<std::string_view>({"a", "b", ""}));
+  SplitViews("\"a, \\\"b\", c", ',', tokens);
+  EXPECT_EQ(tokens, std::vector<std::string_view>({"\"a, \\\"b\"", "c"}));
+}
+
+TEST(SerializationTest, ParseNumber) {
+  int i = 0;
+  EXPECT_TRUE(ParseNumber("-1", i));
+  EXPECT_EQ(i, -1);
+  EXPECT_FALSE(ParseNumber("", i));
+  EXPECT_FALSE(ParseNumber("1 ", i));
+  EXPECT_FALSE(ParseNumber("1.5", i));
+  uint32_t u = 0;
+  EXPECT_TRUE(ParseNumber("4294967295", u));
+  EXPECT_EQ(u, 4294967295u);
+  EXPECT_FALSE(ParseNumber("4294967296", u));
+  EXPECT_FALSE(ParseNumber("-1", u));
+  double d = 0;
+  EXPECT_TRUE(ParseNumber("1e-05", d));
+  EXPECT_EQ(d, 1e-05);
+  EXPECT_TRUE(ParseNumber("0.25", d));
+  EXPECT_EQ(d, 0.25);
+  EXPECT_FALSE(ParseNumber("0.25s", d));
+  float f = 0;
+  EXPECT_TRUE(ParseNumber("nan", f));
+  EXPECT_TRUE(std::isnan(f));
+  EXPECT_TRUE(ParseNumber("-nan", f));
+  EXPECT_TRUE(std::isnan(f));
+}
+
 TEST(SerializationTest, Escape) {
   EXPECT_EQ(Escape(""), "\"\"");
   EXPECT_EQ(Escape("a"), "\"a\"");
@@ -73,5 +112,31 @@ TEST(SerializationTest, Subsampling) {
             Status::kUnknownError);
 }
 
+TEST(SerializationTest, DistortionMetric) {
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    EXPECT_EQ(DistortionMetricFromString(kDistortionMetricToStr[m],
+                                         /*quiet=*/false)
+                  .value,
+              static_cast<DistortionMetric>(m));
+  }
+  EXPECT_EQ(DistortionMetricFromString("ssimulacra2", /*quiet=*/false).value,
+            DistortionMetric::kLibjxlSsimulacra2);
+  EXPECT_EQ(DistortionMetricFromString("ssim2", /*quiet=*/true).status,
+            Status::kUnknownError);
+}
+
+TEST(SerializationTest, TimingStatistic) {
+  for (TimingStatistic timing_statistic :
+       {TimingStatistic::kMean, TimingStatistic::kMedian,
+        TimingStatistic::kMin}) {
+    const StatusOr<TimingStatistic> parsed = TimingStatisticFromString(
+        TimingStatisticToString(timing_statistic), /*quiet=*/false);
+    ASSERT_EQ(parsed.status, Status::kOk);
+    EXPECT_EQ(parsed.value, timing_statistic);
+  }
+  EXPECT_EQ(TimingStatisticFromString("max", /*quiet=*/true).status,
+            Status::kUnknownError);
+}
+
 }  // namespace
 }  // namespace codec_compare_gen
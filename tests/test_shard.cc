@@ -0,0 +1,91 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shard.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr Subsampling kDef = Subsampling::kDefault;
+
+std::vector<TaskInput> MakeTasks() {
+  std::vector<TaskInput> tasks;
+  for (Codec codec : {Codec::kWebp, Codec::kJpegXl, Codec::kAvif}) {
+    for (int effort : {0, 1, 2}) {
+      for (int quality : {10, 50, 90}) {
+        for (int image = 0; image < 10; ++image) {
+          tasks.push_back({{codec, kDef, effort, quality},
+                           "folder/image" + std::to_string(image) + ".png"});
+        }
+      }
+    }
+  }
+  return tasks;
+}
+
+TEST(ShardTest, DisjointAndComplete) {
+  const std::vector<TaskInput> all_tasks = MakeTasks();
+  constexpr uint32_t kNumShards = 4;
+  size_t num_tasks = 0;
+  for (uint32_t shard_index = 0; shard_index < kNumShards; ++shard_index) {
+    std::vector<TaskInput> tasks = all_tasks;
+    KeepShardTasks(shard_index, kNumShards, tasks);
+    EXPECT_FALSE(tasks.empty());  // Likely, with that many tasks.
+    for (const TaskInput& task : tasks) {
+      EXPECT_EQ(GetShardIndex(task, kNumShards), shard_index);
+    }
+    num_tasks += tasks.size();
+  }
+  EXPECT_EQ(num_tasks, all_tasks.size());
+
+  std::vector<TaskInput> tasks = all_tasks;
+  KeepShardTasks(/*shard_index=*/0, /*num_shards=*/1, tasks);
+  EXPECT_EQ(tasks.size(), all_tasks.size());
+}
+
+TEST(ShardTest, Stable) {
+  constexpr uint32_t kNumShards = 7;
+  const TaskInput task{{Codec::kWebp, kDef, 4, 50}, "/mnt/a/image.png"};
+  const uint32_t shard_index = GetShardIndex(task, kNumShards);
+  // Same shard for any quality and mount point.
+  EXPECT_EQ(GetShardIndex({{Codec::kWebp, kDef, 4, 90}, "/mnt/a/image.png"},
+                          kNumShards),
+            shard_index);
+  EXPECT_EQ(GetShardIndex({{Codec::kWebp, kDef, 4, 50}, "/b/image.png",
+                           "/encoded/b/image.png.webp"},
+                          kNumShards),
+            shard_index);
+  // Same shard on any host.
+  EXPECT_EQ(GetShardIndex(task, /*num_shards=*/1000003), 186859u);
+}
+
+TEST(ShardTest, FilePath) {
+  EXPECT_EQ(GetShardFilePath("dir/progress.csv", 2, 8),
+            "dir/progress_shard2of8.csv");
+  EXPECT_EQ(GetShardFilePath("progress.ccgenbin", 0, 3),
+            "progress_shard0of3.ccgenbin");
+  EXPECT_EQ(GetShardFilePath("/a/b/progress", 1, 2),
+            "/a/b/progress_shard1of2");
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,47 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "src/stop_signal.h"
+
+#include <csignal>
+
+#include "gtest/gtest.h"
+
+namespace codec_compare_gen {
+namespace {
+
+int num_previous_handler_calls = 0;
+extern "C" void PreviousHandler(int /*signal_number*/) {
+  ++num_previous_handler_calls;
+}
+
+TEST(StopSignalTest, CatchesOnceAndRestores) {
+  ASSERT_NE(std::signal(SIGTERM, PreviousHandler), SIG_ERR);
+  {
+    const StopSignalCatcher catcher;
+    EXPECT_FALSE(StopSignalCatcher::IsStopRequested());
+    ASSERT_EQ(std::raise(SIGTERM), 0);
+    EXPECT_TRUE(StopSignalCatcher::IsStopRequested());
+    EXPECT_EQ(num_previous_handler_calls, 0);
+  }
+  {
+    const StopSignalCatcher catcher;  // Starts over.
+    EXPECT_FALSE(StopSignalCatcher::IsStopRequested());
+  }
+  ASSERT_EQ(std::raise(SIGTERM), 0);
+  EXPECT_EQ(num_previous_handler_calls, 1);
+  std::signal(SIGTERM, SIG_DFL);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
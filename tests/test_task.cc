@@ -13,9 +13,13 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -58,7 +62,7 @@ TEST(SplitByCodecSettingsAndAggregateByImageTest, Simple) {
   const std::vector<TaskOutput> results = {
       {{{kWebp, kDef, /*effort=*/0, /*quality=*/0}, "img"}, 1, 2, 8, 3, 0}};
   const auto aggregate = SplitByCodecSettingsAndAggregateByImageAndQuality(
-      results, /*quiet=*/false);
+      results, TimingStatistic::kMean, /*quiet=*/false);
   ASSERT_EQ(aggregate.status, Status::kOk);
   ExpectEq(aggregate.value, {results});
 }
@@ -110,7 +114,7 @@ TEST(SplitByCodecSettingsAndAggregateByImageTest, Multiple) {
   std::shuffle(results.begin(), results.end(), std::mt19937(rd()));
 
   const auto aggregate = SplitByCodecSettingsAndAggregateByImageAndQuality(
-      results, /*quiet=*/false);
+      results, TimingStatistic::kMean, /*quiet=*/false);
   ASSERT_EQ(aggregate.status, Status::kOk);
   ExpectEq(
       aggregate.value,
@@ -121,5 +125,310 @@ TEST(SplitByCodecSettingsAndAggregateByImageTest, Multiple) {
        {{{{kWebp2, kDef, 0, 0}, "A"}, 8, 9, 8, 1, 5u, 9.5, 9.5, 4.5, {24.0}}}});
 }
 
+TEST(SplitByCodecSettingsAndAggregateByImageTest, CodecThreads) {
+  const std::vector<TaskOutput> results = {
+      {{{kWebp, kDef, /*effort=*/0, /*quality=*/0, /*num_threads=*/1}, "img"},
+       1, 2, 8, 1, 3, 1.0},
+      {{{kWebp, kDef, /*effort=*/0, /*quality=*/0, /*num_threads=*/4}, "img"},
+       1, 2, 8, 1, 3, 0.5}};
+  const auto aggregate = SplitByCodecSettingsAndAggregateByImageAndQuality(
+      results, TimingStatistic::kMean, /*quiet=*/false);
+  ASSERT_EQ(aggregate.status, Status::kOk);
+  ExpectEq(aggregate.value, {{results[0]}, {results[1]}});
+}
+
+TEST(SplitByCodecSettingsAndAggregateByImageTest, TimingStatistic) {
+  std::vector<TaskOutput> results;
+  for (double duration : {4.0, 1.0, 2.0, 9.0}) {
+    results.push_back({{{kWebp, kDef, /*effort=*/0, /*quality=*/0}, "img"},
+                       1, 2, 8, 1, 3, duration, duration * 2, 0});
+  }
+  for (const auto& [timing_statistic, expected_duration] :
+       {std::make_pair(TimingStatistic::kMean, 4.0),
+        std::make_pair(TimingStatistic::kMedian, 3.0),
+        std::make_pair(TimingStatistic::kMin, 1.0)}) {
+    const auto aggregate = SplitByCodecSettingsAndAggregateByImageAndQuality(
+        results, timing_statistic, /*quiet=*/false);
+    ASSERT_EQ(aggregate.status, Status::kOk);
+    ASSERT_EQ(aggregate.value.size(), 1);
+    ASSERT_EQ(aggregate.value.front().size(), 1);
+    const TaskOutput& task = aggregate.value.front().front();
+    EXPECT_EQ(task.encoding_duration, expected_duration);
+    EXPECT_EQ(task.decoding_duration, expected_duration * 2);
+    EXPECT_DOUBLE_EQ(task.encoding_duration_stddev, std::sqrt(38.0 / 3));
+    EXPECT_DOUBLE_EQ(task.decoding_duration_stddev, 2 * std::sqrt(38.0 / 3));
+  }
+
+  // No spread without repetitions.
+  const auto single = SplitByCodecSettingsAndAggregateByImageAndQuality(
+      {results.front()}, TimingStatistic::kMedian, /*quiet=*/false);
+  ASSERT_EQ(single.status, Status::kOk);
+  EXPECT_EQ(single.value.front().front().encoding_duration, 4.0);
+  EXPECT_LT(single.value.front().front().encoding_duration_stddev, 0);
+}
+
+TEST(DurationPercentileTest, Interpolated) {
+  const std::vector<double> durations = {1.0, 2.0, 4.0, 8.0, 9.0};
+  EXPECT_EQ(DurationPercentile(durations, 0), 1.0);
+  EXPECT_EQ(DurationPercentile(durations, 0.5), 4.0);
+  EXPECT_DOUBLE_EQ(DurationPercentile(durations, 0.9), 8.6);
+  EXPECT_EQ(DurationPercentile(durations, 1), 9.0);
+  EXPECT_EQ(DurationPercentile({3.0}, 0.99), 3.0);
+}
+
+TEST(ForEachCodecSettingsAggregatedByImageAndQualityTest, OneGroupAtATime) {
+  const std::vector<TaskOutput> results = {
+      {{{kWebp, kDef, /*effort=*/1, /*quality=*/0}, "B"}, 1, 2, 8, 3, 4},
+      {{{kWebp, kDef, /*effort=*/0, /*quality=*/0}, "A"}, 1, 2, 8, 3, 4},
+      {{{kWebp, kDef, /*effort=*/1, /*quality=*/0}, "A"}, 1, 2, 8, 3, 4}};
+  const std::vector<const TaskOutput*> result_pointers = {
+      &results[0], &results[1], &results[2]};
+
+  std::vector<size_t> group_sizes;
+  ASSERT_EQ(ForEachCodecSettingsAggregatedByImageAndQuality(
+                result_pointers, TimingStatistic::kMean, /*quiet=*/false,
+                [&](const std::vector<TaskOutput>& group) {
+                  group_sizes.push_back(group.size());
+                  return Status::kOk;
+                }),
+            Status::kOk);
+  EXPECT_EQ(group_sizes, std::vector<size_t>({1, 2}));
+
+  // Stops at the first error.
+  size_t num_visits = 0;
+  EXPECT_NE(ForEachCodecSettingsAggregatedByImageAndQuality(
+                result_pointers, TimingStatistic::kMean, /*quiet=*/false,
+                [&](const std::vector<TaskOutput>&) {
+                  ++num_visits;
+                  return Status::kUnknownError;
+                }),
+            Status::kOk);
+  EXPECT_EQ(num_visits, 1);
+}
+
+TEST(TaskOutputTest, SerializeNotComputedDistortions) {
+  TaskOutput task = {
+      {{kWebp, Subsampling::k420, /*effort=*/0, /*quality=*/50}, "img", "enc"},
+      1,
+      2,
+      8,
+      1,
+      3,
+      0.1,
+      0.2,
+      0};
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+            kDistortionNotComputed);
+  task.distortions[static_cast<size_t>(DistortionMetric::kLibwebp2Psnr)] = 30;
+
+  const std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<size_t>(Codec::kNumCodecs), {50});
+  const StatusOr<TaskOutput> unserialized = TaskOutput::Unserialize(
+      task.Serialize(), qualities_per_codec, /*quiet=*/false);
+  ASSERT_EQ(unserialized.status, Status::kOk);
+  EXPECT_EQ(unserialized.value.task_input, task.task_input);
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    if (m == static_cast<size_t>(DistortionMetric::kLibwebp2Psnr)) {
+      EXPECT_EQ(unserialized.value.distortions[m], 30);
+    } else {
+      EXPECT_TRUE(std::isnan(unserialized.value.distortions[m]));
+    }
+  }
+
+  // Lines written before SamplePSNR existed have one distortion less.
+  const std::string serialized = task.Serialize();
+  const StatusOr<TaskOutput> legacy = TaskOutput::Unserialize(
+      serialized.substr(0, serialized.rfind(',')), qualities_per_codec,
+      /*quiet=*/false);
+  ASSERT_EQ(legacy.status, Status::kOk);
+  EXPECT_EQ(legacy.value.distortions[static_cast<size_t>(
+                DistortionMetric::kLibwebp2Psnr)],
+            30);
+  EXPECT_TRUE(std::isnan(legacy.value.distortions[static_cast<size_t>(
+      DistortionMetric::kSamplePsnr)]));
+}
+
+TEST(TaskOutputTest, SerializeCodecThreads) {
+  const std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<size_t>(Codec::kNumCodecs), {50});
+  for (int quality : {50, kQualityLossless}) {
+    TaskOutput task = {{{kWebp, Subsampling::k420, /*effort=*/0, quality,
+                         /*num_threads=*/4},
+                        "img",
+                        "enc"},
+                       1,
+                       2,
+                       8,
+                       1,
+                       3,
+                       0.1,
+                       0.2,
+                       0};
+    std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+              quality == kQualityLossless ? kNoDistortion : 1.5f);
+    const std::string serialized = task.Serialize();
+    EXPECT_NE(serialized.find("codec_threads=4"), std::string::npos);
+
+    StatusOr<TaskOutput> unserialized =
+        TaskOutput::Unserialize(serialized, qualities_per_codec,
+                                /*quiet=*/false);
+    ASSERT_EQ(unserialized.status, Status::kOk);
+    EXPECT_EQ(unserialized.value.task_input, task.task_input);
+    EXPECT_EQ(unserialized.value.distortions[0], task.distortions[0]);
+    unserialized = TaskOutput::UnserializeNoDistortion(
+        serialized, qualities_per_codec, /*quiet=*/false);
+    ASSERT_EQ(unserialized.status, Status::kOk);
+    EXPECT_EQ(unserialized.value.task_input.codec_settings.num_threads, 4);
+
+    // The default value is omitted.
+    task.task_input.codec_settings.num_threads = 1;
+    EXPECT_EQ(task.Serialize().find("codec_threads"), std::string::npos);
+  }
+
+  EXPECT_EQ(TaskOutput::Unserialize(
+                "webp, 420, 0, 50, img, 1, 2, 8, 1, enc, 3, 0.1, 0.2, 0, "
+                "unknown=1",
+                qualities_per_codec, /*quiet=*/true)
+                .status,
+            Status::kUnknownError);
+}
+
+TEST(TaskOutputTest, SerializeResourceUsage) {
+  TaskOutput task = {
+      {{kWebp, Subsampling::k420, /*effort=*/0, /*quality=*/50}, "img", "enc"},
+      1,
+      2,
+      8,
+      1,
+      3,
+      0.1,
+      0.2,
+      0};
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics, 1.5f);
+  task.encoding_usage.cpu_time = 0.05;
+  task.encoding_usage.cycles = 123456789012;
+  task.decoding_usage.cache_misses = 7;
+  task.decoding_usage.peak_memory = 1 << 20;
+  task.is_extrapolated = true;
+
+  const std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<size_t>(Codec::kNumCodecs), {50});
+  const StatusOr<TaskOutput> unserialized = TaskOutput::Unserialize(
+      task.Serialize(), qualities_per_codec, /*quiet=*/false);
+  ASSERT_EQ(unserialized.status, Status::kOk);
+  EXPECT_EQ(unserialized.value.encoding_usage.cpu_time, 0.05);
+  EXPECT_EQ(unserialized.value.encoding_usage.cycles, 123456789012);
+  EXPECT_EQ(unserialized.value.encoding_usage.instructions, -1);
+  EXPECT_EQ(unserialized.value.decoding_usage.cpu_time, -1);
+  EXPECT_EQ(unserialized.value.decoding_usage.cache_misses, 7);
+  EXPECT_EQ(unserialized.value.decoding_usage.peak_memory, 1 << 20);
+  EXPECT_TRUE(unserialized.value.is_extrapolated);
+  EXPECT_EQ(unserialized.value.distortions[0], 1.5f);
+}
+
+TEST(TaskOutputTest, UnserializeTaskOutputs) {
+  TaskOutput task = {
+      {{kWebp, Subsampling::k420, /*effort=*/0, /*quality=*/50}, "img", "enc"},
+      1,
+      2,
+      8,
+      1,
+      3,
+      0.1,
+      0.2,
+      0};
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics, 1.5f);
+  const std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<size_t>(Codec::kNumCodecs), {50});
+
+  // Big enough to be split into several chunks.
+  std::string serialized_tasks;
+  constexpr uint32_t kNumTasks = 30000;
+  for (uint32_t i = 1; i <= kNumTasks; ++i) {
+    task.image_width = i;
+    serialized_tasks += task.Serialize() + "\n";
+  }
+  for (size_t num_threads : {1, 4}) {
+    const StatusOr<std::vector<TaskOutput>> tasks = UnserializeTaskOutputs(
+        serialized_tasks, qualities_per_codec, /*with_distortions=*/true,
+        num_threads, /*quiet=*/false);
+    ASSERT_EQ(tasks.status, Status::kOk);
+    ASSERT_EQ(tasks.value.size(), kNumTasks);
+    for (uint32_t i = 0; i < kNumTasks; ++i) {
+      ASSERT_EQ(tasks.value[i].image_width, i + 1);  // Same order.
+      EXPECT_EQ(tasks.value[i].task_input, task.task_input);
+      EXPECT_EQ(tasks.value[i].encoding_duration, 0.1);
+      EXPECT_EQ(tasks.value[i].distortions[0], 1.5f);
+    }
+  }
+
+  // Last line without line break.
+  serialized_tasks += task.Serialize();
+  EXPECT_EQ(UnserializeTaskOutputs(serialized_tasks, qualities_per_codec,
+                                   /*with_distortions=*/false,
+                                   /*num_threads=*/4, /*quiet=*/false)
+                .value.size(),
+            kNumTasks + 1);
+
+  // Bad line in the middle.
+  serialized_tasks.insert(serialized_tasks.size() / 2, "\nbad\n");
+  EXPECT_EQ(UnserializeTaskOutputs(serialized_tasks, qualities_per_codec,
+                                   /*with_distortions=*/true,
+                                   /*num_threads=*/4, /*quiet=*/true)
+                .status,
+            Status::kUnknownError);
+
+  EXPECT_TRUE(UnserializeTaskOutputs("", qualities_per_codec,
+                                     /*with_distortions=*/true,
+                                     /*num_threads=*/4, /*quiet=*/false)
+                  .value.empty());
+}
+
+TEST(IsKnownUnsupportedTest, BitDepth) {
+  TaskInput task = {{kWebp, kDef, 0, 50}, "A"};
+  EXPECT_FALSE(IsKnownUnsupported(task));  // Unknown header.
+  task.image_header = {/*width=*/1, /*height=*/1, /*bit_depth=*/16,
+                       /*num_frames=*/1};
+  EXPECT_TRUE(IsKnownUnsupported(task));
+  task.codec_settings.quality = kQualityLossless;  // Spread to 8 bits.
+  EXPECT_FALSE(IsKnownUnsupported(task));
+  task.codec_settings = {Codec::kJpegXl, kDef, 0, 50};
+  EXPECT_FALSE(IsKnownUnsupported(task));
+  task.image_header.bit_depth = 8;
+  task.codec_settings.codec = kWebp;
+  EXPECT_FALSE(IsKnownUnsupported(task));
+}
+
+TEST(GroupTasksByImageTest, KeepOrder) {
+  std::vector<TaskInput> tasks = {{{kWebp, kDef, 0, 0}, "A"},
+                                  {{kWebp, kDef, 0, 0}, "B"},
+                                  {{kWebp2, kDef, 0, 0}, "A"},
+                                  {{kWebp2, kDef, 0, 0}, "B"},
+                                  {{kWebp2, kDef, 0, 0}, "C"}};
+  GroupTasksByImage(/*rng=*/nullptr, tasks);
+  const std::vector<TaskInput> expected = {{{kWebp, kDef, 0, 0}, "A"},
+                                           {{kWebp2, kDef, 0, 0}, "A"},
+                                           {{kWebp, kDef, 0, 0}, "B"},
+                                           {{kWebp2, kDef, 0, 0}, "B"},
+                                           {{kWebp2, kDef, 0, 0}, "C"}};
+  EXPECT_EQ(tasks, expected);
+}
+
+TEST(GroupTasksByImageTest, Shuffled) {
+  std::vector<TaskInput> tasks;
+  for (int quality = 0; quality < 10; ++quality) {
+    for (const char* image_path : {"A", "B", "C", "D"}) {
+      tasks.push_back({{kWebp, kDef, 0, quality}, image_path});
+    }
+  }
+  std::mt19937 rng(42);
+  GroupTasksByImage(&rng, tasks);
+  ASSERT_EQ(tasks.size(), 40);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    // Each batch of 10 tasks shares the same image.
+    EXPECT_EQ(tasks[i].image_path, tasks[i / 10 * 10].image_path);
+  }
+}
+
 }  // namespace
 }  // namespace codec_compare_gen
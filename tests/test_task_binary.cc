@@ -0,0 +1,216 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_binary.h"
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::vector<std::unordered_set<int>> GetQualitiesPerCodec() {
+  std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<int>(Codec::kNumCodecs));
+  for (size_t i = 0; i < qualities_per_codec.size(); ++i) {
+    const std::vector<int> q = CodecLossyQualities(static_cast<Codec>(i));
+    qualities_per_codec[i] = std::unordered_set<int>(q.begin(), q.end());
+  }
+  return qualities_per_codec;
+}
+
+TaskOutput GetTask(const std::string& image_path, int quality) {
+  TaskOutput task = MakeTaskOutput(
+      {{Codec::kWebp, Subsampling::k420, /*effort=*/4, quality},
+       image_path,
+       image_path + "_" + std::to_string(quality) + ".webp"},
+      /*image_width=*/16, /*image_height=*/9);
+  task.encoded_size = 123;
+  task.encoding_duration = 0.5;
+  task.decoding_duration = 0.25;
+  task.decoding_color_conversion_duration = 0.125;
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    task.distortions[m] =
+        quality == kQualityLossless ? kNoDistortion : 30.f + m;
+  }
+  return task;
+}
+
+void ExpectEq(const TaskOutput& actual, const TaskOutput& expected) {
+  EXPECT_EQ(actual.task_input, expected.task_input);
+  EXPECT_EQ(actual.image_width, expected.image_width);
+  EXPECT_EQ(actual.image_height, expected.image_height);
+  EXPECT_EQ(actual.bit_depth, expected.bit_depth);
+  EXPECT_EQ(actual.num_frames, expected.num_frames);
+  EXPECT_EQ(actual.encoded_size, expected.encoded_size);
+  EXPECT_EQ(actual.encoding_duration, expected.encoding_duration);
+  EXPECT_EQ(actual.decoding_duration, expected.decoding_duration);
+  EXPECT_EQ(actual.decoding_color_conversion_duration,
+            expected.decoding_color_conversion_duration);
+  for (size_t m = 0; m < kNumDistortionMetrics; ++m) {
+    EXPECT_EQ(actual.distortions[m], expected.distortions[m]);
+  }
+  EXPECT_EQ(actual.encoding_usage.cpu_time, expected.encoding_usage.cpu_time);
+  EXPECT_EQ(actual.decoding_usage.instructions,
+            expected.decoding_usage.instructions);
+  EXPECT_EQ(actual.encoding_usage.peak_memory,
+            expected.encoding_usage.peak_memory);
+  EXPECT_EQ(actual.is_extrapolated, expected.is_extrapolated);
+}
+
+TEST(TaskBinaryTest, RoundTrip) {
+  std::vector<TaskOutput> tasks = {GetTask("a.png", 0),
+                                   GetTask("b.png", kQualityLossless),
+                                   GetTask("a.png", 100), GetTask("c.png", 0)};
+  tasks.back().task_input.codec_settings.num_threads = 4;
+  tasks.back().encoding_usage.cpu_time = 0.5;
+  tasks.back().decoding_usage.instructions = 1234;
+  tasks.back().encoding_usage.peak_memory = 4096;
+  tasks.back().is_extrapolated = true;
+  tasks[2].is_extrapolated = true;
+  BinaryTaskEncoder encoder;
+  std::string contents = BinaryTaskEncoder::Header();
+  for (const TaskOutput& task : tasks) contents += encoder.Encode(task);
+
+  const StatusOr<std::vector<TaskOutput>> unserialized =
+      UnserializeBinaryTaskOutputs(contents, GetQualitiesPerCodec(),
+                                   /*with_distortions=*/true, /*quiet=*/false);
+  ASSERT_EQ(unserialized.status, Status::kOk);
+  ASSERT_EQ(unserialized.value.size(), tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    ExpectEq(unserialized.value[i], tasks[i]);
+  }
+
+  const StatusOr<std::vector<TaskOutput>> no_distortion =
+      UnserializeBinaryTaskOutputs(contents, GetQualitiesPerCodec(),
+                                   /*with_distortions=*/false, /*quiet=*/false);
+  ASSERT_EQ(no_distortion.status, Status::kOk);
+  ASSERT_EQ(no_distortion.value.size(), tasks.size());
+  EXPECT_TRUE(std::isnan(no_distortion.value.front().distortions[0]));
+}
+
+TEST(TaskBinaryTest, StringsAreStoredOnce) {
+  BinaryTaskEncoder encoder;
+  const std::string first = encoder.Encode(GetTask("long/image/path.png", 0));
+  const std::string second = encoder.Encode(GetTask("long/image/path.png", 0));
+  EXPECT_LT(second.size(), first.size());
+  EXPECT_EQ(second.find("long/image/path.png"), std::string::npos);
+}
+
+TEST(TaskBinaryTest, Resume) {
+  std::string contents = BinaryTaskEncoder::Header();
+  {
+    BinaryTaskEncoder encoder;
+    contents += encoder.Encode(GetTask("a.png", 0));
+  }
+  BinaryTaskEncoder resumed_encoder;
+  const StatusOr<size_t> complete_size =
+      resumed_encoder.Resume(contents, /*quiet=*/false);
+  ASSERT_EQ(complete_size.status, Status::kOk);
+  EXPECT_EQ(complete_size.value, contents.size());
+  const std::string appended = resumed_encoder.Encode(GetTask("a.png", 0));
+  EXPECT_EQ(appended.find("a.png"), std::string::npos);
+  contents += appended;
+  contents += resumed_encoder.Encode(GetTask("b.png", 100));
+
+  const StatusOr<std::vector<TaskOutput>> unserialized =
+      UnserializeBinaryTaskOutputs(contents, GetQualitiesPerCodec(),
+                                   /*with_distortions=*/true, /*quiet=*/false);
+  ASSERT_EQ(unserialized.status, Status::kOk);
+  ASSERT_EQ(unserialized.value.size(), 3);
+  ExpectEq(unserialized.value[1], GetTask("a.png", 0));
+  ExpectEq(unserialized.value[2], GetTask("b.png", 100));
+}
+
+TEST(TaskBinaryTest, InvalidContents) {
+  const auto qualities_per_codec = GetQualitiesPerCodec();
+  EXPECT_NE(UnserializeBinaryTaskOutputs("webp, 420, 4, 0", qualities_per_codec,
+                                         /*with_distortions=*/true,
+                                         /*quiet=*/true)
+                .status,
+            Status::kOk);
+
+  BinaryTaskEncoder encoder;
+  std::string contents =
+      BinaryTaskEncoder::Header() + encoder.Encode(GetTask("a.png", 0));
+  contents[BinaryTaskEncoder::Header().size()] = 'x';  // Unknown chunk.
+  EXPECT_NE(UnserializeBinaryTaskOutputs(contents, qualities_per_codec,
+                                         /*with_distortions=*/true,
+                                         /*quiet=*/true)
+                .status,
+            Status::kOk);
+}
+
+TEST(TaskBinaryTest, IncompleteLastRecord) {
+  TaskOutput measured_task = GetTask("a.png", 0);
+  measured_task.encoding_usage.cpu_time = 0.5;
+  TaskOutput extrapolated_task = measured_task;
+  extrapolated_task.is_extrapolated = true;
+  for (const TaskOutput& last_task :
+       {GetTask("a.png", 0), measured_task, extrapolated_task}) {
+    BinaryTaskEncoder encoder;
+    const std::string complete =
+        BinaryTaskEncoder::Header() + encoder.Encode(GetTask("a.png", 0));
+    // No new string, so that any cut leaves an incomplete chunk.
+    const std::string last = encoder.Encode(last_task);
+    // The usage and extrapolated chunks, if any, precede the record.
+    const size_t flags_size =
+        last.size() - encoder.Encode(GetTask("a.png", 0)).size();
+    // As left by a run interrupted while appending the last record.
+    std::vector<size_t> sizes = {1, last.size() / 2, last.size() - 1};
+    // Right after the usage and extrapolated chunks.
+    if (flags_size > 1) sizes.push_back(flags_size);
+    for (size_t size : sizes) {
+      const std::string contents = complete + last.substr(0, size);
+      const StatusOr<std::vector<TaskOutput>> unserialized =
+          UnserializeBinaryTaskOutputs(contents, GetQualitiesPerCodec(),
+                                       /*with_distortions=*/true,
+                                       /*quiet=*/true);
+      ASSERT_EQ(unserialized.status, Status::kOk);
+      ASSERT_EQ(unserialized.value.size(), 1);
+
+      BinaryTaskEncoder resumed_encoder;
+      const StatusOr<size_t> complete_size =
+          resumed_encoder.Resume(contents, /*quiet=*/true);
+      ASSERT_EQ(complete_size.status, Status::kOk);
+      EXPECT_EQ(complete_size.value, complete.size());
+      const StatusOr<std::vector<TaskOutput>> resumed_tasks =
+          UnserializeBinaryTaskOutputs(
+              complete + resumed_encoder.Encode(last_task),
+              GetQualitiesPerCodec(), /*with_distortions=*/true,
+              /*quiet=*/true);
+      ASSERT_EQ(resumed_tasks.status, Status::kOk);
+      ASSERT_EQ(resumed_tasks.value.size(), 2);
+      ExpectEq(resumed_tasks.value[1], last_task);
+    }
+  }
+}
+
+TEST(TaskBinaryTest, FilePath) {
+  EXPECT_TRUE(IsBinaryTasksFilePath("dir/progress.ccgenbin"));
+  EXPECT_FALSE(IsBinaryTasksFilePath("dir/progress.csv"));
+  EXPECT_FALSE(IsBinaryTasksFilePath("dir.ccgenbin/progress"));
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_cost.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr Codec kWebp = Codec::kWebp;
+constexpr Codec kJpegXl = Codec::kJpegXl;
+constexpr Subsampling kDef = Subsampling::kDefault;
+
+TaskOutput MakeCompletedTask(Codec codec, int effort, const char* image_path,
+                             uint32_t width, uint32_t height,
+                             double encoding_duration) {
+  TaskOutput task = MakeTaskOutput(
+      {{codec, kDef, effort, /*quality=*/50}, image_path}, width, height);
+  task.encoding_duration = encoding_duration;
+  task.decoding_duration = 0;
+  return task;
+}
+
+TEST(TaskCostModelTest, Empty) {
+  EXPECT_TRUE(TaskCostModel({}).IsEmpty());
+  EXPECT_TRUE(
+      TaskCostModel({MakeCompletedTask(kWebp, 0, "A", 10, 10, 0)}).IsEmpty());
+}
+
+TEST(TaskCostModelTest, Estimate) {
+  const TaskCostModel model(
+      {MakeCompletedTask(kWebp, 0, "small", 10, 10, 1),
+       MakeCompletedTask(kWebp, 0, "small", 10, 10, 3),
+       MakeCompletedTask(kJpegXl, 9, "large", 100, 100, 1000),
+       MakeCompletedTask(kJpegXl, 1, "large", 100, 100, 10)});
+  ASSERT_FALSE(model.IsEmpty());
+  // Average of both repetitions.
+  EXPECT_DOUBLE_EQ(model.Estimate({{kWebp, kDef, 0, 90}, "small"}), 2);
+  // Scaled by the number of pixels.
+  EXPECT_DOUBLE_EQ(model.Estimate({{kWebp, kDef, 0, 90}, "large"}), 200);
+  EXPECT_DOUBLE_EQ(model.Estimate({{kJpegXl, kDef, 9, 90}, "small"}), 10);
+  // Unknown effort: any effort of that codec.
+  EXPECT_DOUBLE_EQ(model.Estimate({{kJpegXl, kDef, 5, 90}, "large"}), 505);
+  // Unknown codec and image: everything.
+  EXPECT_GT(model.Estimate({{Codec::kAvif, kDef, 0, 90}, "unknown"}), 0);
+  // Unknown image but probed header.
+  TaskInput probed = {{kWebp, kDef, 0, 90}, "probed"};
+  probed.image_header = {/*width=*/20, /*height=*/10, /*bit_depth=*/8,
+                         /*num_frames=*/2};
+  EXPECT_DOUBLE_EQ(model.Estimate(probed), 8);
+}
+
+TEST(TaskCostModelTest, SortByDecreasingCost) {
+  const TaskCostModel model(
+      {MakeCompletedTask(kWebp, 0, "small", 10, 10, 1),
+       MakeCompletedTask(kJpegXl, 9, "large", 100, 100, 1000)});
+  std::vector<TaskInput> tasks;
+  for (int quality = 0; quality < 10; ++quality) {
+    tasks.push_back({{kWebp, kDef, 0, quality}, "small"});
+    tasks.push_back({{kJpegXl, kDef, 9, quality}, "large"});
+  }
+
+  std::vector<TaskInput> sorted = tasks;
+  SortByDecreasingCost(model, /*rng=*/nullptr, sorted);
+  ASSERT_EQ(sorted.size(), tasks.size());
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    EXPECT_EQ(sorted[i].codec_settings.codec, i < 10 ? kJpegXl : kWebp);
+    // Stable.
+    EXPECT_EQ(sorted[i].codec_settings.quality, static_cast<int>(i % 10));
+  }
+
+  std::mt19937 rng(42);
+  std::vector<TaskInput> shuffled = tasks;
+  SortByDecreasingCost(model, &rng, shuffled);
+  ASSERT_EQ(shuffled.size(), tasks.size());
+  bool is_shuffled = false;
+  for (size_t i = 0; i < shuffled.size(); ++i) {
+    EXPECT_EQ(shuffled[i].codec_settings.codec, i < 10 ? kJpegXl : kWebp);
+    is_shuffled |= !(shuffled[i] == sorted[i]);
+  }
+  EXPECT_TRUE(is_shuffled);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
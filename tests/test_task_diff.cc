@@ -0,0 +1,141 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/task_diff.h"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+#include "src/task.h"
+#include "tests/test_utils.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr Codec kWebp = Codec::kWebp;
+constexpr Subsampling kDef = Subsampling::kDefault;
+
+TaskOutput MakeTask(const char* image_path, int quality, double duration,
+                    size_t encoded_size, float psnr) {
+  TaskOutput task =
+      MakeTaskOutput({{kWebp, kDef, /*effort=*/4, quality}, image_path},
+                     /*image_width=*/10, /*image_height=*/10);
+  task.encoded_size = encoded_size;
+  task.encoding_duration = duration;
+  task.decoding_duration = duration / 10;
+  task.distortions[static_cast<size_t>(DistortionMetric::kLibwebp2Psnr)] =
+      psnr;
+  return task;
+}
+
+TEST(TaskDiffTest, BjontegaardDeltaRate) {
+  const std::vector<std::pair<double, double>> old_curve = {
+      {30, 100}, {35, 200}, {40, 400}};
+  std::vector<std::pair<double, double>> larger_curve;
+  for (const auto& [distortion, size] : old_curve) {
+    larger_curve.emplace_back(distortion, size * 1.1);
+  }
+  EXPECT_NEAR(BjontegaardDeltaRate(old_curve, larger_curve), 0.1, 1e-9);
+  EXPECT_NEAR(BjontegaardDeltaRate(larger_curve, old_curve), 1 / 1.1 - 1,
+              1e-9);
+  EXPECT_NEAR(BjontegaardDeltaRate(old_curve, old_curve), 0, 1e-9);
+
+  // Same curve sampled at other qualities, over a partially overlapping range.
+  EXPECT_NEAR(BjontegaardDeltaRate(old_curve, {{32.5, 100 * std::sqrt(2.)},
+                                               {45, 800}}),
+              0, 1e-9);
+
+  EXPECT_TRUE(std::isnan(BjontegaardDeltaRate(old_curve, {{35, 200}})));
+  EXPECT_TRUE(std::isnan(
+      BjontegaardDeltaRate(old_curve, {{50, 100}, {60, 200}})));
+}
+
+TEST(TaskDiffTest, SignificantSlowdown) {
+  std::vector<TaskOutput> old_tasks, new_tasks, noisy_tasks;
+  for (const char* image_path : {"a", "b"}) {
+    for (int quality : {50, 90}) {
+      const size_t size = quality * 10;
+      for (double noise : {-0.01, 0.0, 0.01}) {
+        old_tasks.push_back(MakeTask(image_path, quality, 1 + noise, size,
+                                     /*psnr=*/quality / 2.f));
+        new_tasks.push_back(MakeTask(image_path, quality, 1.2 + noise, size,
+                                     /*psnr=*/quality / 2.f));
+        noisy_tasks.push_back(MakeTask(image_path, quality, 1 + 30 * noise,
+                                       size, /*psnr=*/quality / 2.f));
+      }
+    }
+  }
+  const TaskDiffSettings settings;
+  const StatusOr<TaskDiff> diff =
+      DiffTasks(old_tasks, new_tasks, settings, /*quiet=*/false);
+  ASSERT_EQ(diff.status, Status::kOk);
+  ASSERT_EQ(diff.value.codec_settings.size(), 1u);
+  const CodecSettingsDiff& group = diff.value.codec_settings.front();
+  EXPECT_EQ(group.num_tasks, 4u);
+  EXPECT_NEAR(group.encoding.ratio, 1.2, 1e-9);
+  EXPECT_GT(group.encoding.relative_error, 0);
+  EXPECT_TRUE(group.encoding.IsSignificant());
+  EXPECT_NEAR(group.size_ratio, 1, 1e-9);
+  EXPECT_NEAR(group.bd_rate, 0, 1e-9);
+  EXPECT_EQ(group.num_bd_rate_images, 2u);
+  EXPECT_TRUE(group.is_regression);
+  EXPECT_TRUE(diff.value.HasRegression());
+
+  // Too noisy to tell.
+  const StatusOr<TaskDiff> noisy_diff =
+      DiffTasks(old_tasks, noisy_tasks, settings, /*quiet=*/false);
+  ASSERT_EQ(noisy_diff.status, Status::kOk);
+  const CodecSettingsDiff& noisy_group = noisy_diff.value.codec_settings[0];
+  EXPECT_FALSE(noisy_group.encoding.IsSignificant());
+  EXPECT_FALSE(noisy_diff.value.HasRegression());
+}
+
+TEST(TaskDiffTest, SizesAndUnmatchedTasks) {
+  const std::vector<TaskOutput> old_tasks = {
+      MakeTask("a", kQualityLossless, 1, 1000, kNoDistortion),
+      MakeTask("b", kQualityLossless, 1, 1000, kNoDistortion),
+      MakeTask("a", 50, 1, 100, 30), MakeTask("a", 90, 1, 200, 40)};
+  const std::vector<TaskOutput> new_tasks = {
+      MakeTask("a", kQualityLossless, 1, 1100, kNoDistortion),
+      MakeTask("c", kQualityLossless, 1, 1000, kNoDistortion),
+      MakeTask("a", 50, 1, 90, 30), MakeTask("a", 90, 1, 180, 40)};
+  const StatusOr<TaskDiff> diff =
+      DiffTasks(old_tasks, new_tasks, TaskDiffSettings(), /*quiet=*/false);
+  ASSERT_EQ(diff.status, Status::kOk);
+  EXPECT_EQ(diff.value.num_old_only_tasks, 1u);
+  EXPECT_EQ(diff.value.num_new_only_tasks, 1u);
+  ASSERT_EQ(diff.value.codec_settings.size(), 2u);
+  // Lossy first because false < true.
+  const CodecSettingsDiff& lossy = diff.value.codec_settings[0];
+  const CodecSettingsDiff& lossless = diff.value.codec_settings[1];
+  ASSERT_FALSE(lossy.lossless);
+  EXPECT_NEAR(lossy.bd_rate, -0.1, 1e-6);
+  EXPECT_FALSE(lossy.is_regression);
+  // Not repeated so the durations are unchanged but not significant.
+  EXPECT_EQ(lossy.encoding.relative_error, -1);
+  EXPECT_NEAR(lossy.encoding.ratio, 1, 1e-9);
+  ASSERT_TRUE(lossless.lossless);
+  EXPECT_NEAR(lossless.size_ratio, 1.1, 1e-9);
+  EXPECT_TRUE(std::isnan(lossless.bd_rate));
+  EXPECT_TRUE(lossless.is_regression);
+
+  EXPECT_NE(DiffTasks({}, new_tasks, TaskDiffSettings(), /*quiet=*/true).status,
+            Status::kOk);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,172 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/temp_file_cache.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr bool kQuiet = false;
+
+// Writes num_bytes bytes to path and counts the calls.
+struct Writer {
+  Status operator()(const std::string& path) {
+    ++num_calls;
+    std::ofstream file(path, std::ios::binary);
+    file << std::string(num_bytes, 'x');
+    return file.good() ? Status::kOk : Status::kUnknownError;
+  }
+  size_t num_bytes;
+  size_t num_calls = 0;
+};
+
+//------------------------------------------------------------------------------
+
+TEST(TempFileCacheTest, HitsAndMisses) {
+  TempFileCache cache(std::numeric_limits<size_t>::max());
+  Writer writer{/*num_bytes=*/10};
+  auto write = [&](const std::string& path) { return writer(path); };
+
+  const StatusOr<std::shared_ptr<const TempFile>> first =
+      cache.Get("a.png", write, kQuiet);
+  ASSERT_EQ(first.status, Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(first.value->path));
+  EXPECT_EQ(first.value->num_bytes, 10);
+  EXPECT_EQ(cache.num_hits(), 0);
+  EXPECT_EQ(cache.num_misses(), 1);
+
+  const StatusOr<std::shared_ptr<const TempFile>> second =
+      cache.Get("a.png", write, kQuiet);
+  ASSERT_EQ(second.status, Status::kOk);
+  EXPECT_EQ(first.value, second.value);  // Same file.
+  EXPECT_EQ(writer.num_calls, 1);
+  EXPECT_EQ(cache.num_hits(), 1);
+  EXPECT_EQ(cache.num_misses(), 1);
+
+  const StatusOr<std::shared_ptr<const TempFile>> third =
+      cache.Get("b.png", write, kQuiet);
+  ASSERT_EQ(third.status, Status::kOk);
+  EXPECT_NE(first.value->path, third.value->path);
+  EXPECT_EQ(writer.num_calls, 2);
+}
+
+TEST(TempFileCacheTest, EvictedFileIsDeletedOnceUnused) {
+  TempFileCache cache(/*max_num_bytes=*/15);
+  Writer writer{/*num_bytes=*/10};
+  auto write = [&](const std::string& path) { return writer(path); };
+
+  StatusOr<std::shared_ptr<const TempFile>> a =
+      cache.Get("a.png", write, kQuiet);
+  ASSERT_EQ(a.status, Status::kOk);
+  const std::string a_path = a.value->path;
+  // Evicts a.png, but it is still in use.
+  ASSERT_EQ(cache.Get("b.png", write, kQuiet).status, Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(a_path));
+  a.value.reset();
+  EXPECT_FALSE(std::filesystem::exists(a_path));
+
+  // a.png must be written again.
+  const StatusOr<std::shared_ptr<const TempFile>> new_a =
+      cache.Get("a.png", write, kQuiet);
+  ASSERT_EQ(new_a.status, Status::kOk);
+  EXPECT_TRUE(std::filesystem::exists(new_a.value->path));
+  EXPECT_EQ(writer.num_calls, 3);
+}
+
+TEST(TempFileCacheTest, FilesAreDeletedAtDestruction) {
+  std::string path;
+  {
+    TempFileCache cache(std::numeric_limits<size_t>::max());
+    Writer writer{/*num_bytes=*/10};
+    const StatusOr<std::shared_ptr<const TempFile>> file = cache.Get(
+        "a.png", [&](const std::string& path) { return writer(path); },
+        kQuiet);
+    ASSERT_EQ(file.status, Status::kOk);
+    path = file.value->path;
+  }
+  EXPECT_FALSE(std::filesystem::exists(path));
+  EXPECT_FALSE(
+      std::filesystem::exists(std::filesystem::path(path).parent_path()));
+}
+
+TEST(TempFileCacheTest, WriteFailure) {
+  TempFileCache cache(std::numeric_limits<size_t>::max());
+  const auto fail = [](const std::string&) { return Status::kUnknownError; };
+  EXPECT_NE(cache.Get("a.bin", fail, /*quiet=*/true).status, Status::kOk);
+  // The next call tries again.
+  Writer writer{/*num_bytes=*/1};
+  EXPECT_EQ(cache
+                .Get("a.bin",
+                     [&](const std::string& path) { return writer(path); },
+                     kQuiet)
+                .status,
+            Status::kOk);
+  EXPECT_EQ(writer.num_calls, 1);
+}
+
+TEST(TempFileCacheTest, FastTempDirectory) {
+  const std::string folder_path =
+      (std::filesystem::path(::testing::TempDir()) / "ccgen_fast_temp")
+          .string();
+  std::filesystem::create_directories(folder_path);
+  SetFastTempDirectory(folder_path);
+  EXPECT_EQ(GetFastTempDirectory(), folder_path);
+  std::string path;
+  {
+    TempFileCache cache(std::numeric_limits<size_t>::max());
+    Writer writer{/*num_bytes=*/1};
+    const StatusOr<std::shared_ptr<const TempFile>> file = cache.Get(
+        "a.png", [&](const std::string& path) { return writer(path); },
+        kQuiet);
+    ASSERT_EQ(file.status, Status::kOk);
+    path = file.value->path;
+  }
+  EXPECT_EQ(path.rfind(folder_path, 0), 0u);
+  SetFastTempDirectory("");
+  EXPECT_NE(GetFastTempDirectory(), folder_path);
+}
+
+TEST(TempFileCacheTest, MemoryFile) {
+  if (!MemoryFile::IsSupported()) GTEST_SKIP() << "Unsupported platform";
+  std::string path;
+  {
+    MemoryFile file;
+    ASSERT_EQ(file.Create("a.png", kQuiet), Status::kOk);
+    path = file.path();
+    Writer writer{/*num_bytes=*/10};
+    ASSERT_EQ(writer(path), Status::kOk);
+    ASSERT_EQ(writer(path), Status::kOk);  // Truncated.
+    EXPECT_EQ(std::filesystem::file_size(path), 10u);
+    // Readable by another process too.
+    EXPECT_EQ(std::system(("test -s " + path).c_str()), 0);
+    EXPECT_NE(file.Create("b.png", /*quiet=*/true), Status::kOk);
+  }
+  EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/trace.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path);
+  return std::string((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+}
+
+size_t Count(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t i = text.find(pattern); i != std::string::npos;
+       i = text.find(pattern, i + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(TraceTest, NothingRecordedByDefault) {
+  EXPECT_FALSE(IsTracing());
+  { TraceScope trace("untraced"); }
+  const std::string path = ::testing::TempDir() + "/trace_default.json";
+  TraceRecorder recorder;
+  ASSERT_EQ(recorder.Start(path, /*quiet=*/false), Status::kOk);
+  EXPECT_TRUE(IsTracing());
+  EXPECT_NE(recorder.Start(path, /*quiet=*/true), Status::kOk);
+  ASSERT_EQ(recorder.Stop(), Status::kOk);
+  EXPECT_FALSE(IsTracing());
+  EXPECT_EQ(Count(ReadFile(path), "\"name\""), 0u);
+}
+
+TEST(TraceTest, OneTrackPerThread) {
+  const std::string path = ::testing::TempDir() + "/trace_threads.json";
+  for (int run = 0; run < 2; ++run) {  // The threads must not reuse old tracks.
+    TraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(path, /*quiet=*/false), Status::kOk);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+      threads.emplace_back([]() {
+        TraceScope outer("outer");
+        for (int i = 0; i < 2; ++i) TraceScope inner("inner");
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    { TraceScope trace("main"); }
+    ASSERT_EQ(recorder.Stop(), Status::kOk);
+
+    const std::string trace = ReadFile(path);
+    EXPECT_EQ(trace.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["),
+              0u);
+    EXPECT_EQ(Count(trace, "\"name\": \"outer\""), 3u);
+    EXPECT_EQ(Count(trace, "\"name\": \"inner\""), 6u);
+    EXPECT_EQ(Count(trace, "\"name\": \"main\""), 1u);
+    EXPECT_EQ(Count(trace, "\"ph\": \"X\""), 10u);
+    for (int tid = 0; tid < 4; ++tid) {
+      EXPECT_GT(Count(trace, "\"tid\": " + std::to_string(tid) + ","), 0u);
+    }
+    EXPECT_EQ(Count(trace, "\"tid\": 4,"), 0u);
+  }
+}
+
+TEST(TraceTest, WrittenByDestructor) {
+  const std::string path = ::testing::TempDir() + "/trace_destructor.json";
+  {
+    TraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(path, /*quiet=*/false), Status::kOk);
+    TraceScope trace("scope");
+  }
+  EXPECT_FALSE(IsTracing());
+  EXPECT_EQ(Count(ReadFile(path), "\"name\": \"scope\""), 1u);
+
+  TraceRecorder recorder;
+  EXPECT_NE(recorder.Stop(), Status::kOk);
+  EXPECT_NE(recorder.Start("", /*quiet=*/true), Status::kOk);
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
@@ -0,0 +1,49 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TESTS_TEST_UTILS_H_
+#define TESTS_TEST_UTILS_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "src/base.h"
+#include "src/task.h"
+
+namespace codec_compare_gen {
+
+// Returns a successful output of the input for an 8-bit still image of
+// image_width x image_height pixels, encoded into 1 byte in 1 second and
+// decoded in 1 second, without any computed distortion. The tests then set
+// the fields they rely on.
+inline TaskOutput MakeTaskOutput(const TaskInput& input,
+                                 uint32_t image_width = 1,
+                                 uint32_t image_height = 1) {
+  TaskOutput task{input,
+                  image_width,
+                  image_height,
+                  /*bit_depth=*/8,
+                  /*num_frames=*/1,
+                  /*encoded_size=*/1,
+                  /*encoding_duration=*/1,
+                  /*decoding_duration=*/1,
+                  /*decoding_color_conversion_duration=*/0};
+  std::fill(task.distortions, task.distortions + kNumDistortionMetrics,
+            kDistortionNotComputed);
+  return task;
+}
+
+}  // namespace codec_compare_gen
+
+#endif  // TESTS_TEST_UTILS_H_
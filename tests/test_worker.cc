@@ -12,9 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "src/cpu_affinity.h"
 #include "src/worker.h"
 
 namespace codec_compare_gen {
@@ -77,5 +83,213 @@ TEST(WorkerTest, PoolOf10) {
   EXPECT_EQ(context.done, 2);
 }
 
+TEST(WorkerTest, PoolsSharingMutex) {
+  WorkerContext context = {/*to_do=*/10, /*done=*/0};
+  std::mutex mutex;
+  WorkerPool<WorkerContext, TestWorker> pool_a(/*num_workers=*/2, mutex);
+  WorkerPool<WorkerContext, TestWorker> pool_b(/*num_workers=*/3, mutex);
+  std::thread thread([&]() { pool_b.Run(context); });
+  pool_a.Run(context);
+  thread.join();
+  EXPECT_EQ(context.to_do, 0);
+  EXPECT_EQ(context.done, 10);
+}
+
+struct CpuContext {
+  int to_do;
+  std::vector<std::vector<int>> allowed_cpus;  // One per task.
+};
+
+class CpuWorker : public Worker<CpuContext, CpuWorker> {
+  using Worker<CpuContext, CpuWorker>::Worker;
+  bool AssignTask(CpuContext& context) override {
+    if (context.to_do == 0) return false;
+    --context.to_do;
+    return true;
+  }
+  void DoTask() override { allowed_cpus_ = GetAllowedCpus(); }
+  void EndTask(CpuContext& context) override {
+    context.allowed_cpus.push_back(allowed_cpus_);
+  }
+  std::vector<int> allowed_cpus_;
+};
+
+TEST(WorkerTest, PinnedWorkers) {
+  const std::vector<int> all_cpus = GetAllowedCpus();
+  if (all_cpus.empty()) GTEST_SKIP() << "Unsupported platform";
+
+  CpuContext context = {/*to_do=*/6, /*allowed_cpus=*/{}};
+  WorkerPool<CpuContext, CpuWorker> pool(/*num_workers=*/3);
+  pool.SetCpusPerWorker({{all_cpus.front()}, {all_cpus.back()}});
+  pool.Run(context);
+  ASSERT_EQ(context.allowed_cpus.size(), 6);
+  for (const std::vector<int>& cpus : context.allowed_cpus) {
+    EXPECT_TRUE(cpus == std::vector<int>({all_cpus.front()}) ||
+                cpus == std::vector<int>({all_cpus.back()}));
+  }
+  // The worker running on the calling thread restored its affinity.
+  EXPECT_EQ(GetAllowedCpus(), all_cpus);
+}
+
+//------------------------------------------------------------------------------
+
+TEST(BoundedQueueTest, ProducerAndConsumers) {
+  BoundedQueue<int> queue(/*capacity=*/2);
+  std::mutex mutex;
+  int sum = 0;
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 3; ++i) {
+    consumers.emplace_back([&]() {
+      int item;
+      while (queue.Pop(item)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sum += item;
+      }
+    });
+  }
+  for (int item = 1; item <= 100; ++item) queue.Push(item);
+  queue.Close();
+  for (std::thread& consumer : consumers) consumer.join();
+  EXPECT_TRUE(queue.IsClosedAndEmpty());
+  EXPECT_EQ(sum, 5050);
+}
+
+TEST(BoundedQueueTest, PopAfterClose) {
+  BoundedQueue<int> queue(/*capacity=*/2);
+  queue.Push(42);
+  queue.Close();
+  EXPECT_FALSE(queue.IsClosedAndEmpty());
+  int item = 0;
+  EXPECT_TRUE(queue.Pop(item));
+  EXPECT_EQ(item, 42);
+  EXPECT_FALSE(queue.Pop(item));
+  EXPECT_TRUE(queue.IsClosedAndEmpty());
+}
+
+//------------------------------------------------------------------------------
+
+struct ThreadSafeWorkerContext {
+  explicit ThreadSafeWorkerContext(std::vector<int> items, size_t num_workers)
+      : to_do(std::move(items), num_workers) {}
+  WorkStealingQueue<int> to_do;
+  std::atomic<int> sum{0};
+  std::atomic<int> done{0};
+};
+
+class ThreadSafeTestWorker
+    : public Worker<ThreadSafeWorkerContext, ThreadSafeTestWorker> {
+ public:
+  static constexpr bool kIsThreadSafe = true;
+
+ private:
+  using Worker<ThreadSafeWorkerContext, ThreadSafeTestWorker>::Worker;
+  bool AssignTask(ThreadSafeWorkerContext& context) override {
+    return context.to_do.Pop(worker_id_, item_);
+  }
+  void DoTask() override {}
+  void EndTask(ThreadSafeWorkerContext& context) override {
+    context.sum += item_;
+    ++context.done;
+  }
+  int item_ = 0;
+};
+
+TEST(WorkerTest, ThreadSafePoolWithWorkStealing) {
+  std::vector<int> items;
+  for (int item = 1; item <= 100; ++item) items.push_back(item);
+  // More shards than workers: some deques are only emptied by stealing.
+  ThreadSafeWorkerContext context(items, /*num_workers=*/8);
+  WorkerPool<ThreadSafeWorkerContext, ThreadSafeTestWorker> pool(
+      /*num_workers=*/3);
+  pool.Run(context);
+  EXPECT_EQ(context.to_do.size(), 0);
+  EXPECT_EQ(context.done, 100);
+  EXPECT_EQ(context.sum, 5050);
+}
+
+TEST(WorkStealingQueueTest, OwnShardFromFrontThenStealFromBack) {
+  WorkStealingQueue<int> queue({0, 1, 2, 3, 4, 5}, /*num_shards=*/2);
+  EXPECT_EQ(queue.size(), 6);
+  int item = -1;
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 0);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 2);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 5);  // Stolen.
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 3);
+  EXPECT_EQ(queue.size(), 1);
+  queue.Clear();
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_FALSE(queue.Pop(/*shard_index=*/1, item));
+}
+
+TEST(WorkStealingQueueTest, Interleaved) {
+  WorkStealingQueue<int> queue({0, 1, 2, 3, 4}, /*num_shards=*/2,
+                               /*interleave=*/true);
+  int item = -1;
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 0);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 3);
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 4);  // Stolen.
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  EXPECT_EQ(item, 2);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(WorkStealingQueueTest, HeldItemsProduceItems) {
+  WorkStealingQueue<int> queue({3}, /*num_shards=*/2);
+  int item = -1;
+  ASSERT_TRUE(queue.PopAndHold(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 3);
+  // Another worker waits for the held item to produce new ones.
+  std::thread other_worker([&queue]() {
+    int other_item = -1;
+    ASSERT_TRUE(queue.PopAndHold(/*shard_index=*/0, other_item));
+    EXPECT_EQ(other_item, 2);  // Stolen from the back.
+    queue.Release(/*shard_index=*/0, {});
+  });
+  queue.Release(/*shard_index=*/1, {1, 2});
+  other_worker.join();
+  ASSERT_TRUE(queue.PopAndHold(/*shard_index=*/1, item));
+  EXPECT_EQ(item, 1);
+  queue.Clear();
+  queue.Release(/*shard_index=*/1, {0});  // Dropped.
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_FALSE(queue.PopAndHold(/*shard_index=*/1, item));
+}
+
+TEST(WorkStealingQueueTest, ForEachNext) {
+  WorkStealingQueue<int> queue({0, 1, 2, 3, 4, 5}, /*num_shards=*/2);
+  int item = -1;
+  ASSERT_TRUE(queue.Pop(/*shard_index=*/0, item));
+  std::vector<int> next_items;
+  queue.ForEachNext(/*shard_index=*/0, [&](int next_item) {
+    next_items.push_back(next_item);
+    return true;
+  });
+  EXPECT_EQ(next_items, std::vector<int>({1, 2}));
+  next_items.clear();
+  queue.ForEachNext(/*shard_index=*/1, [&](int next_item) {
+    next_items.push_back(next_item);
+    return next_items.size() < 2;
+  });
+  EXPECT_EQ(next_items, std::vector<int>({3, 4}));
+  EXPECT_EQ(queue.size(), 5);
+}
+
+TEST(WorkStealingQueueTest, Empty) {
+  WorkStealingQueue<int> queue({}, /*num_shards=*/0);
+  int item;
+  EXPECT_FALSE(queue.Pop(/*shard_index=*/3, item));
+}
+
 }  // namespace
 }  // namespace codec_compare_gen
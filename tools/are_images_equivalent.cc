@@ -12,9 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "src/base.h"
 #include "src/distortion.h"
@@ -25,34 +35,120 @@ namespace codec_compare_gen {
 void PrintUsage(const char* binary_path) {
   std::cout << "Usage: "
             << std::filesystem::path(binary_path).filename().string()
-            << " <path> <path>" << std::endl;
+            << " <path> <path>" << std::endl
+            << "       "
+            << std::filesystem::path(binary_path).filename().string()
+            << " --batch <list file path, or - for stdin> [--threads <count>]"
+            << std::endl;
 }
 
-StatusOr<bool> AreEquivalent(const char* file_path_a, const char* file_path_b) {
-  ASSIGN_OR_RETURN(Image image_a, ReadStillImageOrAnimation(
-                                      file_path_a, kARGB32, /*quiet=*/false));
-  ASSIGN_OR_RETURN(Image image_b, ReadStillImageOrAnimation(
-                                      file_path_b, kARGB32, /*quiet=*/false));
-  return PixelEquality(image_a, image_b, /*quiet=*/false);
+StatusOr<bool> AreEquivalent(const char* file_path_a, const char* file_path_b,
+                             bool quiet) {
+  ASSIGN_OR_RETURN(Image image_a,
+                   ReadStillImageOrAnimation(file_path_a, kARGB32, quiet));
+  ASSIGN_OR_RETURN(Image image_b,
+                   ReadStillImageOrAnimation(file_path_b, kARGB32, quiet));
+  return PixelEquality(image_a, image_b, quiet);
+}
+
+// Compares each pair of paths separated by a tab on each line of list, with
+// num_threads threads. Prints one line per pair as soon as it is compared:
+// its line number, "same", "differs" or "error", and the two paths, all
+// separated by tabs. Then prints the counts. Returns 0 if all pairs are the
+// same.
+int CompareBatch(std::istream& list, size_t num_threads) {
+  std::vector<std::pair<std::string, std::string>> pairs;
+  std::string line;
+  size_t line_number = 0;
+  while (std::getline(list, line)) {
+    ++line_number;
+    if (line.empty()) {
+      pairs.emplace_back();  // Keeps the indices matching the line numbers.
+      continue;
+    }
+    const size_t tab = line.find('\t');
+    if (tab == std::string::npos) {
+      std::cerr << "Expected two tab-separated paths at line " << line_number
+                << std::endl;
+      return 1;
+    }
+    pairs.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+  }
+
+  std::mutex mutex;  // Guards the output and the counts.
+  size_t num_same = 0, num_different = 0, num_failures = 0;
+  std::atomic<size_t> next_index(0);
+  const auto compare = [&]() {
+    for (size_t i = next_index++; i < pairs.size(); i = next_index++) {
+      const auto& [path_a, path_b] = pairs[i];
+      if (path_a.empty() && path_b.empty()) continue;
+      const StatusOr<bool> result =
+          AreEquivalent(path_a.c_str(), path_b.c_str(), /*quiet=*/true);
+      const char* outcome = result.status != Status::kOk ? "error"
+                            : result.value               ? "same"
+                                                         : "differs";
+      std::lock_guard<std::mutex> lock(mutex);
+      std::cout << (i + 1) << "\t" << outcome << "\t" << path_a << "\t"
+                << path_b << "\n";
+      if (result.status != Status::kOk) {
+        ++num_failures;
+      } else if (result.value) {
+        ++num_same;
+      } else {
+        ++num_different;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(num_threads, pairs.size()); ++i) {
+    threads.emplace_back(compare);
+  }
+  compare();
+  for (std::thread& thread : threads) thread.join();
+
+  std::cout << std::flush;
+  std::cerr << (num_same + num_different + num_failures) << " pairs: "
+            << num_same << " same, " << num_different << " different, "
+            << num_failures << " failed" << std::endl;
+  return num_different == 0 && num_failures == 0 ? 0 : 1;
 }
 
 int Main(int argc, const char* argv[]) {
   for (int i = 1; i < argc; ++i) {
     if (!std::strcmp(argv[i], "-h") || !std::strcmp(argv[i], "--help")) {
       std::cout << "Checks if the files at the given paths have the same pixel "
-                   "values."
+                   "values. In batch mode, checks each pair of tab-separated "
+                   "paths of each line of the list."
                 << std::endl;
       PrintUsage(argv[0]);
       return 0;
     }
   }
+  if (argc >= 3 && !std::strcmp(argv[1], "--batch")) {
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc == 5 && !std::strcmp(argv[3], "--threads")) {
+      num_threads = std::max(1ul, std::stoul(argv[4]));
+    } else if (argc != 3) {
+      std::cerr << "Wrong number of arguments." << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    if (!std::strcmp(argv[2], "-")) return CompareBatch(std::cin, num_threads);
+    std::ifstream list(argv[2]);
+    if (!list.is_open()) {
+      std::cerr << "Failed to open " << argv[2] << std::endl;
+      return 1;
+    }
+    return CompareBatch(list, num_threads);
+  }
   if (argc != 3) {
     std::cerr << "Wrong number of arguments." << std::endl;
     PrintUsage(argv[0]);
     return 1;
   }
 
-  const StatusOr<bool> result = AreEquivalent(argv[1], argv[2]);
+  const StatusOr<bool> result =
+      AreEquivalent(argv[1], argv[2], /*quiet=*/false);
   if (result.status != Status::kOk) {
     std::cerr << "Failed to open " << argv[1] << " or " << argv[2] << std::endl;
     return 1;
@@ -0,0 +1,238 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks of the codec adapters in isolation from the framework: the
+// encoding and decoding functions of each codec at a few efforts, on the
+// images of a folder and on synthetic ones of several sizes. The throughputs
+// are reported in megapixels and in bytes of decoded pixels per second. The
+// color conversion part of each decoding is reported separately.
+// Run with --benchmark_filter={regex} to select some of them, for example
+// --benchmark_filter='^jpegli/.*/decode'.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/codec_basis.h"
+#include "src/frame.h"
+#include "src/task.h"
+#include "third_party/libwebp2/src/wp2/base.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr bool kQuiet = true;
+
+// Codec configurations to benchmark, from the fastest effort to the slowest.
+struct BenchCodec {
+  Codec codec;
+  Subsampling chroma_subsampling;
+  std::vector<int> efforts;
+};
+
+const std::vector<BenchCodec>& GetBenchCodecs() {
+  static const auto* const kCodecs = new std::vector<BenchCodec>{
+      {Codec::kWebp, Subsampling::k420, {0, 4, 6}},
+      {Codec::kWebp2, Subsampling::k420, {0, 5, 9}},
+      {Codec::kJpegXl, Subsampling::k444, {1, 7, 9}},
+      {Codec::kAvif, Subsampling::k420, {9, 6}},
+      {Codec::kAvifSsim, Subsampling::k420, {9, 6}},
+      {Codec::kAvifIq, Subsampling::k420, {9, 6}},
+      {Codec::kAvifExp, Subsampling::k420, {9, 6}},
+      {Codec::kAvifAvm, Subsampling::k420, {9}},
+      {Codec::kAvifLibheif, Subsampling::k420, {9, 6}},
+      {Codec::kCombination, Subsampling::k420, {0}},
+      {Codec::kJpegturbo, Subsampling::k420, {0}},
+      {Codec::kJpegli, Subsampling::k420, {0}},
+      {Codec::kJpegsimple, Subsampling::k420, {0, 4, 8}},
+      {Codec::kJpegmoz, Subsampling::k420, {0}},
+      {Codec::kJp2, Subsampling::k444, {0}},
+      {Codec::kFfv1, Subsampling::k444, {0}},
+      {Codec::kBasis, Subsampling::k444, {0}}};
+  return *kCodecs;
+}
+
+// Writes an opaque PNG mixing smooth gradients and noise, to get realistic
+// compression rates at any size.
+Status WriteSyntheticImage(uint32_t size, const std::string& path) {
+  Image image;
+  image.emplace_back(WP2::ArgbBuffer(WP2_ARGB_32), /*duration_ms=*/0);
+  WP2::ArgbBuffer& pixels = image.back().pixels;
+  CHECK_OR_RETURN(pixels.Resize(size, size) == WP2_STATUS_OK, kQuiet);
+  uint32_t noise = 42;
+  for (uint32_t y = 0; y < size; ++y) {
+    uint8_t* row = pixels.GetRow8(y);
+    for (uint32_t x = 0; x < size; ++x) {
+      noise = noise * 1664525u + 1013904223u;  // Linear congruential.
+      row[x * 4 + 0] = 0xFF;
+      row[x * 4 + 1] = static_cast<uint8_t>(x * 255 / size);
+      row[x * 4 + 2] = static_cast<uint8_t>(y * 255 / size);
+      row[x * 4 + 3] = static_cast<uint8_t>(((x ^ y) & 0x80) + (noise >> 28));
+    }
+  }
+  return WriteStillImageOrAnimation(image, path.c_str(), kQuiet);
+}
+
+void SetThroughputs(benchmark::State& state, const Image& image) {
+  uint64_t num_pixels = 0, num_bytes = 0;
+  for (const Frame& frame : image) {
+    const uint64_t frame_num_pixels =
+        uint64_t{frame.pixels.width()} * frame.pixels.height();
+    num_pixels += frame_num_pixels;
+    num_bytes += frame_num_pixels * WP2FormatBpp(frame.pixels.format());
+  }
+  state.counters["MP/s"] =
+      benchmark::Counter(num_pixels / 1e6,
+                         benchmark::Counter::kIsIterationInvariantRate);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               num_bytes));
+}
+
+void BenchmarkEncoding(benchmark::State& state, const TaskInput& input) {
+  const StatusOr<std::shared_ptr<const Image>> original =
+      ReadImageForCodec(input, /*original_image_cache=*/nullptr, kQuiet);
+  if (original.status != Status::kOk) {
+    state.SkipWithError("Could not read the image for this codec");
+    return;
+  }
+  size_t encoded_size = 0;
+  for (auto _ : state) {
+    const StatusOr<WP2::Data> encoded =
+        EncodeWithCodec(input, *original.value, kQuiet);
+    if (encoded.status != Status::kOk) {
+      state.SkipWithError("Encoding failed");
+      return;
+    }
+    encoded_size = encoded.value.size;
+    benchmark::DoNotOptimize(encoded.value.bytes);
+  }
+  SetThroughputs(state, *original.value);
+  state.counters["encoded_bytes"] = static_cast<double>(encoded_size);
+}
+
+void BenchmarkDecoding(benchmark::State& state, const TaskInput& input) {
+  const StatusOr<std::shared_ptr<const Image>> original =
+      ReadImageForCodec(input, /*original_image_cache=*/nullptr, kQuiet);
+  if (original.status != Status::kOk) {
+    state.SkipWithError("Could not read the image for this codec");
+    return;
+  }
+  const StatusOr<WP2::Data> encoded =
+      EncodeWithCodec(input, *original.value, kQuiet);
+  if (encoded.status != Status::kOk) {
+    state.SkipWithError("Encoding failed");
+    return;
+  }
+  const WP2::DataView encoded_view = {encoded.value.bytes, encoded.value.size};
+  double color_conversion_duration = 0;
+  for (auto _ : state) {
+    const StatusOr<std::pair<Image, double>> decoded =
+        DecodeWithCodec(input, encoded_view, kQuiet);
+    if (decoded.status != Status::kOk) {
+      state.SkipWithError("Decoding failed");
+      return;
+    }
+    color_conversion_duration += decoded.value.second;
+    benchmark::DoNotOptimize(decoded.value.first.data());
+  }
+  SetThroughputs(state, *original.value);
+  // In seconds per decoding, included in the decoding duration.
+  state.counters["color_conversion"] = benchmark::Counter(
+      color_conversion_duration, benchmark::Counter::kAvgIterations);
+}
+
+int Main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (argc > 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [benchmark flags] [folder of images (default tests/data)]"
+              << std::endl;
+    return 1;
+  }
+  const std::string folder_path = argc > 1 ? argv[1] : "tests/data";
+
+  // name, path
+  std::vector<std::pair<std::string, std::string>> images;
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(folder_path, error)) {
+    const std::string extension = entry.path().extension().string();
+    if (extension == ".png" || extension == ".gif" || extension == ".webp") {
+      images.emplace_back(entry.path().filename().string(),
+                          entry.path().string());
+    }
+  }
+  std::sort(images.begin(), images.end());
+  std::vector<std::string> synthetic_paths;
+  for (uint32_t size : {256u, 1024u, 2048u}) {
+    const std::string name = "synthetic" + std::to_string(size) + "x" +
+                             std::to_string(size) + ".png";
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("ccgen_bench_" + name))
+            .string();
+    if (WriteSyntheticImage(size, path) != Status::kOk) {
+      std::cerr << "Could not write " << path << std::endl;
+      return 1;
+    }
+    images.emplace_back(name, path);
+    synthetic_paths.push_back(path);
+  }
+
+  for (const BenchCodec& bench_codec : GetBenchCodecs()) {
+    const std::vector<int> qualities = CodecLossyQualities(bench_codec.codec);
+    // A middle quality, or lossless for the codecs without lossy mode.
+    const int quality = qualities.empty() ? kQualityLossless
+                                          : qualities[qualities.size() / 2];
+    for (int effort : bench_codec.efforts) {
+      for (const auto& [image_name, image_path] : images) {
+        const TaskInput input = {{bench_codec.codec,
+                                  bench_codec.chroma_subsampling, effort,
+                                  quality},
+                                 image_path};
+        const std::string name = CodecName(bench_codec.codec) + "/effort:" +
+                                 std::to_string(effort) + "/" + image_name;
+        for (const bool is_encoding : {true, false}) {
+          benchmark::RegisterBenchmark(
+              (name + (is_encoding ? "/encode" : "/decode")).c_str(),
+              is_encoding ? BenchmarkEncoding : BenchmarkDecoding, input)
+              ->Unit(benchmark::kMillisecond)
+              ->UseRealTime();
+        }
+      }
+    }
+  }
+
+  const BasisContext basis_context(/*enabled=*/true);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  for (const std::string& path : synthetic_paths) {
+    std::filesystem::remove(path, error);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+int main(int argc, char** argv) { return codec_compare_gen::Main(argc, argv); }
@@ -0,0 +1,189 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/framework.h"
+#include "src/framework_steps.h"
+#include "src/serialization.h"
+#include "src/task.h"
+#include "src/task_diff.h"
+
+namespace codec_compare_gen {
+
+// Exit code of Main() if a regression is found. 1 means failure.
+constexpr int kRegressionExitCode = 2;
+
+void PrintUsage(const char* binary_path) {
+  const TaskDiffSettings kDefSet;
+  std::cout
+      << "Usage: " << std::filesystem::path(binary_path).filename().string()
+      << " [options] <old progress file> <new progress file>" << std::endl
+      << " [--metric {distortion metric used for the BD-rate}] - default: "
+      << kDistortionMetricToStr[static_cast<size_t>(kDefSet.metric)]
+      << std::endl
+      << " [--max_encoding_slowdown {ratio}] - default: "
+      << kDefSet.max_encoding_slowdown << std::endl
+      << " [--max_decoding_slowdown {ratio}] - default: "
+      << kDefSet.max_decoding_slowdown << std::endl
+      << " [--max_size_increase {ratio of the lossless sizes}] - default: "
+      << kDefSet.max_size_increase << std::endl
+      << " [--max_bd_rate {ratio of the lossy sizes}] - default: "
+      << kDefSet.max_bd_rate << std::endl
+      << " [--z_score {of the significance tests of the durations}] - "
+         "default: "
+      << kDefSet.z_score << std::endl;
+}
+
+std::string PercentToString(double ratio) {
+  std::stringstream stream;
+  stream << std::showpos << std::fixed << std::setprecision(2)
+         << (ratio * 100) << "%";
+  return stream.str();
+}
+
+std::string DurationDeltaToString(const DurationDelta& delta) {
+  std::string str = PercentToString(delta.ratio - 1);
+  if (delta.relative_error >= 0) {
+    // Bounds of the confidence interval of ratio.
+    str += " [" + PercentToString(std::exp(-delta.relative_error) *
+                                  delta.ratio - 1) +
+           ", " +
+           PercentToString(std::exp(delta.relative_error) * delta.ratio - 1) +
+           "]";
+    if (delta.IsSignificant()) str += " *";
+  } else {
+    str += " (not repeated)";
+  }
+  return str;
+}
+
+StatusOr<std::vector<TaskOutput>> ReadTasks(const std::string& file_path) {
+  CHECK_OR_RETURN(std::filesystem::exists(file_path), /*quiet=*/false)
+      << file_path << " does not exist";
+  ComparisonSettings settings;
+  settings.num_extra_threads = std::thread::hardware_concurrency() > 1
+                                   ? std::thread::hardware_concurrency() - 1
+                                   : 0;
+  return LoadTasks(settings, file_path);
+}
+
+int Main(int argc, const char* argv[]) {
+  TaskDiffSettings settings;
+  std::vector<std::string> file_paths;
+  for (int arg_index = 1; arg_index < argc; ++arg_index) {
+    const std::string arg = argv[arg_index];
+    if (arg == "-h" || arg == "--help") {
+      std::cout << "Compares the tasks of two progress files produced by "
+                   "ccgen with the same images and flags, for example before "
+                   "and after a codec update. Exits with "
+                << kRegressionExitCode
+                << " if a codec configuration got significantly slower or "
+                   "larger than the thresholds."
+                << std::endl;
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (arg == "--metric" && arg_index + 1 < argc) {
+      const StatusOr<DistortionMetric> metric =
+          DistortionMetricFromString(argv[++arg_index], /*quiet=*/false);
+      if (metric.status != Status::kOk) return 1;
+      settings.metric = metric.value;
+    } else if (arg == "--max_encoding_slowdown" && arg_index + 1 < argc) {
+      settings.max_encoding_slowdown = std::stod(argv[++arg_index]);
+    } else if (arg == "--max_decoding_slowdown" && arg_index + 1 < argc) {
+      settings.max_decoding_slowdown = std::stod(argv[++arg_index]);
+    } else if (arg == "--max_size_increase" && arg_index + 1 < argc) {
+      settings.max_size_increase = std::stod(argv[++arg_index]);
+    } else if (arg == "--max_bd_rate" && arg_index + 1 < argc) {
+      settings.max_bd_rate = std::stod(argv[++arg_index]);
+    } else if (arg == "--z_score" && arg_index + 1 < argc) {
+      settings.z_score = std::stod(argv[++arg_index]);
+    } else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    } else {
+      file_paths.push_back(arg);
+    }
+  }
+  if (file_paths.size() != 2) {
+    std::cerr << "Wrong number of arguments." << std::endl;
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  const StatusOr<std::vector<TaskOutput>> old_tasks = ReadTasks(file_paths[0]);
+  if (old_tasks.status != Status::kOk) return 1;
+  const StatusOr<std::vector<TaskOutput>> new_tasks = ReadTasks(file_paths[1]);
+  if (new_tasks.status != Status::kOk) return 1;
+  const StatusOr<TaskDiff> diff = DiffTasks(old_tasks.value, new_tasks.value,
+                                            settings, /*quiet=*/false);
+  if (diff.status != Status::kOk) return 1;
+
+  std::cout << "Encoding and decoding durations and sizes of "
+            << file_paths[1] << " relative to " << file_paths[0]
+            << ". The confidence intervals of the durations are at z="
+            << settings.z_score << " (* if significant)." << std::endl;
+  for (const CodecSettingsDiff& group : diff.value.codec_settings) {
+    std::string name = CodecPrettyName(group.codec, group.lossless,
+                                       group.chroma_subsampling, group.effort);
+    if (group.num_threads != 1) {
+      name += " " + std::to_string(group.num_threads) + " threads";
+    }
+    std::cout << (group.lossless ? "lossless " : "lossy ") << name << " ("
+              << group.num_tasks << " tasks)" << std::endl
+              << "  encoding " << DurationDeltaToString(group.encoding)
+              << std::endl
+              << "  decoding " << DurationDeltaToString(group.decoding)
+              << std::endl
+              << "  size " << PercentToString(group.size_ratio - 1);
+    if (!group.lossless) {
+      std::cout << ", " << kDistortionMetricToStr[static_cast<size_t>(
+                               settings.metric)]
+                << " BD-rate ";
+      if (std::isnan(group.bd_rate)) {
+        std::cout << "unknown";
+      } else {
+        std::cout << PercentToString(group.bd_rate) << " ("
+                  << group.num_bd_rate_images << " images)";
+      }
+    }
+    std::cout << std::endl;
+    if (group.is_regression) std::cout << "  REGRESSION" << std::endl;
+  }
+  if (diff.value.num_old_only_tasks != 0 ||
+      diff.value.num_new_only_tasks != 0) {
+    std::cout << "Ignored " << diff.value.num_old_only_tasks
+              << " tasks only in " << file_paths[0] << " and "
+              << diff.value.num_new_only_tasks << " tasks only in "
+              << file_paths[1] << std::endl;
+  }
+  return diff.value.HasRegression() ? kRegressionExitCode : 0;
+}
+
+}  // namespace codec_compare_gen
+
+int main(int argc, const char* argv[]) {
+  return codec_compare_gen::Main(argc, argv);
+}
@@ -14,54 +14,55 @@
 
 #include "tools/ccgen_impl.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "src/base.h"
 #include "src/codec.h"
+#include "src/distortion.h"
 #include "src/framework.h"
+#include "src/image_manifest.h"
 #include "src/serialization.h"
 
 namespace codec_compare_gen {
 
 namespace {
 
-void GetAllFilesIn(const std::filesystem::path& file_or_directory_path,
-                   std::vector<std::string>& file_paths) {
-  if (std::filesystem::is_directory(file_or_directory_path)) {
-    for (const std::filesystem::directory_entry& entry :
-         std::filesystem::directory_iterator(file_or_directory_path)) {
-      GetAllFilesIn(entry.path(), file_paths);
-    }
-  } else if (file_or_directory_path.has_extension() &&
-             (file_or_directory_path.extension() == ".png" ||
-              file_or_directory_path.extension() == ".PNG" ||
-              file_or_directory_path.extension() == ".jpg" ||
-              file_or_directory_path.extension() == ".JPG" ||
-              file_or_directory_path.extension() == ".jpeg" ||
-              file_or_directory_path.extension() == ".JPEG" ||
-              file_or_directory_path.extension() == ".gif" ||
-              file_or_directory_path.extension() == ".GIF" ||
-              file_or_directory_path.extension() == ".webp" ||
-              file_or_directory_path.extension() == ".WEBP")) {
-    file_paths.push_back(file_or_directory_path);
-  }
-}
-
 struct CodecEffort {
   Codec codec;
   Subsampling chroma_subsampling;
   int effort;
 };
 
+// Parses "{metric}:{value}" into the metric and value of the settings.
+bool ParseMetricAndValue(const std::string& flag, const std::string& str,
+                         QualitySearchSettings& settings) {
+  const auto delim = str.find(':');
+  if (delim == std::string::npos) {
+    std::cerr << "Error: Expected {metric}:{value} for " << flag << ", got \""
+              << str << "\"" << std::endl;
+    return false;
+  }
+  const StatusOr<DistortionMetric> metric =
+      DistortionMetricFromString(str.substr(0, delim), /*quiet=*/false);
+  if (metric.status != Status::kOk) return false;
+  settings.metric = metric.value;
+  settings.value = std::stod(str.substr(delim + 1));
+  return true;
+}
+
 }  // namespace
 
 int Main(int argc, const char* const argv[]) {
-  std::vector<std::string> image_paths;
+  std::vector<std::string> file_or_folder_paths;
+  std::string manifest_path;
   std::vector<CodecEffort> codec_settings;
   ComparisonSettings settings;
   bool lossy = false;
@@ -69,9 +70,11 @@ int Main(int argc, const char* const argv[]) {
   std::unordered_set<int> allowed_qualities;
   std::string completed_tasks_file_path;
   std::string results_folder_path;
+  uint32_t num_benchmark_decodings = 0;
 
   settings.random_order = true;
   settings.quiet = false;
+  settings.image_cache_max_num_bytes = size_t{1024} << 20;  // 1 GiB
   const ComparisonSettings kDefSet = settings;  // Default settings.
 
   int arg_index = 1;
@@ -104,18 +107,174 @@ int Main(int argc, const char* const argv[]) {
                 << " [--quality {unique|min:max}]" << std::endl
                 << " [--repeat {number of times to encode each image}]"
                 << " - default: " << kDefSet.num_repetitions << std::endl
+                << " [--warmup {discarded encodings and decodings before each "
+                   "measured one}] - default: "
+                << kDefSet.timing.num_warmups << std::endl
+                << " [--repeat_until_error {repeat each encoding and decoding "
+                   "in-process until the 95% confidence interval of their "
+                   "durations is within that ratio of their mean, 0 to "
+                   "disable}] - default: "
+                << kDefSet.timing.max_relative_error << std::endl
+                << " [--repeat_time_budget {max seconds spent repeating each "
+                   "task in-process}] - default: "
+                << kDefSet.timing.max_seconds << std::endl
+                << " [--timing_statistic {mean|median|min}] - default: "
+                << TimingStatisticToString(kDefSet.timing.statistic)
+                << std::endl
+                << " [--metrics {psnr,ssim,dssim,butteraugli,ssimulacra,"
+                   "ssimulacra2,p3norm,samplepsnr}] - default: all but "
+                   "samplepsnr" << std::endl
+                << " [--target_distortion {metric}:{value} (bisect the "
+                   "qualities to find the lowest one reaching that "
+                   "distortion)]"
+                << std::endl
+                << " [--target_bpp {value} (bisect the qualities to find the "
+                   "lowest one exceeding that number of bits per pixel)]"
+                << std::endl
+                << " [--sample_curve {metric}:{max error} (only encode the "
+                   "qualities where linearly interpolating the "
+                   "rate-distortion curve of that metric would be off by more "
+                   "than max error)]"
+                << std::endl
+                << " [--curve_initial_qualities {evenly spread qualities "
+                   "first sampled by --sample_curve}] - default: "
+                << kDefSet.quality_search.num_initial_curve_qualities
+                << std::endl
+                << " [--prune_saturated {run the qualities of each image in "
+                   "increasing order and copy the last result to the higher "
+                   "ones once lossless or unchanged in size}]"
+                << std::endl
                 << " [--recompute_distortion]" << std::endl
                 << " [--threads {extra threads on top of main thread}]"
                 << " - default: " << kDefSet.num_extra_threads << std::endl
+                << " [--metric_threads {threads computing distortions, 0 to "
+                   "use the threads above}] - default: "
+                << kDefSet.num_metric_threads << std::endl
+                << " [--frame_threads {threads evaluating the frames of each "
+                   "animation in parallel}] - default: "
+                << kDefSet.num_frame_threads << std::endl
+                << " [--codec_threads {threads used by each encoder and "
+                   "decoder, ignored by the JPEG codecs}] - default: "
+                << kDefSet.num_codec_threads << std::endl
+                << " [--pin_threads {run each encoding thread alone on "
+                   "dedicated CPUs, the other threads on the remaining ones}]"
+                << std::endl
+                << " [--numa_node {index of the NUMA node to run on}]"
+                << std::endl
+                << " [--cpu_time {requires --codec_threads 1}]" << std::endl
+                << " [--trace_file {path of the Chrome trace JSON file of the "
+                   "phases of the tasks, for chrome://tracing or Perfetto}]"
+                << std::endl
+                << " [--hardware_counters {Linux only}]" << std::endl
+                << " [--peak_memory {Linux only, requires --threads 0, "
+                   "--metric_threads 0 and no option starting background "
+                   "threads}]"
+                << std::endl
+                << " [--image_cache {MB of decoded original images kept in "
+                   "memory, 0 to disable}] - default: "
+                << (kDefSet.image_cache_max_num_bytes >> 20) << std::endl
+                << " [--max_memory {MB of estimated peak memory of the tasks "
+                   "running at once, the image cache and the pooled pixels, "
+                   "0 to disable}] - default: "
+                << (kDefSet.max_memory_num_bytes >> 20) << std::endl
+                << " [--stream_rows {megapixels from which the still images "
+                   "are decoded and compared row by row, with --metrics "
+                   "SamplePSNR only, 0 to disable}] - default: "
+                << kDefSet.stream_rows_min_num_pixels / 1000000 << std::endl
+                << " [--prefetch {number of images read ahead of the next "
+                   "tasks of each thread, 0 to disable}] - default: "
+                << kDefSet.prefetch_num_images << std::endl
+                << " [--artifact_threads {number of threads writing the "
+                   "decoded PNG files, 0 to write them in the tasks}] - "
+                   "default: "
+                << kDefSet.num_artifact_threads << std::endl
+                << " [--fast_artifacts {faster but larger decoded animation "
+                   "files, with --artifact_threads}]"
+                << std::endl
+                << " [--encode_cache {folder where the outputs and encoded "
+                   "files of the tasks are kept to be reused by later runs}]"
+                << std::endl
+                << " [--dedup_images {encode the images with identical file "
+                   "contents only once}]"
+                << std::endl
+                << " [--reuse_candidates {the combination codec reuses the "
+                   "images encoded by the other tasks}]"
+                << std::endl
                 << " [--deterministic]" << std::endl
+                << " [--group_by_image]" << std::endl
+                << " [--longest_first {run first the tasks expected to take "
+                   "the longest according to the progress file}]"
+                << std::endl
                 << " [--abort_above_fail_ratio {0..1}] - default: "
                 << (kDefSet.abort_above_fail_ratio * 100) << "%" << std::endl
                 << " [--skip_all_remaining]" << std::endl
+                << " [--time_budget {seconds after which no task is started, "
+                   "and the completed ones are saved as if all were done}]"
+                << std::endl
+                << " [--results_update_period {seconds between two writes of "
+                   "the outdated JSON files while running, 0 to only write "
+                   "them at the end}] - default: "
+                << kDefSet.results_update_period << std::endl
+                << " [--results_gzip {compress the JSON files with gzip}]"
+                << std::endl
+                << " [--results_chunk_rows {rows per separate chunk file "
+                   "listed by each JSON file, 0 to keep the rows in the JSON "
+                   "file}] - default: "
+                << kDefSet.results_format.chunk_num_rows << std::endl
+                << " [--status_file {path of a JSON file rewritten every few "
+                   "seconds with the progress, the time left and the "
+                   "throughput of each codec}]"
+                << std::endl
+                << " [--num_shards {split the tasks into that many "
+                   "independent runs, each with its own progress file}] - "
+                   "default: "
+                << kDefSet.num_shards << std::endl
+                << " [--shard_index {run only the tasks of that shard, in "
+                   "[0:num_shards)}] - default: "
+                << kDefSet.shard_index << std::endl
+                << " [--merge_shards {run nothing but merge the progress files "
+                   "of all --num_shards into --progress_file and write "
+                   "--results_folder}]"
+                << std::endl
+                << " [--serve_tasks {TCP port on which remote workers can "
+                   "take tasks, without authentication}]"
+                << std::endl
+                << " [--serve_tasks_address {address to listen on for "
+                   "--serve_tasks, all interfaces by default}]"
+                << std::endl
+                << " [--remote_worker_timeout {seconds without answer from a "
+                   "remote worker before its task is handed out again, 0 to "
+                   "wait forever}] - default: "
+                << kDefSet.remote_worker_timeout << std::endl
+                << " [--coordinator {host:port of a --serve_tasks run to take "
+                   "tasks from instead of planning any, with the same "
+                   "arguments}]"
+                << std::endl
                 << " [--quiet]" << std::endl
                 << " [--metric_binary_folder {path to third_party created by "
                    "deps.sh}]"
                 << std::endl
+                << " [--temp_folder {folder of the temporary files, /dev/shm "
+                   "if it exists by default}]"
+                << std::endl
+                << " [--memory_files {give in-memory files to the metric "
+                   "binaries (Linux only)}]"
+                << std::endl
+                << " [--metric_servers {start the metric binaries from "
+                   "long-lived shells shared by all threads}]"
+                << std::endl
+                << " [--cold_codecs {create the codec states for each "
+                   "encoding and decoding instead of reusing them}]"
+                << std::endl
+                << " [--manifest {file listing the images found in the "
+                   "input folders, reused for the unchanged folders by later "
+                   "runs}]"
+                << std::endl
                 << " [--encoded_folder {path}]" << std::endl
+                << " [--decode_benchmark {only decode each image of "
+                   "--encoded_folder that many times in memory and write "
+                   "the decoding speeds to --results_folder}]"
+                << std::endl
                 << " --progress_file {path}" << std::endl
                 << " --results_folder {path}" << std::endl
                 << " -- {image file path}..." << std::endl;
@@ -194,6 +353,17 @@ int Main(int argc, const char* const argv[]) {
       }
     } else if (arg == "--repeat" && arg_index + 1 < argc) {
       settings.num_repetitions = std::stoul(argv[++arg_index]);
+    } else if (arg == "--warmup" && arg_index + 1 < argc) {
+      settings.timing.num_warmups = std::stoul(argv[++arg_index]);
+    } else if (arg == "--repeat_until_error" && arg_index + 1 < argc) {
+      settings.timing.max_relative_error = std::stod(argv[++arg_index]);
+    } else if (arg == "--repeat_time_budget" && arg_index + 1 < argc) {
+      settings.timing.max_seconds = std::stod(argv[++arg_index]);
+    } else if (arg == "--timing_statistic" && arg_index + 1 < argc) {
+      const StatusOr<TimingStatistic> timing_statistic =
+          TimingStatisticFromString(argv[++arg_index], /*quiet=*/false);
+      if (timing_statistic.status != Status::kOk) return 1;
+      settings.timing.statistic = timing_statistic.value;
     } else if (arg == "--recompute_distortion") {
       settings.discard_distortion_values = true;
     } else if (arg == "--lossy") {
@@ -214,20 +384,129 @@ int Main(int argc, const char* const argv[]) {
         allowed_qualities.insert(std::stoi(str));
       }
       lossy = true;
+    } else if (arg == "--metrics" && arg_index + 1 < argc) {
+      settings.distortion_metrics.clear();
+      for (const std::string& name : Split(argv[++arg_index], ',')) {
+        const StatusOr<DistortionMetric> metric =
+            DistortionMetricFromString(Trim(name), /*quiet=*/false);
+        if (metric.status != Status::kOk) return 1;
+        settings.distortion_metrics.push_back(metric.value);
+      }
+    } else if (arg == "--target_distortion" && arg_index + 1 < argc) {
+      if (!ParseMetricAndValue(arg, argv[++arg_index],
+                               settings.quality_search)) {
+        return 1;
+      }
+      settings.quality_search.target = QualitySearchTarget::kDistortion;
+    } else if (arg == "--target_bpp" && arg_index + 1 < argc) {
+      settings.quality_search.target = QualitySearchTarget::kBitsPerPixel;
+      settings.quality_search.value = std::stod(argv[++arg_index]);
+    } else if (arg == "--sample_curve" && arg_index + 1 < argc) {
+      if (!ParseMetricAndValue(arg, argv[++arg_index],
+                               settings.quality_search)) {
+        return 1;
+      }
+      settings.quality_search.target =
+          QualitySearchTarget::kRateDistortionCurve;
+    } else if (arg == "--prune_saturated") {
+      settings.quality_search.prune_saturated = true;
+    } else if (arg == "--curve_initial_qualities" && arg_index + 1 < argc) {
+      settings.quality_search.num_initial_curve_qualities =
+          std::stoul(argv[++arg_index]);
     } else if (arg == "--threads" && arg_index + 1 < argc) {
       settings.num_extra_threads = std::stoul(argv[++arg_index]);
+    } else if (arg == "--metric_threads" && arg_index + 1 < argc) {
+      settings.num_metric_threads = std::stoul(argv[++arg_index]);
+    } else if (arg == "--frame_threads" && arg_index + 1 < argc) {
+      settings.num_frame_threads = std::stoul(argv[++arg_index]);
+    } else if (arg == "--codec_threads" && arg_index + 1 < argc) {
+      settings.num_codec_threads = std::stoul(argv[++arg_index]);
+    } else if (arg == "--pin_threads") {
+      settings.pin_threads = true;
+    } else if (arg == "--numa_node" && arg_index + 1 < argc) {
+      settings.numa_node = std::stoi(argv[++arg_index]);
+    } else if (arg == "--trace_file" && arg_index + 1 < argc) {
+      settings.trace_file_path = argv[++arg_index];
+    } else if (arg == "--cpu_time") {
+      settings.resource_usage.cpu_time = true;
+    } else if (arg == "--hardware_counters") {
+      settings.resource_usage.hardware_counters = true;
+    } else if (arg == "--peak_memory") {
+      settings.resource_usage.peak_memory = true;
+    } else if (arg == "--image_cache" && arg_index + 1 < argc) {
+      settings.image_cache_max_num_bytes = size_t{std::stoul(argv[++arg_index])}
+                                           << 20;
+    } else if (arg == "--max_memory" && arg_index + 1 < argc) {
+      settings.max_memory_num_bytes = uint64_t{std::stoul(argv[++arg_index])}
+                                      << 20;
+    } else if (arg == "--stream_rows" && arg_index + 1 < argc) {
+      settings.stream_rows_min_num_pixels =
+          uint64_t{std::stoul(argv[++arg_index])} * 1000000;
+    } else if (arg == "--prefetch" && arg_index + 1 < argc) {
+      settings.prefetch_num_images = std::stoul(argv[++arg_index]);
+    } else if (arg == "--artifact_threads" && arg_index + 1 < argc) {
+      settings.num_artifact_threads = std::stoul(argv[++arg_index]);
+    } else if (arg == "--fast_artifacts") {
+      settings.fast_artifacts = true;
+    } else if (arg == "--encode_cache" && arg_index + 1 < argc) {
+      settings.encode_cache_folder_path = argv[++arg_index];
+    } else if (arg == "--dedup_images") {
+      settings.dedup_images = true;
+    } else if (arg == "--reuse_candidates") {
+      settings.reuse_candidates = true;
     } else if (arg == "--deterministic") {
       settings.random_order = false;
+    } else if (arg == "--group_by_image") {
+      settings.group_by_image = true;
+    } else if (arg == "--longest_first") {
+      settings.longest_first = true;
     } else if (arg == "--abort_above_fail_ratio" && arg_index + 1 < argc) {
       settings.abort_above_fail_ratio = std::stod(argv[++arg_index]);
     } else if (arg == "--skip_all_remaining") {
       settings.skip_all_remaining = true;
+    } else if (arg == "--time_budget" && arg_index + 1 < argc) {
+      settings.time_budget = std::stod(argv[++arg_index]);
+    } else if (arg == "--results_update_period" && arg_index + 1 < argc) {
+      settings.results_update_period = std::stod(argv[++arg_index]);
+    } else if (arg == "--results_gzip") {
+      settings.results_format.gzip = true;
+    } else if (arg == "--results_chunk_rows" && arg_index + 1 < argc) {
+      settings.results_format.chunk_num_rows = std::stoull(argv[++arg_index]);
+    } else if (arg == "--status_file" && arg_index + 1 < argc) {
+      settings.status_file_path = argv[++arg_index];
+    } else if (arg == "--num_shards" && arg_index + 1 < argc) {
+      settings.num_shards = std::stoul(argv[++arg_index]);
+    } else if (arg == "--shard_index" && arg_index + 1 < argc) {
+      settings.shard_index = std::stoul(argv[++arg_index]);
+    } else if (arg == "--merge_shards") {
+      settings.merge_shards = true;
+    } else if (arg == "--serve_tasks" && arg_index + 1 < argc) {
+      settings.serve_tasks_port =
+          static_cast<uint16_t>(std::stoul(argv[++arg_index]));
+    } else if (arg == "--serve_tasks_address" && arg_index + 1 < argc) {
+      settings.serve_tasks_address = argv[++arg_index];
+    } else if (arg == "--remote_worker_timeout" && arg_index + 1 < argc) {
+      settings.remote_worker_timeout = std::stod(argv[++arg_index]);
+    } else if (arg == "--coordinator" && arg_index + 1 < argc) {
+      settings.coordinator_address = argv[++arg_index];
     } else if (arg == "--quiet") {
       settings.quiet = true;
     } else if (arg == "--metric_binary_folder" && arg_index + 1 < argc) {
       settings.metric_binary_folder_path = argv[++arg_index];
+    } else if (arg == "--temp_folder" && arg_index + 1 < argc) {
+      settings.temp_folder_path = argv[++arg_index];
+    } else if (arg == "--memory_files") {
+      settings.memory_files = true;
+    } else if (arg == "--metric_servers") {
+      settings.metric_servers = true;
+    } else if (arg == "--cold_codecs") {
+      settings.reuse_codec_contexts = false;
     } else if (arg == "--encoded_folder" && arg_index + 1 < argc) {
       settings.encoded_folder_path = argv[++arg_index];
+    } else if (arg == "--decode_benchmark" && arg_index + 1 < argc) {
+      num_benchmark_decodings = std::stoul(argv[++arg_index]);
+    } else if (arg == "--manifest" && arg_index + 1 < argc) {
+      manifest_path = argv[++arg_index];
     } else if (arg == "--progress_file" && arg_index + 1 < argc) {
       completed_tasks_file_path = argv[++arg_index];
     } else if (arg == "--results_folder" && arg_index + 1 < argc) {
@@ -243,7 +522,7 @@ int Main(int argc, const char* const argv[]) {
             << arg << "\" as a file path)" << std::endl;
         return 1;
       }
-      GetAllFilesIn(arg, image_paths);
+      file_or_folder_paths.push_back(arg);
     }
   }
 
@@ -252,7 +531,9 @@ int Main(int argc, const char* const argv[]) {
               << std::endl;
     return 1;
   }
-  if (lossy && settings.metric_binary_folder_path.empty()) {
+  if (lossy && settings.metric_binary_folder_path.empty() &&
+      NeedsMetricBinaries(settings.distortion_metrics) &&
+      num_benchmark_decodings == 0 && !settings.merge_shards) {
     std::cerr << "Missing --metric_binary_folder for lossy evaluations"
               << std::endl;
     return 1;
@@ -260,7 +541,23 @@ int Main(int argc, const char* const argv[]) {
 
   // All arguments after "--" are file paths.
   for (; arg_index < argc; ++arg_index) {
-    GetAllFilesIn(argv[arg_index], image_paths);
+    file_or_folder_paths.push_back(argv[arg_index]);
+  }
+  // Listing folders mostly waits for the file system, so use at least as many
+  // threads as CPUs.
+  const StatusOr<std::vector<FoundImage>> found_images = FindImageFiles(
+      file_or_folder_paths, manifest_path,
+      std::max<size_t>(settings.num_extra_threads + 1,
+                       std::thread::hardware_concurrency()),
+      settings.quiet);
+  if (found_images.status != Status::kOk) return 1;
+  std::vector<std::string> image_paths;
+  image_paths.reserve(found_images.value.size());
+  for (const FoundImage& image : found_images.value) {
+    image_paths.push_back(image.path);
+    if (!manifest_path.empty()) {
+      settings.image_headers[image.path] = image.header;
+    }
   }
 
   if (lossy) {
@@ -292,6 +589,13 @@ int Main(int argc, const char* const argv[]) {
     }
   }
 
+  if (num_benchmark_decodings > 0) {
+    if (BenchmarkDecoders(image_paths, settings, num_benchmark_decodings,
+                          results_folder_path) != Status::kOk) {
+      return 1;
+    }
+    return 0;
+  }
   if (Compare(image_paths, settings, completed_tasks_file_path,
               results_folder_path) != Status::kOk) {
     return 1;
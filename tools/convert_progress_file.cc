@@ -0,0 +1,121 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/mapped_file.h"
+#include "src/task.h"
+#include "src/task_binary.h"
+
+namespace codec_compare_gen {
+
+void PrintUsage(const char* binary_path) {
+  std::cout << "Usage: "
+            << std::filesystem::path(binary_path).filename().string()
+            << " <input path> <output path>" << std::endl;
+}
+
+StatusOr<std::vector<TaskOutput>> ReadTasks(const std::string& file_path) {
+  std::vector<std::unordered_set<int>> qualities_per_codec(
+      static_cast<int>(Codec::kNumCodecs));
+  for (size_t i = 0; i < qualities_per_codec.size(); ++i) {
+    const std::vector<int> q = CodecLossyQualities(static_cast<Codec>(i));
+    qualities_per_codec[i] = std::unordered_set<int>(q.begin(), q.end());
+  }
+
+  MappedFile file;
+  OK_OR_RETURN(file.Open(file_path, /*quiet=*/false));
+  const std::string_view contents = file.contents();
+  if (IsBinaryTasksFilePath(file_path)) {
+    if (contents.empty()) return std::vector<TaskOutput>();
+    return UnserializeBinaryTaskOutputs(contents, qualities_per_codec,
+                                        /*with_distortions=*/true,
+                                        /*quiet=*/false);
+  }
+  return UnserializeTaskOutputs(
+      contents, qualities_per_codec, /*with_distortions=*/true,
+      /*num_threads=*/std::thread::hardware_concurrency(), /*quiet=*/false);
+}
+
+Status WriteTasks(const std::vector<TaskOutput>& tasks,
+                  const std::string& file_path) {
+  std::ofstream file(file_path, std::ios::trunc | std::ios::binary);
+  CHECK_OR_RETURN(file.is_open(), /*quiet=*/false)
+      << "Could not open " << file_path << " for writing";
+  if (IsBinaryTasksFilePath(file_path)) {
+    BinaryTaskEncoder encoder;
+    file << BinaryTaskEncoder::Header();
+    for (const TaskOutput& task : tasks) file << encoder.Encode(task);
+  } else {
+    for (const TaskOutput& task : tasks) file << task.Serialize() << std::endl;
+  }
+  file.close();
+  CHECK_OR_RETURN(!file.fail(), /*quiet=*/false)
+      << "Could not write " << file_path;
+  return Status::kOk;
+}
+
+int Main(int argc, const char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "-h") || !std::strcmp(argv[i], "--help")) {
+      std::cout << "Converts a ccgen progress file from or to the binary "
+                   "format, selected by the "
+                << kBinaryTasksFileExtension
+                << " extension. Other paths use the CSV format." << std::endl;
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+  if (argc != 3) {
+    std::cerr << "Wrong number of arguments." << std::endl;
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  std::error_code error_code;
+  if (std::filesystem::equivalent(argv[1], argv[2], error_code)) {
+    std::cerr << "The input and output paths must differ." << std::endl;
+    return 1;
+  }
+
+  const StatusOr<std::vector<TaskOutput>> tasks = ReadTasks(argv[1]);
+  if (tasks.status != Status::kOk) {
+    std::cerr << "Failed to read " << argv[1] << std::endl;
+    return 1;
+  }
+  if (WriteTasks(tasks.value, argv[2]) != Status::kOk) {
+    std::cerr << "Failed to write " << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << "Converted " << tasks.value.size() << " tasks from " << argv[1]
+            << " to " << argv[2] << std::endl;
+  return 0;
+}
+
+}  // namespace codec_compare_gen
+
+int main(int argc, const char* argv[]) {
+  return codec_compare_gen::Main(argc, argv);
+}
@@ -0,0 +1,301 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the steps of a comparison whose durations scale with the
+// number of tasks rather than with the number of pixels: planning, resuming
+// from a progress file, aggregating the results, writing them as JSON, and
+// dispatching tasks to the WorkerPool. All tasks and their outputs are
+// synthetic, nothing is encoded.
+// Run with --benchmark_filter={regex} to select some of them, for example
+// --benchmark_filter='BM_LoadTasks/.*/2097152'.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/base.h"
+#include "src/codec.h"
+#include "src/framework.h"
+#include "src/framework_steps.h"
+#include "src/result_json.h"
+#include "src/task.h"
+#include "src/task_binary.h"
+#include "src/worker.h"
+
+namespace codec_compare_gen {
+namespace {
+
+constexpr bool kQuiet = true;
+
+// Numbers of tasks of the benchmarks below.
+constexpr int64_t kMinNumTasks = int64_t{1} << 15;
+constexpr int64_t kMaxNumTasks = int64_t{1} << 21;
+
+// Settings planning at least num_tasks tasks: every lossy quality of a few
+// codecs, for as many images as needed.
+ComparisonSettings MakeSettings(size_t num_tasks,
+                                std::vector<std::string>& image_paths) {
+  ComparisonSettings settings;
+  settings.quiet = kQuiet;
+  settings.encoded_folder_path = "/tmp/ccgen_framework_bench/encoded";
+  for (Codec codec :
+       {Codec::kWebp, Codec::kWebp2, Codec::kJpegXl, Codec::kAvif}) {
+    for (int quality : CodecLossyQualities(codec)) {
+      settings.codec_settings.push_back(
+          {codec, Subsampling::k420, /*effort=*/4, quality});
+    }
+  }
+  const size_t num_images = (num_tasks + settings.codec_settings.size() - 1) /
+                            settings.codec_settings.size();
+  image_paths.clear();
+  for (size_t i = 0; i < num_images; ++i) {
+    image_paths.push_back("/tmp/ccgen_framework_bench/images/image_" +
+                          std::to_string(i) + ".png");
+  }
+  return settings;
+}
+
+// Returns plausible outputs of the tasks, without running them.
+std::vector<TaskOutput> MakeTaskOutputs(const std::vector<TaskInput>& tasks) {
+  std::vector<TaskOutput> outputs;
+  outputs.reserve(tasks.size());
+  uint32_t seed = 42;
+  const auto random = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;  // Linear congruential.
+    return seed >> 8;
+  };
+  for (const TaskInput& task : tasks) {
+    TaskOutput output;
+    output.task_input = task;
+    output.image_width = 256 + random() % 2048;
+    output.image_height = 256 + random() % 2048;
+    output.bit_depth = 8;
+    output.num_frames = 1;
+    output.encoded_size = 1000 + random() % 1000000;
+    output.encoding_duration = (random() % 100000) / 1e5;
+    output.decoding_duration = (random() % 10000) / 1e5;
+    output.decoding_color_conversion_duration = output.decoding_duration / 10;
+    for (float& distortion : output.distortions) {
+      distortion = static_cast<float>(random() % 10000) / 100;
+    }
+    outputs.push_back(output);
+  }
+  return outputs;
+}
+
+// Synthetic tasks and outputs shared by the benchmarks of the same size.
+struct Fixture {
+  std::vector<std::string> image_paths;
+  ComparisonSettings settings;
+  std::vector<TaskInput> tasks;
+  std::vector<TaskOutput> outputs;
+};
+
+const Fixture& GetFixture(size_t num_tasks) {
+  static std::mutex mutex;
+  static Fixture* fixture = nullptr;  // Only the last size is kept.
+  static size_t fixture_num_tasks = 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (fixture == nullptr || fixture_num_tasks != num_tasks) {
+    delete fixture;
+    fixture = new Fixture;
+    fixture_num_tasks = num_tasks;
+    fixture->settings = MakeSettings(num_tasks, fixture->image_paths);
+    fixture->tasks = PlanTasks(fixture->image_paths, fixture->settings).value;
+    fixture->outputs = MakeTaskOutputs(fixture->tasks);
+  }
+  return *fixture;
+}
+
+std::string GetTempPath(const std::string& file_name) {
+  return (std::filesystem::temp_directory_path() /
+          ("ccgen_framework_bench_" + file_name))
+      .string();
+}
+
+void SetTaskRate(benchmark::State& state, size_t num_tasks) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() *
+                                               num_tasks));
+}
+
+void BM_PlanTasks(benchmark::State& state) {
+  const Fixture& fixture = GetFixture(state.range(0));
+  for (auto _ : state) {
+    const StatusOr<std::vector<TaskInput>> tasks =
+        PlanTasks(fixture.image_paths, fixture.settings);
+    benchmark::DoNotOptimize(tasks.value.data());
+  }
+  SetTaskRate(state, fixture.tasks.size());
+}
+
+// Parses a progress file in the CSV format if state.range(1) is 0, or in the
+// binary format otherwise.
+void BM_LoadTasks(benchmark::State& state) {
+  const Fixture& fixture = GetFixture(state.range(0));
+  const bool is_binary = state.range(1) != 0;
+  const std::string path =
+      GetTempPath(is_binary ? "progress.ccgenbin" : "progress.csv");
+  {
+    std::ofstream file(path, std::ios::trunc | std::ios::binary);
+    BinaryTaskEncoder encoder;
+    if (is_binary) file << BinaryTaskEncoder::Header();
+    for (const TaskOutput& output : fixture.outputs) {
+      if (is_binary) {
+        file << encoder.Encode(output);
+      } else {
+        file << output.Serialize() << std::endl;
+      }
+    }
+  }
+  for (auto _ : state) {
+    const StatusOr<std::vector<TaskOutput>> tasks =
+        LoadTasks(fixture.settings, path);
+    if (tasks.status != Status::kOk ||
+        tasks.value.size() != fixture.outputs.size()) {
+      state.SkipWithError("Could not load the tasks");
+      break;
+    }
+  }
+  SetTaskRate(state, fixture.tasks.size());
+  std::error_code error;
+  std::filesystem::remove(path, error);
+}
+
+// Half of the planned tasks are completed, as with an interrupted run.
+void BM_RemoveCompletedTasksFromRemainingTasks(benchmark::State& state) {
+  const Fixture& fixture = GetFixture(state.range(0));
+  std::vector<TaskOutput> completed_tasks;
+  for (size_t i = 0; i < fixture.outputs.size(); i += 2) {
+    completed_tasks.push_back(fixture.outputs[i]);
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<TaskInput> remaining_tasks = fixture.tasks;
+    state.ResumeTiming();
+    if (RemoveCompletedTasksFromRemainingTasks(
+            fixture.settings, "progress.csv", completed_tasks,
+            remaining_tasks) != Status::kOk) {
+      state.SkipWithError("Could not match the completed tasks");
+      break;
+    }
+  }
+  SetTaskRate(state, fixture.tasks.size());
+}
+
+void BM_SplitByCodecSettingsAndAggregateByImageAndQuality(
+    benchmark::State& state) {
+  const Fixture& fixture = GetFixture(state.range(0));
+  for (auto _ : state) {
+    const StatusOr<std::vector<std::vector<TaskOutput>>> groups =
+        SplitByCodecSettingsAndAggregateByImageAndQuality(
+            fixture.outputs, TimingStatistic::kMean, kQuiet);
+    if (groups.status != Status::kOk) {
+      state.SkipWithError("Could not aggregate the tasks");
+      break;
+    }
+  }
+  SetTaskRate(state, fixture.tasks.size());
+}
+
+void BM_TasksToJson(benchmark::State& state) {
+  const Fixture& fixture = GetFixture(state.range(0));
+  const StatusOr<std::vector<std::vector<TaskOutput>>> groups =
+      SplitByCodecSettingsAndAggregateByImageAndQuality(
+          fixture.outputs, TimingStatistic::kMean, kQuiet);
+  if (groups.status != Status::kOk) {
+    state.SkipWithError("Could not aggregate the tasks");
+    return;
+  }
+  const std::string path = GetTempPath("results.json");
+  for (auto _ : state) {
+    for (const std::vector<TaskOutput>& group : groups.value) {
+      const CodecSettings& settings = group.front().task_input.codec_settings;
+      if (TasksToJson(CodecName(settings.codec), settings,
+                      TimingStatistic::kMean, group, ResultsFormat(), kQuiet,
+                      path) != Status::kOk) {
+        state.SkipWithError("Could not write the results");
+        break;
+      }
+    }
+  }
+  SetTaskRate(state, fixture.tasks.size());
+  std::error_code error;
+  std::filesystem::remove(path, error);
+}
+
+// Counts the no-op tasks left to assign. Guarded by the WorkerPool mutex.
+struct NoOpContext {
+  size_t num_tasks = 0;
+  size_t num_assigned_tasks = 0;
+};
+
+class NoOpWorker : public Worker<NoOpContext, NoOpWorker> {
+ public:
+  using Worker<NoOpContext, NoOpWorker>::Worker;
+
+ private:
+  bool AssignTask(NoOpContext& context) override {
+    return context.num_assigned_tasks++ < context.num_tasks;
+  }
+  void DoTask() override {}
+};
+
+// Dispatches state.range(0) no-op tasks to state.range(1) workers.
+void BM_WorkerPool(benchmark::State& state) {
+  for (auto _ : state) {
+    NoOpContext context;
+    context.num_tasks = static_cast<size_t>(state.range(0));
+    WorkerPool<NoOpContext, NoOpWorker> pool(state.range(1));
+    pool.Run(context);
+  }
+  SetTaskRate(state, state.range(0));
+}
+
+BENCHMARK(BM_PlanTasks)
+    ->RangeMultiplier(8)
+    ->Range(kMinNumTasks, kMaxNumTasks)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadTasks)
+    ->ArgsProduct({benchmark::CreateRange(kMinNumTasks, kMaxNumTasks, 8),
+                   {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_RemoveCompletedTasksFromRemainingTasks)
+    ->RangeMultiplier(8)
+    ->Range(kMinNumTasks, kMaxNumTasks)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SplitByCodecSettingsAndAggregateByImageAndQuality)
+    ->RangeMultiplier(8)
+    ->Range(kMinNumTasks, kMaxNumTasks)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TasksToJson)
+    ->RangeMultiplier(8)
+    ->Range(kMinNumTasks, kMaxNumTasks)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_WorkerPool)
+    ->ArgsProduct({{kMinNumTasks, kMaxNumTasks}, {1, 2, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace codec_compare_gen
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the throughput of the dispatched pixel kernels with their plain C++
+// counterparts and with std::memcmp(), on buffers the size of a large image.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "src/pixel_kernels.h"
+#include "src/timer.h"
+
+namespace codec_compare_gen {
+
+void PrintUsage(const char* binary_path) {
+  std::cout << "Usage: "
+            << std::filesystem::path(binary_path).filename().string()
+            << " [megabytes per buffer (default 64)] [number of runs]"
+            << std::endl;
+}
+
+// Prints the best throughput of the given number of calls to function.
+void Benchmark(const std::string& name, size_t num_bytes, int num_runs,
+               const std::function<uint64_t()>& function) {
+  double best_seconds = 0;
+  uint64_t checksum = 0;  // Keeps the calls from being optimized away.
+  for (int run = 0; run < num_runs; ++run) {
+    const Timer timer;
+    checksum += function();
+    const double seconds = timer.seconds();
+    if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+  }
+  std::cout << std::left << std::setw(32) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(8)
+            << num_bytes / best_seconds / 1e9 << " GB/s"
+            << " (checksum " << checksum << ")" << std::endl;
+}
+
+int Main(int argc, const char* argv[]) {
+  if (argc > 3) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  const size_t num_bytes =
+      (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64) << 20;
+  const int num_runs = argc > 2 ? std::atoi(argv[2]) : 10;
+  if (num_bytes == 0 || num_runs <= 0) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // Equal buffers are the worst case of the equality check: all bytes are read.
+  std::vector<uint8_t> a(num_bytes), b(num_bytes);
+  for (size_t i = 0; i < num_bytes; ++i) a[i] = static_cast<uint8_t>(i * 7);
+  b = a;
+  std::cout << "Instruction set: " << PixelKernelsInstructionSet()
+            << std::endl;
+
+  Benchmark("BytesEqual", num_bytes, num_runs,
+            [&]() { return BytesEqual(a.data(), b.data(), num_bytes); });
+  Benchmark("BytesEqualScalar", num_bytes, num_runs,
+            [&]() { return BytesEqualScalar(a.data(), b.data(), num_bytes); });
+  Benchmark("std::memcmp", num_bytes, num_runs, [&]() {
+    return std::memcmp(a.data(), b.data(), num_bytes) == 0;
+  });
+
+  for (size_t i = 0; i < num_bytes; i += 3) b[i] ^= 0x55;
+  Benchmark("SumOfSquaredDifferences", num_bytes, num_runs, [&]() {
+    return SumOfSquaredDifferences(a.data(), b.data(), num_bytes);
+  });
+  Benchmark("SumOfSquaredDifferencesScalar", num_bytes, num_runs, [&]() {
+    return SumOfSquaredDifferencesScalar(a.data(), b.data(), num_bytes);
+  });
+  return 0;
+}
+
+}  // namespace codec_compare_gen
+
+int main(int argc, const char* argv[]) {
+  return codec_compare_gen::Main(argc, argv);
+}